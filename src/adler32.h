@@ -0,0 +1,545 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2017-2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_ADLER32_H
+#define CHOCOBO1_ADLER32_H
+
+#include "state_serializer.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+// the SIMD paths are taken only outside of constant evaluation
+#ifndef CHOCOBO1_HASH_ADLER32_RUNTIME_DISPATCH
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated) && (defined(__SSSE3__) || defined(__AVX2__))
+#define CHOCOBO1_HASH_ADLER32_RUNTIME_DISPATCH 1
+#endif
+#endif
+#endif
+
+#if defined(CHOCOBO1_HASH_ADLER32_RUNTIME_DISPATCH)
+#include <immintrin.h>
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// Adler32();
+	//   `combine(other, otherLength)` appends the data hashed by `other`, `addDataParallel()` splits large inputs across threads
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+#ifndef CONSTEXPR_CPP17_CHOCOBO1_HASH
+#if __cplusplus >= 201703L
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
+#else
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
+#endif
+#endif
+
+
+namespace Adler32_NS
+{
+#if defined(CHOCOBO1_HASH_ADLER32_RUNTIME_DISPATCH)
+#if defined(__SSSE3__)
+	struct Ssse3Ops
+	{
+		using Vector = __m128i;
+		static constexpr int BLOCK_SIZE = 16;
+		static constexpr int BLOCK_SHIFT = 4;
+
+		static Vector load(const uint8_t *p)
+		{
+			return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		}
+		static Vector zero()
+		{
+			return _mm_setzero_si128();
+		}
+		static Vector set0(const uint32_t x)
+		{
+			// `x` in the first 32-bit lane
+			return _mm_cvtsi32_si128(static_cast<int>(x));
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm_add_epi32(a, b);
+		}
+		static Vector byteSum(const Vector x)
+		{
+			// sum of the bytes, in the low half of each 64-bit lane
+			return _mm_sad_epu8(x, _mm_setzero_si128());
+		}
+		static Vector weightedSum(const Vector x)
+		{
+			// sum of byte[i] * (BLOCK_SIZE - i), in 32-bit lanes
+			const __m128i weights = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+			return _mm_madd_epi16(_mm_maddubs_epi16(x, weights), _mm_set1_epi16(1));
+		}
+		static Vector shiftBlock(const Vector x)
+		{
+			return _mm_slli_epi32(x, BLOCK_SHIFT);
+		}
+		static uint32_t sum(const Vector x)
+		{
+			uint32_t lanes[4] = {};
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), x);
+			return (lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+		}
+	};
+#endif
+
+#if defined(__AVX2__)
+	struct Avx2Ops
+	{
+		using Vector = __m256i;
+		static constexpr int BLOCK_SIZE = 32;
+		static constexpr int BLOCK_SHIFT = 5;
+
+		static Vector load(const uint8_t *p)
+		{
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		}
+		static Vector zero()
+		{
+			return _mm256_setzero_si256();
+		}
+		static Vector set0(const uint32_t x)
+		{
+			return _mm256_setr_epi32(static_cast<int>(x), 0, 0, 0, 0, 0, 0, 0);
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm256_add_epi32(a, b);
+		}
+		static Vector byteSum(const Vector x)
+		{
+			return _mm256_sad_epu8(x, _mm256_setzero_si256());
+		}
+		static Vector weightedSum(const Vector x)
+		{
+			const __m256i weights = _mm256_setr_epi8(
+				32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+				16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+			return _mm256_madd_epi16(_mm256_maddubs_epi16(x, weights), _mm256_set1_epi16(1));
+		}
+		static Vector shiftBlock(const Vector x)
+		{
+			return _mm256_slli_epi32(x, BLOCK_SHIFT);
+		}
+		static uint32_t sum(const Vector x)
+		{
+			uint32_t lanes[8] = {};
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), x);
+			return (lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7]);
+		}
+	};
+#endif
+#endif
+
+	class Adler32
+	{
+		// https://tools.ietf.org/html/rfc1950
+		// SIMD kernel follows the zlib-ng & Chromium approach: `psadbw` for the byte sum, `pmaddubsw` for the weighted sum
+
+		public:
+			using Byte = uint8_t;
+			using ResultArrayType = std::array<Byte, 4>;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			constexpr Adler32();
+
+			constexpr void reset();
+			constexpr Adler32& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
+
+			constexpr Adler32& addData(const Span<const Byte> inData);
+			constexpr Adler32& addData(const void *ptr, const std::size_t length);
+			template <std::size_t N>
+			constexpr Adler32& addData(const Byte (&array)[N]);
+			template <typename T, std::size_t N>
+			Adler32& addData(const T (&array)[N]);
+			template <typename T>
+			Adler32& addData(const Span<T> inSpan);
+
+			// same result as `addData()`, `threads == 0` uses all cores
+			Adler32& addDataParallel(const Span<const Byte> inData, const std::size_t threads = 0);
+			Adler32& addDataParallel(const void *ptr, const std::size_t length, const std::size_t threads = 0);
+
+			// as if the data hashed by `other` were passed to `addData()`
+			constexpr Adler32& combine(const Adler32 &other, const uint64_t otherLength);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			constexpr void addDataImpl(const Span<const Byte> data);
+			constexpr void addDataScalar(const Byte *ptr, std::size_t length);
+#if defined(CHOCOBO1_HASH_ADLER32_RUNTIME_DISPATCH)
+			template <typename Ops>
+			std::size_t addDataSimd(const Byte *ptr, const std::size_t length);
+#endif
+
+			static constexpr uint32_t BASE = 65521;  // largest prime smaller than 65536
+			static constexpr std::size_t NMAX = 5552;  // largest n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1
+			static constexpr std::size_t THREAD_THRESHOLD = 1024 * 1024;
+
+			uint32_t m_a = 1;
+			uint32_t m_b = 0;
+	};
+
+
+	//
+	constexpr Adler32::Adler32()
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+		reset();
+	}
+
+	constexpr void Adler32::reset()
+	{
+		m_a = 1;
+		m_b = 0;
+	}
+
+	constexpr Adler32& Adler32::finalize()
+	{
+		return (*this);
+	}
+
+	inline std::string Adler32::toString() const
+	{
+		const auto a = toArray();
+		std::string ret;
+		ret.resize(2 * a.size());
+
+		auto retPtr = &ret.front();
+		for (const auto c : a)
+		{
+			const Byte upper = static_cast<Byte>(c >> 4);
+			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
+
+			const Byte lower = c & 0xf;
+			*(retPtr++) = static_cast<char>((lower < 10) ? (lower + '0') : (lower - 10 + 'a'));
+		}
+
+		return ret;
+	}
+
+	inline std::vector<Adler32::Byte> Adler32::toVector() const
+	{
+		const auto a = toArray();
+		return {a.begin(), a.end()};
+	}
+
+	CONSTEXPR_CPP17_CHOCOBO1_HASH Adler32::ResultArrayType Adler32::toArray() const
+	{
+		const uint32_t value = (m_b << 16) | m_a;
+
+		ResultArrayType ret {};
+		auto retPtr = ret.data();
+		for (int j = 3; j >= 0; --j)
+			*(retPtr++) = static_cast<Byte>(value >> (j * 8));
+
+		return ret;
+	}
+
+	CONSTEXPR_CPP17_CHOCOBO1_HASH Adler32::ResultArrayType Adler32::peekDigest() const
+	{
+		Adler32 copy = *this;
+		return copy.finalize().toArray();
+	}
+
+	constexpr Adler32& Adler32::addData(const Span<const Byte> inData)
+	{
+		addDataImpl(inData);
+		return (*this);
+	}
+
+	constexpr Adler32& Adler32::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <std::size_t N>
+	constexpr Adler32& Adler32::addData(const Byte (&array)[N])
+	{
+		return addData({array, N});
+	}
+
+	template <typename T, std::size_t N>
+	Adler32& Adler32::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename T>
+	Adler32& Adler32::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	inline Adler32& Adler32::addDataParallel(const Span<const Byte> inData, const std::size_t threads)
+	{
+		// threads: at most one per core & every piece at least `THREAD_THRESHOLD / 2` bytes
+		const std::size_t dataSize = static_cast<std::size_t>(inData.size());
+		const std::size_t cores = std::thread::hardware_concurrency();
+		std::size_t threadCount = (threads == 0) ? ((cores == 0) ? 2 : cores) : threads;
+		if (cores != 0)
+			threadCount = std::min(threadCount, cores);
+		threadCount = std::min(threadCount, (dataSize / (THREAD_THRESHOLD / 2)));
+		if (threadCount <= 1)
+			return addData(inData);
+
+		const std::size_t pieceSize = (dataSize + threadCount - 1) / threadCount;
+		const std::size_t pieces = (dataSize + pieceSize - 1) / pieceSize;
+
+		std::vector<Adler32> partials(pieces);
+		std::vector<std::thread> workers;
+		workers.reserve(pieces - 1);
+		for (std::size_t i = 1; i < pieces; ++i)
+		{
+			const Span<const Byte> piece = inData.subspan((i * pieceSize), std::min(pieceSize, (dataSize - (i * pieceSize))));
+			workers.emplace_back([&partials, i, piece]()
+			{
+				partials[i].addDataImpl(piece);
+			});
+		}
+		addDataImpl(inData.first(pieceSize));
+
+		for (auto &worker : workers)
+			worker.join();
+
+		for (std::size_t i = 1; i < pieces; ++i)
+			combine(partials[i], std::min(pieceSize, (dataSize - (i * pieceSize))));
+
+		return (*this);
+	}
+
+	inline Adler32& Adler32::addDataParallel(const void *ptr, const std::size_t length, const std::size_t threads)
+	{
+		return addDataParallel({static_cast<const Byte*>(ptr), length}, threads);
+	}
+
+	constexpr Adler32& Adler32::combine(const Adler32 &other, const uint64_t otherLength)
+	{
+		// from zlib `adler32_combine()`: a = a1 + a2 - 1, b = b1 + b2 + (len2 * a1) - len2
+		const uint32_t base = BASE;
+		const uint32_t rem = static_cast<uint32_t>(otherLength % base);
+
+		uint32_t a = m_a + other.m_a + base - 1;
+		uint32_t b = static_cast<uint32_t>((static_cast<uint64_t>(rem) * m_a) % base) + m_b + other.m_b + base - rem;
+		if (a >= base)
+			a -= base;
+		if (a >= base)
+			a -= base;
+		if (b >= (base << 1))
+			b -= (base << 1);
+		if (b >= base)
+			b -= base;
+
+		m_a = a;
+		m_b = b;
+		return (*this);
+	}
+
+	constexpr void Adler32::addDataImpl(const Span<const Byte> data)
+	{
+		const Byte *ptr = data.data();
+		std::size_t length = static_cast<std::size_t>(data.size());
+
+#if defined(CHOCOBO1_HASH_ADLER32_RUNTIME_DISPATCH)
+		if (!__builtin_is_constant_evaluated())
+		{
+#if defined(__AVX2__)
+			const std::size_t done = addDataSimd<Avx2Ops>(ptr, length);
+#else
+			const std::size_t done = addDataSimd<Ssse3Ops>(ptr, length);
+#endif
+			ptr += done;
+			length -= done;
+		}
+#endif
+
+		addDataScalar(ptr, length);
+	}
+
+	constexpr void Adler32::addDataScalar(const Byte *ptr, std::size_t length)
+	{
+		// the modulo is deferred for up to NMAX bytes
+		const std::size_t nmax = NMAX;
+		uint32_t a = m_a;
+		uint32_t b = m_b;
+		while (length > 0)
+		{
+			const std::size_t chunk = std::min(length, nmax);
+			length -= chunk;
+
+			std::size_t i = 0;
+			for (; (i + 8) <= chunk; i += 8)
+			{
+				a += ptr[i + 0];
+				b += a;
+				a += ptr[i + 1];
+				b += a;
+				a += ptr[i + 2];
+				b += a;
+				a += ptr[i + 3];
+				b += a;
+				a += ptr[i + 4];
+				b += a;
+				a += ptr[i + 5];
+				b += a;
+				a += ptr[i + 6];
+				b += a;
+				a += ptr[i + 7];
+				b += a;
+			}
+			for (; i < chunk; ++i)
+			{
+				a += ptr[i];
+				b += a;
+			}
+			ptr += chunk;
+
+			a %= BASE;
+			b %= BASE;
+		}
+		m_a = a;
+		m_b = b;
+	}
+
+#if defined(CHOCOBO1_HASH_ADLER32_RUNTIME_DISPATCH)
+	template <typename Ops>
+	std::size_t Adler32::addDataSimd(const Byte *ptr, const std::size_t length)
+	{
+		// per block: a += sum(bytes), b += BLOCK_SIZE * a + sum(bytes[i] * (BLOCK_SIZE - i))
+		// the `BLOCK_SIZE * a` terms are summed up as the `a` of every block seen & multiplied once per chunk
+		// returns the number of bytes consumed, whole blocks only
+		const std::size_t blockSize = Ops::BLOCK_SIZE;
+		const std::size_t chunkBlocks = NMAX / blockSize;
+		const std::size_t blocks = length / blockSize;
+
+		typename Ops::Vector a = Ops::set0(m_a);
+		typename Ops::Vector b = Ops::set0(m_b);
+		for (std::size_t done = 0; done < blocks; )
+		{
+			const std::size_t count = std::min(chunkBlocks, (blocks - done));
+
+			// two blocks per iteration, with separate sums to shorten the dependency chains
+			typename Ops::Vector prevA = Ops::zero();
+			typename Ops::Vector prevA2 = Ops::zero();
+			typename Ops::Vector b2 = Ops::zero();
+			std::size_t i = 0;
+			for (; (i + 2) <= count; i += 2)
+			{
+				const typename Ops::Vector x0 = Ops::load(ptr + ((done + i) * blockSize));
+				const typename Ops::Vector x1 = Ops::load(ptr + ((done + i + 1) * blockSize));
+				const typename Ops::Vector s0 = Ops::byteSum(x0);
+				prevA = Ops::add(prevA, a);
+				prevA2 = Ops::add(prevA2, Ops::add(a, s0));
+				a = Ops::add(a, Ops::add(s0, Ops::byteSum(x1)));
+				b = Ops::add(b, Ops::weightedSum(x0));
+				b2 = Ops::add(b2, Ops::weightedSum(x1));
+			}
+			for (; i < count; ++i)
+			{
+				const typename Ops::Vector x = Ops::load(ptr + ((done + i) * blockSize));
+				prevA = Ops::add(prevA, a);
+				a = Ops::add(a, Ops::byteSum(x));
+				b = Ops::add(b, Ops::weightedSum(x));
+			}
+			b = Ops::add(Ops::add(b, b2), Ops::shiftBlock(Ops::add(prevA, prevA2)));
+			done += count;
+
+			// reduce once per chunk
+			a = Ops::set0(Ops::sum(a) % BASE);
+			b = Ops::set0(Ops::sum(b) % BASE);
+		}
+
+		m_a = Ops::sum(a);
+		m_b = Ops::sum(b);
+		return (blocks * blockSize);
+	}
+#endif
+
+	inline std::vector<Adler32::Byte> Adler32::serialize() const
+	{
+		StateWriter writer("Adler32");
+		writer.put(m_a);
+		writer.put(m_b);
+		return writer.data();
+	}
+
+	inline bool Adler32::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "Adler32");
+		const uint32_t a = reader.get<uint32_t>();
+		const uint32_t b = reader.get<uint32_t>();
+		if (!reader.finished() || (a >= BASE) || (b >= BASE))
+			return false;
+
+		m_a = a;
+		m_b = b;
+		return true;
+	}
+}
+}
+	using Adler32 = Hash::Adler32_NS::Adler32;
+}
+
+#endif  // CHOCOBO1_ADLER32_H
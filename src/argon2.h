@@ -0,0 +1,655 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_ARGON2_H
+#define CHOCOBO1_ARGON2_H
+
+#include "blake2.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// Argon2d::hash(const Argon2d::Parameters &params, const Argon2d::Span<const Argon2d::Byte> password, const Argon2d::Span<const Argon2d::Byte> salt, const Argon2d::Span<Argon2d::Byte> output);
+	// Argon2i::hash(const Argon2i::Parameters &params, const Argon2i::Span<const Argon2i::Byte> password, const Argon2i::Span<const Argon2i::Byte> salt, const Argon2i::Span<Argon2i::Byte> output);
+	// Argon2id::hash(const Argon2id::Parameters &params, const Argon2id::Span<const Argon2id::Byte> password, const Argon2id::Span<const Argon2id::Byte> salt, const Argon2id::Span<Argon2id::Byte> output);
+	//   `Parameters` holds the costs (memory, passes, lanes) and the optional secret & associated data
+	//   lanes are filled by up to `Parameters::threads` threads, the memory is backed by huge pages when the OS provides them
+	//   out-of-range costs, a salt shorter than 8 bytes or an output shorter than 4 bytes throw `std::invalid_argument`
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+namespace Argon2_NS
+{
+	using Byte = uint8_t;
+	using Block = std::array<uint64_t, 128>;  // 1 KiB
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+	template <typename T, std::size_t Extent = std::dynamic_extent>
+	using Span = std::span<T, Extent>;
+#else
+	template <typename T, std::size_t Extent = gsl::dynamic_extent>
+	using Span = gsl::span<T, Extent>;
+#endif
+
+	enum class Type
+	{
+		// `y` in the spec
+		D = 0,
+		I = 1,
+		ID = 2
+	};
+
+	class Memory
+	{
+		// storage for the blocks, huge pages cut down the TLB misses of the random reads
+		public:
+			explicit Memory(const std::size_t blocks);
+			Memory(const Memory &) = delete;
+			Memory& operator=(const Memory &) = delete;
+			~Memory();
+
+			Block* data();
+
+		private:
+			Block *m_blocks = nullptr;
+#if defined(__linux__)
+			std::size_t m_mappedSize = 0;
+#endif
+			std::vector<Block> m_fallback;
+	};
+
+	class Barrier
+	{
+		// lanes meet here after each segment
+		public:
+			explicit Barrier(const std::size_t count);
+
+			void arriveAndWait();
+
+		private:
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+			const std::size_t m_count = 0;
+			std::size_t m_arrived = 0;
+			std::size_t m_generation = 0;
+	};
+
+	template <Type T>
+	class Argon2
+	{
+		// https://tools.ietf.org/html/rfc9106
+
+		public:
+			using Byte = uint8_t;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename U, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<U, Extent>;
+#else
+			template <typename U, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<U, Extent>;
+#endif
+
+			struct Parameters
+			{
+				uint32_t memory = 65536;  // KiB, at least `8 * lanes`, rounded down to a multiple of `4 * lanes`
+				uint32_t passes = 3;
+				uint32_t lanes = 1;
+				uint32_t threads = 0;  // threads filling the lanes, 0: one per lane up to the number of cores
+
+				Span<const Byte> secret;  // `K`, optional
+				Span<const Byte> associatedData;  // `X`, optional
+			};
+
+			static constexpr int BLOCK_SIZE = 1024;
+			static constexpr int SYNC_POINTS = 4;  // segments per lane & pass
+
+			// `salt` is at least 8 bytes, `output` is at least 4 bytes
+			// throws `std::invalid_argument` when the parameters are outside of the spec's ranges
+			static void hash(const Parameters &params, const Span<const Byte> password, const Span<const Byte> salt, const Span<Byte> output);
+
+		private:
+			struct Instance
+			{
+				uint32_t passes = 0;
+				uint32_t lanes = 0;
+				uint32_t memoryBlocks = 0;
+				uint32_t laneLength = 0;
+				uint32_t segmentLength = 0;
+				Block *memory = nullptr;
+			};
+
+			static void fillSegment(const Instance &instance, const uint32_t pass, const uint32_t lane, const uint32_t slice);
+			static uint32_t referenceIndex(const Instance &instance, const uint32_t pass, const uint32_t slice, const uint32_t index, const uint32_t pseudoRand, const bool sameLane);
+	};
+
+
+	// helpers
+	inline void hashLong(const Span<Byte> output, const std::initializer_list<Span<const Byte>> inputs)
+	{
+		// H' in the spec, BLAKE2b with an output of any length
+		const std::size_t outputSize = static_cast<std::size_t>(output.size());
+		const Byte outputSizeBytes[4] = {static_cast<Byte>(outputSize), static_cast<Byte>(outputSize >> 8), static_cast<Byte>(outputSize >> 16), static_cast<Byte>(outputSize >> 24)};
+
+		const auto blake2 = [](const std::size_t digestLength) -> Blake2
+		{
+			Blake2::Parameters params;
+			params.digestLength = static_cast<uint8_t>(digestLength);
+			return Blake2(params);
+		};
+
+		Blake2 first = blake2(std::min<std::size_t>(outputSize, 64));
+		first.addData(outputSizeBytes);
+		for (const Span<const Byte> input : inputs)
+			first.addData(input);
+		const std::vector<Byte> v1 = first.finalize().toVector();
+
+		if (outputSize <= 64)
+		{
+			std::copy(v1.begin(), v1.end(), output.begin());
+			return;
+		}
+
+		// the first half of each 64 bytes digest goes to the output, the last digest fills up the rest
+		std::vector<Byte> v = v1;
+		std::size_t offset = 0;
+		for (; (outputSize - offset) > 64; offset += 32)
+		{
+			std::copy(v.begin(), (v.begin() + 32), (output.begin() + offset));
+			const std::size_t nextLength = std::min<std::size_t>((outputSize - offset - 32), 64);
+			v = blake2(nextLength).addData(v.data(), v.size()).finalize().toVector();
+		}
+		std::copy(v.begin(), v.end(), (output.begin() + offset));
+	}
+
+	inline uint64_t blamka(const uint64_t x, const uint64_t y)
+	{
+		const uint64_t mask = 0xFFFFFFFF;
+		return (x + y + (2 * (x & mask) * (y & mask)));
+	}
+
+	inline uint64_t rotr64(const uint64_t x, const unsigned int s)
+	{
+		return ((x >> s) | (x << (64 - s)));
+	}
+
+	inline void gb(uint64_t &a, uint64_t &b, uint64_t &c, uint64_t &d)
+	{
+		a = blamka(a, b);
+		d = rotr64((d ^ a), 32);
+		c = blamka(c, d);
+		b = rotr64((b ^ c), 24);
+		a = blamka(a, b);
+		d = rotr64((d ^ a), 16);
+		c = blamka(c, d);
+		b = rotr64((b ^ c), 63);
+	}
+
+	inline void permute(uint64_t *v, const std::size_t (&idx)[16])
+	{
+		// a BLAKE2b round without the message words
+		gb(v[idx[0]], v[idx[4]], v[idx[8]], v[idx[12]]);
+		gb(v[idx[1]], v[idx[5]], v[idx[9]], v[idx[13]]);
+		gb(v[idx[2]], v[idx[6]], v[idx[10]], v[idx[14]]);
+		gb(v[idx[3]], v[idx[7]], v[idx[11]], v[idx[15]]);
+		gb(v[idx[0]], v[idx[5]], v[idx[10]], v[idx[15]]);
+		gb(v[idx[1]], v[idx[6]], v[idx[11]], v[idx[12]]);
+		gb(v[idx[2]], v[idx[7]], v[idx[8]], v[idx[13]]);
+		gb(v[idx[3]], v[idx[4]], v[idx[9]], v[idx[14]]);
+	}
+
+#if defined(__AVX2__)
+	inline __m256i blamka(const __m256i x, const __m256i y)
+	{
+		const __m256i product = _mm256_mul_epu32(x, y);
+		return _mm256_add_epi64(_mm256_add_epi64(x, y), _mm256_add_epi64(product, product));
+	}
+
+	inline void gb(__m256i &a, __m256i &b, __m256i &c, __m256i &d)
+	{
+		// four G functions at once, one per 64-bit lane
+		const __m256i rotate24 = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+		const __m256i rotate16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+
+		a = blamka(a, b);
+		d = _mm256_shuffle_epi32(_mm256_xor_si256(d, a), 0xb1);
+		c = blamka(c, d);
+		b = _mm256_shuffle_epi8(_mm256_xor_si256(b, c), rotate24);
+		a = blamka(a, b);
+		d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rotate16);
+		c = blamka(c, d);
+		b = _mm256_xor_si256(b, c);
+		b = _mm256_xor_si256(_mm256_srli_epi64(b, 63), _mm256_add_epi64(b, b));
+	}
+
+	inline void permute(__m256i &a, __m256i &b, __m256i &c, __m256i &d)
+	{
+		// columns, then the diagonals are rotated into columns & back
+		gb(a, b, c, d);
+		b = _mm256_permute4x64_epi64(b, 0x39);
+		c = _mm256_permute4x64_epi64(c, 0x4e);
+		d = _mm256_permute4x64_epi64(d, 0x93);
+		gb(a, b, c, d);
+		b = _mm256_permute4x64_epi64(b, 0x93);
+		c = _mm256_permute4x64_epi64(c, 0x4e);
+		d = _mm256_permute4x64_epi64(d, 0x39);
+	}
+
+	inline __m256i loadPairs(const uint64_t *lo, const uint64_t *hi)
+	{
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lo))), _mm_loadu_si128(reinterpret_cast<const __m128i *>(hi)), 1);
+	}
+
+	inline void storePairs(uint64_t *lo, uint64_t *hi, const __m256i x)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(lo), _mm256_castsi256_si128(x));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(hi), _mm256_extracti128_si256(x, 1));
+	}
+#endif
+
+	inline void fillBlock(const Block &prev, const Block &ref, Block &next, const bool withXor)
+	{
+		// G in the spec: the permutation over rows then columns of `prev ^ ref`, `withXor` keeps the old content mixed in
+		Block r;
+		Block q;
+		for (std::size_t i = 0; i < r.size(); ++i)
+		{
+			r[i] = prev[i] ^ ref[i];
+			q[i] = withXor ? (r[i] ^ next[i]) : r[i];
+		}
+
+#if defined(__AVX2__)
+		uint64_t *v = r.data();
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			uint64_t *row = v + (16 * i);
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + 0));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + 4));
+			__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + 8));
+			__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + 12));
+			permute(a, b, c, d);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(row + 0), a);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(row + 4), b);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(row + 8), c);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(row + 12), d);
+		}
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			// a column is 16 words: 2 adjacent words from each row
+			uint64_t *col = v + (2 * i);
+			__m256i a = loadPairs((col + 0), (col + 16));
+			__m256i b = loadPairs((col + 32), (col + 48));
+			__m256i c = loadPairs((col + 64), (col + 80));
+			__m256i d = loadPairs((col + 96), (col + 112));
+			permute(a, b, c, d);
+			storePairs((col + 0), (col + 16), a);
+			storePairs((col + 32), (col + 48), b);
+			storePairs((col + 64), (col + 80), c);
+			storePairs((col + 96), (col + 112), d);
+		}
+#else
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			const std::size_t b = 16 * i;
+			const std::size_t rowIdx[16] = {b, (b + 1), (b + 2), (b + 3), (b + 4), (b + 5), (b + 6), (b + 7)
+				, (b + 8), (b + 9), (b + 10), (b + 11), (b + 12), (b + 13), (b + 14), (b + 15)};
+			permute(r.data(), rowIdx);
+		}
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			const std::size_t b = 2 * i;
+			const std::size_t colIdx[16] = {b, (b + 1), (b + 16), (b + 17), (b + 32), (b + 33), (b + 48), (b + 49)
+				, (b + 64), (b + 65), (b + 80), (b + 81), (b + 96), (b + 97), (b + 112), (b + 113)};
+			permute(r.data(), colIdx);
+		}
+#endif
+
+		for (std::size_t i = 0; i < r.size(); ++i)
+			next[i] = q[i] ^ r[i];
+	}
+
+	inline Memory::Memory(const std::size_t blocks)
+	{
+#if defined(__linux__)
+		// explicit huge pages need a reserved pool, transparent huge pages are the next best thing
+		const std::size_t hugePageSize = 2 * 1024 * 1024;
+		const std::size_t size = blocks * sizeof(Block);
+		const std::size_t hugeSize = (size + hugePageSize - 1) / hugePageSize * hugePageSize;
+
+		void *ptr = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+		if (size >= hugePageSize)
+		{
+			ptr = mmap(nullptr, hugeSize, (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB), -1, 0);
+			if (ptr != MAP_FAILED)
+				m_mappedSize = hugeSize;
+		}
+#endif
+		if (ptr == MAP_FAILED)
+		{
+			ptr = mmap(nullptr, size, (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+			if (ptr != MAP_FAILED)
+			{
+				m_mappedSize = size;
+#if defined(MADV_HUGEPAGE)
+				madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+			}
+		}
+		if (ptr != MAP_FAILED)
+		{
+			m_blocks = static_cast<Block *>(ptr);
+			return;
+		}
+#endif
+
+		m_fallback.resize(blocks);
+		m_blocks = m_fallback.data();
+	}
+
+	inline Memory::~Memory()
+	{
+#if defined(__linux__)
+		if (m_mappedSize > 0)
+			munmap(m_blocks, m_mappedSize);
+#endif
+	}
+
+	inline Block* Memory::data()
+	{
+		return m_blocks;
+	}
+
+	inline Barrier::Barrier(const std::size_t count)
+		: m_count(count)
+	{
+	}
+
+	inline void Barrier::arriveAndWait()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		const std::size_t generation = m_generation;
+		if (++m_arrived == m_count)
+		{
+			m_arrived = 0;
+			++m_generation;
+			m_condition.notify_all();
+			return;
+		}
+
+		m_condition.wait(lock, [this, generation]() { return (generation != m_generation); });
+	}
+
+
+	//
+	template <Type T>
+	void Argon2<T>::hash(const Parameters &params, const Span<const Byte> password, const Span<const Byte> salt, const Span<Byte> output)
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+
+		const uint32_t syncPoints = SYNC_POINTS;
+		const std::size_t lengthMax = 0xFFFFFFFF;
+		if ((params.lanes < 1) || (params.lanes > 0xFFFFFF))
+			throw std::invalid_argument("Argon2: lanes must be in [1, 2^24 - 1]");
+		if (params.passes < 1)
+			throw std::invalid_argument("Argon2: passes must be at least 1");
+		if (params.memory < (2 * syncPoints * params.lanes))
+			throw std::invalid_argument("Argon2: memory must be at least 8 * lanes KiB");
+		if ((salt.size() < 8) || (static_cast<std::size_t>(salt.size()) > lengthMax))
+			throw std::invalid_argument("Argon2: salt must be at least 8 bytes");
+		if ((output.size() < 4) || (static_cast<std::size_t>(output.size()) > lengthMax))
+			throw std::invalid_argument("Argon2: output must be at least 4 bytes");
+		for (const Span<const Byte> input : {password, params.secret, params.associatedData})
+		{
+			if (static_cast<std::size_t>(input.size()) > lengthMax)
+				throw std::invalid_argument("Argon2: inputs must be shorter than 2^32 bytes");
+		}
+
+		const auto le32 = [](const std::size_t value) -> std::array<Byte, 4>
+		{
+			return {{static_cast<Byte>(value), static_cast<Byte>(value >> 8), static_cast<Byte>(value >> 16), static_cast<Byte>(value >> 24)}};
+		};
+		const auto span = [](const std::array<Byte, 4> &a) -> Span<const Byte>
+		{
+			return {a.data(), a.size()};
+		};
+
+		// H_0
+		const std::array<Byte, 4> h0Fields[] = {le32(params.lanes), le32(output.size()), le32(params.memory), le32(params.passes)
+			, le32(0x13), le32(static_cast<uint32_t>(T))};
+		Blake2 h0Hash;
+		for (const auto &field : h0Fields)
+			h0Hash.addData(span(field));
+		for (const Span<const Byte> input : {password, salt, params.secret, params.associatedData})
+		{
+			const std::array<Byte, 4> length = le32(input.size());
+			h0Hash.addData(span(length)).addData(input);
+		}
+		const Blake2::ResultArrayType h0 = h0Hash.finalize().toArray();
+
+		Instance instance;
+		instance.passes = params.passes;
+		instance.lanes = params.lanes;
+		instance.segmentLength = params.memory / (params.lanes * syncPoints);
+		instance.laneLength = instance.segmentLength * syncPoints;
+		instance.memoryBlocks = instance.laneLength * params.lanes;
+
+		Memory memory(instance.memoryBlocks);
+		instance.memory = memory.data();
+
+		// the first 2 blocks of each lane
+		for (uint32_t lane = 0; lane < instance.lanes; ++lane)
+		{
+			for (uint32_t i = 0; i < 2; ++i)
+			{
+				Byte blockBytes[BLOCK_SIZE] = {};
+				const std::array<Byte, 4> indexBytes = le32(i);
+				const std::array<Byte, 4> laneBytes = le32(lane);
+				hashLong(blockBytes, {{h0.data(), h0.size()}, span(indexBytes), span(laneBytes)});
+
+				Block &block = instance.memory[(lane * instance.laneLength) + i];
+				for (std::size_t w = 0; w < block.size(); ++w)
+				{
+					uint64_t word = 0;
+					for (int j = 7; j >= 0; --j)
+						word = (word << 8) | blockBytes[(w * 8) + static_cast<std::size_t>(j)];
+					block[w] = word;
+				}
+			}
+		}
+
+		// a segment only references segments of other lanes from previous slices, lanes of the same slice are independent
+		const unsigned int cores = std::thread::hardware_concurrency();
+		const uint32_t maxThreads = (params.threads > 0) ? params.threads : ((cores == 0) ? 1 : cores);
+		const uint32_t threadCount = std::min(maxThreads, instance.lanes);
+
+		Barrier barrier(threadCount);
+		const auto worker = [&instance, &barrier, threadCount, syncPoints](const uint32_t id) -> void
+		{
+			for (uint32_t pass = 0; pass < instance.passes; ++pass)
+			{
+				for (uint32_t slice = 0; slice < syncPoints; ++slice)
+				{
+					for (uint32_t lane = id; lane < instance.lanes; lane += threadCount)
+						fillSegment(instance, pass, lane, slice);
+					if (threadCount > 1)
+						barrier.arriveAndWait();
+				}
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (uint32_t id = 1; id < threadCount; ++id)
+			workers.emplace_back(worker, id);
+		worker(0);
+		for (auto &w : workers)
+			w.join();
+
+		// XOR of the last column
+		Block last = instance.memory[instance.laneLength - 1];
+		for (uint32_t lane = 1; lane < instance.lanes; ++lane)
+		{
+			const Block &block = instance.memory[(lane * instance.laneLength) + instance.laneLength - 1];
+			for (std::size_t i = 0; i < last.size(); ++i)
+				last[i] ^= block[i];
+		}
+
+		Byte lastBytes[BLOCK_SIZE] = {};
+		for (std::size_t w = 0; w < last.size(); ++w)
+		{
+			for (std::size_t j = 0; j < 8; ++j)
+				lastBytes[(w * 8) + j] = static_cast<Byte>(last[w] >> (j * 8));
+		}
+		hashLong(output, {lastBytes});
+	}
+
+	template <Type T>
+	void Argon2<T>::fillSegment(const Instance &instance, const uint32_t pass, const uint32_t lane, const uint32_t slice)
+	{
+		const uint32_t syncPoints = SYNC_POINTS;
+		const bool dataIndependent = (T == Type::I) || ((T == Type::ID) && (pass == 0) && (slice < (syncPoints / 2)));
+
+		// Argon2i addressing, reference positions come from a counter mode generator instead of the memory
+		const Block zero {};
+		Block input {};
+		Block addresses {};
+		const auto nextAddresses = [&zero, &input, &addresses]() -> void
+		{
+			++input[6];
+			fillBlock(zero, input, addresses, false);
+			fillBlock(zero, addresses, addresses, false);
+		};
+		if (dataIndependent)
+		{
+			input[0] = pass;
+			input[1] = lane;
+			input[2] = slice;
+			input[3] = instance.memoryBlocks;
+			input[4] = instance.passes;
+			input[5] = static_cast<uint64_t>(T);
+		}
+
+		uint32_t start = 0;
+		if ((pass == 0) && (slice == 0))
+		{
+			// the first 2 blocks are already there
+			start = 2;
+			if (dataIndependent)
+				nextAddresses();
+		}
+
+		const uint32_t laneBase = lane * instance.laneLength;
+		uint32_t column = (slice * instance.segmentLength) + start;
+		for (uint32_t i = start; i < instance.segmentLength; ++i, ++column)
+		{
+			const uint32_t prevColumn = (column == 0) ? (instance.laneLength - 1) : (column - 1);
+			const Block &prev = instance.memory[laneBase + prevColumn];
+
+			uint64_t pseudoRand = 0;
+			if (dataIndependent)
+			{
+				if ((i % addresses.size()) == 0)
+					nextAddresses();
+				pseudoRand = addresses[i % addresses.size()];
+			}
+			else
+			{
+				pseudoRand = prev[0];
+			}
+
+			const uint32_t refLane = ((pass == 0) && (slice == 0)) ? lane : static_cast<uint32_t>((pseudoRand >> 32) % instance.lanes);
+			const uint32_t refColumn = referenceIndex(instance, pass, slice, i, static_cast<uint32_t>(pseudoRand), (refLane == lane));
+			const Block &ref = instance.memory[(refLane * instance.laneLength) + refColumn];
+
+			// version 0x13 XORs the new block into the old one on later passes
+			fillBlock(prev, ref, instance.memory[laneBase + column], (pass != 0));
+		}
+	}
+
+	template <Type T>
+	uint32_t Argon2<T>::referenceIndex(const Instance &instance, const uint32_t pass, const uint32_t slice, const uint32_t index, const uint32_t pseudoRand, const bool sameLane)
+	{
+		const uint32_t syncPoints = SYNC_POINTS;
+
+		// blocks that are finished & not being written by other lanes
+		uint32_t areaSize = 0;
+		if (pass == 0)
+		{
+			const uint32_t finished = slice * instance.segmentLength;
+			areaSize = sameLane ? (finished + index - 1) : (finished - ((index == 0) ? 1 : 0));
+		}
+		else
+		{
+			const uint32_t finished = instance.laneLength - instance.segmentLength;
+			areaSize = sameLane ? (finished + index - 1) : (finished - ((index == 0) ? 1 : 0));
+		}
+
+		// biased towards the recent blocks
+		uint64_t relative = pseudoRand;
+		relative = (relative * relative) >> 32;
+		relative = areaSize - 1 - ((areaSize * relative) >> 32);
+
+		const uint32_t startColumn = ((pass == 0) || (slice == (syncPoints - 1))) ? 0 : ((slice + 1) * instance.segmentLength);
+		return static_cast<uint32_t>((startColumn + relative) % instance.laneLength);
+	}
+}
+}
+	using Argon2d = Hash::Argon2_NS::Argon2<Hash::Argon2_NS::Type::D>;
+	using Argon2i = Hash::Argon2_NS::Argon2<Hash::Argon2_NS::Type::I>;
+	using Argon2id = Hash::Argon2_NS::Argon2<Hash::Argon2_NS::Type::ID>;
+}
+
+#endif  // CHOCOBO1_ARGON2_H
@@ -12,12 +12,16 @@
 #ifndef CHOCOBO1_BLAKE1_256_H
 #define CHOCOBO1_BLAKE1_256_H
 
+#include "state_serializer.h"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <climits>
 #include <cmath>
 #include <cstdint>
 #include <initializer_list>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -45,6 +49,11 @@ namespace Chocobo1
 {
 	// Use these!!
 	// Blake1_256();
+	//   `peekDigest()` returns the digest of the data so far without finalizing, more data can follow
+	//   `exportState()` & `importState(State)` copy the raw running state, e.g. hash a shared prefix once & fork it per suffix
+	//   `importState()` throws `std::invalid_argument` unless `State::length` is whole blocks & `State::bufferSize` is less than a block
+	//   `compressBlocks(blocks)` feeds whole 64-byte blocks directly: `blocks.size()` must be a multiple of 64 (block-aligned) & no bytes may be pending from `addData()`, otherwise it throws `std::invalid_argument`
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, `restore()` returns false on a malformed snapshot
 }
 
 
@@ -58,7 +67,7 @@ namespace Hash
 #if __cplusplus >= 201703L
 #define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
 #else
-#define CONSTEXPR_CPP17_CHOCOBO1_HASH
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
 #endif
 #endif
 
@@ -167,6 +176,12 @@ namespace Hash
 
 namespace Blake1_256_NS
 {
+	constexpr uint32_t cTable[16] =
+	{
+		0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0, 0x082efa98, 0xec4e6c89,
+		0x452821e6, 0x38d01377, 0xbe5466cf, 0x34e90c6c, 0xc0ac29b7, 0xc97c50dd, 0x3f84d5b5, 0xb5470917
+	};
+
 	class Blake1_256
 	{
 		// https://131002.net/blake/
@@ -175,6 +190,8 @@ namespace Blake1_256_NS
 			using Byte = uint8_t;
 			using ResultArrayType = std::array<Byte, 32>;
 
+			static constexpr int BLOCK_SIZE = 64;
+
 #if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
 			template <typename T, std::size_t Extent = std::dynamic_extent>
 			using Span = std::span<T, Extent>;
@@ -183,6 +200,15 @@ namespace Blake1_256_NS
 			using Span = gsl::span<T, Extent>;
 #endif
 
+			struct State
+			{
+				// everything `importState()` needs to resume hashing
+				std::array<uint32_t, 8> h {};  // chaining value
+				uint64_t length = 0;  // bytes compressed into `h`
+				std::array<Byte, BLOCK_SIZE> buffer {};  // pending bytes, less than a block
+				std::size_t bufferSize = 0;
+			};
+
 
 			constexpr Blake1_256();
 
@@ -192,6 +218,7 @@ namespace Blake1_256_NS
 			std::string toString() const;
 			std::vector<Byte> toVector() const;
 			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
 
 			constexpr Blake1_256& addData(const Span<const Byte> inData);
 			constexpr Blake1_256& addData(const void *ptr, const std::size_t length);
@@ -202,25 +229,24 @@ namespace Blake1_256_NS
 			template <typename T>
 			Blake1_256& addData(const Span<T> inSpan);
 
+			// raw state access, e.g. hash a shared prefix once & fork it for many suffixes
+			CONSTEXPR_CPP17_CHOCOBO1_HASH State exportState() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH void importState(const State &state);
+			constexpr Blake1_256& compressBlocks(const Span<const Byte> blocks);  // whole blocks only, requires no pending bytes
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
 			constexpr void addDataImpl(const Span<const Byte> data, const int paddingLen = 0);
 
-			static constexpr int BLOCK_SIZE = 64;
-
 			Buffer<Byte, (BLOCK_SIZE * 2)> m_buffer;  // x2 for paddings
 			uint64_t m_sizeCounter = 0;
 
 			uint32_t m_h[8] = {};
-
-			static constexpr uint32_t cTable[16] =
-			{
-				0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0, 0x082efa98, 0xec4e6c89,
-				0x452821e6, 0x38d01377, 0xbe5466cf, 0x34e90c6c, 0xc0ac29b7, 0xc97c50dd, 0x3f84d5b5, 0xb5470917
-			};
 	};
 
-	constexpr uint32_t Blake1_256::cTable[16];
-
 
 	// helpers
 	template <typename T>
@@ -299,7 +325,7 @@ namespace Blake1_256_NS
 		m_buffer.fill(1 << 7);
 
 		// append paddings
-		const int len = static_cast<int>(BLOCK_SIZE - ((m_buffer.size() + 8) % BLOCK_SIZE));
+		const int len = static_cast<int>((BLOCK_SIZE - ((m_buffer.size() + 8) % BLOCK_SIZE)) % BLOCK_SIZE);
 		m_buffer.fill(0, (len + 8));
 
 		m_buffer[m_buffer.size() - 9] |= 1;
@@ -317,7 +343,7 @@ namespace Blake1_256_NS
 		return (*this);
 	}
 
-	std::string Blake1_256::toString() const
+	inline std::string Blake1_256::toString() const
 	{
 		const auto a = toArray();
 		std::string ret;
@@ -336,7 +362,7 @@ namespace Blake1_256_NS
 		return ret;
 	}
 
-	std::vector<Blake1_256::Byte> Blake1_256::toVector() const
+	inline std::vector<Blake1_256::Byte> Blake1_256::toVector() const
 	{
 		const auto a = toArray();
 		return {a.begin(), a.end()};
@@ -358,6 +384,12 @@ namespace Blake1_256_NS
 		return ret;
 	}
 
+	CONSTEXPR_CPP17_CHOCOBO1_HASH Blake1_256::ResultArrayType Blake1_256::peekDigest() const
+	{
+		Blake1_256 copy = *this;
+		return copy.finalize().toArray();
+	}
+
 	constexpr Blake1_256& Blake1_256::addData(const Span<const Byte> inData)
 	{
 		Span<const Byte> data = inData;
@@ -416,6 +448,42 @@ namespace Blake1_256_NS
 		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
 	}
 
+	CONSTEXPR_CPP17_CHOCOBO1_HASH Blake1_256::State Blake1_256::exportState() const
+	{
+		State ret;
+		for (int i = 0; i < 8; ++i)
+			ret.h[i] = m_h[i];
+		ret.length = m_sizeCounter / 8;  // the counter is in bits
+		for (std::size_t i = 0; i < m_buffer.size(); ++i)
+			ret.buffer[i] = m_buffer[i];
+		ret.bufferSize = m_buffer.size();
+		return ret;
+	}
+
+	CONSTEXPR_CPP17_CHOCOBO1_HASH void Blake1_256::importState(const State &state)
+	{
+		if (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE))
+			throw std::invalid_argument("Blake1_256: importState() needs less than a block of pending bytes");
+		if ((state.length % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("Blake1_256: importState() needs a length of whole blocks");
+
+		for (int i = 0; i < 8; ++i)
+			m_h[i] = state.h[i];
+		m_sizeCounter = state.length * 8;
+		m_buffer = {state.buffer.begin(), (state.buffer.begin() + state.bufferSize)};
+	}
+
+	constexpr Blake1_256& Blake1_256::compressBlocks(const Span<const Byte> blocks)
+	{
+		if (!m_buffer.empty())
+			throw std::invalid_argument("Blake1_256: compressBlocks() called with bytes pending from addData()");
+		if ((blocks.size() % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("Blake1_256: compressBlocks() takes whole blocks only");
+
+		addDataImpl(blocks);
+		return (*this);
+	}
+
 	constexpr void Blake1_256::addDataImpl(const Span<const Byte> data, const int paddingLen)
 	{
 		assert((data.size() % BLOCK_SIZE) == 0);
@@ -597,6 +665,37 @@ namespace Blake1_256_NS
 			m_h[7] ^= (v[7] ^ v[15]);
 		}
 	}
+
+	inline std::vector<Blake1_256::Byte> Blake1_256::serialize() const
+	{
+		const State state = exportState();
+
+		StateWriter writer("Blake1_256");
+		for (const auto word : state.h)
+			writer.put(word);
+		writer.put(state.length);
+		writer.put(static_cast<uint32_t>(state.bufferSize));
+		writer.put(state.buffer.data(), state.bufferSize);
+		return writer.data();
+	}
+
+	inline bool Blake1_256::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "Blake1_256");
+		State state;
+		for (auto &word : state.h)
+			word = reader.get<uint32_t>();
+		state.length = reader.get<uint64_t>();
+		state.bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || ((state.length % BLOCK_SIZE) != 0) || (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE)))
+			return false;
+		reader.get(state.buffer.data(), state.bufferSize);
+		if (!reader.finished())
+			return false;
+
+		importState(state);
+		return true;
+	}
 }
 }
 	using Blake1_256 = Hash::Blake1_256_NS::Blake1_256;
@@ -12,12 +12,16 @@
 #ifndef CHOCOBO1_BLAKE1_384_H
 #define CHOCOBO1_BLAKE1_384_H
 
+#include "state_serializer.h"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <climits>
 #include <cmath>
 #include <cstdint>
 #include <initializer_list>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -45,6 +49,11 @@ namespace Chocobo1
 {
 	// Use these!!
 	// Blake1_384();
+	//   `peekDigest()` returns the digest of the data so far without finalizing, more data can follow
+	//   `exportState()` & `importState(State)` copy the raw running state, e.g. hash a shared prefix once & fork it per suffix
+	//   `importState()` throws `std::invalid_argument` unless `State::length` is whole blocks & `State::bufferSize` is less than a block
+	//   `compressBlocks(blocks)` feeds whole 128-byte blocks directly: `blocks.size()` must be a multiple of 128 (block-aligned) & no bytes may be pending from `addData()`, otherwise it throws `std::invalid_argument`
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, `restore()` returns false on a malformed snapshot
 }
 
 
@@ -58,7 +67,7 @@ namespace Hash
 #if __cplusplus >= 201703L
 #define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
 #else
-#define CONSTEXPR_CPP17_CHOCOBO1_HASH
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
 #endif
 #endif
 
@@ -174,6 +183,11 @@ namespace Hash
 			{
 			}
 
+			constexpr Uint128(const uint64_t high, const uint64_t low)
+				: m_lo(low), m_hi(high)
+			{
+			}
+
 			constexpr Uint128& operator= (const uint64_t n)
 			{
 				this->m_lo = n;
@@ -229,6 +243,12 @@ namespace Hash
 
 namespace Blake1_384_NS
 {
+	constexpr uint64_t cTable[16] =
+	{
+		0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0, 0x082efa98ec4e6c89, 0x452821e638d01377, 0xbe5466cf34e90c6c, 0xc0ac29b7c97c50dd, 0x3f84d5b5b5470917,
+		0x9216d5d98979fb1b, 0xd1310ba698dfb5ac, 0x2ffd72dbd01adfb7, 0xb8e1afed6a267e96, 0xba7c9045f12c7f99, 0x24a19947b3916cf7, 0x0801f2e2858efc16, 0x636920d871574e69
+	};
+
 	class Blake1_384
 	{
 		// https://131002.net/blake/
@@ -237,6 +257,8 @@ namespace Blake1_384_NS
 			using Byte = uint8_t;
 			using ResultArrayType = std::array<Byte, 48>;
 
+			static constexpr int BLOCK_SIZE = 128;
+
 #if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
 			template <typename T, std::size_t Extent = std::dynamic_extent>
 			using Span = std::span<T, Extent>;
@@ -245,6 +267,16 @@ namespace Blake1_384_NS
 			using Span = gsl::span<T, Extent>;
 #endif
 
+			struct State
+			{
+				// everything `importState()` needs to resume hashing
+				std::array<uint64_t, 8> h {};  // chaining value
+				uint64_t length = 0;  // bytes compressed into `h`, low 64 bits
+				uint64_t lengthHigh = 0;  // high 64 bits of the 128-bit byte count
+				std::array<Byte, BLOCK_SIZE> buffer {};  // pending bytes, less than a block
+				std::size_t bufferSize = 0;
+			};
+
 
 			constexpr Blake1_384();
 
@@ -254,6 +286,7 @@ namespace Blake1_384_NS
 			std::string toString() const;
 			std::vector<Byte> toVector() const;
 			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
 
 			constexpr Blake1_384& addData(const Span<const Byte> inData);
 			constexpr Blake1_384& addData(const void *ptr, const std::size_t length);
@@ -264,25 +297,24 @@ namespace Blake1_384_NS
 			template <typename T>
 			Blake1_384& addData(const Span<T> inSpan);
 
+			// raw state access, e.g. hash a shared prefix once & fork it for many suffixes
+			CONSTEXPR_CPP17_CHOCOBO1_HASH State exportState() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH void importState(const State &state);
+			constexpr Blake1_384& compressBlocks(const Span<const Byte> blocks);  // whole blocks only, requires no pending bytes
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
 			constexpr void addDataImpl(const Span<const Byte> data, const int paddingLen = 0);
 
-			static constexpr int BLOCK_SIZE = 128;
-
 			Buffer<Byte, (BLOCK_SIZE * 2)> m_buffer;  // x2 for paddings
 			Uint128 m_sizeCounter;
 
 			uint64_t m_h[8] = {};
-
-			static constexpr uint64_t cTable[16] =
-			{
-				0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0, 0x082efa98ec4e6c89, 0x452821e638d01377, 0xbe5466cf34e90c6c, 0xc0ac29b7c97c50dd, 0x3f84d5b5b5470917,
-				0x9216d5d98979fb1b, 0xd1310ba698dfb5ac, 0x2ffd72dbd01adfb7, 0xb8e1afed6a267e96, 0xba7c9045f12c7f99, 0x24a19947b3916cf7, 0x0801f2e2858efc16, 0x636920d871574e69
-			};
 	};
 
-	constexpr uint64_t Blake1_384::cTable[16];
-
 
 	// helpers
 	template <typename T>
@@ -365,7 +397,7 @@ namespace Blake1_384_NS
 		m_buffer.fill(1 << 7);
 
 		// append paddings
-		const int len = static_cast<int>(BLOCK_SIZE - ((m_buffer.size() + 16) % BLOCK_SIZE));
+		const int len = static_cast<int>((BLOCK_SIZE - ((m_buffer.size() + 16) % BLOCK_SIZE)) % BLOCK_SIZE);
 		m_buffer.fill(0, (len + 16));
 
 		// append size in bits
@@ -381,7 +413,7 @@ namespace Blake1_384_NS
 		return (*this);
 	}
 
-	std::string Blake1_384::toString() const
+	inline std::string Blake1_384::toString() const
 	{
 		const auto a = toArray();
 		std::string ret;
@@ -400,7 +432,7 @@ namespace Blake1_384_NS
 		return ret;
 	}
 
-	std::vector<Blake1_384::Byte> Blake1_384::toVector() const
+	inline std::vector<Blake1_384::Byte> Blake1_384::toVector() const
 	{
 		const auto a = toArray();
 		return {a.begin(), a.end()};
@@ -422,6 +454,12 @@ namespace Blake1_384_NS
 		return ret;
 	}
 
+	CONSTEXPR_CPP17_CHOCOBO1_HASH Blake1_384::ResultArrayType Blake1_384::peekDigest() const
+	{
+		Blake1_384 copy = *this;
+		return copy.finalize().toArray();
+	}
+
 	constexpr Blake1_384& Blake1_384::addData(const Span<const Byte> inData)
 	{
 		Span<const Byte> data = inData;
@@ -480,6 +518,44 @@ namespace Blake1_384_NS
 		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
 	}
 
+	CONSTEXPR_CPP17_CHOCOBO1_HASH Blake1_384::State Blake1_384::exportState() const
+	{
+		State ret;
+		for (int i = 0; i < 8; ++i)
+			ret.h[i] = m_h[i];
+		ret.length = (m_sizeCounter.high() << 61) | (m_sizeCounter.low() >> 3);  // the counter is in bits
+		ret.lengthHigh = m_sizeCounter.high() >> 3;
+		for (std::size_t i = 0; i < m_buffer.size(); ++i)
+			ret.buffer[i] = m_buffer[i];
+		ret.bufferSize = m_buffer.size();
+		return ret;
+	}
+
+	CONSTEXPR_CPP17_CHOCOBO1_HASH void Blake1_384::importState(const State &state)
+	{
+		if (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE))
+			throw std::invalid_argument("Blake1_384: importState() needs less than a block of pending bytes");
+		if ((state.length % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("Blake1_384: importState() needs a length of whole blocks");
+
+		for (int i = 0; i < 8; ++i)
+			m_h[i] = state.h[i];
+		m_sizeCounter = Uint128(state.lengthHigh, state.length);
+		m_sizeCounter * 8;  // scales in-place, the counter is in bits
+		m_buffer = {state.buffer.begin(), (state.buffer.begin() + state.bufferSize)};
+	}
+
+	constexpr Blake1_384& Blake1_384::compressBlocks(const Span<const Byte> blocks)
+	{
+		if (!m_buffer.empty())
+			throw std::invalid_argument("Blake1_384: compressBlocks() called with bytes pending from addData()");
+		if ((blocks.size() % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("Blake1_384: compressBlocks() takes whole blocks only");
+
+		addDataImpl(blocks);
+		return (*this);
+	}
+
 	constexpr void Blake1_384::addDataImpl(const Span<const Byte> data, const int paddingLen)
 	{
 		assert((data.size() % BLOCK_SIZE) == 0);
@@ -679,6 +755,39 @@ namespace Blake1_384_NS
 			m_h[7] ^= (v[7] ^ v[15]);
 		}
 	}
+
+	inline std::vector<Blake1_384::Byte> Blake1_384::serialize() const
+	{
+		const State state = exportState();
+
+		StateWriter writer("Blake1_384");
+		for (const auto word : state.h)
+			writer.put(word);
+		writer.put(state.length);
+		writer.put(state.lengthHigh);
+		writer.put(static_cast<uint32_t>(state.bufferSize));
+		writer.put(state.buffer.data(), state.bufferSize);
+		return writer.data();
+	}
+
+	inline bool Blake1_384::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "Blake1_384");
+		State state;
+		for (auto &word : state.h)
+			word = reader.get<uint64_t>();
+		state.length = reader.get<uint64_t>();
+		state.lengthHigh = reader.get<uint64_t>();
+		state.bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || ((state.length % BLOCK_SIZE) != 0) || (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE)))
+			return false;
+		reader.get(state.buffer.data(), state.bufferSize);
+		if (!reader.finished())
+			return false;
+
+		importState(state);
+		return true;
+	}
 }
 }
 	using Blake1_384 = Hash::Blake1_384_NS::Blake1_384;
@@ -12,6 +12,9 @@
 #ifndef CHOCOBO1_BLAKE2_H
 #define CHOCOBO1_BLAKE2_H
 
+#include "state_serializer.h"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <climits>
@@ -40,11 +43,20 @@
 #include "gsl/span"
 #endif
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 
 namespace Chocobo1
 {
 	// Use these!!
 	// Blake2();
+	// Blake2(const Blake2::Parameters &params);  // tree hashing parameters
+	// Blake2(const Blake2::Span<const Blake2::Byte> key);  // keyed hashing (MAC), up to 64 bytes key
+	// Blake2(const Blake2::Span<const Blake2::Byte> key, const Blake2::Parameters &params);
+	//
+	// a keyed instance caches the state after the key block, copy a fresh instance for each message to skip re-hashing the key
 }
 
 
@@ -58,7 +70,7 @@ namespace Hash
 #if __cplusplus >= 201703L
 #define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
 #else
-#define CONSTEXPR_CPP17_CHOCOBO1_HASH
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
 #endif
 #endif
 
@@ -174,6 +186,11 @@ namespace Hash
 			{
 			}
 
+			constexpr Uint128(const uint64_t high, const uint64_t low)
+				: m_lo(low), m_hi(high)
+			{
+			}
+
 			constexpr Uint128& operator= (const uint64_t n)
 			{
 				this->m_lo = n;
@@ -229,6 +246,20 @@ namespace Hash
 
 namespace Blake2_NS
 {
+	constexpr uint8_t sigmaTable[10][16] =
+	{
+		{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+		{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+		{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+		{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+		{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+		{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+		{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+		{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+		{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+		{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 }
+	};
+
 	class Blake2
 	{
 		// https://blake2.net/
@@ -237,6 +268,26 @@ namespace Blake2_NS
 			using Byte = uint8_t;
 			using ResultArrayType = std::array<Byte, 64>;
 
+			struct Parameters
+			{
+				// tree hashing parameters, the defaults are for sequential mode
+				uint8_t digestLength = 64;  // 1 ~ 64 bytes, `toString()` & `toVector()` output this many bytes
+				uint8_t fanout = 1;
+				uint8_t depth = 1;
+				uint32_t leafLength = 0;
+				uint64_t nodeOffset = 0;
+				uint8_t nodeDepth = 0;
+				uint8_t innerLength = 0;
+				bool lastNode = false;
+
+				std::array<Byte, 16> salt = {};
+				std::array<Byte, 16> personalization = {};
+			};
+
+			static constexpr int BLOCK_SIZE = 128;
+			static constexpr int MAX_KEY_SIZE = 64;
+			static constexpr int SIMD_LANES = 4;  // number of states `addBlocks()` & `finalizeBlocks()` process in one pass
+
 #if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
 			template <typename T, std::size_t Extent = std::dynamic_extent>
 			using Span = std::span<T, Extent>;
@@ -247,6 +298,9 @@ namespace Blake2_NS
 
 
 			constexpr Blake2();
+			constexpr explicit Blake2(const Parameters &params);
+			constexpr explicit Blake2(const Span<const Byte> key);
+			constexpr Blake2(const Span<const Byte> key, const Parameters &params);
 
 			constexpr void reset();
 			constexpr Blake2& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `reset()` are available
@@ -254,6 +308,7 @@ namespace Blake2_NS
 			std::string toString() const;
 			std::vector<Byte> toVector() const;
 			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;
+			std::vector<Byte> peekDigest() const;  // digest of the data added so far (`digestLength` bytes), the running state is untouched & more data can follow
 
 			constexpr Blake2& addData(const Span<const Byte> inData);
 			constexpr Blake2& addData(const void *ptr, const std::size_t length);
@@ -264,10 +319,35 @@ namespace Blake2_NS
 			template <typename T>
 			Blake2& addData(const Span<T> inSpan);
 
+			// compress `blocks` whole blocks into each of `states` simultaneously
+			// `data[i]` points to the first block of `states[i]`, consecutive blocks are `stride` bytes apart
+			// the states must not have pending data from `addData()` and none of the blocks can be the final one
+			template <std::size_t N>
+			static void addBlocks(Blake2 *const (&states)[N], const Byte *const (&data)[N], const std::size_t blocks, const std::size_t stride = BLOCK_SIZE);
+
+			// finalize each of `states` simultaneously, `data[i]` holds the last `length` bytes of `states[i]`
+			// the states must not have pending data from `addData()`
+			template <std::size_t N>
+			static void finalizeBlocks(Blake2 *const (&states)[N], const Byte *const (&data)[N], const std::size_t length);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// restore into an instance constructed with the same parameters
+			// keyed instances give an empty snapshot, their running state is as secret as the key itself
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
+			constexpr void initState();
 			constexpr void addDataImpl(const Span<const Byte> data, const bool isFinal, const int paddingLen = 0);
+#if defined(__AVX2__)
+			static void addBlocksAvx2(Blake2 *const *states, const Byte *const *data, const std::size_t blocks, const std::size_t stride, const bool isFinal = false, const int paddingLen = 0);
+#endif
 
-			static constexpr int BLOCK_SIZE = 128;
+			Parameters m_params;
+
+			Byte m_key[MAX_KEY_SIZE] = {};
+			int m_keyLength = 0;
+			uint64_t m_keyedH[8] = {};  // state after the key block
 
 			Buffer<Byte, BLOCK_SIZE> m_buffer;
 			Uint128 m_sizeCounter;
@@ -332,24 +412,100 @@ namespace Blake2_NS
 
 	//
 	constexpr Blake2::Blake2()
+		: Blake2(Parameters {})
+	{
+	}
+
+	constexpr Blake2::Blake2(const Parameters &params)
+		: Blake2({}, params)
+	{
+	}
+
+	constexpr Blake2::Blake2(const Span<const Byte> key)
+		: Blake2(key, Parameters {})
+	{
+	}
+
+	constexpr Blake2::Blake2(const Span<const Byte> key, const Parameters &params)
+		: m_params(params)
 	{
 		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+		assert((m_params.digestLength > 0) && (m_params.digestLength <= 64));
+		assert(key.size() <= MAX_KEY_SIZE);
+
+		m_keyLength = static_cast<int>(key.size());
+		for (int i = 0; i < m_keyLength; ++i)
+			m_key[i] = key[i];
+
+		if (m_keyLength > 0)
+		{
+			// the key is the first block, padded with zeros
+			Byte block[BLOCK_SIZE] = {};
+			for (int i = 0; i < m_keyLength; ++i)
+				block[i] = m_key[i];
+
+			initState();
+			m_sizeCounter = 0;
+			addDataImpl({block, BLOCK_SIZE}, false);
+			for (int i = 0; i < 8; ++i)
+				m_keyedH[i] = m_h[i];
+		}
+
 		reset();
 	}
 
 	constexpr void Blake2::reset()
 	{
 		m_buffer.clear();
-		m_sizeCounter = 0;
 
+		if (m_keyLength > 0)
+		{
+			m_sizeCounter = BLOCK_SIZE;
+			for (int i = 0; i < 8; ++i)
+				m_h[i] = m_keyedH[i];
+		}
+		else
+		{
+			m_sizeCounter = 0;
+			initState();
+		}
+	}
+
+	constexpr void Blake2::initState()
+	{
 		for (int i = 0; i < 8; ++i)
 			m_h[i] = m_initializationVector[i];
 
-		m_h[0] ^= (0x01010000 ^ (0 << 8) ^ 64);
+		// parameter block
+		m_h[0] ^= ((static_cast<uint64_t>(m_params.leafLength) << 32)
+			^ (static_cast<uint64_t>(m_params.depth) << 24)
+			^ (static_cast<uint64_t>(m_params.fanout) << 16)
+			^ (static_cast<uint64_t>(m_keyLength) << 8)
+			^ m_params.digestLength);
+		m_h[1] ^= m_params.nodeOffset;
+		m_h[2] ^= ((static_cast<uint64_t>(m_params.innerLength) << 8) ^ m_params.nodeDepth);
+		for (int i = 0; i < 16; ++i)
+		{
+			m_h[4 + (i / 8)] ^= (static_cast<uint64_t>(m_params.salt[i]) << ((i % 8) * 8));
+			m_h[6 + (i / 8)] ^= (static_cast<uint64_t>(m_params.personalization[i]) << ((i % 8) * 8));
+		}
 	}
 
 	constexpr Blake2& Blake2::finalize()
 	{
+		if ((m_keyLength > 0) && m_buffer.empty() && (m_sizeCounter.low() == BLOCK_SIZE) && (m_sizeCounter.high() == 0))
+		{
+			// empty message, the key block is also the last block
+			Byte block[BLOCK_SIZE] = {};
+			for (int i = 0; i < m_keyLength; ++i)
+				block[i] = m_key[i];
+
+			initState();
+			m_sizeCounter = 0;
+			addDataImpl({block, BLOCK_SIZE}, true);
+			return (*this);
+		}
+
 		// append paddings
 		const int len = static_cast<int>(BLOCK_SIZE - m_buffer.size());
 		m_buffer.fill(0, len);
@@ -360,15 +516,16 @@ namespace Blake2_NS
 		return (*this);
 	}
 
-	std::string Blake2::toString() const
+	inline std::string Blake2::toString() const
 	{
 		const auto a = toArray();
 		std::string ret;
-		ret.resize(2 * a.size());
+		ret.resize(2 * m_params.digestLength);
 
 		auto retPtr = &ret.front();
-		for (const auto c : a)
+		for (int i = 0; i < m_params.digestLength; ++i)
 		{
+			const Byte c = a[i];
 			const Byte upper = ror<Byte>(c, 4);
 			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
 
@@ -379,10 +536,10 @@ namespace Blake2_NS
 		return ret;
 	}
 
-	std::vector<Blake2::Byte> Blake2::toVector() const
+	inline std::vector<Blake2::Byte> Blake2::toVector() const
 	{
 		const auto a = toArray();
-		return {a.begin(), a.end()};
+		return {a.begin(), (a.begin() + m_params.digestLength)};
 	}
 
 	CONSTEXPR_CPP17_CHOCOBO1_HASH Blake2::ResultArrayType Blake2::toArray() const
@@ -398,9 +555,19 @@ namespace Blake2_NS
 				*(retPtr++) = ror<Byte>(i, (j * 8));
 		}
 
+		// truncated digest, zero the unused bytes
+		for (std::size_t i = m_params.digestLength; i < ret.size(); ++i)
+			ret[i] = 0;
+
 		return ret;
 	}
 
+	inline std::vector<Blake2::Byte> Blake2::peekDigest() const
+	{
+		Blake2 copy = *this;
+		return copy.finalize().toVector();
+	}
+
 	constexpr Blake2& Blake2::addData(const Span<const Byte> inData)
 	{
 		if (inData.empty())
@@ -477,7 +644,7 @@ namespace Blake2_NS
 				m_initializationVector[4] ^ m_sizeCounter.low(),
 				m_initializationVector[5] ^ m_sizeCounter.high(),
 				isFinal ? ~m_initializationVector[6] : m_initializationVector[6],
-				m_initializationVector[7]
+				(isFinal && m_params.lastNode) ? ~m_initializationVector[7] : m_initializationVector[7]
 			};
 
 			#ifdef blakeMix
@@ -604,6 +771,200 @@ namespace Blake2_NS
 			m_h[7] ^= (v[7] ^ v[15]);
 		}
 	}
+
+	template <std::size_t N>
+	void Blake2::addBlocks(Blake2 *const (&states)[N], const Byte *const (&data)[N], const std::size_t blocks, const std::size_t stride)
+	{
+#if defined(__AVX2__)
+		if (N == SIMD_LANES)
+		{
+			addBlocksAvx2(states, data, blocks, stride);
+			return;
+		}
+#endif
+
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			assert(states[i]->m_buffer.empty());
+			for (std::size_t iter = 0; iter < blocks; ++iter)
+				states[i]->addDataImpl({(data[i] + (iter * stride)), BLOCK_SIZE}, false);
+		}
+	}
+
+	template <std::size_t N>
+	void Blake2::finalizeBlocks(Blake2 *const (&states)[N], const Byte *const (&data)[N], const std::size_t length)
+	{
+		assert(length <= BLOCK_SIZE);
+
+		Byte blocks[N][BLOCK_SIZE] = {};
+		const Byte *blockPtrs[N] = {};
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			assert(states[i]->m_buffer.empty());
+			for (std::size_t j = 0; j < length; ++j)
+				blocks[i][j] = data[i][j];
+			blockPtrs[i] = blocks[i];
+		}
+
+		const int paddingLen = static_cast<int>(BLOCK_SIZE - length);
+#if defined(__AVX2__)
+		if (N == SIMD_LANES)
+		{
+			addBlocksAvx2(states, blockPtrs, 1, BLOCK_SIZE, true, paddingLen);
+			return;
+		}
+#endif
+
+		for (std::size_t i = 0; i < N; ++i)
+			states[i]->addDataImpl({blockPtrs[i], BLOCK_SIZE}, true, paddingLen);
+	}
+
+#if defined(__AVX2__)
+	inline void Blake2::addBlocksAvx2(Blake2 *const *states, const Byte *const *data, const std::size_t blocks, const std::size_t stride, const bool isFinal, const int paddingLen)
+	{
+		// 4 states in the 4 64-bit lanes of AVX2 registers
+		const __m256i rotr16Mask = _mm256_setr_epi8(
+			2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+			2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+		const __m256i rotr24Mask = _mm256_setr_epi8(
+			3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+			3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+
+		const auto gather = [](const uint64_t a, const uint64_t b, const uint64_t c, const uint64_t d) -> __m256i
+		{
+			return _mm256_set_epi64x(static_cast<long long>(d), static_cast<long long>(c), static_cast<long long>(b), static_cast<long long>(a));
+		};
+
+		__m256i h[8];
+		for (int i = 0; i < 8; ++i)
+		{
+			assert(states[i % 4]->m_buffer.empty());
+			h[i] = gather(states[0]->m_h[i], states[1]->m_h[i], states[2]->m_h[i], states[3]->m_h[i]);
+		}
+
+		const uint64_t *iv = states[0]->m_initializationVector;
+		for (std::size_t iter = 0; iter < blocks; ++iter)
+		{
+			const Loader<uint64_t> m0(data[0] + (iter * stride));
+			const Loader<uint64_t> m1(data[1] + (iter * stride));
+			const Loader<uint64_t> m2(data[2] + (iter * stride));
+			const Loader<uint64_t> m3(data[3] + (iter * stride));
+
+			__m256i m[16];
+			for (int i = 0; i < 16; ++i)
+				m[i] = gather(m0[i], m1[i], m2[i], m3[i]);
+
+			for (int i = 0; i < 4; ++i)
+				states[i]->m_sizeCounter += (BLOCK_SIZE - paddingLen);
+
+			const auto lastNode = [isFinal, iv, states](const int i) -> uint64_t
+			{
+				return (isFinal && states[i]->m_params.lastNode) ? ~iv[7] : iv[7];
+			};
+
+			__m256i v[16] =
+			{
+				h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+				gather(iv[0], iv[0], iv[0], iv[0]), gather(iv[1], iv[1], iv[1], iv[1]),
+				gather(iv[2], iv[2], iv[2], iv[2]), gather(iv[3], iv[3], iv[3], iv[3]),
+				gather((iv[4] ^ states[0]->m_sizeCounter.low()), (iv[4] ^ states[1]->m_sizeCounter.low()),
+					(iv[4] ^ states[2]->m_sizeCounter.low()), (iv[4] ^ states[3]->m_sizeCounter.low())),
+				gather((iv[5] ^ states[0]->m_sizeCounter.high()), (iv[5] ^ states[1]->m_sizeCounter.high()),
+					(iv[5] ^ states[2]->m_sizeCounter.high()), (iv[5] ^ states[3]->m_sizeCounter.high())),
+				isFinal ? gather(~iv[6], ~iv[6], ~iv[6], ~iv[6]) : gather(iv[6], iv[6], iv[6], iv[6]),
+				gather(lastNode(0), lastNode(1), lastNode(2), lastNode(3))
+			};
+
+			const auto mix = [&v, &rotr16Mask, &rotr24Mask](const int a, const int b, const int c, const int d, const __m256i x, const __m256i y)
+			{
+				v[a] = _mm256_add_epi64(_mm256_add_epi64(v[a], v[b]), x);
+				v[d] = _mm256_shuffle_epi32(_mm256_xor_si256(v[d], v[a]), _MM_SHUFFLE(2, 3, 0, 1));
+				v[c] = _mm256_add_epi64(v[c], v[d]);
+				v[b] = _mm256_shuffle_epi8(_mm256_xor_si256(v[b], v[c]), rotr24Mask);
+				v[a] = _mm256_add_epi64(_mm256_add_epi64(v[a], v[b]), y);
+				v[d] = _mm256_shuffle_epi8(_mm256_xor_si256(v[d], v[a]), rotr16Mask);
+				v[c] = _mm256_add_epi64(v[c], v[d]);
+				const __m256i t = _mm256_xor_si256(v[b], v[c]);
+				v[b] = _mm256_or_si256(_mm256_srli_epi64(t, 63), _mm256_add_epi64(t, t));
+			};
+
+			for (int round = 0; round < 12; ++round)
+			{
+				const uint8_t *s = sigmaTable[round % 10];
+				mix(0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+				mix(1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+				mix(2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+				mix(3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+				mix(0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+				mix(1, 6, 11, 12, m[s[10]], m[s[11]]);
+				mix(2, 7,  8, 13, m[s[12]], m[s[13]]);
+				mix(3, 4,  9, 14, m[s[14]], m[s[15]]);
+			}
+
+			for (int i = 0; i < 8; ++i)
+				h[i] = _mm256_xor_si256(h[i], _mm256_xor_si256(v[i], v[i + 8]));
+		}
+
+		for (int i = 0; i < 8; ++i)
+		{
+			alignas(32) uint64_t lanes[4] = {};
+			_mm256_store_si256(reinterpret_cast<__m256i *>(lanes), h[i]);
+			for (int j = 0; j < 4; ++j)
+				states[j]->m_h[i] = lanes[j];
+		}
+	}
+#endif
+
+	inline std::vector<Blake2::Byte> Blake2::serialize() const
+	{
+		if (m_keyLength > 0)
+			return {};
+
+		// the digest of the empty message pins the parameters
+		Blake2 fresh = *this;
+		fresh.reset();
+		const ResultArrayType fingerprint = fresh.finalize().toArray();
+
+		StateWriter writer("Blake2");
+		writer.put(fingerprint.data(), fingerprint.size());
+		for (const auto word : m_h)
+			writer.put(word);
+		writer.put(m_sizeCounter.low());
+		writer.put(m_sizeCounter.high());
+		writer.put(static_cast<uint32_t>(m_buffer.size()));
+		writer.put(m_buffer.data(), m_buffer.size());
+		return writer.data();
+	}
+
+	inline bool Blake2::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "Blake2");
+		ResultArrayType fingerprint {};
+		reader.get(fingerprint.data(), fingerprint.size());
+		uint64_t h[8] = {};
+		for (auto &word : h)
+			word = reader.get<uint64_t>();
+		const uint64_t counterLow = reader.get<uint64_t>();
+		const uint64_t counterHigh = reader.get<uint64_t>();
+		const uint32_t bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || (bufferSize > BLOCK_SIZE))
+			return false;
+		Byte buffer[BLOCK_SIZE] = {};
+		reader.get(buffer, bufferSize);
+		if (!reader.finished())
+			return false;
+
+		Blake2 fresh = *this;
+		fresh.reset();
+		if (fresh.finalize().toArray() != fingerprint)
+			return false;
+
+		for (int i = 0; i < 8; ++i)
+			m_h[i] = h[i];
+		m_sizeCounter = Uint128(counterHigh, counterLow);
+		m_buffer = {buffer, (buffer + bufferSize)};
+		return true;
+	}
 }
 }
 	using Blake2 = Hash::Blake2_NS::Blake2;
@@ -12,6 +12,9 @@
 #ifndef CHOCOBO1_BLAKE2S_H
 #define CHOCOBO1_BLAKE2S_H
 
+#include "state_serializer.h"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <climits>
@@ -40,11 +43,20 @@
 #include "gsl/span"
 #endif
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 
 namespace Chocobo1
 {
 	// Use these!!
 	// Blake2s();
+	// Blake2s(const Blake2s::Parameters &params);  // tree hashing parameters
+	// Blake2s(const Blake2s::Span<const Blake2s::Byte> key);  // keyed hashing (MAC), up to 32 bytes key
+	// Blake2s(const Blake2s::Span<const Blake2s::Byte> key, const Blake2s::Parameters &params);
+	//
+	// a keyed instance caches the state after the key block, copy a fresh instance for each message to skip re-hashing the key
 }
 
 
@@ -58,7 +70,7 @@ namespace Hash
 #if __cplusplus >= 201703L
 #define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
 #else
-#define CONSTEXPR_CPP17_CHOCOBO1_HASH
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
 #endif
 #endif
 
@@ -167,6 +179,20 @@ namespace Hash
 
 namespace Blake2s_NS
 {
+	constexpr uint8_t sigmaTable[10][16] =
+	{
+		{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+		{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+		{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+		{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+		{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+		{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+		{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+		{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+		{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+		{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 }
+	};
+
 	class Blake2s
 	{
 		// https://blake2.net/
@@ -175,6 +201,26 @@ namespace Blake2s_NS
 			using Byte = uint8_t;
 			using ResultArrayType = std::array<Byte, 32>;
 
+			struct Parameters
+			{
+				// tree hashing parameters, the defaults are for sequential mode
+				uint8_t digestLength = 32;  // 1 ~ 32 bytes, `toString()` & `toVector()` output this many bytes
+				uint8_t fanout = 1;
+				uint8_t depth = 1;
+				uint32_t leafLength = 0;
+				uint64_t nodeOffset = 0;  // 48 bits
+				uint8_t nodeDepth = 0;
+				uint8_t innerLength = 0;
+				bool lastNode = false;
+
+				std::array<Byte, 8> salt = {};
+				std::array<Byte, 8> personalization = {};
+			};
+
+			static constexpr int BLOCK_SIZE = 64;
+			static constexpr int MAX_KEY_SIZE = 32;
+			static constexpr int SIMD_LANES = 8;  // number of states `addBlocks()` & `finalizeBlocks()` process in one pass
+
 #if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
 			template <typename T, std::size_t Extent = std::dynamic_extent>
 			using Span = std::span<T, Extent>;
@@ -185,6 +231,9 @@ namespace Blake2s_NS
 
 
 			constexpr Blake2s();
+			constexpr explicit Blake2s(const Parameters &params);
+			constexpr explicit Blake2s(const Span<const Byte> key);
+			constexpr Blake2s(const Span<const Byte> key, const Parameters &params);
 
 			constexpr void reset();
 			constexpr Blake2s& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `reset()` are available
@@ -192,6 +241,7 @@ namespace Blake2s_NS
 			std::string toString() const;
 			std::vector<Byte> toVector() const;
 			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;
+			std::vector<Byte> peekDigest() const;  // digest of the data added so far (`digestLength` bytes), the running state is untouched & more data can follow
 
 			constexpr Blake2s& addData(const Span<const Byte> inData);
 			constexpr Blake2s& addData(const void *ptr, const std::size_t length);
@@ -202,10 +252,35 @@ namespace Blake2s_NS
 			template <typename T>
 			Blake2s& addData(const Span<T> inSpan);
 
+			// compress `blocks` whole blocks into each of `states` simultaneously
+			// `data[i]` points to the first block of `states[i]`, consecutive blocks are `stride` bytes apart
+			// the states must not have pending data from `addData()` and none of the blocks can be the final one
+			template <std::size_t N>
+			static void addBlocks(Blake2s *const (&states)[N], const Byte *const (&data)[N], const std::size_t blocks, const std::size_t stride = BLOCK_SIZE);
+
+			// finalize each of `states` simultaneously, `data[i]` holds the last `length` bytes of `states[i]`
+			// the states must not have pending data from `addData()`
+			template <std::size_t N>
+			static void finalizeBlocks(Blake2s *const (&states)[N], const Byte *const (&data)[N], const std::size_t length);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// restore into an instance constructed with the same parameters
+			// keyed instances give an empty snapshot, their running state is as secret as the key itself
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
+			constexpr void initState();
 			constexpr void addDataImpl(const Span<const Byte> data, const bool isFinal, const int paddingLen = 0);
+#if defined(__AVX2__)
+			static void addBlocksAvx2(Blake2s *const *states, const Byte *const *data, const std::size_t blocks, const std::size_t stride, const bool isFinal = false, const int paddingLen = 0);
+#endif
 
-			static constexpr int BLOCK_SIZE = 64;
+			Parameters m_params;
+
+			Byte m_key[MAX_KEY_SIZE] = {};
+			int m_keyLength = 0;
+			uint32_t m_keyedH[8] = {};  // state after the key block
 
 			Buffer<Byte, BLOCK_SIZE> m_buffer;
 			uint64_t m_sizeCounter = 0;
@@ -266,24 +341,102 @@ namespace Blake2s_NS
 
 	//
 	constexpr Blake2s::Blake2s()
+		: Blake2s(Parameters {})
+	{
+	}
+
+	constexpr Blake2s::Blake2s(const Parameters &params)
+		: Blake2s({}, params)
+	{
+	}
+
+	constexpr Blake2s::Blake2s(const Span<const Byte> key)
+		: Blake2s(key, Parameters {})
+	{
+	}
+
+	constexpr Blake2s::Blake2s(const Span<const Byte> key, const Parameters &params)
+		: m_params(params)
 	{
 		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+		assert((m_params.digestLength > 0) && (m_params.digestLength <= 32));
+		assert(key.size() <= MAX_KEY_SIZE);
+
+		m_keyLength = static_cast<int>(key.size());
+		for (int i = 0; i < m_keyLength; ++i)
+			m_key[i] = key[i];
+
+		if (m_keyLength > 0)
+		{
+			// the key is the first block, padded with zeros
+			Byte block[BLOCK_SIZE] = {};
+			for (int i = 0; i < m_keyLength; ++i)
+				block[i] = m_key[i];
+
+			initState();
+			m_sizeCounter = 0;
+			addDataImpl({block, BLOCK_SIZE}, false);
+			for (int i = 0; i < 8; ++i)
+				m_keyedH[i] = m_h[i];
+		}
+
 		reset();
 	}
 
 	constexpr void Blake2s::reset()
 	{
 		m_buffer.clear();
-		m_sizeCounter = 0;
 
+		if (m_keyLength > 0)
+		{
+			m_sizeCounter = BLOCK_SIZE;
+			for (int i = 0; i < 8; ++i)
+				m_h[i] = m_keyedH[i];
+		}
+		else
+		{
+			m_sizeCounter = 0;
+			initState();
+		}
+	}
+
+	constexpr void Blake2s::initState()
+	{
 		for (int i = 0; i < 8; ++i)
 			m_h[i] = m_initializationVector[i];
 
-		m_h[0] ^= (0x01010000 ^ (0 << 8) ^ 32);
+		// parameter block
+		m_h[0] ^= ((static_cast<uint32_t>(m_params.depth) << 24)
+			^ (static_cast<uint32_t>(m_params.fanout) << 16)
+			^ (static_cast<uint32_t>(m_keyLength) << 8)
+			^ m_params.digestLength);
+		m_h[1] ^= m_params.leafLength;
+		m_h[2] ^= ror<uint32_t>(m_params.nodeOffset, 0);
+		m_h[3] ^= ((static_cast<uint32_t>(m_params.innerLength) << 24)
+			^ (static_cast<uint32_t>(m_params.nodeDepth) << 16)
+			^ ror<uint32_t>((m_params.nodeOffset & 0xFFFF00000000), 32));
+		for (int i = 0; i < 8; ++i)
+		{
+			m_h[4 + (i / 4)] ^= (static_cast<uint32_t>(m_params.salt[i]) << ((i % 4) * 8));
+			m_h[6 + (i / 4)] ^= (static_cast<uint32_t>(m_params.personalization[i]) << ((i % 4) * 8));
+		}
 	}
 
 	constexpr Blake2s& Blake2s::finalize()
 	{
+		if ((m_keyLength > 0) && m_buffer.empty() && (m_sizeCounter == BLOCK_SIZE))
+		{
+			// empty message, the key block is also the last block
+			Byte block[BLOCK_SIZE] = {};
+			for (int i = 0; i < m_keyLength; ++i)
+				block[i] = m_key[i];
+
+			initState();
+			m_sizeCounter = 0;
+			addDataImpl({block, BLOCK_SIZE}, true);
+			return (*this);
+		}
+
 		// append paddings
 		const int len = static_cast<int>(BLOCK_SIZE - m_buffer.size());
 		m_buffer.fill(0, len);
@@ -294,15 +447,16 @@ namespace Blake2s_NS
 		return (*this);
 	}
 
-	std::string Blake2s::toString() const
+	inline std::string Blake2s::toString() const
 	{
 		const auto a = toArray();
 		std::string ret;
-		ret.resize(2 * a.size());
+		ret.resize(2 * m_params.digestLength);
 
 		auto retPtr = &ret.front();
-		for (const auto c : a)
+		for (int i = 0; i < m_params.digestLength; ++i)
 		{
+			const Byte c = a[i];
 			const Byte upper = ror<Byte>(c, 4);
 			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
 
@@ -313,10 +467,10 @@ namespace Blake2s_NS
 		return ret;
 	}
 
-	std::vector<Blake2s::Byte> Blake2s::toVector() const
+	inline std::vector<Blake2s::Byte> Blake2s::toVector() const
 	{
 		const auto a = toArray();
-		return {a.begin(), a.end()};
+		return {a.begin(), (a.begin() + m_params.digestLength)};
 	}
 
 	CONSTEXPR_CPP17_CHOCOBO1_HASH Blake2s::ResultArrayType Blake2s::toArray() const
@@ -332,9 +486,19 @@ namespace Blake2s_NS
 				*(retPtr++) = ror<Byte>(i, (j * 8));
 		}
 
+		// truncated digest, zero the unused bytes
+		for (std::size_t i = m_params.digestLength; i < ret.size(); ++i)
+			ret[i] = 0;
+
 		return ret;
 	}
 
+	inline std::vector<Blake2s::Byte> Blake2s::peekDigest() const
+	{
+		Blake2s copy = *this;
+		return copy.finalize().toVector();
+	}
+
 	constexpr Blake2s& Blake2s::addData(const Span<const Byte> inData)
 	{
 		if (inData.empty())
@@ -411,7 +575,7 @@ namespace Blake2s_NS
 				m_initializationVector[4] ^ ror<uint32_t>(m_sizeCounter, 0),
 				m_initializationVector[5] ^ ror<uint32_t>(m_sizeCounter, 32),
 				isFinal ? ~m_initializationVector[6] : m_initializationVector[6],
-				m_initializationVector[7]
+				(isFinal && m_params.lastNode) ? ~m_initializationVector[7] : m_initializationVector[7]
 			};
 
 			#ifdef blakeMix
@@ -522,6 +686,204 @@ namespace Blake2s_NS
 			m_h[7] ^= (v[7] ^ v[15]);
 		}
 	}
+
+	template <std::size_t N>
+	void Blake2s::addBlocks(Blake2s *const (&states)[N], const Byte *const (&data)[N], const std::size_t blocks, const std::size_t stride)
+	{
+#if defined(__AVX2__)
+		if (N == SIMD_LANES)
+		{
+			addBlocksAvx2(states, data, blocks, stride);
+			return;
+		}
+#endif
+
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			assert(states[i]->m_buffer.empty());
+			for (std::size_t iter = 0; iter < blocks; ++iter)
+				states[i]->addDataImpl({(data[i] + (iter * stride)), BLOCK_SIZE}, false);
+		}
+	}
+
+	template <std::size_t N>
+	void Blake2s::finalizeBlocks(Blake2s *const (&states)[N], const Byte *const (&data)[N], const std::size_t length)
+	{
+		assert(length <= BLOCK_SIZE);
+
+		Byte blocks[N][BLOCK_SIZE] = {};
+		const Byte *blockPtrs[N] = {};
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			assert(states[i]->m_buffer.empty());
+			for (std::size_t j = 0; j < length; ++j)
+				blocks[i][j] = data[i][j];
+			blockPtrs[i] = blocks[i];
+		}
+
+		const int paddingLen = static_cast<int>(BLOCK_SIZE - length);
+#if defined(__AVX2__)
+		if (N == SIMD_LANES)
+		{
+			addBlocksAvx2(states, blockPtrs, 1, BLOCK_SIZE, true, paddingLen);
+			return;
+		}
+#endif
+
+		for (std::size_t i = 0; i < N; ++i)
+			states[i]->addDataImpl({blockPtrs[i], BLOCK_SIZE}, true, paddingLen);
+	}
+
+#if defined(__AVX2__)
+	inline void Blake2s::addBlocksAvx2(Blake2s *const *states, const Byte *const *data, const std::size_t blocks, const std::size_t stride, const bool isFinal, const int paddingLen)
+	{
+		// 8 states in the 8 32-bit lanes of AVX2 registers
+		const __m256i rotr16Mask = _mm256_setr_epi8(
+			2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+			2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+		const __m256i rotr8Mask = _mm256_setr_epi8(
+			1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+			1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+
+		const auto gather = [](const uint32_t (&lanes)[8]) -> __m256i
+		{
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lanes));
+		};
+		const auto broadcast = [](const uint32_t x) -> __m256i
+		{
+			return _mm256_set1_epi32(static_cast<int>(x));
+		};
+
+		__m256i h[8];
+		for (int i = 0; i < 8; ++i)
+		{
+			assert(states[i]->m_buffer.empty());
+			uint32_t lanes[8] = {};
+			for (int j = 0; j < 8; ++j)
+				lanes[j] = states[j]->m_h[i];
+			h[i] = gather(lanes);
+		}
+
+		const uint32_t *iv = states[0]->m_initializationVector;
+		for (std::size_t iter = 0; iter < blocks; ++iter)
+		{
+			__m256i m[16];
+			for (int i = 0; i < 16; ++i)
+			{
+				uint32_t lanes[8] = {};
+				for (int j = 0; j < 8; ++j)
+					lanes[j] = Loader<uint32_t>(data[j] + (iter * stride))[i];
+				m[i] = gather(lanes);
+			}
+
+			uint32_t counterLow[8] = {};
+			uint32_t counterHigh[8] = {};
+			uint32_t lastNode[8] = {};
+			for (int j = 0; j < 8; ++j)
+			{
+				states[j]->m_sizeCounter += (BLOCK_SIZE - paddingLen);
+				counterLow[j] = iv[4] ^ ror<uint32_t>(states[j]->m_sizeCounter, 0);
+				counterHigh[j] = iv[5] ^ ror<uint32_t>(states[j]->m_sizeCounter, 32);
+				lastNode[j] = (isFinal && states[j]->m_params.lastNode) ? ~iv[7] : iv[7];
+			}
+
+			__m256i v[16] =
+			{
+				h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+				broadcast(iv[0]), broadcast(iv[1]), broadcast(iv[2]), broadcast(iv[3]),
+				gather(counterLow), gather(counterHigh),
+				broadcast(isFinal ? ~iv[6] : iv[6]), gather(lastNode)
+			};
+
+			const auto mix = [&v, &rotr16Mask, &rotr8Mask](const int a, const int b, const int c, const int d, const __m256i x, const __m256i y)
+			{
+				v[a] = _mm256_add_epi32(_mm256_add_epi32(v[a], v[b]), x);
+				v[d] = _mm256_shuffle_epi8(_mm256_xor_si256(v[d], v[a]), rotr16Mask);
+				v[c] = _mm256_add_epi32(v[c], v[d]);
+				const __m256i t1 = _mm256_xor_si256(v[b], v[c]);
+				v[b] = _mm256_or_si256(_mm256_srli_epi32(t1, 12), _mm256_slli_epi32(t1, 20));
+				v[a] = _mm256_add_epi32(_mm256_add_epi32(v[a], v[b]), y);
+				v[d] = _mm256_shuffle_epi8(_mm256_xor_si256(v[d], v[a]), rotr8Mask);
+				v[c] = _mm256_add_epi32(v[c], v[d]);
+				const __m256i t2 = _mm256_xor_si256(v[b], v[c]);
+				v[b] = _mm256_or_si256(_mm256_srli_epi32(t2, 7), _mm256_slli_epi32(t2, 25));
+			};
+
+			for (int round = 0; round < 10; ++round)
+			{
+				const uint8_t *s = sigmaTable[round];
+				mix(0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+				mix(1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+				mix(2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+				mix(3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+				mix(0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+				mix(1, 6, 11, 12, m[s[10]], m[s[11]]);
+				mix(2, 7,  8, 13, m[s[12]], m[s[13]]);
+				mix(3, 4,  9, 14, m[s[14]], m[s[15]]);
+			}
+
+			for (int i = 0; i < 8; ++i)
+				h[i] = _mm256_xor_si256(h[i], _mm256_xor_si256(v[i], v[i + 8]));
+		}
+
+		for (int i = 0; i < 8; ++i)
+		{
+			uint32_t lanes[8] = {};
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), h[i]);
+			for (int j = 0; j < 8; ++j)
+				states[j]->m_h[i] = lanes[j];
+		}
+	}
+#endif
+
+	inline std::vector<Blake2s::Byte> Blake2s::serialize() const
+	{
+		if (m_keyLength > 0)
+			return {};
+
+		// the digest of the empty message pins the parameters
+		Blake2s fresh = *this;
+		fresh.reset();
+		const ResultArrayType fingerprint = fresh.finalize().toArray();
+
+		StateWriter writer("Blake2s");
+		writer.put(fingerprint.data(), fingerprint.size());
+		for (const auto word : m_h)
+			writer.put(word);
+		writer.put(m_sizeCounter);
+		writer.put(static_cast<uint32_t>(m_buffer.size()));
+		writer.put(m_buffer.data(), m_buffer.size());
+		return writer.data();
+	}
+
+	inline bool Blake2s::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "Blake2s");
+		ResultArrayType fingerprint {};
+		reader.get(fingerprint.data(), fingerprint.size());
+		uint32_t h[8] = {};
+		for (auto &word : h)
+			word = reader.get<uint32_t>();
+		const uint64_t counter = reader.get<uint64_t>();
+		const uint32_t bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || (bufferSize > BLOCK_SIZE))
+			return false;
+		Byte buffer[BLOCK_SIZE] = {};
+		reader.get(buffer, bufferSize);
+		if (!reader.finished())
+			return false;
+
+		Blake2s fresh = *this;
+		fresh.reset();
+		if (fresh.finalize().toArray() != fingerprint)
+			return false;
+
+		for (int i = 0; i < 8; ++i)
+			m_h[i] = h[i];
+		m_sizeCounter = counter;
+		m_buffer = {buffer, (buffer + bufferSize)};
+		return true;
+	}
 }
 }
 	using Blake2s = Hash::Blake2s_NS::Blake2s;
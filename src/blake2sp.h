@@ -0,0 +1,353 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_BLAKE2SP_H
+#define CHOCOBO1_BLAKE2SP_H
+
+#include "blake2s.h"
+#include "state_serializer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// Blake2sp();
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+namespace Blake2sp_NS
+{
+	class Blake2sp
+	{
+		// https://blake2.net/blake2.pdf
+		// section 2.10: 8 BLAKE2s leaves hashing interleaved blocks, 1 BLAKE2s root hashing the leaf digests
+
+		public:
+			using Byte = uint8_t;
+			using ResultArrayType = Blake2s_NS::Blake2s::ResultArrayType;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			Blake2sp();
+
+			void reset();
+			Blake2sp& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+			ResultArrayType toArray() const;
+
+			Blake2sp& addData(const Span<const Byte> inData);
+			Blake2sp& addData(const void *ptr, const std::size_t length);
+			template <typename T, std::size_t N>
+			Blake2sp& addData(const T (&array)[N]);
+			template <typename T>
+			Blake2sp& addData(const Span<T> inSpan);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			void addDataImpl(const Span<const Byte> data);
+
+			static Blake2s_NS::Blake2s::Parameters leafParameters(const int index);
+			static Blake2s_NS::Blake2s::Parameters rootParameters();
+
+			static constexpr int PARALLELISM = 8;
+			static constexpr int BLOCK_SIZE = Blake2s_NS::Blake2s::BLOCK_SIZE;
+			static constexpr int STRIPE_SIZE = PARALLELISM * BLOCK_SIZE;
+
+			// inputs at least this large are split across threads, one leaf each
+			// the 7 helper threads are started & joined within the call, no pool is kept: smaller inputs stay on the
+			// calling thread, at this size starting them is a small fraction of the hashing
+			static constexpr std::size_t THREAD_THRESHOLD = 1024 * 1024;
+
+			// a stripe is only compressed when more than `STRIPE_SIZE` bytes follow it,
+			// otherwise it may contain the final block of some leaf
+			Buffer<Byte, (STRIPE_SIZE * 2)> m_buffer;
+
+			Blake2s_NS::Blake2s m_leaves[PARALLELISM];
+			ResultArrayType m_result {};
+	};
+
+
+	//
+	inline Blake2sp::Blake2sp()
+		: m_leaves {Blake2s_NS::Blake2s(leafParameters(0)), Blake2s_NS::Blake2s(leafParameters(1))
+			, Blake2s_NS::Blake2s(leafParameters(2)), Blake2s_NS::Blake2s(leafParameters(3))
+			, Blake2s_NS::Blake2s(leafParameters(4)), Blake2s_NS::Blake2s(leafParameters(5))
+			, Blake2s_NS::Blake2s(leafParameters(6)), Blake2s_NS::Blake2s(leafParameters(7))}
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+	}
+
+	inline void Blake2sp::reset()
+	{
+		m_buffer.clear();
+		m_result = {};
+
+		for (auto &leaf : m_leaves)
+			leaf.reset();
+	}
+
+	inline Blake2sp& Blake2sp::finalize()
+	{
+		// the remaining stripes go through the leaves' own buffering so the final blocks are flagged properly
+		for (std::size_t offset = 0; offset < m_buffer.size(); offset += BLOCK_SIZE)
+		{
+			const std::size_t len = std::min<std::size_t>(BLOCK_SIZE, (m_buffer.size() - offset));
+			m_leaves[(offset / BLOCK_SIZE) % PARALLELISM].addData((m_buffer.data() + offset), len);
+		}
+		m_buffer.clear();
+
+		Blake2s_NS::Blake2s root(rootParameters());
+		for (auto &leaf : m_leaves)
+		{
+			const auto digest = leaf.finalize().toArray();
+			root.addData(digest.data(), digest.size());
+		}
+		m_result = root.finalize().toArray();
+
+		return (*this);
+	}
+
+	inline std::string Blake2sp::toString() const
+	{
+		const auto a = toArray();
+		std::string ret;
+		ret.resize(2 * a.size());
+
+		auto retPtr = &ret.front();
+		for (const auto c : a)
+		{
+			const Byte upper = Blake2s_NS::ror<Byte>(c, 4);
+			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
+
+			const Byte lower = c & 0xf;
+			*(retPtr++) = static_cast<char>((lower < 10) ? (lower + '0') : (lower - 10 + 'a'));
+		}
+
+		return ret;
+	}
+
+	inline std::vector<Blake2sp::Byte> Blake2sp::toVector() const
+	{
+		const auto a = toArray();
+		return {a.begin(), a.end()};
+	}
+
+	inline Blake2sp::ResultArrayType Blake2sp::toArray() const
+	{
+		return m_result;
+	}
+
+	inline Blake2sp& Blake2sp::addData(const Span<const Byte> inData)
+	{
+		Span<const Byte> data = inData;
+
+		while (!data.empty())
+		{
+			if (!m_buffer.empty())
+			{
+				const std::size_t len = std::min<std::size_t>(((STRIPE_SIZE * 2) - m_buffer.size()), data.size());
+				m_buffer.push_back(data.begin(), (data.begin() + len));
+				data = data.subspan(len);
+
+				if (data.empty())
+					break;
+
+				// buffer is full and more data follows
+				if (data.size() > STRIPE_SIZE)
+				{
+					addDataImpl({m_buffer.data(), m_buffer.size()});
+					m_buffer.clear();
+				}
+				else
+				{
+					addDataImpl({m_buffer.data(), STRIPE_SIZE});
+					m_buffer = {(m_buffer.data() + STRIPE_SIZE), (m_buffer.data() + m_buffer.size())};
+				}
+				continue;
+			}
+
+			if (data.size() > (STRIPE_SIZE * 2))
+			{
+				// process data in bulk, leave `STRIPE_SIZE + 1` to `STRIPE_SIZE * 2` bytes
+				const std::size_t stripes = (data.size() - STRIPE_SIZE - 1) / STRIPE_SIZE;
+				const std::size_t len = stripes * STRIPE_SIZE;
+				addDataImpl(data.first(len));
+				data = data.subspan(len);
+			}
+
+			m_buffer = {data.begin(), data.end()};
+			break;
+		}
+
+		return (*this);
+	}
+
+	inline Blake2sp& Blake2sp::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <typename T, std::size_t N>
+	Blake2sp& Blake2sp::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename T>
+	Blake2sp& Blake2sp::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	inline std::vector<Blake2sp::Byte> Blake2sp::serialize() const
+	{
+		StateWriter writer("Blake2sp");
+		writer.putNested({m_buffer.data(), (m_buffer.data() + m_buffer.size())});
+		for (const auto &leaf : m_leaves)
+			writer.putNested(leaf.serialize());
+		return writer.data();
+	}
+
+	inline bool Blake2sp::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "Blake2sp");
+		const std::vector<Byte> buffer = reader.getNested();
+		std::vector<Byte> leafSnapshots[PARALLELISM];
+		for (auto &leafSnapshot : leafSnapshots)
+			leafSnapshot = reader.getNested();
+		if (!reader.finished() || (buffer.size() > (STRIPE_SIZE * 2)))
+			return false;
+
+		// all or nothing, the leaves are only touched once every snapshot restores into a copy
+		for (int i = 0; i < PARALLELISM; ++i)
+		{
+			Blake2s_NS::Blake2s leaf = m_leaves[i];
+			if (!leaf.restore({leafSnapshots[i].data(), leafSnapshots[i].size()}))
+				return false;
+		}
+		for (int i = 0; i < PARALLELISM; ++i)
+			m_leaves[i].restore({leafSnapshots[i].data(), leafSnapshots[i].size()});
+
+		m_buffer = {buffer.data(), (buffer.data() + buffer.size())};
+		m_result = {};
+		return true;
+	}
+
+	inline void Blake2sp::addDataImpl(const Span<const Byte> data)
+	{
+		assert((data.size() % STRIPE_SIZE) == 0);
+
+		const std::size_t stripes = static_cast<std::size_t>(data.size() / STRIPE_SIZE);
+		const Byte *leafData[PARALLELISM] = {};
+		Blake2s_NS::Blake2s *leaves[PARALLELISM] = {};
+		for (int i = 0; i < PARALLELISM; ++i)
+		{
+			leafData[i] = data.data() + (i * BLOCK_SIZE);
+			leaves[i] = &m_leaves[i];
+		}
+
+		const unsigned int cores = std::thread::hardware_concurrency();
+		if ((static_cast<std::size_t>(data.size()) >= THREAD_THRESHOLD) && (cores != 1))
+		{
+			std::thread workers[PARALLELISM - 1];
+			for (int i = 1; i < PARALLELISM; ++i)
+			{
+				workers[i - 1] = std::thread([&leaves, &leafData, stripes, i]()
+				{
+					Blake2s_NS::Blake2s::addBlocks({leaves[i]}, {leafData[i]}, stripes, STRIPE_SIZE);
+				});
+			}
+			Blake2s_NS::Blake2s::addBlocks({leaves[0]}, {leafData[0]}, stripes, STRIPE_SIZE);
+
+			for (auto &worker : workers)
+				worker.join();
+			return;
+		}
+
+		Blake2s_NS::Blake2s::addBlocks(leaves, leafData, stripes, STRIPE_SIZE);
+	}
+
+	inline Blake2s_NS::Blake2s::Parameters Blake2sp::leafParameters(const int index)
+	{
+		Blake2s_NS::Blake2s::Parameters params;
+		params.fanout = PARALLELISM;
+		params.depth = 2;
+		params.nodeOffset = static_cast<uint64_t>(index);
+		params.nodeDepth = 0;
+		params.innerLength = std::tuple_size<ResultArrayType>::value;
+		params.lastNode = (index == (PARALLELISM - 1));
+		return params;
+	}
+
+	inline Blake2s_NS::Blake2s::Parameters Blake2sp::rootParameters()
+	{
+		Blake2s_NS::Blake2s::Parameters params;
+		params.fanout = PARALLELISM;
+		params.depth = 2;
+		params.nodeOffset = 0;
+		params.nodeDepth = 1;
+		params.innerLength = std::tuple_size<ResultArrayType>::value;
+		params.lastNode = true;
+		return params;
+	}
+}
+}
+	using Blake2sp = Hash::Blake2sp_NS::Blake2sp;
+}
+
+#endif  // CHOCOBO1_BLAKE2SP_H
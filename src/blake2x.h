@@ -0,0 +1,334 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_BLAKE2X_H
+#define CHOCOBO1_BLAKE2X_H
+
+#include "blake2.h"
+#include "blake2s.h"
+#include "state_serializer.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// Blake2Xb(const int digestLengthInBytes);  // 1 ~ `Blake2Xb::MAX_DIGEST_LENGTH` (INT_MAX)
+	// Blake2Xs(const int digestLengthInBytes);  // 1 ~ `Blake2Xs::MAX_DIGEST_LENGTH` (2^16 - 2)
+	//   other lengths throw `std::invalid_argument`
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, restore into an instance constructed with the same length
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+namespace Blake2X_NS
+{
+	template <typename B>  // `B`: Blake2 or Blake2s
+	class Blake2X
+	{
+		// https://blake2.net/blake2x.pdf
+		// the input is hashed once, each output block is then an independent BLAKE2 hash of the root digest
+
+		public:
+			using Byte = uint8_t;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+			// the XOF length field is 32 bits for BLAKE2Xb and 16 bits for BLAKE2Xs, its maximum value is reserved
+			static constexpr int MAX_DIGEST_LENGTH = (std::tuple_size<typename B::ResultArrayType>::value == 64) ? INT_MAX : 0xFFFE;
+
+
+			explicit Blake2X(const int digestLength);
+
+			void reset();
+			Blake2X& finalize();  // after this, only `toString()`, `toVector()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+
+			Blake2X& addData(const Span<const Byte> inData);
+			Blake2X& addData(const void *ptr, const std::size_t length);
+			template <typename T, std::size_t N>
+			Blake2X& addData(const T (&array)[N]);
+			template <typename T>
+			Blake2X& addData(const Span<T> inSpan);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// restore into an instance constructed with the same digest length
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			using RootDigestType = typename B::ResultArrayType;
+
+			void generateBlocks(const RootDigestType &rootDigest, const std::size_t first, const std::size_t last);
+			template <std::size_t... I>
+			std::array<B, sizeof...(I)> makeBlockStates(const std::size_t first, const std::size_t last, std::index_sequence<I...>) const;
+
+			static int checkDigestLength(const int digestLength);
+			typename B::Parameters rootParameters() const;
+			typename B::Parameters blockParameters(const std::size_t index) const;
+
+			static constexpr int OUTPUT_SIZE = static_cast<int>(std::tuple_size<RootDigestType>::value);
+			// the XOF length field is 32 bits for BLAKE2Xb and 16 bits for BLAKE2Xs, the maximum value means "unknown"
+			static constexpr uint64_t UNKNOWN_LENGTH = (OUTPUT_SIZE == 64) ? 0xFFFFFFFF : 0xFFFF;
+
+			// outputs at least this large are split across threads
+			static constexpr std::size_t THREAD_THRESHOLD = 1024 * 1024;
+
+			const int m_digestLength;
+
+			B m_root;
+			std::vector<Byte> m_final;
+	};
+
+
+	//
+	template <typename B>
+	Blake2X<B>::Blake2X(const int digestLength)
+		: m_digestLength(checkDigestLength(digestLength))
+		, m_root(rootParameters())
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+	}
+
+	template <typename B>
+	void Blake2X<B>::reset()
+	{
+		m_root.reset();
+		m_final.clear();
+	}
+
+	template <typename B>
+	Blake2X<B>& Blake2X<B>::finalize()
+	{
+		const RootDigestType rootDigest = m_root.finalize().toArray();
+
+		const std::size_t blocks = static_cast<std::size_t>((m_digestLength + OUTPUT_SIZE - 1) / OUTPUT_SIZE);
+		m_final.resize(static_cast<std::size_t>(m_digestLength));
+
+		const unsigned int cores = std::thread::hardware_concurrency();
+		if ((m_final.size() >= THREAD_THRESHOLD) && (cores != 1))
+		{
+			const std::size_t threadCount = (cores == 0) ? 2 : cores;
+			// keep the SIMD groups intact
+			const std::size_t perThread = (((blocks + threadCount - 1) / threadCount) + B::SIMD_LANES - 1) / B::SIMD_LANES * B::SIMD_LANES;
+
+			std::vector<std::thread> workers;
+			for (std::size_t first = perThread; first < blocks; first += perThread)
+			{
+				const std::size_t last = std::min((first + perThread), blocks);
+				workers.emplace_back([this, &rootDigest, first, last]()
+				{
+					generateBlocks(rootDigest, first, last);
+				});
+			}
+			generateBlocks(rootDigest, 0, std::min(perThread, blocks));
+
+			for (auto &worker : workers)
+				worker.join();
+		}
+		else
+		{
+			generateBlocks(rootDigest, 0, blocks);
+		}
+
+		return (*this);
+	}
+
+	template <typename B>
+	std::string Blake2X<B>::toString() const
+	{
+		const auto v = toVector();
+		std::string ret;
+		ret.resize(2 * v.size());
+
+		auto retPtr = &ret.front();
+		for (const auto c : v)
+		{
+			const Byte upper = static_cast<Byte>(c >> 4);
+			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
+
+			const Byte lower = c & 0xf;
+			*(retPtr++) = static_cast<char>((lower < 10) ? (lower + '0') : (lower - 10 + 'a'));
+		}
+
+		return ret;
+	}
+
+	template <typename B>
+	std::vector<typename Blake2X<B>::Byte> Blake2X<B>::toVector() const
+	{
+		return m_final;
+	}
+
+	template <typename B>
+	Blake2X<B>& Blake2X<B>::addData(const Span<const Byte> inData)
+	{
+		m_root.addData(inData);
+		return (*this);
+	}
+
+	template <typename B>
+	Blake2X<B>& Blake2X<B>::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <typename B>
+	template <typename T, std::size_t N>
+	Blake2X<B>& Blake2X<B>::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename B>
+	template <typename T>
+	Blake2X<B>& Blake2X<B>::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	template <typename B>
+	std::vector<typename Blake2X<B>::Byte> Blake2X<B>::serialize() const
+	{
+		// the root parameters carry the digest length, `B::restore()` checks them
+		StateWriter writer("Blake2X");
+		writer.putNested(m_root.serialize());
+		return writer.data();
+	}
+
+	template <typename B>
+	bool Blake2X<B>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "Blake2X");
+		const std::vector<Byte> root = reader.getNested();
+		if (!reader.finished() || !m_root.restore({root.data(), root.size()}))
+			return false;
+
+		m_final.clear();
+		return true;
+	}
+
+	template <typename B>
+	void Blake2X<B>::generateBlocks(const RootDigestType &rootDigest, const std::size_t first, const std::size_t last)
+	{
+		// output blocks `[first, last)`, `B::SIMD_LANES` blocks at a time
+		for (std::size_t i = first; i < last; i += B::SIMD_LANES)
+		{
+			auto states = makeBlockStates(i, last, std::make_index_sequence<B::SIMD_LANES>());
+
+			B *statePtrs[B::SIMD_LANES] = {};
+			const Byte *data[B::SIMD_LANES] = {};
+			for (int lane = 0; lane < B::SIMD_LANES; ++lane)
+			{
+				statePtrs[lane] = &states[lane];
+				data[lane] = rootDigest.data();
+			}
+			B::finalizeBlocks(statePtrs, data, rootDigest.size());
+
+			for (std::size_t lane = 0; (lane < B::SIMD_LANES) && ((i + lane) < last); ++lane)
+			{
+				const std::size_t offset = (i + lane) * OUTPUT_SIZE;
+				const std::size_t len = std::min<std::size_t>(OUTPUT_SIZE, (m_final.size() - offset));
+				const auto digest = states[lane].toArray();
+				std::copy(digest.begin(), (digest.begin() + len), (m_final.begin() + offset));
+			}
+		}
+	}
+
+	template <typename B>
+	template <std::size_t... I>
+	std::array<B, sizeof...(I)> Blake2X<B>::makeBlockStates(const std::size_t first, const std::size_t last, std::index_sequence<I...>) const
+	{
+		// surplus lanes past `last` duplicate the last block, their results are discarded
+		return {{B(blockParameters(std::min((first + I), (last - 1))))...}};
+	}
+
+	template <typename B>
+	int Blake2X<B>::checkDigestLength(const int digestLength)
+	{
+		// out of range lengths would wrap around in the XOF length field, `UNKNOWN_LENGTH` itself is reserved
+		static_assert((static_cast<uint64_t>(MAX_DIGEST_LENGTH) < UNKNOWN_LENGTH), "MAX_DIGEST_LENGTH doesn't fit the XOF length field");
+		if ((digestLength < 1) || (digestLength > MAX_DIGEST_LENGTH))
+			throw std::invalid_argument("Blake2X: digest length out of range");
+		return digestLength;
+	}
+
+	template <typename B>
+	typename B::Parameters Blake2X<B>::rootParameters() const
+	{
+		typename B::Parameters params;
+		params.nodeOffset = static_cast<uint64_t>(m_digestLength) << 32;  // XOF digest length
+		return params;
+	}
+
+	template <typename B>
+	typename B::Parameters Blake2X<B>::blockParameters(const std::size_t index) const
+	{
+		const std::size_t remaining = static_cast<std::size_t>(m_digestLength) - (index * OUTPUT_SIZE);
+
+		typename B::Parameters params;
+		params.digestLength = static_cast<uint8_t>(std::min<std::size_t>(OUTPUT_SIZE, remaining));
+		params.fanout = 0;
+		params.depth = 0;
+		params.leafLength = OUTPUT_SIZE;
+		params.nodeOffset = (static_cast<uint64_t>(m_digestLength) << 32) | static_cast<uint64_t>(index);
+		params.nodeDepth = 0;
+		params.innerLength = OUTPUT_SIZE;
+		return params;
+	}
+}
+}
+	using Blake2Xb = Hash::Blake2X_NS::Blake2X<Hash::Blake2_NS::Blake2>;
+	using Blake2Xs = Hash::Blake2X_NS::Blake2X<Hash::Blake2s_NS::Blake2s>;
+}
+
+#endif  // CHOCOBO1_BLAKE2X_H
@@ -0,0 +1,1084 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_BLAKE3_H
+#define CHOCOBO1_BLAKE3_H
+
+#include "state_serializer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// Blake3();
+	// Blake3(const Blake3::KeyArrayType &key);  // keyed hash mode
+	// Blake3(const std::string &context);  // key derivation mode
+	//   `addData()` splits subtrees of at least 1 MiB across threads, which are started & joined within each call, there's no pool
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+#ifndef CONSTEXPR_CPP17_CHOCOBO1_HASH
+#if __cplusplus >= 201703L
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
+#else
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+	using IndexType = std::size_t;
+#else
+	using IndexType = gsl::index;
+#endif
+
+#ifndef CHOCOBO1_HASH_BUFFER_IMPL
+#define CHOCOBO1_HASH_BUFFER_IMPL
+	template <typename T, IndexType N>
+	class Buffer
+	{
+		public:
+			using value_type = T;
+			using index_type = IndexType;
+			using size_type = std::size_t;
+
+			constexpr Buffer() = default;
+			constexpr Buffer(const Buffer &) = default;
+
+			constexpr Buffer(const std::initializer_list<T> initList)
+			{
+#if !defined(NDEBUG)
+				// check if out-of-bounds
+				static_cast<void>(m_array.at(m_dataEndIdx + initList.size() - 1));
+#endif
+
+				for (const auto &i : initList)
+				{
+					m_array[m_dataEndIdx] = i;
+					++m_dataEndIdx;
+				}
+			}
+
+			template <typename InputIt>
+			constexpr Buffer(const InputIt first, const InputIt last)
+			{
+				for (InputIt iter = first; iter != last; ++iter)
+				{
+					this->fill(*iter);
+				}
+			}
+
+			constexpr T& operator[](const index_type pos)
+			{
+				return m_array[pos];
+			}
+
+			constexpr T operator[](const index_type pos) const
+			{
+				return m_array[pos];
+			}
+
+			constexpr void fill(const T &value, const index_type count = 1)
+			{
+#if !defined(NDEBUG)
+				// check if out-of-bounds
+				static_cast<void>(m_array.at(m_dataEndIdx + count - 1));
+#endif
+
+				for (index_type i = 0; i < count; ++i)
+				{
+					m_array[m_dataEndIdx] = value;
+					++m_dataEndIdx;
+				}
+			}
+
+			template <typename InputIt>
+			constexpr void push_back(const InputIt first, const InputIt last)
+			{
+				for (InputIt iter = first; iter != last; ++iter)
+				{
+					this->fill(*iter);
+				}
+			}
+
+			constexpr void clear()
+			{
+				m_array = {};
+				m_dataEndIdx = 0;
+			}
+
+			constexpr bool empty() const
+			{
+				return (m_dataEndIdx == 0);
+			}
+
+			constexpr size_type size() const
+			{
+				return m_dataEndIdx;
+			}
+
+			constexpr const T* data() const
+			{
+				return m_array.data();
+			}
+
+		private:
+			std::array<T, N> m_array {};
+			index_type m_dataEndIdx = 0;
+	};
+#endif
+
+
+namespace Blake3_NS
+{
+	constexpr uint32_t initializationVector[8] =
+	{
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+
+	constexpr uint8_t messageSchedule[7][16] =
+	{
+		{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+		{  2,  6,  3, 10,  7,  0,  4, 13,  1, 11, 12,  5,  9, 14, 15,  8 },
+		{  3,  4, 10, 12, 13,  2,  7, 14,  6,  5,  9,  0, 11, 15,  8,  1 },
+		{ 10,  7, 12,  9, 14,  3, 13, 15,  4,  0, 11,  2,  5,  8,  1,  6 },
+		{ 12, 13,  9, 11, 15, 10, 14,  8,  7,  2,  5,  3,  0,  1,  6,  4 },
+		{  9, 14, 11,  5,  8, 12, 15,  1, 13,  3,  0, 10,  2,  6,  4,  7 },
+		{ 11, 15,  5,  0,  1,  9,  8,  6, 14, 10,  2, 12,  3,  4,  7, 13 }
+	};
+
+	class Blake3
+	{
+		// https://github.com/BLAKE3-team/BLAKE3-specs/blob/master/blake3.pdf
+
+		public:
+			using Byte = uint8_t;
+			using ResultArrayType = std::array<Byte, 32>;
+			using KeyArrayType = std::array<Byte, 32>;
+
+			static constexpr int BLOCK_SIZE = 64;
+			static constexpr int CHUNK_SIZE = 1024;
+#if defined(__AVX512F__)
+			static constexpr int SIMD_LANES = 16;  // number of chunks compressed in one pass
+#else
+			static constexpr int SIMD_LANES = 8;  // number of chunks compressed in one pass
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			Blake3();
+			explicit Blake3(const KeyArrayType &key);
+			explicit Blake3(const std::string &context);  // `context` should be hardcoded, globally unique and application-specific
+
+			void reset();
+			Blake3& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+			std::vector<Byte> toVector(const std::size_t length) const;  // extendable output
+			ResultArrayType toArray() const;
+			ResultArrayType peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
+
+			Blake3& addData(const Span<const Byte> inData);
+			Blake3& addData(const void *ptr, const std::size_t length);
+			template <typename T, std::size_t N>
+			Blake3& addData(const T (&array)[N]);
+			template <typename T>
+			Blake3& addData(const Span<T> inSpan);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// keyed & key derivation instances give an empty snapshot, their running state is as secret as the key or key material
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			using KeyWords = std::array<uint32_t, 8>;
+
+			// domain separation flags
+			static constexpr uint32_t CHUNK_START = 1 << 0;
+			static constexpr uint32_t CHUNK_END = 1 << 1;
+			static constexpr uint32_t PARENT = 1 << 2;
+			static constexpr uint32_t ROOT = 1 << 3;
+			static constexpr uint32_t KEYED_HASH = 1 << 4;
+			static constexpr uint32_t DERIVE_KEY_CONTEXT = 1 << 5;
+			static constexpr uint32_t DERIVE_KEY_MATERIAL = 1 << 6;
+
+			struct Output
+			{
+				// everything needed to compress a node, kept unfinished so it can become the root
+				uint32_t inputCv[8] = {};
+				Byte block[BLOCK_SIZE] = {};
+				uint32_t blockLength = 0;
+				uint64_t counter = 0;
+				uint32_t flags = 0;
+			};
+
+			Blake3(const KeyWords &key, const uint32_t flags);
+
+			static KeyWords contextKey(const std::string &context);
+
+			static void compress(const uint32_t (&cv)[8], const Byte *block, const uint32_t blockLength, const uint64_t counter, const uint32_t flags, uint32_t (&out)[16]);
+			static void chainingValue(const Output &output, Byte *out);
+			static void rootBytes(const Output &output, Byte *out, const std::size_t length);
+
+			// hash `inputs` inputs of `blocks` whole blocks each, input `i` starts at `data + (i * stride)`
+			// writes a 32 bytes chaining value per input to `out`
+			static void hashMany(const Byte *data, const std::size_t inputs, const std::size_t stride, const std::size_t blocks
+				, const uint32_t (&key)[8], const uint64_t counter, const bool incrementCounter, const uint32_t flags, const uint32_t flagsStart, const uint32_t flagsEnd, Byte *out);
+			static void hashOne(const Byte *data, const std::size_t blocks, const uint32_t (&key)[8], const uint64_t counter
+				, const uint32_t flags, const uint32_t flagsStart, const uint32_t flagsEnd, Byte *out);
+#if defined(__AVX2__) || defined(__AVX512F__)
+			template <typename Ops>
+			static void hashManySimd(const Byte *data, const std::size_t stride, const std::size_t blocks, const uint32_t (&key)[8], const uint64_t counter
+				, const bool incrementCounter, const uint32_t flags, const uint32_t flagsStart, const uint32_t flagsEnd, Byte *out);
+#endif
+
+			// `chunks` is a power of 2, writes the chaining value of the subtree to `out`
+			// `threads` is the number of threads the subtree may occupy
+			void hashSubtree(const Byte *data, const std::size_t chunks, const uint64_t counter, Byte *out, const unsigned int threads) const;
+
+			// same as above, but writes the chaining values of both halves, which form the parent block
+			void hashSubtreeHalves(const Byte *data, const std::size_t chunks, const uint64_t counter, Byte *out, const unsigned int threads) const;
+
+			void updateChunk(const Byte *data, const std::size_t length);
+			std::size_t chunkLength() const;
+			Output chunkOutput() const;
+			Output parentOutput(const Byte *block) const;
+			void pushCv(const Byte *cv, const uint64_t chunkCounter);
+			void mergeCvStack(const uint64_t totalChunks);
+
+			static constexpr int CV_SIZE = 32;  // chaining value
+			static constexpr int MAX_DEPTH = 54;  // 2^64 bytes of input at most
+
+			// subtrees at least this large are split across threads, which are started & joined within the call
+			static constexpr std::size_t THREAD_THRESHOLD = 1024 * 1024;
+			// a subtree is only handed to another thread when each half has at least this many chunks
+			static constexpr std::size_t THREAD_MIN_CHUNKS = 128;
+			// subtrees up to this many chunks are hashed in one go on the stack
+			static constexpr std::size_t LEAF_SUBTREE_CHUNKS = 64;
+
+			uint32_t m_key[8] = {};
+			uint32_t m_flags = 0;
+
+			// the current chunk
+			uint32_t m_chunkCv[8] = {};
+			uint64_t m_chunkCounter = 0;
+			int m_blocksCompressed = 0;
+			Buffer<Byte, BLOCK_SIZE> m_buffer;
+
+			// chaining values of the completed subtrees, merged lazily since the last one could become the root
+			Byte m_cvStack[MAX_DEPTH + 1][CV_SIZE] = {};
+			int m_cvStackLength = 0;
+
+			Output m_output;
+	};
+
+
+	// helpers
+	template <typename T>
+	class Loader
+	{
+		// this class workaround loading data from unaligned memory boundaries
+		// also eliminate endianness issues
+		public:
+			explicit constexpr Loader(const void *ptr)
+				: m_ptr(static_cast<const uint8_t *>(ptr))
+			{
+			}
+
+			constexpr T operator[](const IndexType idx) const
+			{
+				static_assert(std::is_same<T, uint32_t>::value, "");
+				// handle specific endianness here
+				const uint8_t *ptr = m_ptr + (sizeof(T) * idx);
+				return  ( (static_cast<T>(*(ptr + 0)) <<  0)
+						| (static_cast<T>(*(ptr + 1)) <<  8)
+						| (static_cast<T>(*(ptr + 2)) << 16)
+						| (static_cast<T>(*(ptr + 3)) << 24));
+			}
+
+		private:
+			const uint8_t *m_ptr;
+	};
+
+	template <typename R, typename T>
+	constexpr R ror(const T x, const unsigned int s)
+	{
+		static_assert(std::is_unsigned<R>::value, "");
+		static_assert(std::is_unsigned<T>::value, "");
+		return static_cast<R>(x >> s);
+	}
+
+	template <typename T>
+	constexpr T rotr(const T x, const unsigned int s)
+	{
+		static_assert(std::is_unsigned<T>::value, "");
+		if (s == 0)
+			return x;
+		return ((x >> s) | (x << ((sizeof(T) * 8) - s)));
+	}
+
+	inline void storeWords(const uint32_t *words, const int count, uint8_t *out)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+				*(out++) = ror<uint8_t>(words[i], (j * 8));
+		}
+	}
+
+#if defined(__AVX2__)
+	struct Avx2Ops
+	{
+		using Vector = __m256i;
+		static constexpr int LANES = 8;
+
+		static Vector load(const uint32_t *p)
+		{
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		}
+		static void store(uint32_t *p, const Vector x)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+		}
+		static Vector set1(const uint32_t x)
+		{
+			return _mm256_set1_epi32(static_cast<int>(x));
+		}
+		static Vector gather(const uint8_t *base, const Vector offsets)
+		{
+			return _mm256_i32gather_epi32(reinterpret_cast<const int *>(base), offsets, 1);
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm256_add_epi32(a, b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return _mm256_xor_si256(a, b);
+		}
+		static Vector rotr16(const Vector x)
+		{
+			return _mm256_shuffle_epi8(x, _mm256_setr_epi8(
+				2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+				2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+		}
+		static Vector rotr12(const Vector x)
+		{
+			return _mm256_or_si256(_mm256_srli_epi32(x, 12), _mm256_slli_epi32(x, 20));
+		}
+		static Vector rotr8(const Vector x)
+		{
+			return _mm256_shuffle_epi8(x, _mm256_setr_epi8(
+				1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+				1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12));
+		}
+		static Vector rotr7(const Vector x)
+		{
+			return _mm256_or_si256(_mm256_srli_epi32(x, 7), _mm256_slli_epi32(x, 25));
+		}
+	};
+#endif
+
+#if defined(__AVX512F__)
+	struct Avx512Ops
+	{
+		using Vector = __m512i;
+		static constexpr int LANES = 16;
+		// the zero-masked forms with every lane selected, the unmasked ones trip `-Wmaybe-uninitialized` on GCC 12
+		static constexpr __mmask16 ALL = 0xFFFF;
+
+		static Vector load(const uint32_t *p)
+		{
+			return _mm512_loadu_si512(p);
+		}
+		static void store(uint32_t *p, const Vector x)
+		{
+			_mm512_storeu_si512(p, x);
+		}
+		static Vector set1(const uint32_t x)
+		{
+			return _mm512_set1_epi32(static_cast<int>(x));
+		}
+		static Vector gather(const uint8_t *base, const Vector offsets)
+		{
+			return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), ALL, offsets, base, 1);
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm512_add_epi32(a, b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return _mm512_xor_si512(a, b);
+		}
+		static Vector rotr16(const Vector x)
+		{
+			return _mm512_or_si512(_mm512_maskz_srli_epi32(ALL, x, 16), _mm512_maskz_slli_epi32(ALL, x, 16));
+		}
+		static Vector rotr12(const Vector x)
+		{
+			return _mm512_or_si512(_mm512_maskz_srli_epi32(ALL, x, 12), _mm512_maskz_slli_epi32(ALL, x, 20));
+		}
+		static Vector rotr8(const Vector x)
+		{
+			return _mm512_or_si512(_mm512_maskz_srli_epi32(ALL, x, 8), _mm512_maskz_slli_epi32(ALL, x, 24));
+		}
+		static Vector rotr7(const Vector x)
+		{
+			return _mm512_or_si512(_mm512_maskz_srli_epi32(ALL, x, 7), _mm512_maskz_slli_epi32(ALL, x, 25));
+		}
+	};
+#endif
+
+
+	//
+	inline Blake3::Blake3()
+		: Blake3(KeyWords {initializationVector[0], initializationVector[1], initializationVector[2], initializationVector[3]
+			, initializationVector[4], initializationVector[5], initializationVector[6], initializationVector[7]}, 0)
+	{
+	}
+
+	inline Blake3::Blake3(const KeyArrayType &key)
+		: Blake3(KeyWords {Loader<uint32_t>(key.data())[0], Loader<uint32_t>(key.data())[1], Loader<uint32_t>(key.data())[2], Loader<uint32_t>(key.data())[3]
+			, Loader<uint32_t>(key.data())[4], Loader<uint32_t>(key.data())[5], Loader<uint32_t>(key.data())[6], Loader<uint32_t>(key.data())[7]}, KEYED_HASH)
+	{
+	}
+
+	inline Blake3::Blake3(const std::string &context)
+		: Blake3(contextKey(context), DERIVE_KEY_MATERIAL)
+	{
+	}
+
+	inline Blake3::Blake3(const KeyWords &key, const uint32_t flags)
+		: m_flags(flags)
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+
+		for (int i = 0; i < 8; ++i)
+			m_key[i] = key[i];
+		reset();
+	}
+
+	inline void Blake3::reset()
+	{
+		for (int i = 0; i < 8; ++i)
+			m_chunkCv[i] = m_key[i];
+		m_chunkCounter = 0;
+		m_blocksCompressed = 0;
+		m_buffer.clear();
+
+		m_cvStackLength = 0;
+		m_output = {};
+	}
+
+	inline Blake3& Blake3::finalize()
+	{
+		if (m_cvStackLength == 0)
+		{
+			m_output = chunkOutput();
+			return (*this);
+		}
+
+		int cvsRemaining = m_cvStackLength;
+		Output output;
+		if (chunkLength() > 0)
+		{
+			output = chunkOutput();
+		}
+		else
+		{
+			// the input ended right after a subtree, its 2 halves are still on the stack
+			cvsRemaining -= 2;
+			output = parentOutput(m_cvStack[cvsRemaining]);
+		}
+
+		while (cvsRemaining > 0)
+		{
+			--cvsRemaining;
+
+			Byte block[BLOCK_SIZE] = {};
+			std::copy(m_cvStack[cvsRemaining], (m_cvStack[cvsRemaining] + CV_SIZE), block);
+			chainingValue(output, (block + CV_SIZE));
+			output = parentOutput(block);
+		}
+
+		m_output = output;
+		return (*this);
+	}
+
+	inline std::string Blake3::toString() const
+	{
+		const auto a = toArray();
+		std::string ret;
+		ret.resize(2 * a.size());
+
+		auto retPtr = &ret.front();
+		for (const auto c : a)
+		{
+			const Byte upper = ror<Byte>(c, 4);
+			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
+
+			const Byte lower = c & 0xf;
+			*(retPtr++) = static_cast<char>((lower < 10) ? (lower + '0') : (lower - 10 + 'a'));
+		}
+
+		return ret;
+	}
+
+	inline std::vector<Blake3::Byte> Blake3::toVector() const
+	{
+		const auto a = toArray();
+		return {a.begin(), a.end()};
+	}
+
+	inline std::vector<Blake3::Byte> Blake3::toVector(const std::size_t length) const
+	{
+		std::vector<Byte> ret(length);
+		rootBytes(m_output, ret.data(), ret.size());
+		return ret;
+	}
+
+	inline Blake3::ResultArrayType Blake3::toArray() const
+	{
+		ResultArrayType ret {};
+		rootBytes(m_output, ret.data(), ret.size());
+		return ret;
+	}
+
+	inline Blake3::ResultArrayType Blake3::peekDigest() const
+	{
+		Blake3 copy = *this;
+		return copy.finalize().toArray();
+	}
+
+	inline Blake3& Blake3::addData(const Span<const Byte> inData)
+	{
+		Span<const Byte> data = inData;
+
+		if (chunkLength() > 0)
+		{
+			// complete the current chunk first
+			const std::size_t len = std::min<std::size_t>((CHUNK_SIZE - chunkLength()), data.size());
+			updateChunk(data.data(), len);
+			data = data.subspan(len);
+
+			if (data.empty())
+				return (*this);
+
+			// more data follows, the chunk can't be the root
+			Byte cv[CV_SIZE] = {};
+			chainingValue(chunkOutput(), cv);
+			pushCv(cv, m_chunkCounter);
+
+			for (int i = 0; i < 8; ++i)
+				m_chunkCv[i] = m_key[i];
+			++m_chunkCounter;
+			m_blocksCompressed = 0;
+			m_buffer.clear();
+		}
+
+		while (data.size() > CHUNK_SIZE)
+		{
+			// the largest subtree that fits and is aligned to the chunks seen so far
+			std::size_t subtreeChunks = 1;
+			while ((subtreeChunks * 2 * CHUNK_SIZE) <= static_cast<std::size_t>(data.size()))
+				subtreeChunks *= 2;
+			while ((m_chunkCounter & (subtreeChunks - 1)) != 0)
+				subtreeChunks /= 2;
+
+			if (subtreeChunks == 1)
+			{
+				// more data follows, the chunk can't be the root
+				Byte cv[CV_SIZE] = {};
+				hashOne(data.data(), (CHUNK_SIZE / BLOCK_SIZE), m_key, m_chunkCounter, m_flags, CHUNK_START, CHUNK_END, cv);
+				pushCv(cv, m_chunkCounter);
+			}
+			else
+			{
+				const unsigned int cores = std::thread::hardware_concurrency();
+				const unsigned int threads = (((subtreeChunks * CHUNK_SIZE) >= THREAD_THRESHOLD) && (cores != 1))
+					? ((cores == 0) ? 2 : cores)
+					: 1;
+
+				// the subtree may span the rest of the input, push its halves so the root is decided later
+				Byte cvs[2 * CV_SIZE] = {};
+				hashSubtreeHalves(data.data(), subtreeChunks, m_chunkCounter, cvs, threads);
+				pushCv(cvs, m_chunkCounter);
+				pushCv((cvs + CV_SIZE), (m_chunkCounter + (subtreeChunks / 2)));
+			}
+
+			m_chunkCounter += subtreeChunks;
+			data = data.subspan(subtreeChunks * CHUNK_SIZE);
+		}
+
+		if (!data.empty())
+		{
+			updateChunk(data.data(), static_cast<std::size_t>(data.size()));
+			mergeCvStack(m_chunkCounter);
+		}
+
+		return (*this);
+	}
+
+	inline Blake3& Blake3::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <typename T, std::size_t N>
+	Blake3& Blake3::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename T>
+	Blake3& Blake3::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	inline Blake3::KeyWords Blake3::contextKey(const std::string &context)
+	{
+		Blake3 hasher(KeyWords {initializationVector[0], initializationVector[1], initializationVector[2], initializationVector[3]
+			, initializationVector[4], initializationVector[5], initializationVector[6], initializationVector[7]}, DERIVE_KEY_CONTEXT);
+		const auto key = hasher.addData(context.data(), context.size()).finalize().toArray();
+
+		KeyWords ret {};
+		for (int i = 0; i < 8; ++i)
+			ret[i] = Loader<uint32_t>(key.data())[i];
+		return ret;
+	}
+
+	inline void Blake3::compress(const uint32_t (&cv)[8], const Byte *block, const uint32_t blockLength, const uint64_t counter, const uint32_t flags, uint32_t (&out)[16])
+	{
+		const Loader<uint32_t> loader(block);
+		uint32_t m[16] = {};
+		for (int i = 0; i < 16; ++i)
+			m[i] = loader[i];
+
+		uint32_t v[16] =
+		{
+			cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+			initializationVector[0], initializationVector[1], initializationVector[2], initializationVector[3],
+			ror<uint32_t>(counter, 0), ror<uint32_t>(counter, 32), blockLength, flags
+		};
+
+		const auto mix = [&v](const int a, const int b, const int c, const int d, const uint32_t x, const uint32_t y)
+		{
+			v[a] = v[a] + v[b] + x;
+			v[d] = rotr((v[d] ^ v[a]), 16);
+			v[c] = v[c] + v[d];
+			v[b] = rotr((v[b] ^ v[c]), 12);
+			v[a] = v[a] + v[b] + y;
+			v[d] = rotr((v[d] ^ v[a]), 8);
+			v[c] = v[c] + v[d];
+			v[b] = rotr((v[b] ^ v[c]), 7);
+		};
+
+		for (int round = 0; round < 7; ++round)
+		{
+			const uint8_t *s = messageSchedule[round];
+			mix(0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+			mix(1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+			mix(2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+			mix(3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+			mix(0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+			mix(1, 6, 11, 12, m[s[10]], m[s[11]]);
+			mix(2, 7,  8, 13, m[s[12]], m[s[13]]);
+			mix(3, 4,  9, 14, m[s[14]], m[s[15]]);
+		}
+
+		for (int i = 0; i < 8; ++i)
+		{
+			out[i] = v[i] ^ v[i + 8];
+			out[i + 8] = v[i + 8] ^ cv[i];
+		}
+	}
+
+	inline void Blake3::chainingValue(const Output &output, Byte *out)
+	{
+		uint32_t words[16] = {};
+		compress(output.inputCv, output.block, output.blockLength, output.counter, output.flags, words);
+		storeWords(words, 8, out);
+	}
+
+	inline void Blake3::rootBytes(const Output &output, Byte *out, const std::size_t length)
+	{
+		// each output block comes from compressing the root node again with an incrementing counter
+		for (std::size_t offset = 0, counter = 0; offset < length; offset += BLOCK_SIZE, ++counter)
+		{
+			uint32_t words[16] = {};
+			compress(output.inputCv, output.block, output.blockLength, counter, (output.flags | ROOT), words);
+
+			Byte block[BLOCK_SIZE] = {};
+			storeWords(words, 16, block);
+			const std::size_t len = std::min<std::size_t>(BLOCK_SIZE, (length - offset));
+			std::copy(block, (block + len), (out + offset));
+		}
+	}
+
+	inline void Blake3::hashMany(const Byte *data, const std::size_t inputs, const std::size_t stride, const std::size_t blocks
+		, const uint32_t (&key)[8], const uint64_t counter, const bool incrementCounter, const uint32_t flags, const uint32_t flagsStart, const uint32_t flagsEnd, Byte *out)
+	{
+		std::size_t i = 0;
+#if defined(__AVX512F__)
+		for (; (i + Avx512Ops::LANES) <= inputs; i += Avx512Ops::LANES)
+			hashManySimd<Avx512Ops>((data + (i * stride)), stride, blocks, key, (counter + (incrementCounter ? i : 0)), incrementCounter, flags, flagsStart, flagsEnd, (out + (i * CV_SIZE)));
+#endif
+#if defined(__AVX2__)
+		for (; (i + Avx2Ops::LANES) <= inputs; i += Avx2Ops::LANES)
+			hashManySimd<Avx2Ops>((data + (i * stride)), stride, blocks, key, (counter + (incrementCounter ? i : 0)), incrementCounter, flags, flagsStart, flagsEnd, (out + (i * CV_SIZE)));
+#endif
+		for (; i < inputs; ++i)
+			hashOne((data + (i * stride)), blocks, key, (counter + (incrementCounter ? i : 0)), flags, flagsStart, flagsEnd, (out + (i * CV_SIZE)));
+	}
+
+	inline void Blake3::hashOne(const Byte *data, const std::size_t blocks, const uint32_t (&key)[8], const uint64_t counter
+		, const uint32_t flags, const uint32_t flagsStart, const uint32_t flagsEnd, Byte *out)
+	{
+		uint32_t cv[8] = {};
+		std::copy(key, (key + 8), cv);
+
+		for (std::size_t i = 0; i < blocks; ++i)
+		{
+			const uint32_t blockFlags = flags
+				| ((i == 0) ? flagsStart : 0)
+				| ((i == (blocks - 1)) ? flagsEnd : 0);
+
+			uint32_t words[16] = {};
+			compress(cv, (data + (i * BLOCK_SIZE)), BLOCK_SIZE, counter, blockFlags, words);
+			std::copy(words, (words + 8), cv);
+		}
+
+		storeWords(cv, 8, out);
+	}
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+	template <typename Ops>
+	void Blake3::hashManySimd(const Byte *data, const std::size_t stride, const std::size_t blocks, const uint32_t (&key)[8], const uint64_t counter
+		, const bool incrementCounter, const uint32_t flags, const uint32_t flagsStart, const uint32_t flagsEnd, Byte *out)
+	{
+		// one input in each 32-bit lane, the message words are gathered straight from the inputs
+		using Vector = typename Ops::Vector;
+		constexpr int LANES = Ops::LANES;
+
+		uint32_t offsets[LANES] = {};
+		uint32_t counterLow[LANES] = {};
+		uint32_t counterHigh[LANES] = {};
+		for (int j = 0; j < LANES; ++j)
+		{
+			offsets[j] = static_cast<uint32_t>(j * stride);
+
+			const uint64_t c = counter + (incrementCounter ? static_cast<uint64_t>(j) : 0);
+			counterLow[j] = ror<uint32_t>(c, 0);
+			counterHigh[j] = ror<uint32_t>(c, 32);
+		}
+		const Vector offsetVector = Ops::load(offsets);
+
+		Vector h[8];
+		for (int i = 0; i < 8; ++i)
+			h[i] = Ops::set1(key[i]);
+
+		for (std::size_t iter = 0; iter < blocks; ++iter)
+		{
+			const Byte *block = data + (iter * BLOCK_SIZE);
+
+			Vector m[16];
+			for (int i = 0; i < 16; ++i)
+				m[i] = Ops::gather((block + (i * 4)), offsetVector);
+
+			const uint32_t blockFlags = flags
+				| ((iter == 0) ? flagsStart : 0)
+				| ((iter == (blocks - 1)) ? flagsEnd : 0);
+
+			Vector v[16] =
+			{
+				h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+				Ops::set1(initializationVector[0]), Ops::set1(initializationVector[1]), Ops::set1(initializationVector[2]), Ops::set1(initializationVector[3]),
+				Ops::load(counterLow), Ops::load(counterHigh), Ops::set1(BLOCK_SIZE), Ops::set1(blockFlags)
+			};
+
+			const auto mix = [&v](const int a, const int b, const int c, const int d, const Vector x, const Vector y)
+			{
+				v[a] = Ops::add(Ops::add(v[a], v[b]), x);
+				v[d] = Ops::rotr16(Ops::xor_(v[d], v[a]));
+				v[c] = Ops::add(v[c], v[d]);
+				v[b] = Ops::rotr12(Ops::xor_(v[b], v[c]));
+				v[a] = Ops::add(Ops::add(v[a], v[b]), y);
+				v[d] = Ops::rotr8(Ops::xor_(v[d], v[a]));
+				v[c] = Ops::add(v[c], v[d]);
+				v[b] = Ops::rotr7(Ops::xor_(v[b], v[c]));
+			};
+
+			for (int round = 0; round < 7; ++round)
+			{
+				const uint8_t *s = messageSchedule[round];
+				mix(0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+				mix(1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+				mix(2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+				mix(3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+				mix(0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+				mix(1, 6, 11, 12, m[s[10]], m[s[11]]);
+				mix(2, 7,  8, 13, m[s[12]], m[s[13]]);
+				mix(3, 4,  9, 14, m[s[14]], m[s[15]]);
+			}
+
+			for (int i = 0; i < 8; ++i)
+				h[i] = Ops::xor_(v[i], v[i + 8]);
+		}
+
+		uint32_t lanes[8][LANES] = {};
+		for (int i = 0; i < 8; ++i)
+			Ops::store(lanes[i], h[i]);
+
+		for (int j = 0; j < LANES; ++j)
+		{
+			uint32_t cv[8] = {};
+			for (int i = 0; i < 8; ++i)
+				cv[i] = lanes[i][j];
+			storeWords(cv, 8, (out + (j * CV_SIZE)));
+		}
+	}
+#endif
+
+	inline void Blake3::hashSubtree(const Byte *data, const std::size_t chunks, const uint64_t counter, Byte *out, const unsigned int threads) const
+	{
+		if (chunks <= LEAF_SUBTREE_CHUNKS)
+		{
+			Byte cvs[LEAF_SUBTREE_CHUNKS * CV_SIZE];
+			hashMany(data, chunks, CHUNK_SIZE, (CHUNK_SIZE / BLOCK_SIZE), m_key, counter, true, m_flags, CHUNK_START, CHUNK_END, cvs);
+
+			// a parent block is 2 adjacent chaining values, each level overwrites only the values already consumed
+			for (std::size_t n = chunks; n > 1; n /= 2)
+				hashMany(cvs, (n / 2), BLOCK_SIZE, 1, m_key, 0, false, (m_flags | PARENT), 0, 0, cvs);
+
+			std::copy(cvs, (cvs + CV_SIZE), out);
+			return;
+		}
+
+		Byte block[BLOCK_SIZE] = {};
+		hashSubtreeHalves(data, chunks, counter, block, threads);
+		hashOne(block, 1, m_key, 0, (m_flags | PARENT), 0, 0, out);
+	}
+
+	inline void Blake3::hashSubtreeHalves(const Byte *data, const std::size_t chunks, const uint64_t counter, Byte *out, const unsigned int threads) const
+	{
+		const std::size_t halfChunks = chunks / 2;
+		const Byte *rightData = data + (halfChunks * CHUNK_SIZE);
+		const uint64_t rightCounter = counter + halfChunks;
+
+		if ((threads > 1) && (halfChunks >= THREAD_MIN_CHUNKS))
+		{
+			const unsigned int rightThreads = threads / 2;
+			std::thread worker([this, rightData, halfChunks, rightCounter, out, rightThreads]()
+			{
+				hashSubtree(rightData, halfChunks, rightCounter, (out + CV_SIZE), rightThreads);
+			});
+			hashSubtree(data, halfChunks, counter, out, (threads - rightThreads));
+			worker.join();
+			return;
+		}
+
+		hashSubtree(data, halfChunks, counter, out, 1);
+		hashSubtree(rightData, halfChunks, rightCounter, (out + CV_SIZE), 1);
+	}
+
+	inline void Blake3::updateChunk(const Byte *data, const std::size_t length)
+	{
+		assert((chunkLength() + length) <= CHUNK_SIZE);
+
+		for (const Byte *p = data, *pEnd = (data + length); p != pEnd; )
+		{
+			// the last block is kept in buffer, it gets the `CHUNK_END` flag
+			if (m_buffer.size() == BLOCK_SIZE)
+			{
+				uint32_t out[16] = {};
+				compress(m_chunkCv, m_buffer.data(), BLOCK_SIZE, m_chunkCounter, (m_flags | ((m_blocksCompressed == 0) ? CHUNK_START : 0)), out);
+				std::copy(out, (out + 8), m_chunkCv);
+				++m_blocksCompressed;
+				m_buffer.clear();
+			}
+
+			const std::size_t len = std::min<std::size_t>((BLOCK_SIZE - m_buffer.size()), static_cast<std::size_t>(pEnd - p));
+			m_buffer.push_back(p, (p + len));
+			p += len;
+		}
+	}
+
+	inline std::size_t Blake3::chunkLength() const
+	{
+		return ((static_cast<std::size_t>(m_blocksCompressed) * BLOCK_SIZE) + m_buffer.size());
+	}
+
+	inline Blake3::Output Blake3::chunkOutput() const
+	{
+		Output ret;
+		std::copy(m_chunkCv, (m_chunkCv + 8), ret.inputCv);
+		std::copy(m_buffer.data(), (m_buffer.data() + m_buffer.size()), ret.block);
+		ret.blockLength = static_cast<uint32_t>(m_buffer.size());
+		ret.counter = m_chunkCounter;
+		ret.flags = m_flags | ((m_blocksCompressed == 0) ? CHUNK_START : 0) | CHUNK_END;
+		return ret;
+	}
+
+	inline Blake3::Output Blake3::parentOutput(const Byte *block) const
+	{
+		Output ret;
+		std::copy(m_key, (m_key + 8), ret.inputCv);
+		std::copy(block, (block + BLOCK_SIZE), ret.block);
+		ret.blockLength = BLOCK_SIZE;
+		ret.counter = 0;
+		ret.flags = m_flags | PARENT;
+		return ret;
+	}
+
+	inline void Blake3::pushCv(const Byte *cv, const uint64_t chunkCounter)
+	{
+		mergeCvStack(chunkCounter);
+
+		assert(m_cvStackLength <= MAX_DEPTH);
+		std::copy(cv, (cv + CV_SIZE), m_cvStack[m_cvStackLength]);
+		++m_cvStackLength;
+	}
+
+	inline void Blake3::mergeCvStack(const uint64_t totalChunks)
+	{
+		// a complete subtree exists for each set bit of `totalChunks`
+		int subtrees = 0;
+		for (uint64_t n = totalChunks; n > 0; n &= (n - 1))
+			++subtrees;
+
+		while (m_cvStackLength > subtrees)
+		{
+			// the top 2 entries are adjacent, together they form a parent block
+			Byte *block = m_cvStack[m_cvStackLength - 2];
+			chainingValue(parentOutput(block), block);
+			--m_cvStackLength;
+		}
+	}
+
+	inline std::vector<Blake3::Byte> Blake3::serialize() const
+	{
+		if (m_flags != 0)
+			return {};
+
+		// the digest of the empty message pins the mode
+		Blake3 fresh = *this;
+		fresh.reset();
+		const ResultArrayType fingerprint = fresh.finalize().toArray();
+
+		StateWriter writer("Blake3");
+		writer.put(fingerprint.data(), fingerprint.size());
+		for (const auto word : m_chunkCv)
+			writer.put(word);
+		writer.put(m_chunkCounter);
+		writer.put(static_cast<uint32_t>(m_blocksCompressed));
+		writer.put(static_cast<uint32_t>(m_buffer.size()));
+		writer.put(m_buffer.data(), m_buffer.size());
+		writer.put(static_cast<uint32_t>(m_cvStackLength));
+		for (int i = 0; i < m_cvStackLength; ++i)
+			writer.put(m_cvStack[i], CV_SIZE);
+		return writer.data();
+	}
+
+	inline bool Blake3::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "Blake3");
+		ResultArrayType fingerprint {};
+		reader.get(fingerprint.data(), fingerprint.size());
+		uint32_t chunkCv[8] = {};
+		for (auto &word : chunkCv)
+			word = reader.get<uint32_t>();
+		const uint64_t chunkCounter = reader.get<uint64_t>();
+		const uint32_t blocksCompressed = reader.get<uint32_t>();
+		const uint32_t bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || (blocksCompressed >= (CHUNK_SIZE / BLOCK_SIZE)) || (bufferSize > BLOCK_SIZE))
+			return false;
+		Byte buffer[BLOCK_SIZE] = {};
+		reader.get(buffer, bufferSize);
+		const uint32_t cvStackLength = reader.get<uint32_t>();
+		if (!reader.ok() || (cvStackLength > (MAX_DEPTH + 1)))
+			return false;
+		Byte cvStack[MAX_DEPTH + 1][CV_SIZE] = {};
+		for (uint32_t i = 0; i < cvStackLength; ++i)
+			reader.get(cvStack[i], CV_SIZE);
+		if (!reader.finished())
+			return false;
+
+		Blake3 fresh = *this;
+		fresh.reset();
+		if (fresh.finalize().toArray() != fingerprint)
+			return false;
+
+		for (int i = 0; i < 8; ++i)
+			m_chunkCv[i] = chunkCv[i];
+		m_chunkCounter = chunkCounter;
+		m_blocksCompressed = static_cast<int>(blocksCompressed);
+		m_buffer = {buffer, (buffer + bufferSize)};
+		std::copy(&cvStack[0][0], (&cvStack[0][0] + sizeof(cvStack)), &m_cvStack[0][0]);
+		m_cvStackLength = static_cast<int>(cvStackLength);
+		m_output = {};
+		return true;
+	}
+}
+}
+	using Blake3 = Hash::Blake3_NS::Blake3;
+}
+
+#endif  // CHOCOBO1_BLAKE3_H
@@ -0,0 +1,679 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2017-2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_CRC_H
+#define CHOCOBO1_CRC_H
+
+#include "state_serializer.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+// the hardware paths are taken only outside of constant evaluation
+#ifndef CHOCOBO1_HASH_CRC_RUNTIME_DISPATCH
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated) && (defined(__SSE4_2__) || defined(__PCLMUL__)) && defined(__x86_64__)
+#define CHOCOBO1_HASH_CRC_RUNTIME_DISPATCH 1
+#endif
+#endif
+#endif
+
+#if defined(CHOCOBO1_HASH_CRC_RUNTIME_DISPATCH)
+#include <immintrin.h>
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// Crc<int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices = 8>();
+	//   parameters as in https://reveng.sourceforge.io/crc-catalogue/ (refin == refout == Reflect), `Slices` is the slicing-by-N depth
+	// CRC_32C();
+	// CRC_64_NVME();
+	// CRC_64_XZ();
+	//   `combine(other, otherLength)` appends the data hashed by `other`, `addDataParallel()` splits large inputs across threads
+	//   CRC-32C uses the SSE4.2 `crc32` instruction & other reflected CRCs use PCLMUL folding when the compiler targets them
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+#ifndef CONSTEXPR_CPP17_CHOCOBO1_HASH
+#if __cplusplus >= 201703L
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
+#else
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+	using IndexType = std::size_t;
+#else
+	using IndexType = gsl::index;
+#endif
+
+
+namespace Crc_NS
+{
+	// helpers
+	template <typename T, int Width>
+	constexpr T widthMask()
+	{
+		return static_cast<T>(static_cast<T>(~T(0)) >> ((sizeof(T) * CHAR_BIT) - Width));
+	}
+
+	template <typename T>
+	constexpr T reflect(const T value, const int bits)
+	{
+		T ret = 0;
+		for (int i = 0; i < bits; ++i)
+		{
+			if (((value >> i) & 1) != 0)
+				ret |= static_cast<T>(T(1) << (bits - 1 - i));
+		}
+		return ret;
+	}
+
+	template <typename T, int Width, bool Reflect>
+	constexpr T multiplyX(const T value, const T poly)
+	{
+		// value * x mod P, in the register bit order
+		if (Reflect)
+			return static_cast<T>((value >> 1) ^ ((value & 1) * poly));
+		return static_cast<T>(((value << 1) ^ (((value >> (Width - 1)) & 1) * poly)) & widthMask<T, Width>());
+	}
+
+	template <typename T, int Width, bool Reflect>
+	constexpr T multModP(const T a, T b, const T poly)
+	{
+		// a * b mod P, walking `a` from x^0 upwards
+		T ret = 0;
+		for (int i = 0; i < Width; ++i)
+		{
+			const T bit = Reflect ? static_cast<T>(T(1) << (Width - 1 - i)) : static_cast<T>(T(1) << i);
+			if ((a & bit) != 0)
+				ret ^= b;
+			b = multiplyX<T, Width, Reflect>(b, poly);
+		}
+		return ret;
+	}
+
+	template <typename T, int Width, bool Reflect>
+	constexpr T xPowModP(const uint64_t n, const T poly)
+	{
+		// x^n mod P, by squaring
+		T ret = Reflect ? static_cast<T>(T(1) << (Width - 1)) : T(1);
+		T square = Reflect ? static_cast<T>(T(1) << (Width - 2)) : T(2);
+		for (uint64_t bits = n; bits != 0; bits >>= 1)
+		{
+			if ((bits & 1) != 0)
+				ret = multModP<T, Width, Reflect>(square, ret, poly);
+			square = multModP<T, Width, Reflect>(square, square, poly);
+		}
+		return ret;
+	}
+
+	template <typename T, int Slices>
+	struct Table
+	{
+		T t[Slices][256];
+	};
+
+	template <typename T, int Width, bool Reflect, int Slices>
+	constexpr Table<T, Slices> makeTable(const T poly)
+	{
+		// t[s][i]: byte `i` followed by `s` zero bytes
+		Table<T, Slices> ret {};
+		for (int i = 0; i < 256; ++i)
+		{
+			T crc = Reflect ? static_cast<T>(i) : static_cast<T>(T(i) << (Width - 8));
+			for (int j = 0; j < 8; ++j)
+				crc = multiplyX<T, Width, Reflect>(crc, poly);
+			ret.t[0][i] = crc;
+		}
+		for (int s = 1; s < Slices; ++s)
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				const T prev = ret.t[s - 1][i];
+				ret.t[s][i] = Reflect
+					? static_cast<T>((prev >> 8) ^ ret.t[0][prev & 0xFF])
+					: static_cast<T>(((prev << 8) & widthMask<T, Width>()) ^ ret.t[0][(prev >> (Width - 8)) & 0xFF]);
+			}
+		}
+		return ret;
+	}
+
+	template <typename T>
+	struct PowerTable
+	{
+		T t[67];  // x^(2^k) mod P, enough for shifting over 2^64 bytes
+	};
+
+	template <typename T, int Width, bool Reflect>
+	constexpr PowerTable<T> makePowerTable(const T poly)
+	{
+		PowerTable<T> ret {};
+		ret.t[0] = Reflect ? static_cast<T>(T(1) << (Width - 2)) : T(2);
+		for (int k = 1; k < 67; ++k)
+			ret.t[k] = multModP<T, Width, Reflect>(ret.t[k - 1], ret.t[k - 1], poly);
+		return ret;
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	class Crc
+	{
+		// slicing-by-N from: http://create.stephan-brumme.com/crc32/
+		// PCLMUL folding from: "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction", Intel
+
+		public:
+			using Byte = uint8_t;
+			using ResultArrayType = std::array<Byte, (Width / 8)>;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			constexpr Crc();
+
+			constexpr void reset();
+			constexpr Crc& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
+
+			constexpr Crc& addData(const Span<const Byte> inData);
+			constexpr Crc& addData(const void *ptr, const std::size_t length);
+			template <std::size_t N>
+			constexpr Crc& addData(const Byte (&array)[N]);
+			template <typename T, std::size_t N>
+			Crc& addData(const T (&array)[N]);
+			template <typename T>
+			Crc& addData(const Span<T> inSpan);
+
+			// same result as `addData()`, `threads == 0` uses all cores
+			// no more threads than cores are used & every thread gets at least 512 KiB
+			Crc& addDataParallel(const Span<const Byte> inData, const std::size_t threads = 0);
+			Crc& addDataParallel(const void *ptr, const std::size_t length, const std::size_t threads = 0);
+
+			// as if the data hashed by `other` were passed to `addData()`, neither may be finalized
+			constexpr Crc& combine(const Crc &other, const uint64_t otherLength);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			using Value = typename std::conditional<(Width <= 32), uint32_t, uint64_t>::type;
+
+			static constexpr Value shiftModP(const Value value, const uint64_t length);  // value * x^(8 * length) mod P
+
+			// the table lookups of one slicing block, unrolled
+			template <int J>
+			static constexpr Value sliceTerms(const Value crc, const Byte *ptr, std::integral_constant<int, J>);
+			static constexpr Value sliceTerms(const Value crc, const Byte *ptr, std::integral_constant<int, Slices>);
+
+			constexpr void addDataImpl(const Span<const Byte> data);
+			constexpr void addDataTable(const Span<const Byte> data);
+#if defined(CHOCOBO1_HASH_CRC_RUNTIME_DISPATCH)
+#if defined(__SSE4_2__)
+			void addDataCrc32c(const Span<const Byte> data);
+#endif
+#if defined(__PCLMUL__)
+			void addDataClmul(const Span<const Byte> data);
+#endif
+#endif
+
+			static_assert(((Width >= 8) && (Width <= 64) && ((Width % 8) == 0)), "Width must be a multiple of 8, up to 64");
+			static_assert(((Slices >= 1) && (Slices <= 16)), "Slices must be in [1, 16]");
+
+			static constexpr Value MASK = widthMask<Value, Width>();
+			static constexpr Value POLY = Reflect ? reflect<Value>(static_cast<Value>(Poly), Width) : static_cast<Value>(Poly);
+			static constexpr Value INIT = Reflect ? reflect<Value>(static_cast<Value>(Init), Width) : static_cast<Value>(Init);
+			static constexpr bool IS_CRC_32C = (Width == 32) && (Poly == 0x1EDC6F41) && Reflect;
+
+			static constexpr Table<Value, Slices> TABLE = makeTable<Value, Width, Reflect, Slices>(POLY);
+			static constexpr PowerTable<Value> POWERS = makePowerTable<Value, Width, Reflect>(POLY);
+
+			static constexpr std::size_t CRC_32C_LANE_SIZE = 4096;
+			static constexpr std::size_t THREAD_THRESHOLD = 1024 * 1024;
+
+			Value m_h = 0;
+	};
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr Table<typename Crc<Width, Poly, Reflect, Init, XorOut, Slices>::Value, Slices> Crc<Width, Poly, Reflect, Init, XorOut, Slices>::TABLE;
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr PowerTable<typename Crc<Width, Poly, Reflect, Init, XorOut, Slices>::Value> Crc<Width, Poly, Reflect, Init, XorOut, Slices>::POWERS;
+
+
+	//
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr Crc<Width, Poly, Reflect, Init, XorOut, Slices>::Crc()
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+		reset();
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr void Crc<Width, Poly, Reflect, Init, XorOut, Slices>::reset()
+	{
+		m_h = INIT;
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr Crc<Width, Poly, Reflect, Init, XorOut, Slices>& Crc<Width, Poly, Reflect, Init, XorOut, Slices>::finalize()
+	{
+		m_h = static_cast<Value>((m_h ^ XorOut) & MASK);
+		return (*this);
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	std::string Crc<Width, Poly, Reflect, Init, XorOut, Slices>::toString() const
+	{
+		const auto a = toArray();
+		std::string ret;
+		ret.resize(2 * a.size());
+
+		auto retPtr = &ret.front();
+		for (const auto c : a)
+		{
+			const Byte upper = static_cast<Byte>(c >> 4);
+			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
+
+			const Byte lower = c & 0xf;
+			*(retPtr++) = static_cast<char>((lower < 10) ? (lower + '0') : (lower - 10 + 'a'));
+		}
+
+		return ret;
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	std::vector<typename Crc<Width, Poly, Reflect, Init, XorOut, Slices>::Byte> Crc<Width, Poly, Reflect, Init, XorOut, Slices>::toVector() const
+	{
+		const auto a = toArray();
+		return {a.begin(), a.end()};
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	CONSTEXPR_CPP17_CHOCOBO1_HASH typename Crc<Width, Poly, Reflect, Init, XorOut, Slices>::ResultArrayType Crc<Width, Poly, Reflect, Init, XorOut, Slices>::toArray() const
+	{
+		const int dataSize = Width / 8;
+
+		ResultArrayType ret {};
+		auto retPtr = ret.data();
+		for (int j = (dataSize - 1); j >= 0; --j)
+			*(retPtr++) = static_cast<Byte>(m_h >> (j * 8));
+
+		return ret;
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	CONSTEXPR_CPP17_CHOCOBO1_HASH typename Crc<Width, Poly, Reflect, Init, XorOut, Slices>::ResultArrayType Crc<Width, Poly, Reflect, Init, XorOut, Slices>::peekDigest() const
+	{
+		Crc copy = *this;
+		return copy.finalize().toArray();
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr Crc<Width, Poly, Reflect, Init, XorOut, Slices>& Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addData(const Span<const Byte> inData)
+	{
+		addDataImpl(inData);
+		return (*this);
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr Crc<Width, Poly, Reflect, Init, XorOut, Slices>& Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	template <std::size_t N>
+	constexpr Crc<Width, Poly, Reflect, Init, XorOut, Slices>& Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addData(const Byte (&array)[N])
+	{
+		return addData({array, N});
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	template <typename T, std::size_t N>
+	Crc<Width, Poly, Reflect, Init, XorOut, Slices>& Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	template <typename T>
+	Crc<Width, Poly, Reflect, Init, XorOut, Slices>& Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	Crc<Width, Poly, Reflect, Init, XorOut, Slices>& Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addDataParallel(const Span<const Byte> inData, const std::size_t threads)
+	{
+		// threads: at most one per core & every piece at least `THREAD_THRESHOLD / 2` bytes
+		const std::size_t dataSize = static_cast<std::size_t>(inData.size());
+		const std::size_t cores = std::thread::hardware_concurrency();
+		std::size_t threadCount = (threads == 0) ? ((cores == 0) ? 2 : cores) : threads;
+		if (cores != 0)
+			threadCount = std::min(threadCount, cores);
+		threadCount = std::min(threadCount, (dataSize / (THREAD_THRESHOLD / 2)));
+		if (threadCount <= 1)
+			return addData(inData);
+
+		// CRC is linear: hash the pieces independently, then shift each partial result over the following pieces
+		const std::size_t pieceSize = (dataSize + threadCount - 1) / threadCount;
+		const std::size_t pieces = (dataSize + pieceSize - 1) / pieceSize;
+
+		std::vector<Crc> partials(pieces);
+		std::vector<std::thread> workers;
+		workers.reserve(pieces - 1);
+		for (std::size_t i = 1; i < pieces; ++i)
+		{
+			const Span<const Byte> piece = inData.subspan((i * pieceSize), std::min(pieceSize, (dataSize - (i * pieceSize))));
+			workers.emplace_back([&partials, i, piece]()
+			{
+				partials[i].addDataImpl(piece);
+			});
+		}
+		addDataImpl(inData.first(pieceSize));
+
+		for (auto &worker : workers)
+			worker.join();
+
+		for (std::size_t i = 1; i < pieces; ++i)
+			combine(partials[i], std::min(pieceSize, (dataSize - (i * pieceSize))));
+
+		return (*this);
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	Crc<Width, Poly, Reflect, Init, XorOut, Slices>& Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addDataParallel(const void *ptr, const std::size_t length, const std::size_t threads)
+	{
+		return addDataParallel({static_cast<const Byte*>(ptr), length}, threads);
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr Crc<Width, Poly, Reflect, Init, XorOut, Slices>& Crc<Width, Poly, Reflect, Init, XorOut, Slices>::combine(const Crc &other, const uint64_t otherLength)
+	{
+		// `other` started from the same initial value, which cancels out here
+		m_h = static_cast<Value>(shiftModP(static_cast<Value>(m_h ^ INIT), otherLength) ^ other.m_h);
+		return (*this);
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr typename Crc<Width, Poly, Reflect, Init, XorOut, Slices>::Value Crc<Width, Poly, Reflect, Init, XorOut, Slices>::shiftModP(const Value value, const uint64_t length)
+	{
+		Value ret = value;
+		uint64_t n = length;
+		for (int k = 3; n != 0; ++k)
+		{
+			if ((n & 1) != 0)
+				ret = multModP<Value, Width, Reflect>(POWERS.t[k], ret, POLY);
+			n >>= 1;
+		}
+		return ret;
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	template <int J>
+	constexpr typename Crc<Width, Poly, Reflect, Init, XorOut, Slices>::Value Crc<Width, Poly, Reflect, Init, XorOut, Slices>::sliceTerms(const Value crc, const Byte *ptr, std::integral_constant<int, J>)
+	{
+		// byte `J` of the block, the register overlaps the first bytes
+		const int shift = (J >= (Width / 8)) ? -1 : (Reflect ? (8 * J) : (Width - 8 - (8 * J)));
+		const Byte b = static_cast<Byte>(ptr[J] ^ ((shift < 0) ? 0 : static_cast<Byte>(crc >> shift)));
+		return static_cast<Value>(TABLE.t[Slices - 1 - J][b] ^ sliceTerms(crc, ptr, std::integral_constant<int, (J + 1)>()));
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr typename Crc<Width, Poly, Reflect, Init, XorOut, Slices>::Value Crc<Width, Poly, Reflect, Init, XorOut, Slices>::sliceTerms(const Value, const Byte *, std::integral_constant<int, Slices>)
+	{
+		return 0;
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr void Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addDataImpl(const Span<const Byte> data)
+	{
+#if defined(CHOCOBO1_HASH_CRC_RUNTIME_DISPATCH)
+		if (!__builtin_is_constant_evaluated())
+		{
+#if defined(__SSE4_2__)
+			if (IS_CRC_32C)
+			{
+				addDataCrc32c(data);
+				return;
+			}
+#endif
+#if defined(__PCLMUL__)
+			if (Reflect && (data.size() >= 64))
+			{
+				addDataClmul(data);
+				return;
+			}
+#endif
+		}
+#endif
+
+		addDataTable(data);
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	constexpr void Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addDataTable(const Span<const Byte> data)
+	{
+		const Byte *ptr = data.data();
+		const std::size_t dataSize = static_cast<std::size_t>(data.size());
+		const int remainShift = ((Slices * 8) >= Width) ? 0 : (Slices * 8);  // the part of the register that outlives a block
+
+		Value crc = m_h;
+		std::size_t i = 0;
+		for (; (i + Slices) <= dataSize; i += Slices, ptr += Slices)
+		{
+			Value next = sliceTerms(crc, ptr, std::integral_constant<int, 0>());
+			if (remainShift > 0)
+				next ^= Reflect ? static_cast<Value>(crc >> remainShift) : static_cast<Value>((crc << remainShift) & MASK);
+			crc = next;
+		}
+
+		// remaining bytes use "standard algorithm"
+		for (; i < dataSize; ++i, ++ptr)
+		{
+			crc = Reflect
+				? static_cast<Value>((crc >> 8) ^ TABLE.t[0][static_cast<Byte>(crc) ^ *ptr])
+				: static_cast<Value>(((crc << 8) & MASK) ^ TABLE.t[0][static_cast<Byte>(crc >> (Width - 8)) ^ *ptr]);
+		}
+		m_h = crc;
+	}
+
+#if defined(CHOCOBO1_HASH_CRC_RUNTIME_DISPATCH)
+#if defined(__SSE4_2__)
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	void Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addDataCrc32c(const Span<const Byte> data)
+	{
+		// `crc32` has a latency of 3 cycles & a throughput of 1, so 3 independent lanes keep it busy
+		// the lanes are merged by shifting the earlier ones over the later ones
+		const auto load = [](const Byte *ptr) -> uint64_t
+		{
+			uint64_t ret = 0;
+			std::memcpy(&ret, ptr, sizeof(ret));
+			return ret;
+		};
+
+		const std::size_t laneSize = CRC_32C_LANE_SIZE;
+		const Byte *ptr = data.data();
+		std::size_t remaining = static_cast<std::size_t>(data.size());
+
+		uint32_t crc = static_cast<uint32_t>(m_h);
+		while (remaining >= (3 * laneSize))
+		{
+			uint64_t a = crc;
+			uint64_t b = 0;
+			uint64_t c = 0;
+			for (std::size_t i = 0; i < laneSize; i += 8)
+			{
+				a = _mm_crc32_u64(a, load(ptr + i));
+				b = _mm_crc32_u64(b, load(ptr + laneSize + i));
+				c = _mm_crc32_u64(c, load(ptr + (2 * laneSize) + i));
+			}
+
+			constexpr Value shiftTwoLanes = xPowModP<Value, Width, Reflect>((8 * 2 * CRC_32C_LANE_SIZE), POLY);
+			constexpr Value shiftOneLane = xPowModP<Value, Width, Reflect>((8 * CRC_32C_LANE_SIZE), POLY);
+			crc = static_cast<uint32_t>(multModP<Value, Width, Reflect>(shiftTwoLanes, static_cast<Value>(a), POLY)
+				^ multModP<Value, Width, Reflect>(shiftOneLane, static_cast<Value>(b), POLY)
+				^ c);
+
+			ptr += (3 * laneSize);
+			remaining -= (3 * laneSize);
+		}
+
+		uint64_t tail = crc;
+		for (; remaining >= 8; remaining -= 8, ptr += 8)
+			tail = _mm_crc32_u64(tail, load(ptr));
+		crc = static_cast<uint32_t>(tail);
+		for (; remaining > 0; --remaining, ++ptr)
+			crc = _mm_crc32_u8(crc, *ptr);
+
+		m_h = static_cast<Value>(crc);
+	}
+#endif
+
+#if defined(__PCLMUL__)
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	void Crc<Width, Poly, Reflect, Init, XorOut, Slices>::addDataClmul(const Span<const Byte> data)
+	{
+		// 128-bit lanes are loaded little-endian, bit `i` of a 64-bit half holds the coefficient of x^(63 - i)
+		// folding a lane over `d` bits: L * x^(d + 64) + H * x^d, the carry-less product is short by one power of x
+		// so the constants are x^(d + 63) & x^(d - 1), left-aligned to 64 bits
+		// the last lane finishes through the tables instead of a Barrett reduction
+		const auto constant = [](const Value c) -> long long
+		{
+			return static_cast<long long>(static_cast<uint64_t>(c) << (64 - Width));
+		};
+		const auto fold = [](const __m128i x, const __m128i k) -> __m128i
+		{
+			return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11));
+		};
+		const auto load = [](const Byte *ptr) -> __m128i
+		{
+			return _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+		};
+
+		constexpr Value k512Low = xPowModP<Value, Width, Reflect>((512 + 63), POLY);
+		constexpr Value k512High = xPowModP<Value, Width, Reflect>((512 - 1), POLY);
+		constexpr Value k128Low = xPowModP<Value, Width, Reflect>((128 + 63), POLY);
+		constexpr Value k128High = xPowModP<Value, Width, Reflect>((128 - 1), POLY);
+		const __m128i k512 = _mm_set_epi64x(constant(k512High), constant(k512Low));
+		const __m128i k128 = _mm_set_epi64x(constant(k128High), constant(k128Low));
+
+		const Byte *ptr = data.data();
+		std::size_t remaining = static_cast<std::size_t>(data.size());
+
+		// the register goes into the first bytes of the message
+		__m128i x0 = _mm_xor_si128(load(ptr), _mm_cvtsi64_si128(static_cast<long long>(m_h)));
+		__m128i x1 = load(ptr + 16);
+		__m128i x2 = load(ptr + 32);
+		__m128i x3 = load(ptr + 48);
+		ptr += 64;
+		remaining -= 64;
+
+		for (; remaining >= 64; remaining -= 64, ptr += 64)
+		{
+			x0 = _mm_xor_si128(fold(x0, k512), load(ptr));
+			x1 = _mm_xor_si128(fold(x1, k512), load(ptr + 16));
+			x2 = _mm_xor_si128(fold(x2, k512), load(ptr + 32));
+			x3 = _mm_xor_si128(fold(x3, k512), load(ptr + 48));
+		}
+
+		x1 = _mm_xor_si128(fold(x0, k128), x1);
+		x2 = _mm_xor_si128(fold(x1, k128), x2);
+		x3 = _mm_xor_si128(fold(x2, k128), x3);
+		for (; remaining >= 16; remaining -= 16, ptr += 16)
+			x3 = _mm_xor_si128(fold(x3, k128), load(ptr));
+
+		Byte last[16] = {};
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(last), x3);
+
+		m_h = 0;
+		addDataTable({last, 16});
+		addDataTable({ptr, remaining});
+	}
+#endif
+#endif
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	std::vector<typename Crc<Width, Poly, Reflect, Init, XorOut, Slices>::Byte> Crc<Width, Poly, Reflect, Init, XorOut, Slices>::serialize() const
+	{
+		// `Slices` only affects speed, it isn't part of the name
+		StateWriter writer("CRC_" + std::to_string(Width) + "_" + std::to_string(Poly) + "_" + std::to_string(Reflect) + "_" + std::to_string(Init) + "_" + std::to_string(XorOut));
+		writer.put(m_h);
+		return writer.data();
+	}
+
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices>
+	bool Crc<Width, Poly, Reflect, Init, XorOut, Slices>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "CRC_" + std::to_string(Width) + "_" + std::to_string(Poly) + "_" + std::to_string(Reflect) + "_" + std::to_string(Init) + "_" + std::to_string(XorOut));
+		const Value h = reader.get<Value>();
+		if (!reader.finished() || ((h & ~MASK) != 0))
+			return false;
+
+		m_h = h;
+		return true;
+	}
+}
+}
+	template <int Width, uint64_t Poly, bool Reflect, uint64_t Init, uint64_t XorOut, int Slices = 8>
+	using Crc = Hash::Crc_NS::Crc<Width, Poly, Reflect, Init, XorOut, Slices>;
+
+	using CRC_32C = Hash::Crc_NS::Crc<32, 0x1EDC6F41, true, 0xFFFFFFFF, 0xFFFFFFFF, 8>;
+	using CRC_64_NVME = Hash::Crc_NS::Crc<64, 0xAD93D23594C93659, true, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 8>;
+	using CRC_64_XZ = Hash::Crc_NS::Crc<64, 0x42F0E1EBA9EA3693, true, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 8>;
+}
+
+#endif  // CHOCOBO1_CRC_H
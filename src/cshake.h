@@ -13,12 +13,12 @@
 #define CHOCOBO1_CSHAKE_H
 
 #include "sha3.h"
+#include "state_serializer.h"
 
 #include <climits>
-#include <cmath>
 #include <cstdint>
-#include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #if (__cplusplus > 201703L)
@@ -45,6 +45,10 @@ namespace Chocobo1
 	// Use these!!
 	// CSHAKE_128(const int digestLengthInBytes, const std::string &name = {}, const std::string &customize = {});
 	// CSHAKE_256(const int digestLengthInBytes, const std::string &name = {}, const std::string &customize = {});
+	//   output of any length can be streamed: `finalize()`, then `squeeze(Span<Byte>)` as many times as needed
+	//   the name & customization string are absorbed once, `reset()` & copies start from the cached state,
+	//   so build one instance per (name, customize) pair & copy it for each message
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, restore into an instance constructed with the same parameters
 }
 
 
@@ -80,6 +84,10 @@ namespace CShake_NS
 			std::string toString() const;
 			std::vector<Byte> toVector() const;
 
+			// XOF output in pieces, call it after `finalize()` as many times as needed
+			// the pieces concatenated are the same bytes as `toVector()` of the total length, but don't mix the two
+			constexpr CShake& squeeze(const Span<Byte> output);
+
 			constexpr CShake& addData(const Span<const Byte> inData);
 			constexpr CShake& addData(const void *ptr, const std::size_t length);
 			template <std::size_t N>
@@ -89,13 +97,22 @@ namespace CShake_NS
 			template <typename T>
 			CShake& addData(const Span<T> inSpan);
 
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// restore into an instance constructed with the same parameters
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
 			constexpr void addDataImpl(const Span<const Byte> data);
 
-			const bool m_customized = false;
+			bool m_customized = false;
 
-			std::unique_ptr<S> m_shake;
-			std::unique_ptr<K> m_keccak;
+			K m_prefixed;  // after bytepad(encode_string(N) || encode_string(S)), unused when not customized
+			union  // the running state, `m_shake` when not customized & `m_keccak` otherwise
+			{
+				S m_shake;
+				K m_keccak;
+			};
 	};
 
 
@@ -108,79 +125,78 @@ namespace CShake_NS
 		return static_cast<R>(x >> s);
 	}
 
-	const auto leftEncode = [](const uint64_t value) -> Buffer<uint8_t, sizeof(value)>
+	constexpr Buffer<uint8_t, (sizeof(uint64_t) + 1)> leftEncode(const uint64_t value)
 	{
-		const uint8_t n = (value == 0) ? 1 : static_cast<uint8_t>(std::lround((std::log2(value) / 8) + 0.5));
+		uint8_t n = 1;
+		while ((n < sizeof(value)) && ((value >> (8 * n)) != 0))
+			++n;
 
-		Buffer<uint8_t, sizeof(value)> ret = {n};
+		Buffer<uint8_t, (sizeof(uint64_t) + 1)> ret = {n};
 		for (int i = (n - 1); i >= 0; --i)
 			ret.fill(ror<uint8_t>(value, (8 * i)));
 
 		return ret;
-	};
+	}
 
 
 	//
 	template <typename S, typename K, int P>
 	constexpr CShake<S, K, P>::CShake(const int digestLength, const std::string &name, const std::string &customize)
 		: m_customized(!(name.empty() && customize.empty()))
+		, m_prefixed(digestLength)
+		, m_keccak(digestLength)
 	{
-		static_assert((P >= 0), "Template parameter value invalid: P");
+		static_assert((P > 0), "Template parameter value invalid: P");
 		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+		static_assert((std::is_trivially_copyable<S>::value && std::is_trivially_copyable<K>::value), "Union members must be trivially copyable");
 
 		if (!m_customized)
 		{
-			m_shake = std::make_unique<S>(digestLength);
+			m_shake = S(digestLength);
 			return;
 		}
-		else
-		{
-			m_keccak = std::make_unique<K>(digestLength);
-		}
 
-		const auto processString = [this](const std::string &str, size_t &length) -> void
+		size_t length = 0;
+		const auto absorb = [this, &length](const Span<const Byte> data) -> void
 		{
-			const auto encodedStr = leftEncode(str.size() * 8);
-			addData({encodedStr.data(), encodedStr.size()});
-			length += encodedStr.size();
-			addData(str.data(), str.size());
-			length += str.size();
+			m_prefixed.addData(data);
+			length += static_cast<size_t>(data.size());
 		};
-		const auto bytepadCount = [](const size_t length, const size_t target) -> size_t
+		const auto absorbString = [&absorb](const std::string &str) -> void
 		{
-			return ((target - (length % target)) % target);
+			const auto encoded = leftEncode(static_cast<uint64_t>(str.size()) * 8);
+			absorb({encoded.data(), encoded.size()});
+			absorb({reinterpret_cast<const Byte *>(str.data()), str.size()});
 		};
 
-		size_t length = 0;
-
-		const auto encodedW = leftEncode(P);
-		addData({encodedW.data(), encodedW.size()});
-		length += encodedW.size();
+		const auto encodedRate = leftEncode(P);
+		absorb({encodedRate.data(), encodedRate.size()});
+		absorbString(name);
+		absorbString(customize);
 
-		processString(name, length);
-		processString(customize, length);
+		const size_t rate = P;
+		const Byte zeros[P] = {};
+		absorb({zeros, ((rate - (length % rate)) % rate)});
 
-		const Buffer<Byte, 1> zero {0};
-		for (int i = 0; i < static_cast<int>(bytepadCount(length, P)); ++i)
-			addData({zero.data(), zero.size()});
+		reset();
 	}
 
 	template <typename S, typename K, int P>
 	constexpr void CShake<S, K, P>::reset()
 	{
 		if (!m_customized)
-			m_shake->reset();
+			m_shake.reset();
 		else
-			m_keccak->reset();
+			m_keccak = m_prefixed;
 	}
 
 	template <typename S, typename K, int P>
 	constexpr CShake<S, K, P>& CShake<S, K, P>::finalize()
 	{
 		if (!m_customized)
-			m_shake->finalize();
+			m_shake.finalize();
 		else
-			m_keccak->finalize();
+			m_keccak.finalize();
 		return (*this);
 	}
 
@@ -188,18 +204,28 @@ namespace CShake_NS
 	std::string CShake<S, K, P>::toString() const
 	{
 		if (!m_customized)
-			return m_shake->toString();
+			return m_shake.toString();
 		else
-			return m_keccak->toString();
+			return m_keccak.toString();
 	}
 
 	template <typename S, typename K, int P>
 	std::vector<typename CShake<S, K, P>::Byte> CShake<S, K, P>::toVector() const
 	{
 		if (!m_customized)
-			return m_shake->toVector();
+			return m_shake.toVector();
+		else
+			return m_keccak.toVector();
+	}
+
+	template <typename S, typename K, int P>
+	constexpr CShake<S, K, P>& CShake<S, K, P>::squeeze(const Span<Byte> output)
+	{
+		if (!m_customized)
+			m_shake.squeeze(output);
 		else
-			return m_keccak->toVector();
+			m_keccak.squeeze(output);
+		return (*this);
 	}
 
 	template <typename S, typename K, int P>
@@ -237,13 +263,37 @@ namespace CShake_NS
 		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
 	}
 
+	template <typename S, typename K, int P>
+	std::vector<typename CShake<S, K, P>::Byte> CShake<S, K, P>::serialize() const
+	{
+		StateWriter writer("CShake_" + std::to_string(P));
+		writer.put(static_cast<uint8_t>(m_customized));
+		writer.putNested(!m_customized ? m_shake.serialize() : m_keccak.serialize());
+		return writer.data();
+	}
+
+	template <typename S, typename K, int P>
+	bool CShake<S, K, P>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "CShake_" + std::to_string(P));
+		const uint8_t customized = reader.get<uint8_t>();
+		const std::vector<Byte> running = reader.getNested();
+		if (!reader.finished() || (customized != static_cast<uint8_t>(m_customized)))
+			return false;
+
+		if (!m_customized)
+			return m_shake.restore({running.data(), running.size()});
+		else
+			return m_keccak.restore({running.data(), running.size()});
+	}
+
 	template <typename S, typename K, int P>
 	constexpr void CShake<S, K, P>::addDataImpl(const Span<const Byte> data)
 	{
 		if (!m_customized)
-			m_shake->addData(data);
+			m_shake.addData(data);
 		else
-			m_keccak->addData(data);
+			m_keccak.addData(data);
 	}
 }
 }
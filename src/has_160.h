@@ -12,12 +12,16 @@
 #ifndef CHOCOBO1_HAS_160_H
 #define CHOCOBO1_HAS_160_H
 
+#include "state_serializer.h"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <climits>
 #include <cmath>
 #include <cstdint>
 #include <initializer_list>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -45,6 +49,11 @@ namespace Chocobo1
 {
 	// Use these!!
 	// HAS_160();
+	//   `peekDigest()` returns the digest of the data so far without finalizing, more data can follow
+	//   `exportState()` & `importState(State)` copy the raw running state, e.g. hash a shared prefix once & fork it per suffix
+	//   `importState()` throws `std::invalid_argument` unless `State::length` is whole blocks & `State::bufferSize` is less than a block
+	//   `compressBlocks(blocks)` feeds whole 64-byte blocks directly: `blocks.size()` must be a multiple of 64 (block-aligned) & no bytes may be pending from `addData()`, otherwise it throws `std::invalid_argument`
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, `restore()` returns false on a malformed snapshot
 }
 
 
@@ -58,7 +67,7 @@ namespace Hash
 #if __cplusplus >= 201703L
 #define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
 #else
-#define CONSTEXPR_CPP17_CHOCOBO1_HASH
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
 #endif
 #endif
 
@@ -175,6 +184,8 @@ namespace HAS160_NS
 			using Byte = uint8_t;
 			using ResultArrayType = std::array<Byte, 20>;
 
+			static constexpr int BLOCK_SIZE = 64;
+
 #if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
 			template <typename T, std::size_t Extent = std::dynamic_extent>
 			using Span = std::span<T, Extent>;
@@ -183,6 +194,15 @@ namespace HAS160_NS
 			using Span = gsl::span<T, Extent>;
 #endif
 
+			struct State
+			{
+				// everything `importState()` needs to resume hashing
+				std::array<uint32_t, 5> h {};  // chaining value
+				uint64_t length = 0;  // bytes compressed into `h`
+				std::array<Byte, BLOCK_SIZE> buffer {};  // pending bytes, less than a block
+				std::size_t bufferSize = 0;
+			};
+
 
 			constexpr HAS_160();
 
@@ -192,6 +212,7 @@ namespace HAS160_NS
 			std::string toString() const;
 			std::vector<Byte> toVector() const;
 			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;
+			ResultArrayType peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
 
 			HAS_160& addData(const Span<const Byte> inData);
 			HAS_160& addData(const void *ptr, const std::size_t length);
@@ -202,11 +223,18 @@ namespace HAS160_NS
 			template <typename T>
 			HAS_160& addData(const Span<T> inSpan);
 
+			// raw state access, e.g. hash a shared prefix once & fork it for many suffixes
+			CONSTEXPR_CPP17_CHOCOBO1_HASH State exportState() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH void importState(const State &state);
+			inline HAS_160& compressBlocks(const Span<const Byte> blocks);  // whole blocks only, requires no pending bytes
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
 			void addDataImpl(const Span<const Byte> data);
 
-			static constexpr int BLOCK_SIZE = 64;
-
 			Buffer<Byte, (BLOCK_SIZE * 2)> m_buffer;  // x2 for paddings
 			uint64_t m_sizeCounter = 0;
 
@@ -278,7 +306,7 @@ namespace HAS160_NS
 		m_h[4] = 0xC3D2E1F0;
 	}
 
-	HAS_160& HAS_160::finalize()
+	inline HAS_160& HAS_160::finalize()
 	{
 		m_sizeCounter += m_buffer.size();
 
@@ -286,7 +314,7 @@ namespace HAS160_NS
 		m_buffer.fill(1 << 7);
 
 		// append paddings
-		const size_t len = BLOCK_SIZE - ((m_buffer.size() + 8) % BLOCK_SIZE);
+		const size_t len = (BLOCK_SIZE - ((m_buffer.size() + 8) % BLOCK_SIZE)) % BLOCK_SIZE;
 		m_buffer.fill(0, (len + 8));
 
 		// append size in bits
@@ -305,7 +333,7 @@ namespace HAS160_NS
 		return (*this);
 	}
 
-	std::string HAS_160::toString() const
+	inline std::string HAS_160::toString() const
 	{
 		const auto a = toArray();
 		std::string ret;
@@ -324,7 +352,7 @@ namespace HAS160_NS
 		return ret;
 	}
 
-	std::vector<HAS_160::Byte> HAS_160::toVector() const
+	inline std::vector<HAS_160::Byte> HAS_160::toVector() const
 	{
 		const auto a = toArray();
 		return {a.begin(), a.end()};
@@ -346,7 +374,13 @@ namespace HAS160_NS
 		return ret;
 	}
 
-	HAS_160& HAS_160::addData(const Span<const Byte> inData)
+	inline HAS_160::ResultArrayType HAS_160::peekDigest() const
+	{
+		HAS_160 copy = *this;
+		return copy.finalize().toArray();
+	}
+
+	inline HAS_160& HAS_160::addData(const Span<const Byte> inData)
 	{
 		Span<const Byte> data = inData;
 
@@ -380,7 +414,7 @@ namespace HAS160_NS
 		return (*this);
 	}
 
-	HAS_160& HAS_160::addData(const void *ptr, const std::size_t length)
+	inline HAS_160& HAS_160::addData(const void *ptr, const std::size_t length)
 	{
 		// Span::size_type = std::size_t
 		return addData({static_cast<const Byte*>(ptr), length});
@@ -404,7 +438,43 @@ namespace HAS160_NS
 		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
 	}
 
-	void HAS_160::addDataImpl(const Span<const Byte> data)
+	CONSTEXPR_CPP17_CHOCOBO1_HASH HAS_160::State HAS_160::exportState() const
+	{
+		State ret;
+		for (int i = 0; i < 5; ++i)
+			ret.h[i] = m_h[i];
+		ret.length = m_sizeCounter;
+		for (std::size_t i = 0; i < m_buffer.size(); ++i)
+			ret.buffer[i] = m_buffer[i];
+		ret.bufferSize = m_buffer.size();
+		return ret;
+	}
+
+	CONSTEXPR_CPP17_CHOCOBO1_HASH void HAS_160::importState(const State &state)
+	{
+		if (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE))
+			throw std::invalid_argument("HAS_160: importState() needs less than a block of pending bytes");
+		if ((state.length % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("HAS_160: importState() needs a length of whole blocks");
+
+		for (int i = 0; i < 5; ++i)
+			m_h[i] = state.h[i];
+		m_sizeCounter = state.length;
+		m_buffer = {state.buffer.begin(), (state.buffer.begin() + state.bufferSize)};
+	}
+
+	inline HAS_160& HAS_160::compressBlocks(const Span<const Byte> blocks)
+	{
+		if (!m_buffer.empty())
+			throw std::invalid_argument("HAS_160: compressBlocks() called with bytes pending from addData()");
+		if ((blocks.size() % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("HAS_160: compressBlocks() takes whole blocks only");
+
+		addDataImpl(blocks);
+		return (*this);
+	}
+
+	inline void HAS_160::addDataImpl(const Span<const Byte> data)
 	{
 		assert((data.size() % BLOCK_SIZE) == 0);
 
@@ -559,6 +629,37 @@ namespace HAS160_NS
 			m_h[4] += e;
 		}
 	}
+
+	inline std::vector<HAS_160::Byte> HAS_160::serialize() const
+	{
+		const State state = exportState();
+
+		StateWriter writer("HAS_160");
+		for (const auto word : state.h)
+			writer.put(word);
+		writer.put(state.length);
+		writer.put(static_cast<uint32_t>(state.bufferSize));
+		writer.put(state.buffer.data(), state.bufferSize);
+		return writer.data();
+	}
+
+	inline bool HAS_160::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "HAS_160");
+		State state;
+		for (auto &word : state.h)
+			word = reader.get<uint32_t>();
+		state.length = reader.get<uint64_t>();
+		state.bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || ((state.length % BLOCK_SIZE) != 0) || (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE)))
+			return false;
+		reader.get(state.buffer.data(), state.bufferSize);
+		if (!reader.finished())
+			return false;
+
+		importState(state);
+		return true;
+	}
 }
 }
 	using HAS_160 = Hash::HAS160_NS::HAS_160;
@@ -0,0 +1,233 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_HASH_MANY_H
+#define CHOCOBO1_HASH_MANY_H
+
+#include "blake2.h"
+#include "blake2s.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// hashMany<H>(Span<const Span<const Byte>> inputs, Span<typename H::ResultArrayType> outputs);
+	//   `H` is any hash class providing `toArray()`, e.g. `hashMany<SHA2_256>(inputs, outputs)`
+	//   `inputs` & `outputs` of different sizes throw `std::invalid_argument`
+
+	// BLAKE2b (`Blake2`) & BLAKE2s come with a multi-lane kernel: messages with the same block count are compressed
+	//   together, in the SIMD lanes of `addBlocks()` when built with AVX2. The other algorithms hash one message after another.
+
+	// Algorithms may plug in a multi-lane kernel by specializing:
+	// template <> struct Hash::HashMany_NS::MultiLane<H> { ... };
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+namespace HashMany_NS
+{
+	using Byte = uint8_t;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+	template <typename T, std::size_t Extent = std::dynamic_extent>
+	using Span = std::span<T, Extent>;
+#else
+	template <typename T, std::size_t Extent = gsl::dynamic_extent>
+	using Span = gsl::span<T, Extent>;
+#endif
+
+	template <typename H>
+	struct MultiLane
+	{
+		// default: no multi-lane kernel, every input goes through the scalar loop
+		// a specialization should provide:
+		//   static constexpr int LANES;         // number of messages processed together
+		//   static constexpr int BLOCK_SIZE;    // inputs are bucketed by `size / BLOCK_SIZE`
+		//   static void hash(const Span<const Byte> *inputs, typename H::ResultArrayType *const *outputs);
+		//     `inputs` & `outputs` have `LANES` elements, all inputs have the same block count
+		static constexpr int LANES = 1;
+		static constexpr int BLOCK_SIZE = 64;
+	};
+
+	template <typename B>
+	struct Blake2MultiLane
+	{
+		// on top of `B::addBlocks()` & `B::finalizeBlocks()`, for BLAKE2b & BLAKE2s with the default parameters
+		static constexpr int LANES = B::SIMD_LANES;
+		static constexpr int BLOCK_SIZE = B::BLOCK_SIZE;
+
+		static void hash(const Span<const Byte> *inputs, typename B::ResultArrayType *const *outputs)
+		{
+			// the last block is compressed with the final flag, the blocks before it are shared by all lanes
+			std::size_t blocks = SIZE_MAX;
+			bool sameSize = true;
+			for (int i = 0; i < LANES; ++i)
+			{
+				const std::size_t size = static_cast<std::size_t>(inputs[i].size());
+				blocks = std::min(blocks, ((size == 0) ? 0 : ((size - 1) / BLOCK_SIZE)));
+				sameSize = sameSize && (inputs[i].size() == inputs[0].size());
+			}
+
+			B states[LANES];
+			B *statePtrs[LANES] = {};
+			const Byte *data[LANES] = {};
+			const Byte *tails[LANES] = {};
+			for (int i = 0; i < LANES; ++i)
+			{
+				statePtrs[i] = &states[i];
+				data[i] = inputs[i].data();
+				tails[i] = inputs[i].data() + (blocks * BLOCK_SIZE);
+			}
+			B::addBlocks(statePtrs, data, blocks);
+
+			if (sameSize)
+			{
+				B::finalizeBlocks(statePtrs, tails, (static_cast<std::size_t>(inputs[0].size()) - (blocks * BLOCK_SIZE)));
+			}
+			else
+			{
+				// the tails are up to 2 blocks long & differ in size
+				for (int i = 0; i < LANES; ++i)
+					states[i].addData({tails[i], (static_cast<std::size_t>(inputs[i].size()) - (blocks * BLOCK_SIZE))}).finalize();
+			}
+
+			for (int i = 0; i < LANES; ++i)
+				*outputs[i] = states[i].toArray();
+		}
+	};
+
+	template <>
+	struct MultiLane<Blake2_NS::Blake2> : Blake2MultiLane<Blake2_NS::Blake2>
+	{
+	};
+
+	template <>
+	struct MultiLane<Blake2s_NS::Blake2s> : Blake2MultiLane<Blake2s_NS::Blake2s>
+	{
+	};
+
+
+	template <typename H>
+	void hashScalar(const Span<const Span<const Byte>> inputs, const Span<typename H::ResultArrayType> outputs, const Span<const std::size_t> indexes)
+	{
+		H hash;
+		for (const std::size_t idx : indexes)
+		{
+			hash.reset();
+			outputs[idx] = hash.addData(inputs[idx]).finalize().toArray();
+		}
+	}
+
+	template <typename H>
+	void hashBuckets(const Span<const Span<const Byte>> inputs, const Span<typename H::ResultArrayType> outputs, std::vector<std::size_t> &order, std::false_type)
+	{
+		hashScalar<H>(inputs, outputs, order);
+	}
+
+	template <typename H>
+	void hashBuckets(const Span<const Span<const Byte>> inputs, const Span<typename H::ResultArrayType> outputs, std::vector<std::size_t> &order, std::true_type)
+	{
+		using Kernel = MultiLane<H>;
+		constexpr int LANES = Kernel::LANES;
+
+		// bucket by block count, so that every lane of a kernel call does the same amount of work
+		const auto blockCount = [&inputs](const std::size_t idx) -> std::size_t
+		{
+			return (static_cast<std::size_t>(inputs[idx].size()) / Kernel::BLOCK_SIZE);
+		};
+		std::stable_sort(order.begin(), order.end(), [&blockCount](const std::size_t a, const std::size_t b)
+		{
+			return (blockCount(a) < blockCount(b));
+		});
+
+		std::vector<std::size_t> leftovers;
+		std::size_t begin = 0;
+		while (begin < order.size())
+		{
+			const std::size_t count = blockCount(order[begin]);
+			std::size_t end = begin + 1;
+			while ((end < order.size()) && (blockCount(order[end]) == count))
+				++end;
+
+			std::size_t i = begin;
+			for (; (i + LANES) <= end; i += LANES)
+			{
+				Span<const Byte> laneInputs[LANES];
+				typename H::ResultArrayType *laneOutputs[LANES] = {};
+				for (int lane = 0; lane < LANES; ++lane)
+				{
+					laneInputs[lane] = inputs[order[i + lane]];
+					laneOutputs[lane] = &outputs[order[i + lane]];
+				}
+				Kernel::hash(laneInputs, laneOutputs);
+			}
+			leftovers.insert(leftovers.end(), (order.begin() + i), (order.begin() + end));
+
+			begin = end;
+		}
+
+		// buckets smaller than `LANES` fall back to the scalar loop
+		hashScalar<H>(inputs, outputs, leftovers);
+	}
+
+	template <typename H>
+	void hashMany(const Span<const Span<const Byte>> inputs, const Span<typename H::ResultArrayType> outputs)
+	{
+		static_assert((MultiLane<H>::LANES >= 1), "Invalid MultiLane::LANES");
+
+		if (inputs.size() != outputs.size())
+			throw std::invalid_argument("hashMany: inputs & outputs must have the same size");
+
+		std::vector<std::size_t> order(static_cast<std::size_t>(inputs.size()));
+		std::iota(order.begin(), order.end(), std::size_t(0));
+
+		hashBuckets<H>(inputs, outputs, order, std::integral_constant<bool, (MultiLane<H>::LANES > 1)> {});
+	}
+}
+}
+	template <typename H>
+	void hashMany(const Hash::HashMany_NS::Span<const Hash::HashMany_NS::Span<const Hash::HashMany_NS::Byte>> inputs, const Hash::HashMany_NS::Span<typename H::ResultArrayType> outputs)
+	{
+		Hash::HashMany_NS::hashMany<H>(inputs, outputs);
+	}
+}
+
+#endif  // CHOCOBO1_HASH_MANY_H
@@ -0,0 +1,131 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_HKDF_H
+#define CHOCOBO1_HKDF_H
+
+#include "hmac.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// HKDF<H>::extract(const Span<const Byte> salt, const Span<const Byte> ikm);  // returns the PRK
+	// HKDF<H>::expand(const Span<const Byte> prk, const Span<const Byte> info, const Span<Byte> output);
+	// HKDF<H>::derive(const Span<const Byte> salt, const Span<const Byte> ikm, const Span<const Byte> info, const Span<Byte> output);
+	//   `H` is a hash class accepted by `HMAC<H>`, the PRK pad blocks are absorbed once for all output blocks
+	//   an `output` longer than 255 digests throws `std::invalid_argument`
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+namespace HKDF_NS
+{
+	template <typename H>
+	class HKDF
+	{
+		// https://tools.ietf.org/html/rfc5869
+
+		public:
+			using Byte = uint8_t;
+			using ResultArrayType = typename H::ResultArrayType;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			static ResultArrayType extract(const Span<const Byte> salt, const Span<const Byte> ikm);
+			static void expand(const Span<const Byte> prk, const Span<const Byte> info, const Span<Byte> output);  // `output` is at most 255 digests long
+			static void derive(const Span<const Byte> salt, const Span<const Byte> ikm, const Span<const Byte> info, const Span<Byte> output);
+	};
+
+
+	//
+	template <typename H>
+	typename HKDF<H>::ResultArrayType HKDF<H>::extract(const Span<const Byte> salt, const Span<const Byte> ikm)
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+
+		// an absent salt is the same as a zero-filled one, both pad to the same key block
+		return HMAC<H>(salt).addData(ikm).finalize().toArray();
+	}
+
+	template <typename H>
+	void HKDF<H>::expand(const Span<const Byte> prk, const Span<const Byte> info, const Span<Byte> output)
+	{
+		const std::size_t digestSize = std::tuple_size<ResultArrayType>::value;
+		const std::size_t outputSize = static_cast<std::size_t>(output.size());
+		if (outputSize > (255 * digestSize))
+			throw std::invalid_argument("HKDF: output must be at most 255 digests long");
+
+		// each block depends on the previous one, only the pad states are shared
+		HMAC<H> prf(prk);
+		ResultArrayType t {};
+		for (std::size_t offset = 0, counter = 1; offset < outputSize; offset += digestSize, ++counter)
+		{
+			if (counter > 1)
+				prf.addData(Span<const Byte>(t.data(), t.size()));
+			const Byte index[1] = {static_cast<Byte>(counter)};
+			t = prf.addData(info).addData(index).finalize().toArray();
+			prf.reset();
+
+			const std::size_t len = std::min(digestSize, (outputSize - offset));
+			std::copy(t.begin(), (t.begin() + len), (output.begin() + offset));
+		}
+	}
+
+	template <typename H>
+	void HKDF<H>::derive(const Span<const Byte> salt, const Span<const Byte> ikm, const Span<const Byte> info, const Span<Byte> output)
+	{
+		const ResultArrayType prk = extract(salt, ikm);
+		expand({prk.data(), prk.size()}, info, output);
+	}
+}
+}
+	template <typename H>
+	using HKDF = Hash::HKDF_NS::HKDF<H>;
+}
+
+#endif  // CHOCOBO1_HKDF_H
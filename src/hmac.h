@@ -0,0 +1,1032 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_HMAC_H
+#define CHOCOBO1_HMAC_H
+
+#include "sha2_256.h"
+#include "sha2_512.h"
+#include "state_serializer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// HMAC<H>(const HMAC<H>::Span<const HMAC<H>::Byte> key);
+	//   `H` is a Merkle-Damgard hash class providing `BLOCK_SIZE` & `toArray()`, e.g. `HMAC<SHA2_256>(key)`
+	//   the padded key blocks are absorbed once, `reset()` & copies start from the cached inner state
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, restore into an instance constructed with the same key
+	//   the snapshots hold the keyed inner state, keep them as secret as the key
+	//
+	// HMAC<H>::hashMany(Span<const Span<const Byte>> inputs, Span<HMAC<H>::ResultArrayType> outputs) const;
+	//   MAC many messages with the same key, every message starts from the cached pad states
+	//   `inputs` & `outputs` of different sizes throw `std::invalid_argument`
+	//   `SHA2_256` & `SHA2_512` compress the messages side by side in SIMD lanes, the other algorithms hash one message after another
+
+	// Algorithms may plug in a raw multi-lane kernel by specializing:
+	// template <> struct Hash::HMAC_NS::Midstate<H> { ... };
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+namespace HMAC_NS
+{
+	using Byte = uint8_t;
+
+	template <typename H>
+	struct Midstate
+	{
+		// default: no raw kernel, every message starts from copies of the cached `HMAC<H>` states
+		// a specialization should provide:
+		//   static constexpr bool RAW = true;
+		//   using State;                                                   // chaining value
+		//   static State padState(const Byte *block);                      // chaining value after one `H::BLOCK_SIZE` block
+		//   static State midstate(const H &hash);                          // chaining value of `hash`, no bytes may be pending
+		//   static State load(const typename H::ResultArrayType &digest);
+		//   static typename H::ResultArrayType store(const State &state);
+		//   static std::size_t padTail(const Byte *tail, const std::size_t tailSize, const uint64_t totalLength, Byte *out);
+		//     writes the final blocks of a message: `tail` (shorter than a block) & the padding, returns the block count (1 or 2)
+		//   static void compressLanes(State *states, const Byte *const *blocks, const std::size_t count);
+		//     compresses `blocks[i]` into `states[i]` for each of the `count` messages
+		//   static void iterate(const State *inner, const State *outer, State *u, State *t, const std::size_t count, const uint32_t rounds);
+		//     for each of the `count` chains, `rounds` times: U = HMAC(U), T ^= U
+		static constexpr bool RAW = false;
+	};
+
+
+	// SHA-2 on chaining values, the digest of one iteration is the whole message of the next
+	template <typename Word>
+	struct Sha2Constants;
+
+	template <>
+	struct Sha2Constants<uint32_t>
+	{
+		static constexpr int ROUNDS = 64;
+		static constexpr unsigned int BSIG0_0 = 2, BSIG0_1 = 13, BSIG0_2 = 22;
+		static constexpr unsigned int BSIG1_0 = 6, BSIG1_1 = 11, BSIG1_2 = 25;
+		static constexpr unsigned int SSIG0_0 = 7, SSIG0_1 = 18, SSIG0_2 = 3;
+		static constexpr unsigned int SSIG1_0 = 17, SSIG1_1 = 19, SSIG1_2 = 10;
+
+		static constexpr uint32_t k(const int t)
+		{
+			return SHA2_256_NS::kTable[t];
+		}
+
+		static constexpr std::array<uint32_t, 8> initialState()
+		{
+			return {{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}};
+		}
+	};
+
+	template <>
+	struct Sha2Constants<uint64_t>
+	{
+		static constexpr int ROUNDS = 80;
+		static constexpr unsigned int BSIG0_0 = 28, BSIG0_1 = 34, BSIG0_2 = 39;
+		static constexpr unsigned int BSIG1_0 = 14, BSIG1_1 = 18, BSIG1_2 = 41;
+		static constexpr unsigned int SSIG0_0 = 1, SSIG0_1 = 8, SSIG0_2 = 7;
+		static constexpr unsigned int SSIG1_0 = 19, SSIG1_1 = 61, SSIG1_2 = 6;
+
+		static constexpr uint64_t k(const int t)
+		{
+			return SHA2_512_NS::kTable[t];
+		}
+
+		static constexpr std::array<uint64_t, 8> initialState()
+		{
+			return {{0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1
+				, 0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179}};
+		}
+	};
+
+	template <typename Word>
+	struct ScalarOps
+	{
+		using Vector = Word;
+		static constexpr int LANES = 1;
+
+		static Vector load(const Word *p)
+		{
+			return *p;
+		}
+		static void store(Word *p, const Vector x)
+		{
+			*p = x;
+		}
+		static Vector set1(const Word x)
+		{
+			return x;
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return static_cast<Word>(a + b);
+		}
+		static Vector and_(const Vector a, const Vector b)
+		{
+			return (a & b);
+		}
+		static Vector or_(const Vector a, const Vector b)
+		{
+			return (a | b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return (a ^ b);
+		}
+		template <unsigned int S>
+		static Vector shr(const Vector x)
+		{
+			return (x >> S);
+		}
+		template <unsigned int S>
+		static Vector rotr(const Vector x)
+		{
+			return ((x >> S) | (x << ((sizeof(Word) * 8) - S)));
+		}
+	};
+
+#if defined(__SSE2__)
+	template <typename Word>
+	struct Sse2Ops;
+
+	template <>
+	struct Sse2Ops<uint32_t>
+	{
+		using Vector = __m128i;
+		static constexpr int LANES = 4;
+
+		static Vector load(const uint32_t *p)
+		{
+			return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		}
+		static void store(uint32_t *p, const Vector x)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(p), x);
+		}
+		static Vector set1(const uint32_t x)
+		{
+			return _mm_set1_epi32(static_cast<int>(x));
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm_add_epi32(a, b);
+		}
+		static Vector and_(const Vector a, const Vector b)
+		{
+			return _mm_and_si128(a, b);
+		}
+		static Vector or_(const Vector a, const Vector b)
+		{
+			return _mm_or_si128(a, b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return _mm_xor_si128(a, b);
+		}
+		template <unsigned int S>
+		static Vector shr(const Vector x)
+		{
+			return _mm_srli_epi32(x, S);
+		}
+		template <unsigned int S>
+		static Vector rotr(const Vector x)
+		{
+			return _mm_or_si128(_mm_srli_epi32(x, S), _mm_slli_epi32(x, (32 - S)));
+		}
+	};
+
+	template <>
+	struct Sse2Ops<uint64_t>
+	{
+		using Vector = __m128i;
+		static constexpr int LANES = 2;
+
+		static Vector load(const uint64_t *p)
+		{
+			return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		}
+		static void store(uint64_t *p, const Vector x)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(p), x);
+		}
+		static Vector set1(const uint64_t x)
+		{
+			return _mm_set1_epi64x(static_cast<long long>(x));
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm_add_epi64(a, b);
+		}
+		static Vector and_(const Vector a, const Vector b)
+		{
+			return _mm_and_si128(a, b);
+		}
+		static Vector or_(const Vector a, const Vector b)
+		{
+			return _mm_or_si128(a, b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return _mm_xor_si128(a, b);
+		}
+		template <unsigned int S>
+		static Vector shr(const Vector x)
+		{
+			return _mm_srli_epi64(x, S);
+		}
+		template <unsigned int S>
+		static Vector rotr(const Vector x)
+		{
+			return _mm_or_si128(_mm_srli_epi64(x, S), _mm_slli_epi64(x, (64 - S)));
+		}
+	};
+#endif
+
+#if defined(__AVX2__)
+	template <typename Word>
+	struct Avx2Ops;
+
+	template <>
+	struct Avx2Ops<uint32_t>
+	{
+		using Vector = __m256i;
+		static constexpr int LANES = 8;
+
+		static Vector load(const uint32_t *p)
+		{
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		}
+		static void store(uint32_t *p, const Vector x)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+		}
+		static Vector set1(const uint32_t x)
+		{
+			return _mm256_set1_epi32(static_cast<int>(x));
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm256_add_epi32(a, b);
+		}
+		static Vector and_(const Vector a, const Vector b)
+		{
+			return _mm256_and_si256(a, b);
+		}
+		static Vector or_(const Vector a, const Vector b)
+		{
+			return _mm256_or_si256(a, b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return _mm256_xor_si256(a, b);
+		}
+		template <unsigned int S>
+		static Vector shr(const Vector x)
+		{
+			return _mm256_srli_epi32(x, S);
+		}
+		template <unsigned int S>
+		static Vector rotr(const Vector x)
+		{
+			return _mm256_or_si256(_mm256_srli_epi32(x, S), _mm256_slli_epi32(x, (32 - S)));
+		}
+	};
+
+	template <>
+	struct Avx2Ops<uint64_t>
+	{
+		using Vector = __m256i;
+		static constexpr int LANES = 4;
+
+		static Vector load(const uint64_t *p)
+		{
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		}
+		static void store(uint64_t *p, const Vector x)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+		}
+		static Vector set1(const uint64_t x)
+		{
+			return _mm256_set1_epi64x(static_cast<long long>(x));
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm256_add_epi64(a, b);
+		}
+		static Vector and_(const Vector a, const Vector b)
+		{
+			return _mm256_and_si256(a, b);
+		}
+		static Vector or_(const Vector a, const Vector b)
+		{
+			return _mm256_or_si256(a, b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return _mm256_xor_si256(a, b);
+		}
+		template <unsigned int S>
+		static Vector shr(const Vector x)
+		{
+			return _mm256_srli_epi64(x, S);
+		}
+		template <unsigned int S>
+		static Vector rotr(const Vector x)
+		{
+			return _mm256_or_si256(_mm256_srli_epi64(x, S), _mm256_slli_epi64(x, (64 - S)));
+		}
+	};
+#endif
+
+	template <typename Word>
+	struct Sha2Midstate
+	{
+		static constexpr bool RAW = true;
+		using State = std::array<Word, 8>;
+
+		template <typename Ops>
+		static void compress(typename Ops::Vector (&state)[8], const typename Ops::Vector (&block)[16]);
+
+		static void loadBlock(const Byte *block, Word (&words)[16]);
+		template <typename Ops>
+		static void gather(const State *src, typename Ops::Vector (&dst)[8]);
+		template <typename Ops>
+		static void scatter(const typename Ops::Vector (&src)[8], State *dst);
+
+		static State padState(const Byte *block);
+		template <typename H>
+		static State midstate(const H &hash);
+
+		template <typename ResultArrayType>
+		static State load(const ResultArrayType &digest);
+		template <typename ResultArrayType>
+		static ResultArrayType store(const State &state);
+
+		static std::size_t padTail(const Byte *tail, const std::size_t tailSize, const uint64_t totalLength, Byte *out);
+		template <typename Ops>
+		static void compressLanesWith(State *states, const Byte *const *blocks);
+		static void compressLanes(State *states, const Byte *const *blocks, const std::size_t count);
+
+		template <typename Ops>
+		static void iterateLanes(const State *inner, const State *outer, State *u, State *t, const uint32_t rounds);
+		static void iterate(const State *inner, const State *outer, State *u, State *t, const std::size_t count, const uint32_t rounds);
+	};
+
+	template <typename Word>
+	template <typename Ops>
+	void Sha2Midstate<Word>::compress(typename Ops::Vector (&state)[8], const typename Ops::Vector (&block)[16])
+	{
+		// one block in each lane, same as `addDataImpl()` of the hash classes
+		using C = Sha2Constants<Word>;
+		using Vector = typename Ops::Vector;
+
+		const auto ssig0 = [](const Vector x) -> Vector
+		{
+			return Ops::xor_(Ops::xor_(Ops::template rotr<C::SSIG0_0>(x), Ops::template rotr<C::SSIG0_1>(x)), Ops::template shr<C::SSIG0_2>(x));
+		};
+		const auto ssig1 = [](const Vector x) -> Vector
+		{
+			return Ops::xor_(Ops::xor_(Ops::template rotr<C::SSIG1_0>(x), Ops::template rotr<C::SSIG1_1>(x)), Ops::template shr<C::SSIG1_2>(x));
+		};
+		const auto bsig0 = [](const Vector x) -> Vector
+		{
+			return Ops::xor_(Ops::xor_(Ops::template rotr<C::BSIG0_0>(x), Ops::template rotr<C::BSIG0_1>(x)), Ops::template rotr<C::BSIG0_2>(x));
+		};
+		const auto bsig1 = [](const Vector x) -> Vector
+		{
+			return Ops::xor_(Ops::xor_(Ops::template rotr<C::BSIG1_0>(x), Ops::template rotr<C::BSIG1_1>(x)), Ops::template rotr<C::BSIG1_2>(x));
+		};
+
+		Vector w[16];
+		std::copy(block, (block + 16), w);
+
+		Vector a = state[0];
+		Vector b = state[1];
+		Vector c = state[2];
+		Vector d = state[3];
+		Vector e = state[4];
+		Vector f = state[5];
+		Vector g = state[6];
+		Vector h = state[7];
+
+		// round `t + i`, `i` is spelled out so the message schedule indexes are constants
+		const auto round = [&](Vector &a, Vector &b, Vector &c, Vector &d, Vector &e, Vector &f, Vector &g, Vector &h, const int t, const int i) -> void
+		{
+			if (t >= 16)
+				w[i] = Ops::add(Ops::add(ssig1(w[(i + 14) % 16]), w[(i + 9) % 16]), Ops::add(ssig0(w[(i + 1) % 16]), w[i]));
+
+			const Vector ch = Ops::xor_(Ops::and_(e, Ops::xor_(f, g)), g);
+			const Vector maj = Ops::or_(Ops::and_(a, Ops::or_(b, c)), Ops::and_(b, c));
+			const Vector t1 = Ops::add(Ops::add(Ops::add(h, bsig1(e)), Ops::add(ch, Ops::set1(C::k(t + i)))), w[i]);
+			const Vector t2 = Ops::add(bsig0(a), maj);
+
+			h = t1;
+			d = Ops::add(d, h);
+			h = Ops::add(h, t2);
+		};
+		for (int t = 0; t < C::ROUNDS; t += 16)
+		{
+			round(a, b, c, d, e, f, g, h, t, 0);
+			round(h, a, b, c, d, e, f, g, t, 1);
+			round(g, h, a, b, c, d, e, f, t, 2);
+			round(f, g, h, a, b, c, d, e, t, 3);
+			round(e, f, g, h, a, b, c, d, t, 4);
+			round(d, e, f, g, h, a, b, c, t, 5);
+			round(c, d, e, f, g, h, a, b, t, 6);
+			round(b, c, d, e, f, g, h, a, t, 7);
+			round(a, b, c, d, e, f, g, h, t, 8);
+			round(h, a, b, c, d, e, f, g, t, 9);
+			round(g, h, a, b, c, d, e, f, t, 10);
+			round(f, g, h, a, b, c, d, e, t, 11);
+			round(e, f, g, h, a, b, c, d, t, 12);
+			round(d, e, f, g, h, a, b, c, t, 13);
+			round(c, d, e, f, g, h, a, b, t, 14);
+			round(b, c, d, e, f, g, h, a, t, 15);
+		}
+
+		state[0] = Ops::add(state[0], a);
+		state[1] = Ops::add(state[1], b);
+		state[2] = Ops::add(state[2], c);
+		state[3] = Ops::add(state[3], d);
+		state[4] = Ops::add(state[4], e);
+		state[5] = Ops::add(state[5], f);
+		state[6] = Ops::add(state[6], g);
+		state[7] = Ops::add(state[7], h);
+	}
+
+	template <typename Word>
+	void Sha2Midstate<Word>::loadBlock(const Byte *block, Word (&words)[16])
+	{
+		// big-endian words
+		for (int i = 0; i < 16; ++i)
+		{
+			words[i] = 0;
+			for (std::size_t j = 0; j < sizeof(Word); ++j)
+				words[i] = static_cast<Word>((words[i] << 8) | block[(i * sizeof(Word)) + j]);
+		}
+	}
+
+	template <typename Word>
+	template <typename Ops>
+	void Sha2Midstate<Word>::gather(const State *src, typename Ops::Vector (&dst)[8])
+	{
+		// word `i` of every chaining value goes to vector `i`
+		for (int i = 0; i < 8; ++i)
+		{
+			Word words[Ops::LANES] = {};
+			for (int lane = 0; lane < Ops::LANES; ++lane)
+				words[lane] = src[lane][i];
+			dst[i] = Ops::load(words);
+		}
+	}
+
+	template <typename Word>
+	template <typename Ops>
+	void Sha2Midstate<Word>::scatter(const typename Ops::Vector (&src)[8], State *dst)
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			Word words[Ops::LANES] = {};
+			Ops::store(words, src[i]);
+			for (int lane = 0; lane < Ops::LANES; ++lane)
+				dst[lane][i] = words[lane];
+		}
+	}
+
+	template <typename Word>
+	typename Sha2Midstate<Word>::State Sha2Midstate<Word>::padState(const Byte *block)
+	{
+		using Ops = ScalarOps<Word>;
+
+		Word m[16] = {};
+		loadBlock(block, m);
+
+		const State init = Sha2Constants<Word>::initialState();
+		Word state[8] = {};
+		std::copy(init.begin(), init.end(), state);
+		compress<Ops>(state, m);
+
+		State ret {};
+		std::copy(state, (state + 8), ret.begin());
+		return ret;
+	}
+
+	template <typename Word>
+	template <typename H>
+	typename Sha2Midstate<Word>::State Sha2Midstate<Word>::midstate(const H &hash)
+	{
+		const auto state = hash.exportState();
+		assert(state.bufferSize == 0);
+		return state.h;
+	}
+
+	template <typename Word>
+	template <typename ResultArrayType>
+	typename Sha2Midstate<Word>::State Sha2Midstate<Word>::load(const ResultArrayType &digest)
+	{
+		static_assert((std::tuple_size<ResultArrayType>::value == sizeof(State)), "Truncated digests aren't supported");
+
+		State ret {};
+		for (std::size_t i = 0; i < ret.size(); ++i)
+		{
+			for (std::size_t j = 0; j < sizeof(Word); ++j)
+				ret[i] = static_cast<Word>((ret[i] << 8) | digest[(i * sizeof(Word)) + j]);
+		}
+		return ret;
+	}
+
+	template <typename Word>
+	template <typename ResultArrayType>
+	ResultArrayType Sha2Midstate<Word>::store(const State &state)
+	{
+		ResultArrayType ret {};
+		auto retPtr = ret.data();
+		for (const Word i : state)
+		{
+			for (int j = static_cast<int>(sizeof(Word) - 1); j >= 0; --j)
+				*(retPtr++) = static_cast<Byte>(i >> (j * 8));
+		}
+		return ret;
+	}
+
+	template <typename Word>
+	std::size_t Sha2Midstate<Word>::padTail(const Byte *tail, const std::size_t tailSize, const uint64_t totalLength, Byte *out)
+	{
+		// 0x80, zeros & the big-endian bit length in the last `2 * sizeof(Word)` bytes
+		const std::size_t blockSize = 16 * sizeof(Word);
+		const std::size_t lengthSize = 2 * sizeof(Word);
+		assert(tailSize < blockSize);
+
+		const std::size_t blocks = ((tailSize + 1 + lengthSize) > blockSize) ? 2 : 1;
+		Byte *end = out + (blocks * blockSize);
+		std::fill(out, end, Byte(0));
+		std::copy(tail, (tail + tailSize), out);
+		out[tailSize] = 0x80;
+
+		const uint64_t bits = totalLength * 8;
+		for (int i = 0; i < 8; ++i)
+			*(end - 1 - i) = static_cast<Byte>(bits >> (i * 8));
+		return blocks;
+	}
+
+	template <typename Word>
+	template <typename Ops>
+	void Sha2Midstate<Word>::compressLanesWith(State *states, const Byte *const *blocks)
+	{
+		// one block into each of `Ops::LANES` chaining values
+		using Vector = typename Ops::Vector;
+
+		Vector state[8];
+		gather<Ops>(states, state);
+
+		Word words[Ops::LANES][16] = {};
+		for (int lane = 0; lane < Ops::LANES; ++lane)
+			loadBlock(blocks[lane], words[lane]);
+
+		Vector block[16];
+		for (int i = 0; i < 16; ++i)
+		{
+			Word column[Ops::LANES] = {};
+			for (int lane = 0; lane < Ops::LANES; ++lane)
+				column[lane] = words[lane][i];
+			block[i] = Ops::load(column);
+		}
+
+		compress<Ops>(state, block);
+		scatter<Ops>(state, states);
+	}
+
+	template <typename Word>
+	void Sha2Midstate<Word>::compressLanes(State *states, const Byte *const *blocks, const std::size_t count)
+	{
+		std::size_t i = 0;
+#if defined(__AVX2__)
+		const std::size_t avx2Lanes = Avx2Ops<Word>::LANES;
+		for (; (i + avx2Lanes) <= count; i += avx2Lanes)
+			compressLanesWith<Avx2Ops<Word>>((states + i), (blocks + i));
+#endif
+#if defined(__SSE2__)
+		const std::size_t sse2Lanes = Sse2Ops<Word>::LANES;
+		for (; (i + sse2Lanes) <= count; i += sse2Lanes)
+			compressLanesWith<Sse2Ops<Word>>((states + i), (blocks + i));
+#endif
+		for (; i < count; ++i)
+			compressLanesWith<ScalarOps<Word>>((states + i), (blocks + i));
+	}
+
+	template <typename Word>
+	template <typename Ops>
+	void Sha2Midstate<Word>::iterateLanes(const State *inner, const State *outer, State *u, State *t, const uint32_t rounds)
+	{
+		// advances `Ops::LANES` chains
+		using Vector = typename Ops::Vector;
+
+		Vector innerState[8];
+		Vector outerState[8];
+		Vector uState[8];
+		Vector tState[8];
+		gather<Ops>(inner, innerState);
+		gather<Ops>(outer, outerState);
+		gather<Ops>(u, uState);
+		gather<Ops>(t, tState);
+
+		// the message is a digest followed by padding, the padding words never change
+		const Word digestBits = sizeof(State) * 8;
+		const Word blockBits = 16 * sizeof(Word) * 8;
+		Vector block[16];
+		block[8] = Ops::set1(static_cast<Word>(Word(1) << ((sizeof(Word) * 8) - 1)));
+		for (int i = 9; i < 15; ++i)
+			block[i] = Ops::set1(0);
+		block[15] = Ops::set1(static_cast<Word>(blockBits + digestBits));
+
+		for (uint32_t r = 0; r < rounds; ++r)
+		{
+			std::copy(uState, (uState + 8), block);
+			Vector s[8];
+			std::copy(innerState, (innerState + 8), s);
+			compress<Ops>(s, block);
+
+			std::copy(s, (s + 8), block);
+			std::copy(outerState, (outerState + 8), uState);
+			compress<Ops>(uState, block);
+
+			for (int i = 0; i < 8; ++i)
+				tState[i] = Ops::xor_(tState[i], uState[i]);
+		}
+
+		scatter<Ops>(uState, u);
+		scatter<Ops>(tState, t);
+	}
+
+	template <typename Word>
+	void Sha2Midstate<Word>::iterate(const State *inner, const State *outer, State *u, State *t, const std::size_t count, const uint32_t rounds)
+	{
+		std::size_t i = 0;
+#if defined(__AVX2__)
+		const std::size_t avx2Lanes = Avx2Ops<Word>::LANES;
+		for (; (i + avx2Lanes) <= count; i += avx2Lanes)
+			iterateLanes<Avx2Ops<Word>>((inner + i), (outer + i), (u + i), (t + i), rounds);
+#endif
+#if defined(__SSE2__)
+		const std::size_t sse2Lanes = Sse2Ops<Word>::LANES;
+		for (; (i + sse2Lanes) <= count; i += sse2Lanes)
+			iterateLanes<Sse2Ops<Word>>((inner + i), (outer + i), (u + i), (t + i), rounds);
+#endif
+		for (; i < count; ++i)
+			iterateLanes<ScalarOps<Word>>((inner + i), (outer + i), (u + i), (t + i), rounds);
+	}
+
+	template <>
+	struct Midstate<SHA2_256> : Sha2Midstate<uint32_t> {};
+
+	template <>
+	struct Midstate<SHA2_512> : Sha2Midstate<uint64_t> {};
+
+
+
+	template <typename H>
+	class HMAC
+	{
+		// https://tools.ietf.org/html/rfc2104
+
+		public:
+			using Byte = uint8_t;
+			using ResultArrayType = typename H::ResultArrayType;
+
+			static constexpr int BLOCK_SIZE = H::BLOCK_SIZE;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			explicit HMAC(const Span<const Byte> key);
+
+			void reset();
+			HMAC& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+			ResultArrayType toArray() const;
+
+			HMAC& addData(const Span<const Byte> inData);
+			HMAC& addData(const void *ptr, const std::size_t length);
+			template <typename T, std::size_t N>
+			HMAC& addData(const T (&array)[N]);
+			template <typename T>
+			HMAC& addData(const Span<T> inSpan);
+
+			// `outputs[i]` = MAC of `inputs[i]`, doesn't touch the state of this instance
+			void hashMany(const Span<const Span<const Byte>> inputs, const Span<ResultArrayType> outputs) const;
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// restore into an instance constructed with the same key, `H` must provide `serialize()` & `restore()`
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			using PadBlock = std::array<Byte, BLOCK_SIZE>;
+
+			void hashManyImpl(const Span<const Span<const Byte>> inputs, const Span<ResultArrayType> outputs, std::false_type) const;
+			void hashManyImpl(const Span<const Span<const Byte>> inputs, const Span<ResultArrayType> outputs, std::true_type) const;
+
+			// messages passed to the kernel at once, bounds the memory used for the padded tails
+			static constexpr std::size_t HASH_MANY_ITEMS = 64;
+
+			static constexpr Byte INNER_PAD = 0x36;
+			static constexpr Byte OUTER_PAD = 0x5c;
+
+			H m_innerState;  // after the inner pad block
+			H m_outerState;  // after the outer pad block
+			H m_hash;
+	};
+
+
+	//
+	template <typename H>
+	HMAC<H>::HMAC(const Span<const Byte> key)
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+		static_assert((std::tuple_size<ResultArrayType>::value <= BLOCK_SIZE), "Digest doesn't fit in a block");
+
+		// zero padded, only needed until the pad blocks are absorbed
+		PadBlock keyBlock {};
+		const std::size_t blockSize = BLOCK_SIZE;
+		if (static_cast<std::size_t>(key.size()) > blockSize)
+		{
+			// long keys are hashed first
+			const ResultArrayType digest = H().addData(key).finalize().toArray();
+			std::copy(digest.begin(), digest.end(), keyBlock.begin());
+		}
+		else
+		{
+			std::copy(key.begin(), key.end(), keyBlock.begin());
+		}
+
+		PadBlock innerPad {};
+		PadBlock outerPad {};
+		for (std::size_t i = 0; i < blockSize; ++i)
+		{
+			innerPad[i] = static_cast<Byte>(keyBlock[i] ^ INNER_PAD);
+			outerPad[i] = static_cast<Byte>(keyBlock[i] ^ OUTER_PAD);
+		}
+		m_innerState.addData(Span<const Byte>(innerPad.data(), innerPad.size()));
+		m_outerState.addData(Span<const Byte>(outerPad.data(), outerPad.size()));
+
+		reset();
+	}
+
+	template <typename H>
+	void HMAC<H>::reset()
+	{
+		m_hash = m_innerState;
+	}
+
+	template <typename H>
+	HMAC<H>& HMAC<H>::finalize()
+	{
+		const ResultArrayType digest = m_hash.finalize().toArray();
+
+		m_hash = m_outerState;
+		m_hash.addData(Span<const Byte>(digest.data(), digest.size())).finalize();
+
+		return (*this);
+	}
+
+	template <typename H>
+	std::string HMAC<H>::toString() const
+	{
+		const auto a = toArray();
+		std::string ret;
+		ret.resize(2 * a.size());
+
+		auto retPtr = &ret.front();
+		for (const auto c : a)
+		{
+			const Byte upper = static_cast<Byte>(c >> 4);
+			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
+
+			const Byte lower = c & 0xf;
+			*(retPtr++) = static_cast<char>((lower < 10) ? (lower + '0') : (lower - 10 + 'a'));
+		}
+
+		return ret;
+	}
+
+	template <typename H>
+	std::vector<typename HMAC<H>::Byte> HMAC<H>::toVector() const
+	{
+		const auto a = toArray();
+		return {a.begin(), a.end()};
+	}
+
+	template <typename H>
+	typename HMAC<H>::ResultArrayType HMAC<H>::toArray() const
+	{
+		return m_hash.toArray();
+	}
+
+	template <typename H>
+	HMAC<H>& HMAC<H>::addData(const Span<const Byte> inData)
+	{
+		m_hash.addData(inData);
+		return (*this);
+	}
+
+	template <typename H>
+	HMAC<H>& HMAC<H>::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <typename H>
+	template <typename T, std::size_t N>
+	HMAC<H>& HMAC<H>::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename H>
+	template <typename T>
+	HMAC<H>& HMAC<H>::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	template <typename H>
+	std::vector<typename HMAC<H>::Byte> HMAC<H>::serialize() const
+	{
+		// the outer pad state stays out, it only depends on the key
+		StateWriter writer("HMAC");
+		writer.putNested(m_hash.serialize());
+		return writer.data();
+	}
+
+	template <typename H>
+	bool HMAC<H>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "HMAC");
+		const std::vector<Byte> inner = reader.getNested();
+		if (!reader.finished())
+			return false;
+
+		return m_hash.restore({inner.data(), inner.size()});
+	}
+
+	template <typename H>
+	void HMAC<H>::hashMany(const Span<const Span<const Byte>> inputs, const Span<ResultArrayType> outputs) const
+	{
+		if (inputs.size() != outputs.size())
+			throw std::invalid_argument("HMAC::hashMany: inputs & outputs must have the same size");
+
+		// every message starts from the cached pad states, the pad blocks are never compressed again
+		hashManyImpl(inputs, outputs, std::integral_constant<bool, Midstate<H>::RAW> {});
+	}
+
+	template <typename H>
+	void HMAC<H>::hashManyImpl(const Span<const Span<const Byte>> inputs, const Span<ResultArrayType> outputs, std::false_type) const
+	{
+		// no raw kernel, one message after another
+		for (std::size_t i = 0, iend = static_cast<std::size_t>(inputs.size()); i < iend; ++i)
+		{
+			H inner = m_innerState;
+			const ResultArrayType digest = inner.addData(inputs[i]).finalize().toArray();
+
+			H outer = m_outerState;
+			outputs[i] = outer.addData(Span<const Byte>(digest.data(), digest.size())).finalize().toArray();
+		}
+	}
+
+	template <typename H>
+	void HMAC<H>::hashManyImpl(const Span<const Span<const Byte>> inputs, const Span<ResultArrayType> outputs, std::true_type) const
+	{
+		using Kernel = Midstate<H>;
+		using State = typename Kernel::State;
+
+		const std::size_t blockSize = BLOCK_SIZE;
+		const std::size_t digestSize = std::tuple_size<ResultArrayType>::value;
+		const std::size_t count = static_cast<std::size_t>(inputs.size());
+
+		const State innerState = Kernel::midstate(m_innerState);
+		const State outerState = Kernel::midstate(m_outerState);
+
+		// longest first, so the messages still running at any block are a prefix of a batch
+		std::vector<std::size_t> order(count);
+		std::iota(order.begin(), order.end(), std::size_t(0));
+		std::stable_sort(order.begin(), order.end(), [&inputs](const std::size_t a, const std::size_t b)
+		{
+			return (inputs[a].size() > inputs[b].size());
+		});
+
+		const std::size_t hashManyItems = HASH_MANY_ITEMS;
+		std::vector<State> states(hashManyItems);
+		std::vector<const Byte *> blocks(hashManyItems);
+		std::vector<std::size_t> blockCounts(hashManyItems);
+		std::vector<Byte> tails(hashManyItems * 2 * blockSize);  // the padded last 1 or 2 blocks of each message
+
+		for (std::size_t first = 0; first < count; first += hashManyItems)
+		{
+			const std::size_t items = std::min(hashManyItems, (count - first));
+
+			// inner hash: the message after the inner pad block
+			for (std::size_t i = 0; i < items; ++i)
+			{
+				const Span<const Byte> input = inputs[order[first + i]];
+				const std::size_t size = static_cast<std::size_t>(input.size());
+				const std::size_t wholeBlocks = size / blockSize;
+
+				states[i] = innerState;
+				blockCounts[i] = wholeBlocks + Kernel::padTail((input.data() + (wholeBlocks * blockSize)), (size % blockSize)
+					, (blockSize + size), (tails.data() + (i * 2 * blockSize)));
+			}
+
+			std::size_t active = items;
+			for (std::size_t block = 0; block < blockCounts[0]; ++block)
+			{
+				while (blockCounts[active - 1] <= block)
+					--active;
+
+				for (std::size_t i = 0; i < active; ++i)
+				{
+					const Span<const Byte> input = inputs[order[first + i]];
+					const std::size_t wholeBlocks = static_cast<std::size_t>(input.size()) / blockSize;
+					blocks[i] = (block < wholeBlocks)
+						? (input.data() + (block * blockSize))
+						: (tails.data() + (i * 2 * blockSize) + ((block - wholeBlocks) * blockSize));
+				}
+				Kernel::compressLanes(states.data(), blocks.data(), active);
+			}
+
+			// outer hash: the inner digest after the outer pad block, always a single block
+			for (std::size_t i = 0; i < items; ++i)
+			{
+				const ResultArrayType digest = Kernel::template store<ResultArrayType>(states[i]);
+				blocks[i] = tails.data() + (i * 2 * blockSize);
+				Kernel::padTail(digest.data(), digestSize, (blockSize + digestSize), (tails.data() + (i * 2 * blockSize)));
+				states[i] = outerState;
+			}
+			Kernel::compressLanes(states.data(), blocks.data(), items);
+
+			for (std::size_t i = 0; i < items; ++i)
+				outputs[order[first + i]] = Kernel::template store<ResultArrayType>(states[i]);
+		}
+	}
+}
+}
+	template <typename H>
+	using HMAC = Hash::HMAC_NS::HMAC<H>;
+}
+
+#endif  // CHOCOBO1_HMAC_H
@@ -0,0 +1,423 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_KANGAROO_TWELVE_H
+#define CHOCOBO1_KANGAROO_TWELVE_H
+
+#include "sha3.h"
+#include "state_serializer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// KangarooTwelve(const int digestLengthInBytes, const std::string &customize = {});
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, restore into an instance constructed with the same parameters
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+namespace Hash
+{
+namespace KangarooTwelve_NS
+{
+	class KangarooTwelve
+	{
+		// https://www.rfc-editor.org/rfc/rfc9861
+
+		public:
+			using Byte = uint8_t;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			explicit KangarooTwelve(const int digestLength, const std::string &customize = {});
+
+			void reset();
+			KangarooTwelve& finalize();  // after this, only `toString()`, `toVector()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+
+			KangarooTwelve& addData(const Span<const Byte> inData);
+			KangarooTwelve& addData(const void *ptr, const std::size_t length);
+			template <typename T, std::size_t N>
+			KangarooTwelve& addData(const T (&array)[N]);
+			template <typename T>
+			KangarooTwelve& addData(const Span<T> inSpan);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// restore into an instance constructed with the same parameters
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			// TurboSHAKE128 with the domain separation bytes of each node type
+			using SingleNode = SHA3_NS::Keccak<(1344 / 8), 0x07, 12>;
+			using FinalNode = SHA3_NS::Keccak<(1344 / 8), 0x06, 12>;
+			using LeafNode = SHA3_NS::Keccak<(1344 / 8), 0x0B, 12>;
+
+			void addDataImpl(const Span<const Byte> data);
+			void hashChunks(const Span<const Byte> data);
+			static void hashChunksRange(const Byte *data, const std::size_t chunks, Byte *chainingValues);
+			void addChainingValues(const Span<const Byte> chainingValues);
+
+			static constexpr int CHUNK_SIZE = 8192;
+			static constexpr int CV_SIZE = 32;  // chaining value
+			static constexpr int LANES = LeafNode::SIMD_LANES;
+
+			// batches of chunks at least this large are split across threads
+			// each such batch starts & joins its own threads (no pool), smaller ones stay on the calling thread
+			static constexpr std::size_t THREAD_THRESHOLD = 1024 * 1024;
+			// chunks hashed per batch, bounds the memory used for chaining values
+			static constexpr std::size_t BATCH_CHUNKS = 4096;
+
+			const int m_digestLength;
+			const std::string m_customize;
+
+			FinalNode m_finalNode;
+			std::vector<Byte> m_buffer;  // the first chunk until the tree mode is known, then up to `LANES` chunks
+			bool m_treeMode = false;
+			uint64_t m_chunkCount = 0;  // excluding the first chunk
+			std::vector<Byte> m_final;
+	};
+
+
+	// helpers
+	inline Buffer<uint8_t, 9> lengthEncode(const uint64_t value)
+	{
+		Buffer<uint8_t, 9> ret;
+		uint8_t n = 0;
+		for (uint64_t v = value; v > 0; v >>= 8)
+			++n;
+		for (int i = (n - 1); i >= 0; --i)
+			ret.fill(static_cast<uint8_t>(value >> (8 * i)));
+		ret.fill(n);
+		return ret;
+	}
+
+	template <typename T, std::size_t... I>
+	std::array<T, sizeof...(I)> makeStates(const int digestLength, std::index_sequence<I...>)
+	{
+		// one `T(digestLength)` per index, `T` has no default constructor
+		return {{(static_cast<void>(I), T(digestLength))...}};
+	}
+
+
+	//
+	inline KangarooTwelve::KangarooTwelve(const int digestLength, const std::string &customize)
+		: m_digestLength(digestLength)
+		, m_customize(customize)
+		, m_finalNode(digestLength)
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+
+		m_buffer.reserve(CHUNK_SIZE * LANES);
+	}
+
+	inline void KangarooTwelve::reset()
+	{
+		m_finalNode.reset();
+		m_buffer.clear();
+		m_treeMode = false;
+		m_chunkCount = 0;
+		m_final.clear();
+	}
+
+	inline KangarooTwelve& KangarooTwelve::finalize()
+	{
+		addDataImpl({reinterpret_cast<const Byte *>(m_customize.data()), m_customize.size()});
+		const auto encodedLength = lengthEncode(m_customize.size());
+		addDataImpl({encodedLength.data(), encodedLength.size()});
+
+		if (!m_treeMode)
+		{
+			m_final = SingleNode(m_digestLength).addData(m_buffer.data(), m_buffer.size()).finalize().toVector();
+			m_buffer.clear();
+			return (*this);
+		}
+
+		// the last chunk may be shorter than `CHUNK_SIZE`
+		const std::size_t wholeChunks = m_buffer.size() / CHUNK_SIZE;
+		hashChunks({m_buffer.data(), (wholeChunks * CHUNK_SIZE)});
+
+		const std::size_t remainder = m_buffer.size() % CHUNK_SIZE;
+		if (remainder > 0)
+		{
+			const auto cv = LeafNode(CV_SIZE).addData((m_buffer.data() + (wholeChunks * CHUNK_SIZE)), remainder).finalize().toVector();
+			addChainingValues({cv.data(), cv.size()});
+		}
+		m_buffer.clear();
+
+		const auto encodedCount = lengthEncode(m_chunkCount);
+		m_finalNode.addData(encodedCount.data(), encodedCount.size());
+		const Byte terminator[2] = {0xFF, 0xFF};
+		m_finalNode.addData(terminator);
+
+		m_final = m_finalNode.finalize().toVector();
+		return (*this);
+	}
+
+	inline std::string KangarooTwelve::toString() const
+	{
+		const auto v = toVector();
+		std::string ret;
+		ret.resize(2 * v.size());
+
+		auto retPtr = &ret.front();
+		for (const auto c : v)
+		{
+			const Byte upper = static_cast<Byte>(c >> 4);
+			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
+
+			const Byte lower = c & 0xf;
+			*(retPtr++) = static_cast<char>((lower < 10) ? (lower + '0') : (lower - 10 + 'a'));
+		}
+
+		return ret;
+	}
+
+	inline std::vector<KangarooTwelve::Byte> KangarooTwelve::toVector() const
+	{
+		return m_final;
+	}
+
+	inline KangarooTwelve& KangarooTwelve::addData(const Span<const Byte> inData)
+	{
+		addDataImpl(inData);
+		return (*this);
+	}
+
+	inline KangarooTwelve& KangarooTwelve::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <typename T, std::size_t N>
+	KangarooTwelve& KangarooTwelve::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename T>
+	KangarooTwelve& KangarooTwelve::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	inline std::vector<KangarooTwelve::Byte> KangarooTwelve::serialize() const
+	{
+		StateWriter writer("KangarooTwelve");
+		writer.putNested({m_customize.begin(), m_customize.end()});
+		writer.putNested(m_finalNode.serialize());
+		writer.put(static_cast<uint8_t>(m_treeMode));
+		writer.put(m_chunkCount);
+		writer.putNested(m_buffer);
+		return writer.data();
+	}
+
+	inline bool KangarooTwelve::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "KangarooTwelve");
+		const std::vector<Byte> customize = reader.getNested();
+		const std::vector<Byte> finalNode = reader.getNested();
+		const uint8_t treeMode = reader.get<uint8_t>();
+		const uint64_t chunkCount = reader.get<uint64_t>();
+		std::vector<Byte> buffer = reader.getNested();
+		if (!reader.finished() || (treeMode > 1) || (std::string(customize.begin(), customize.end()) != m_customize))
+			return false;
+
+		// before the tree mode the buffer holds the first chunk, afterwards less than a batch of chunks
+		const std::size_t bufferLimit = (treeMode == 0) ? CHUNK_SIZE : ((CHUNK_SIZE * LANES) - 1);
+		if ((buffer.size() > bufferLimit) || ((treeMode == 0) && (chunkCount != 0)))
+			return false;
+
+		if (!m_finalNode.restore({finalNode.data(), finalNode.size()}))
+			return false;
+
+		m_treeMode = (treeMode == 1);
+		m_chunkCount = chunkCount;
+		m_buffer = std::move(buffer);
+		m_buffer.reserve(CHUNK_SIZE * LANES);
+		m_final.clear();
+		return true;
+	}
+
+	inline void KangarooTwelve::addDataImpl(const Span<const Byte> inData)
+	{
+		Span<const Byte> data = inData;
+
+		if (!m_treeMode)
+		{
+			const std::size_t len = std::min<std::size_t>((CHUNK_SIZE - m_buffer.size()), data.size());
+			m_buffer.insert(m_buffer.end(), data.begin(), (data.begin() + len));
+			data = data.subspan(len);
+
+			if (data.empty())
+				return;
+
+			// input is longer than one chunk, the first chunk goes into the final node
+			m_treeMode = true;
+			m_finalNode.addData(m_buffer.data(), m_buffer.size());
+			const Byte separator[8] = {0x03, 0, 0, 0, 0, 0, 0, 0};
+			m_finalNode.addData(separator);
+			m_buffer.clear();
+		}
+
+		const std::size_t batchSize = CHUNK_SIZE * LANES;
+
+		if (!m_buffer.empty())
+		{
+			const std::size_t len = std::min<std::size_t>((batchSize - m_buffer.size()), data.size());
+			m_buffer.insert(m_buffer.end(), data.begin(), (data.begin() + len));
+			data = data.subspan(len);
+
+			if (m_buffer.size() < batchSize)
+				return;
+
+			hashChunks({m_buffer.data(), m_buffer.size()});
+			m_buffer.clear();
+		}
+
+		// hash whole batches straight from the input
+		const std::size_t len = (data.size() / batchSize) * batchSize;
+		hashChunks(data.first(len));
+
+		m_buffer.assign((data.begin() + len), data.end());
+	}
+
+	inline void KangarooTwelve::hashChunks(const Span<const Byte> data)
+	{
+		// `data` consists of whole chunks
+		assert((data.size() % CHUNK_SIZE) == 0);
+
+		const unsigned int cores = std::thread::hardware_concurrency();
+		const std::size_t batchChunks = BATCH_CHUNKS;
+		std::vector<Byte> chainingValues;
+
+		for (std::size_t offset = 0; offset < static_cast<std::size_t>(data.size()); offset += (batchChunks * CHUNK_SIZE))
+		{
+			const std::size_t chunks = std::min<std::size_t>(batchChunks, ((data.size() - offset) / CHUNK_SIZE));
+			const Byte *batch = data.data() + offset;
+			chainingValues.resize(chunks * CV_SIZE);
+
+			if (((chunks * CHUNK_SIZE) >= THREAD_THRESHOLD) && (cores != 1))
+			{
+				const std::size_t threadCount = (cores == 0) ? 2 : cores;
+				// keep the SIMD groups intact
+				const std::size_t perThread = (((chunks + threadCount - 1) / threadCount) + LANES - 1) / LANES * LANES;
+
+				std::vector<std::thread> workers;
+				for (std::size_t first = perThread; first < chunks; first += perThread)
+				{
+					const std::size_t count = std::min(perThread, (chunks - first));
+					workers.emplace_back([batch, first, count, &chainingValues]()
+					{
+						hashChunksRange((batch + (first * CHUNK_SIZE)), count, (chainingValues.data() + (first * CV_SIZE)));
+					});
+				}
+				hashChunksRange(batch, std::min(perThread, chunks), chainingValues.data());
+
+				for (auto &worker : workers)
+					worker.join();
+			}
+			else
+			{
+				hashChunksRange(batch, chunks, chainingValues.data());
+			}
+
+			addChainingValues({chainingValues.data(), chainingValues.size()});
+		}
+	}
+
+	inline void KangarooTwelve::hashChunksRange(const Byte *data, const std::size_t chunks, Byte *chainingValues)
+	{
+		const std::size_t wholeBlocks = CHUNK_SIZE / LeafNode::BLOCK_SIZE;
+		const std::size_t tailLength = CHUNK_SIZE % LeafNode::BLOCK_SIZE;
+
+		auto states = makeStates<LeafNode>(CV_SIZE, std::make_index_sequence<LANES> {});
+		std::size_t i = 0;
+		for (; (i + LANES) <= chunks; i += LANES)
+		{
+			LeafNode *statePtrs[LANES] = {};
+			const Byte *chunkData[LANES] = {};
+			for (int lane = 0; lane < LANES; ++lane)
+			{
+				states[lane].reset();
+				statePtrs[lane] = &states[lane];
+				chunkData[lane] = data + ((i + lane) * CHUNK_SIZE);
+			}
+			LeafNode::addBlocks(statePtrs, chunkData, wholeBlocks);
+
+			for (int lane = 0; lane < LANES; ++lane)
+			{
+				const auto cv = states[lane].addData((chunkData[lane] + (wholeBlocks * LeafNode::BLOCK_SIZE)), tailLength).finalize().toVector();
+				std::copy(cv.begin(), cv.end(), (chainingValues + ((i + lane) * CV_SIZE)));
+			}
+		}
+
+		for (; i < chunks; ++i)
+		{
+			LeafNode &state = states[0];
+			state.reset();
+			const auto cv = state.addData((data + (i * CHUNK_SIZE)), CHUNK_SIZE).finalize().toVector();
+			std::copy(cv.begin(), cv.end(), (chainingValues + (i * CV_SIZE)));
+		}
+	}
+
+	inline void KangarooTwelve::addChainingValues(const Span<const Byte> chainingValues)
+	{
+		m_finalNode.addData(chainingValues);
+		m_chunkCount += static_cast<uint64_t>(chainingValues.size() / CV_SIZE);
+	}
+}
+}
+	using KangarooTwelve = Hash::KangarooTwelve_NS::KangarooTwelve;
+}
+
+#endif  // CHOCOBO1_KANGAROO_TWELVE_H
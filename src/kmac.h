@@ -0,0 +1,235 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_KMAC_H
+#define CHOCOBO1_KMAC_H
+
+#include "tuple_hash.h"
+#include "state_serializer.h"
+
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// KMAC_128(const int digestLengthInBytes, const KMAC_128::Span<const KMAC_128::Byte> key, const std::string &customize = {});
+	// KMAC_256(const int digestLengthInBytes, const KMAC_256::Span<const KMAC_256::Byte> key, const std::string &customize = {});
+
+	// KMACXOF_128(const int digestLengthInBytes, const KMACXOF_128::Span<const KMACXOF_128::Byte> key, const std::string &customize = {});
+	// KMACXOF_256(const int digestLengthInBytes, const KMACXOF_256::Span<const KMACXOF_256::Byte> key, const std::string &customize = {});
+
+	// the key & customization string are absorbed once, `reset()` & copies start from the cached state
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, restore into an instance constructed with the same key & parameters
+	//   the sponge state can be run backwards to the keyed state, keep the snapshots as secret as the key
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+namespace Hash
+{
+namespace KMAC_NS
+{
+	template <typename K, int P, bool XOF>  // `K`: Keccak with cSHAKE padding, `P`: rate in bytes
+	class KMAC
+	{
+		// https://doi.org/10.6028/NIST.SP.800-185
+
+		public:
+			using Byte = uint8_t;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			explicit KMAC(const int digestLength, const Span<const Byte> key, const std::string &customize = {});
+
+			void reset();
+			KMAC& finalize();  // after this, only `toString()`, `toVector()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+
+			KMAC& addData(const Span<const Byte> inData);
+			KMAC& addData(const void *ptr, const std::size_t length);
+			template <typename T, std::size_t N>
+			KMAC& addData(const T (&array)[N]);
+			template <typename T>
+			KMAC& addData(const Span<T> inSpan);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// restore into an instance constructed with the same key & parameters, the snapshot is as secret as the key
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			int m_digestLength = 0;
+
+			K m_prefixed;  // after bytepad(encode_string("KMAC") || encode_string(S)) & bytepad(encode_string(key))
+			K m_keccak;
+	};
+
+
+	//
+	template <typename K, int P, bool XOF>
+	KMAC<K, P, XOF>::KMAC(const int digestLength, const Span<const Byte> key, const std::string &customize)
+		: m_digestLength(digestLength)
+		, m_prefixed(digestLength)
+		, m_keccak(digestLength)
+	{
+		static_assert((P > 0), "Template parameter value invalid: P");
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+
+		size_t length = 0;
+		const auto absorb = [this, &length](const Span<const Byte> data) -> void
+		{
+			m_prefixed.addData(data);
+			length += static_cast<size_t>(data.size());
+		};
+		const auto absorbString = [&absorb](const Span<const Byte> str) -> void
+		{
+			const auto encoded = Chocobo1::Hash::CShake_NS::leftEncode(static_cast<uint64_t>(str.size()) * 8);
+			absorb({encoded.data(), encoded.size()});
+			absorb(str);
+		};
+		const auto bytepad = [&absorb, &length]() -> void
+		{
+			const size_t rate = P;
+			const Byte zeros[P] = {};
+			absorb({zeros, ((rate - (length % rate)) % rate)});
+			length = 0;
+		};
+
+		const auto encodedRate = Chocobo1::Hash::CShake_NS::leftEncode(P);
+		const char name[] = "KMAC";
+
+		absorb({encodedRate.data(), encodedRate.size()});
+		absorbString({reinterpret_cast<const Byte *>(name), (sizeof(name) - 1)});
+		absorbString({reinterpret_cast<const Byte *>(customize.data()), customize.size()});
+		bytepad();
+
+		absorb({encodedRate.data(), encodedRate.size()});
+		absorbString(key);
+		bytepad();
+
+		reset();
+	}
+
+	template <typename K, int P, bool XOF>
+	void KMAC<K, P, XOF>::reset()
+	{
+		m_keccak = m_prefixed;
+	}
+
+	template <typename K, int P, bool XOF>
+	KMAC<K, P, XOF>& KMAC<K, P, XOF>::finalize()
+	{
+		const auto encoded = Chocobo1::Hash::TupleHash_NS::rightEncode(XOF ? 0 : (static_cast<uint64_t>(m_digestLength) * 8));
+		m_keccak.addData({encoded.data(), encoded.size()});
+		m_keccak.finalize();
+		return (*this);
+	}
+
+	template <typename K, int P, bool XOF>
+	std::string KMAC<K, P, XOF>::toString() const
+	{
+		return m_keccak.toString();
+	}
+
+	template <typename K, int P, bool XOF>
+	std::vector<typename KMAC<K, P, XOF>::Byte> KMAC<K, P, XOF>::toVector() const
+	{
+		return m_keccak.toVector();
+	}
+
+	template <typename K, int P, bool XOF>
+	KMAC<K, P, XOF>& KMAC<K, P, XOF>::addData(const Span<const Byte> inData)
+	{
+		m_keccak.addData(inData);
+		return (*this);
+	}
+
+	template <typename K, int P, bool XOF>
+	KMAC<K, P, XOF>& KMAC<K, P, XOF>::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <typename K, int P, bool XOF>
+	template <typename T, std::size_t N>
+	KMAC<K, P, XOF>& KMAC<K, P, XOF>::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename K, int P, bool XOF>
+	template <typename T>
+	KMAC<K, P, XOF>& KMAC<K, P, XOF>::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	template <typename K, int P, bool XOF>
+	std::vector<typename KMAC<K, P, XOF>::Byte> KMAC<K, P, XOF>::serialize() const
+	{
+		StateWriter writer("KMAC" + std::string(XOF ? "XOF_" : "_") + std::to_string(P));
+		writer.putNested(m_keccak.serialize());
+		return writer.data();
+	}
+
+	template <typename K, int P, bool XOF>
+	bool KMAC<K, P, XOF>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "KMAC" + std::string(XOF ? "XOF_" : "_") + std::to_string(P));
+		const std::vector<Byte> running = reader.getNested();
+		if (!reader.finished())
+			return false;
+
+		return m_keccak.restore({running.data(), running.size()});
+	}
+}
+}
+	struct KMAC_128 : Hash::KMAC_NS::KMAC<Hash::SHA3_NS::Keccak<(1344 / 8), 0x04>, (1344 / 8), false> { explicit KMAC_128(const int l, const Span<const Byte> k, const std::string &c = {}) : Hash::KMAC_NS::KMAC<Hash::SHA3_NS::Keccak<(1344 / 8), 0x04>, (1344 / 8), false>(l, k, c) {} };
+	struct KMAC_256 : Hash::KMAC_NS::KMAC<Hash::SHA3_NS::Keccak<(1088 / 8), 0x04>, (1088 / 8), false> { explicit KMAC_256(const int l, const Span<const Byte> k, const std::string &c = {}) : Hash::KMAC_NS::KMAC<Hash::SHA3_NS::Keccak<(1088 / 8), 0x04>, (1088 / 8), false>(l, k, c) {} };
+	struct KMACXOF_128 : Hash::KMAC_NS::KMAC<Hash::SHA3_NS::Keccak<(1344 / 8), 0x04>, (1344 / 8), true> { explicit KMACXOF_128(const int l, const Span<const Byte> k, const std::string &c = {}) : Hash::KMAC_NS::KMAC<Hash::SHA3_NS::Keccak<(1344 / 8), 0x04>, (1344 / 8), true>(l, k, c) {} };
+	struct KMACXOF_256 : Hash::KMAC_NS::KMAC<Hash::SHA3_NS::Keccak<(1088 / 8), 0x04>, (1088 / 8), true> { explicit KMACXOF_256(const int l, const Span<const Byte> k, const std::string &c = {}) : Hash::KMAC_NS::KMAC<Hash::SHA3_NS::Keccak<(1088 / 8), 0x04>, (1088 / 8), true>(l, k, c) {} };
+}
+
+#endif  // CHOCOBO1_KMAC_H
@@ -12,13 +12,18 @@
 #ifndef CHOCOBO1_MD2_H
 #define CHOCOBO1_MD2_H
 
+#include "state_serializer.h"
+
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <climits>
 #include <cmath>
 #include <cstdint>
 #include <initializer_list>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #if (__cplusplus > 201703L)
@@ -44,6 +49,11 @@ namespace Chocobo1
 {
 	// Use these!!
 	// MD2();
+	//   `peekDigest()` returns the digest of the data so far without finalizing, more data can follow
+	//   `exportState()` & `importState(State)` copy the raw running state, e.g. hash a shared prefix once & fork it per suffix
+	//   `importState()` throws `std::invalid_argument` unless `State::bufferSize` is less than a block
+	//   `compressBlocks(blocks)` feeds whole 16-byte blocks directly: `blocks.size()` must be a multiple of 16 (block-aligned) & no bytes may be pending from `addData()`, otherwise it throws `std::invalid_argument`
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, `restore()` returns false on a malformed snapshot
 }
 
 
@@ -57,7 +67,7 @@ namespace Hash
 #if __cplusplus >= 201703L
 #define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
 #else
-#define CONSTEXPR_CPP17_CHOCOBO1_HASH
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
 #endif
 #endif
 
@@ -166,6 +176,26 @@ namespace Hash
 
 namespace MD2_NS
 {
+	constexpr uint8_t piSubst[256] =
+	{
+		 41,  46,  67, 201, 162, 216, 124,   1,  61,  54,  84, 161, 236, 240,   6,  19,
+		 98, 167,   5, 243, 192, 199, 115, 140, 152, 147,  43, 217, 188,  76, 130, 202,
+		 30, 155,  87,  60, 253, 212, 224,  22, 103,  66, 111,  24, 138,  23, 229,  18,
+		190,  78, 196, 214, 218, 158, 222,  73, 160, 251, 245, 142, 187,  47, 238, 122,
+		169, 104, 121, 145,  21, 178,   7,  63, 148, 194,  16, 137,  11,  34,  95,  33,
+		128, 127,  93, 154,  90, 144,  50,  39,  53,  62, 204, 231, 191, 247, 151,   3,
+		255,  25,  48, 179,  72, 165, 181, 209, 215,  94, 146,  42, 172,  86, 170, 198,
+		 79, 184,  56, 210, 150, 164, 125, 182, 118, 252, 107, 226, 156, 116,   4, 241,
+		 69, 157, 112,  89, 100, 113, 135,  32, 134,  91, 207, 101, 230,  45, 168,   2,
+		 27,  96,  37, 173, 174, 176, 185, 246,  28,  70,  97, 105,  52,  64, 126,  15,
+		 85,  71, 163,  35, 221,  81, 175,  58, 195,  92, 249, 206, 186, 197, 234,  38,
+		 44,  83,  13, 110, 133,  40, 132,   9, 211, 223, 205, 244,  65, 129,  77,  82,
+		106, 220,  55, 200, 108, 193, 171, 250,  36, 225, 123,   8,  12, 189, 177,  74,
+		120, 136, 149, 139, 227,  99, 232, 109, 233, 203, 213, 254,  59,   0,  29,  57,
+		242, 239, 183,  14, 102,  88, 208, 228, 166, 119, 114, 248, 235, 117,  75,  10,
+		 49,  68,  80, 180, 143, 237,  31,  26, 219, 153, 141,  51, 159,  17, 131,  20
+	};
+
 	class MD2
 	{
 		// https://tools.ietf.org/html/rfc1319
@@ -174,6 +204,8 @@ namespace MD2_NS
 			using Byte = uint8_t;
 			using ResultArrayType = std::array<Byte, 16>;
 
+			static constexpr int BLOCK_SIZE = 16;
+
 #if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
 			template <typename T, std::size_t Extent = std::dynamic_extent>
 			using Span = std::span<T, Extent>;
@@ -182,6 +214,15 @@ namespace MD2_NS
 			using Span = gsl::span<T, Extent>;
 #endif
 
+			struct State
+			{
+				// everything `importState()` needs to resume hashing, MD2 has no length field
+				std::array<Byte, 16> h {};  // chaining value
+				std::array<Byte, 16> checksum {};  // running checksum
+				std::array<Byte, BLOCK_SIZE> buffer {};  // pending bytes, less than a block
+				std::size_t bufferSize = 0;
+			};
+
 
 			constexpr MD2();
 
@@ -191,6 +232,7 @@ namespace MD2_NS
 			std::string toString() const;
 			std::vector<Byte> toVector() const;
 			constexpr ResultArrayType toArray() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
 
 			CONSTEXPR_CPP17_CHOCOBO1_HASH MD2& addData(const Span<const Byte> inData);
 			CONSTEXPR_CPP17_CHOCOBO1_HASH MD2& addData(const void *ptr, const std::size_t length);
@@ -201,40 +243,25 @@ namespace MD2_NS
 			template <typename T>
 			MD2& addData(const Span<T> inSpan);
 
+			// raw state access, e.g. hash a shared prefix once & fork it for many suffixes
+			CONSTEXPR_CPP17_CHOCOBO1_HASH State exportState() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH void importState(const State &state);
+			CONSTEXPR_CPP17_CHOCOBO1_HASH MD2& compressBlocks(const Span<const Byte> blocks);  // whole blocks only, requires no pending bytes
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
 			CONSTEXPR_CPP17_CHOCOBO1_HASH void addDataImpl(const Span<const Byte> data);
 
-			static constexpr int BLOCK_SIZE = 16;
-
 			Buffer<Byte, (BLOCK_SIZE * 2)> m_buffer;  // x2 for paddings
 
 			std::array<Byte, 48> m_x {};
 			std::array<Byte, 16> m_checksum {};
 			Byte m_checksumL = 0;
-
-			static constexpr Byte piSubst[256] =
-			{
-				 41,  46,  67, 201, 162, 216, 124,   1,  61,  54,  84, 161, 236, 240,   6,  19,
-				 98, 167,   5, 243, 192, 199, 115, 140, 152, 147,  43, 217, 188,  76, 130, 202,
-				 30, 155,  87,  60, 253, 212, 224,  22, 103,  66, 111,  24, 138,  23, 229,  18,
-				190,  78, 196, 214, 218, 158, 222,  73, 160, 251, 245, 142, 187,  47, 238, 122,
-				169, 104, 121, 145,  21, 178,   7,  63, 148, 194,  16, 137,  11,  34,  95,  33,
-				128, 127,  93, 154,  90, 144,  50,  39,  53,  62, 204, 231, 191, 247, 151,   3,
-				255,  25,  48, 179,  72, 165, 181, 209, 215,  94, 146,  42, 172,  86, 170, 198,
-				 79, 184,  56, 210, 150, 164, 125, 182, 118, 252, 107, 226, 156, 116,   4, 241,
-				 69, 157, 112,  89, 100, 113, 135,  32, 134,  91, 207, 101, 230,  45, 168,   2,
-				 27,  96,  37, 173, 174, 176, 185, 246,  28,  70,  97, 105,  52,  64, 126,  15,
-				 85,  71, 163,  35, 221,  81, 175,  58, 195,  92, 249, 206, 186, 197, 234,  38,
-				 44,  83,  13, 110, 133,  40, 132,   9, 211, 223, 205, 244,  65, 129,  77,  82,
-				106, 220,  55, 200, 108, 193, 171, 250,  36, 225, 123,   8,  12, 189, 177,  74,
-				120, 136, 149, 139, 227,  99, 232, 109, 233, 203, 213, 254,  59,   0,  29,  57,
-				242, 239, 183,  14, 102,  88, 208, 228, 166, 119, 114, 248, 235, 117,  75,  10,
-				 49,  68,  80, 180, 143, 237,  31,  26, 219, 153, 141,  51, 159,  17, 131,  20
-			};
 	};
 
-	constexpr MD2::Byte MD2::piSubst[256];
-
 
 	template <typename R, typename T>
 	constexpr R ror(const T x, const unsigned int s)
@@ -276,7 +303,7 @@ namespace MD2_NS
 		return (*this);
 	}
 
-	std::string MD2::toString() const
+	inline std::string MD2::toString() const
 	{
 		const auto a = toArray();
 		std::string ret;
@@ -295,7 +322,7 @@ namespace MD2_NS
 		return ret;
 	}
 
-	std::vector<MD2::Byte> MD2::toVector() const
+	inline std::vector<MD2::Byte> MD2::toVector() const
 	{
 		const auto a = toArray();
 		return {a.begin(), a.end()};
@@ -306,6 +333,12 @@ namespace MD2_NS
 		return {{m_x[0], m_x[1], m_x[2], m_x[3], m_x[4], m_x[5], m_x[6], m_x[7], m_x[8], m_x[9], m_x[10], m_x[11], m_x[12], m_x[13], m_x[14], m_x[15]}};
 	}
 
+	CONSTEXPR_CPP17_CHOCOBO1_HASH MD2::ResultArrayType MD2::peekDigest() const
+	{
+		MD2 copy = *this;
+		return copy.finalize().toArray();
+	}
+
 	CONSTEXPR_CPP17_CHOCOBO1_HASH MD2& MD2::addData(const Span<const Byte> inData)
 	{
 		Span<const Byte> data = inData;
@@ -364,6 +397,46 @@ namespace MD2_NS
 		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
 	}
 
+	CONSTEXPR_CPP17_CHOCOBO1_HASH MD2::State MD2::exportState() const
+	{
+		State ret;
+		for (int i = 0; i < 16; ++i)
+		{
+			ret.h[i] = m_x[i];
+			ret.checksum[i] = m_checksum[i];
+		}
+		for (std::size_t i = 0; i < m_buffer.size(); ++i)
+			ret.buffer[i] = m_buffer[i];
+		ret.bufferSize = m_buffer.size();
+		return ret;
+	}
+
+	CONSTEXPR_CPP17_CHOCOBO1_HASH void MD2::importState(const State &state)
+	{
+		if (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE))
+			throw std::invalid_argument("MD2: importState() needs less than a block of pending bytes");
+
+		m_x = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			m_x[i] = state.h[i];
+			m_checksum[i] = state.checksum[i];
+		}
+		m_checksumL = m_checksum[15];  // the last checksum byte is carried to the next block
+		m_buffer = {state.buffer.begin(), (state.buffer.begin() + state.bufferSize)};
+	}
+
+	CONSTEXPR_CPP17_CHOCOBO1_HASH MD2& MD2::compressBlocks(const Span<const Byte> blocks)
+	{
+		if (!m_buffer.empty())
+			throw std::invalid_argument("MD2: compressBlocks() called with bytes pending from addData()");
+		if ((blocks.size() % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("MD2: compressBlocks() takes whole blocks only");
+
+		addDataImpl(blocks);
+		return (*this);
+	}
+
 	CONSTEXPR_CPP17_CHOCOBO1_HASH void MD2::addDataImpl(const Span<const Byte> data)
 	{
 		for (size_t i = 0, iend = static_cast<size_t>(data.size() / BLOCK_SIZE); i < iend; ++i)
@@ -399,6 +472,35 @@ namespace MD2_NS
 			}
 		}
 	}
+
+	inline std::vector<MD2::Byte> MD2::serialize() const
+	{
+		const State state = exportState();
+
+		StateWriter writer("MD2");
+		writer.put(state.h.data(), state.h.size());
+		writer.put(state.checksum.data(), state.checksum.size());
+		writer.put(static_cast<uint32_t>(state.bufferSize));
+		writer.put(state.buffer.data(), state.bufferSize);
+		return writer.data();
+	}
+
+	inline bool MD2::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "MD2");
+		State state;
+		reader.get(state.h.data(), state.h.size());
+		reader.get(state.checksum.data(), state.checksum.size());
+		state.bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE)))
+			return false;
+		reader.get(state.buffer.data(), state.bufferSize);
+		if (!reader.finished())
+			return false;
+
+		importState(state);
+		return true;
+	}
 }
 }
 	using MD2 = Hash::MD2_NS::MD2;
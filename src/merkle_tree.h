@@ -0,0 +1,771 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_MERKLE_TREE_H
+#define CHOCOBO1_MERKLE_TREE_H
+
+#include "hash_many.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// MerkleTree<H>();
+	// MerkleTree<H>(const MerkleTree<H>::Parameters &params);
+	//   `H` is any hash class providing `toArray()`, e.g. `MerkleTree<SHA2_256>()`
+	//   leaves and nodes go through `hashMany<H>()`, so a `MultiLane<H>` kernel is picked up automatically
+	//   `Parameters::leafSize` must be at least 1 & `Parameters::fanout` at least 2, otherwise it throws `std::invalid_argument`
+	//   `rangeProof()` throws `std::invalid_argument` without `Parameters::keepLevels` & `std::out_of_range` for a range past the end of the input
+
+	// MerkleVerifier<H>(const MerkleTree<H>::Parameters &params, const MerkleTree<H>::ResultArrayType &trustedRoot, const MerkleTree<H>::RangeProof &proof);
+	//   verifies the data of a range leaf by leaf as it arrives, the proof comes from `MerkleTree<H>::rangeProof()`
+	//   throws `std::invalid_argument` for the same parameters as `MerkleTree<H>`
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+namespace MerkleTree_NS
+{
+	template <typename H>
+	class MerkleVerifier;
+
+	template <typename H>
+	class MerkleTree
+	{
+		// leaf = H(leafPrefix || leaf data), node = H(nodePrefix || child digests)
+		// the tree is built level by level: every `fanout` consecutive nodes get a parent,
+		// a trailing group of 1 node is promoted to the next level unchanged
+		// an empty input is treated as a single empty leaf
+
+		public:
+			using Byte = uint8_t;
+			using ResultArrayType = typename H::ResultArrayType;
+
+			struct Parameters
+			{
+				std::size_t leafSize = 1024;
+				std::vector<Byte> leafPrefix = {0x00};
+				std::vector<Byte> nodePrefix = {0x01};
+				int fanout = 2;
+				bool keepLevels = false;  // retain every node for `levels()`, `serializeLevels()` & `rangeProof()`, memory grows with the input
+			};
+
+			struct RangeProof
+			{
+				// covers the whole leaves [firstLeaf, firstLeaf + leaves.size()), i.e. the data starting at `firstLeaf * leafSize`
+				uint64_t totalSize = 0;  // size of the whole input
+				uint64_t firstLeaf = 0;
+				std::vector<ResultArrayType> leaves;  // digests of the covered leaves
+				std::vector<ResultArrayType> siblings;  // nodes outside the range needed to rebuild the root, level by level from the bottom
+			};
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			MerkleTree();
+			explicit MerkleTree(const Parameters &params);
+
+			void reset();
+			MerkleTree& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `levels()`, `serializeLevels()`, `rangeProof()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+			ResultArrayType toArray() const;  // root
+
+			// level 0 holds the leaves, the last level holds the root. Requires `Parameters::keepLevels`
+			std::vector<std::vector<ResultArrayType>> levels() const;
+			// all digests concatenated, level by level starting from the leaves. Requires `Parameters::keepLevels`
+			// the level sizes follow from the leaf count & fanout
+			std::vector<Byte> serializeLevels() const;
+
+			// proof for the leaves overlapping bytes [offset, offset + length). Requires `Parameters::keepLevels`
+			RangeProof rangeProof(const uint64_t offset, const uint64_t length) const;
+
+			MerkleTree& addData(const Span<const Byte> inData);
+			MerkleTree& addData(const void *ptr, const std::size_t length);
+			template <typename T, std::size_t N>
+			MerkleTree& addData(const T (&array)[N]);
+			template <typename T>
+			MerkleTree& addData(const Span<T> inSpan);
+
+		private:
+			friend class MerkleVerifier<H>;
+
+			using DigestSpan = Span<const ResultArrayType>;
+
+			void hashLeaves(const Span<const Byte> data);
+			void hashLeavesRange(const Span<const Byte> data, ResultArrayType *out) const;
+			void addNodes(const std::size_t level, const DigestSpan nodes);
+
+			static void hashPrefixed(const Span<const Byte> prefix, const Span<const Byte> data, const std::size_t itemSize, ResultArrayType *out);
+			static uint64_t leafCount(const uint64_t totalSize, const std::size_t leafSize);
+			// throws `std::invalid_argument` for parameters the tree can't be built with
+			static void checkParameters(const Parameters &params);
+			// rebuild the root from a proof, returns false if the proof doesn't fit the tree shape
+			static bool rangeRoot(const Parameters &params, const RangeProof &proof, ResultArrayType &root);
+
+			// inputs at least this large are split across threads, which are started & joined within the call
+			// there's no pool, many small inputs are hashed on the calling thread without any thread start-up
+			static constexpr std::size_t THREAD_THRESHOLD = 1024 * 1024;
+			// leaves hashed per batch, bounds the memory used for leaf digests
+			static constexpr std::size_t BATCH_LEAVES = 4096;
+			// items passed to `hashMany()` at once, bounds the memory used for prefixing
+			static constexpr std::size_t HASH_MANY_ITEMS = 64;
+
+			const Parameters m_params;
+
+			std::vector<Byte> m_buffer;  // holds a partial leaf
+			uint64_t m_leafCount = 0;
+			uint64_t m_totalSize = 0;
+
+			std::vector<std::vector<ResultArrayType>> m_pending;  // per level, nodes waiting for their siblings
+			std::vector<uint64_t> m_levelSizes;
+			std::vector<std::vector<ResultArrayType>> m_levels;
+			ResultArrayType m_root {};
+	};
+
+
+	//
+	template <typename H>
+	MerkleTree<H>::MerkleTree()
+		: MerkleTree(Parameters {})
+	{
+	}
+
+	template <typename H>
+	MerkleTree<H>::MerkleTree(const Parameters &params)
+		: m_params(params)
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+		static_assert((sizeof(ResultArrayType) == std::tuple_size<ResultArrayType>::value), "Digests are stored back-to-back as node input");
+
+		checkParameters(m_params);
+
+		m_buffer.reserve(m_params.leafSize);
+	}
+
+	template <typename H>
+	void MerkleTree<H>::reset()
+	{
+		m_buffer.clear();
+		m_leafCount = 0;
+		m_totalSize = 0;
+
+		m_pending.clear();
+		m_levelSizes.clear();
+		m_levels.clear();
+		m_root = {};
+	}
+
+	template <typename H>
+	MerkleTree<H>& MerkleTree<H>::finalize()
+	{
+		if (!m_buffer.empty() || (m_leafCount == 0))
+		{
+			hashLeaves({m_buffer.data(), m_buffer.size()});
+			m_buffer.clear();
+		}
+
+		// flush the partial groups from the bottom up, each level is complete once the levels below are flushed
+		for (std::size_t level = 0; ; ++level)
+		{
+			if (m_levelSizes[level] == 1)
+			{
+				m_root = m_pending[level].front();
+				break;
+			}
+
+			auto &pending = m_pending[level];
+			if (pending.size() == 1)
+			{
+				const auto promoted = pending.front();
+				pending.clear();
+				addNodes((level + 1), {&promoted, 1});
+			}
+			else if (!pending.empty())
+			{
+				ResultArrayType parent {};
+				hashPrefixed({m_params.nodePrefix.data(), m_params.nodePrefix.size()}
+					, {reinterpret_cast<const Byte *>(pending.data()), (pending.size() * sizeof(ResultArrayType))}
+					, (pending.size() * sizeof(ResultArrayType)), &parent);
+				pending.clear();
+				addNodes((level + 1), {&parent, 1});
+			}
+		}
+
+		return (*this);
+	}
+
+	template <typename H>
+	std::string MerkleTree<H>::toString() const
+	{
+		const auto a = toArray();
+		std::string ret;
+		ret.resize(2 * a.size());
+
+		auto retPtr = &ret.front();
+		for (const auto c : a)
+		{
+			const Byte upper = static_cast<Byte>(c >> 4);
+			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
+
+			const Byte lower = c & 0xf;
+			*(retPtr++) = static_cast<char>((lower < 10) ? (lower + '0') : (lower - 10 + 'a'));
+		}
+
+		return ret;
+	}
+
+	template <typename H>
+	std::vector<typename MerkleTree<H>::Byte> MerkleTree<H>::toVector() const
+	{
+		const auto a = toArray();
+		return {a.begin(), a.end()};
+	}
+
+	template <typename H>
+	typename MerkleTree<H>::ResultArrayType MerkleTree<H>::toArray() const
+	{
+		return m_root;
+	}
+
+	template <typename H>
+	std::vector<std::vector<typename MerkleTree<H>::ResultArrayType>> MerkleTree<H>::levels() const
+	{
+		assert(m_params.keepLevels);
+		return m_levels;
+	}
+
+	template <typename H>
+	std::vector<typename MerkleTree<H>::Byte> MerkleTree<H>::serializeLevels() const
+	{
+		assert(m_params.keepLevels);
+
+		std::vector<Byte> ret;
+		for (const auto &level : m_levels)
+		{
+			for (const auto &node : level)
+				ret.insert(ret.end(), node.begin(), node.end());
+		}
+		return ret;
+	}
+
+	template <typename H>
+	typename MerkleTree<H>::RangeProof MerkleTree<H>::rangeProof(const uint64_t offset, const uint64_t length) const
+	{
+		if (!m_params.keepLevels)
+			throw std::invalid_argument("MerkleTree: rangeProof() requires Parameters::keepLevels");
+		if ((offset > m_totalSize) || (length > (m_totalSize - offset)))
+			throw std::out_of_range("MerkleTree: rangeProof() range is past the end of the input");
+
+		const uint64_t leafSize = m_params.leafSize;
+		const uint64_t fanout = static_cast<uint64_t>(m_params.fanout);
+
+		RangeProof ret;
+		ret.totalSize = m_totalSize;
+		ret.firstLeaf = std::min((offset / leafSize), (m_leafCount - 1));
+		const uint64_t endLeaf = std::min(std::max((ret.firstLeaf + 1), ((offset + length + leafSize - 1) / leafSize)), m_leafCount);
+		ret.leaves.assign((m_levels[0].begin() + static_cast<std::ptrdiff_t>(ret.firstLeaf)), (m_levels[0].begin() + static_cast<std::ptrdiff_t>(endLeaf)));
+
+		// walk up the levels, collecting the nodes which share a parent with the range but lie outside it
+		uint64_t first = ret.firstLeaf;
+		uint64_t last = ret.firstLeaf + ret.leaves.size() - 1;
+		for (std::size_t level = 0; (level + 1) < m_levels.size(); ++level)
+		{
+			const uint64_t levelSize = m_levels[level].size();
+			const uint64_t groupStart = (first / fanout) * fanout;
+			const uint64_t groupEnd = std::min((((last / fanout) + 1) * fanout), levelSize);
+			for (uint64_t i = groupStart; i < groupEnd; ++i)
+			{
+				if ((i < first) || (i > last))
+					ret.siblings.push_back(m_levels[level][i]);
+			}
+
+			first /= fanout;
+			last /= fanout;
+		}
+
+		return ret;
+	}
+
+	template <typename H>
+	MerkleTree<H>& MerkleTree<H>::addData(const Span<const Byte> inData)
+	{
+		Span<const Byte> data = inData;
+		m_totalSize += static_cast<uint64_t>(data.size());
+
+		if (!m_buffer.empty())
+		{
+			const std::size_t len = std::min<std::size_t>((m_params.leafSize - m_buffer.size()), data.size());
+			m_buffer.insert(m_buffer.end(), data.begin(), (data.begin() + len));
+			data = data.subspan(len);
+
+			if (m_buffer.size() < m_params.leafSize)
+				return (*this);
+
+			hashLeaves({m_buffer.data(), m_buffer.size()});
+			m_buffer.clear();
+		}
+
+		// hash whole leaves straight from the input
+		const std::size_t len = (data.size() / m_params.leafSize) * m_params.leafSize;
+		const std::size_t batchSize = BATCH_LEAVES * m_params.leafSize;
+		for (std::size_t offset = 0; offset < len; offset += batchSize)
+			hashLeaves(data.subspan(offset, std::min(batchSize, (len - offset))));
+
+		m_buffer.assign((data.begin() + len), data.end());
+		return (*this);
+	}
+
+	template <typename H>
+	MerkleTree<H>& MerkleTree<H>::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <typename H>
+	template <typename T, std::size_t N>
+	MerkleTree<H>& MerkleTree<H>::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename H>
+	template <typename T>
+	MerkleTree<H>& MerkleTree<H>::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	template <typename H>
+	void MerkleTree<H>::hashLeaves(const Span<const Byte> data)
+	{
+		// `data` consists of whole leaves, except for the last leaf of the input
+		const std::size_t leafSize = m_params.leafSize;
+		const std::size_t leaves = std::max<std::size_t>(1, ((data.size() + leafSize - 1) / leafSize));
+		std::vector<ResultArrayType> digests(leaves);
+
+		const unsigned int cores = std::thread::hardware_concurrency();
+		if ((static_cast<std::size_t>(data.size()) >= THREAD_THRESHOLD) && (cores != 1))
+		{
+			const std::size_t threadCount = (cores == 0) ? 2 : cores;
+			const std::size_t perThread = (leaves + threadCount - 1) / threadCount;
+
+			std::vector<std::thread> workers;
+			for (std::size_t first = perThread; first < leaves; first += perThread)
+			{
+				const std::size_t count = std::min(perThread, (leaves - first));
+				workers.emplace_back([this, data, first, count, leafSize, &digests]()
+				{
+					const std::size_t offset = first * leafSize;
+					hashLeavesRange(data.subspan(offset, std::min((count * leafSize), (data.size() - offset))), (digests.data() + first));
+				});
+			}
+			hashLeavesRange(data.first(std::min<std::size_t>((perThread * leafSize), data.size())), digests.data());
+
+			for (auto &worker : workers)
+				worker.join();
+		}
+		else
+		{
+			hashLeavesRange(data, digests.data());
+		}
+
+		m_leafCount += leaves;
+		addNodes(0, {digests.data(), digests.size()});
+	}
+
+	template <typename H>
+	void MerkleTree<H>::hashLeavesRange(const Span<const Byte> data, ResultArrayType *out) const
+	{
+		hashPrefixed({m_params.leafPrefix.data(), m_params.leafPrefix.size()}, data, m_params.leafSize, out);
+	}
+
+	template <typename H>
+	void MerkleTree<H>::hashPrefixed(const Span<const Byte> prefix, const Span<const Byte> data, const std::size_t itemSize, ResultArrayType *out)
+	{
+		// hash each `itemSize` bytes of `data` (the last item may be shorter) with `prefix` prepended
+		const std::size_t items = std::max<std::size_t>(1, ((data.size() + itemSize - 1) / itemSize));
+		const std::size_t hashManyItems = HASH_MANY_ITEMS;
+
+		std::vector<Byte> staging;
+		for (std::size_t first = 0; first < items; first += hashManyItems)
+		{
+			const std::size_t count = std::min(hashManyItems, (items - first));
+
+			// `hashMany()` takes contiguous messages, so prefixed items are copied
+			if (!prefix.empty())
+				staging.resize(count * (prefix.size() + itemSize));
+
+			std::vector<Span<const Byte>> inputs(count);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const std::size_t offset = (first + i) * itemSize;
+				const Span<const Byte> item = data.subspan(std::min<std::size_t>(offset, data.size()), std::min(itemSize, (data.size() - std::min<std::size_t>(offset, data.size()))));
+				if (prefix.empty())
+				{
+					inputs[i] = item;
+					continue;
+				}
+
+				Byte *dest = staging.data() + (i * (prefix.size() + itemSize));
+				std::copy(prefix.begin(), prefix.end(), dest);
+				std::copy(item.begin(), item.end(), (dest + prefix.size()));
+				inputs[i] = {dest, (prefix.size() + item.size())};
+			}
+
+			Chocobo1::hashMany<H>({inputs.data(), inputs.size()}, {(out + first), count});
+		}
+	}
+
+	template <typename H>
+	uint64_t MerkleTree<H>::leafCount(const uint64_t totalSize, const std::size_t leafSize)
+	{
+		return std::max<uint64_t>(1, ((totalSize + leafSize - 1) / leafSize));
+	}
+
+	template <typename H>
+	void MerkleTree<H>::checkParameters(const Parameters &params)
+	{
+		if (params.leafSize < 1)
+			throw std::invalid_argument("MerkleTree: leafSize must be at least 1");
+		if (params.fanout < 2)
+			throw std::invalid_argument("MerkleTree: fanout must be at least 2");
+	}
+
+	template <typename H>
+	bool MerkleTree<H>::rangeRoot(const Parameters &params, const RangeProof &proof, ResultArrayType &root)
+	{
+		const uint64_t fanout = static_cast<uint64_t>(params.fanout);
+		uint64_t levelSize = leafCount(proof.totalSize, params.leafSize);
+		uint64_t first = proof.firstLeaf;
+		if (proof.leaves.empty() || ((first + proof.leaves.size()) > levelSize))
+			return false;
+
+		std::vector<ResultArrayType> nodes = proof.leaves;
+		std::size_t sibling = 0;
+		while (levelSize > 1)
+		{
+			const uint64_t last = first + nodes.size() - 1;
+			const uint64_t groupStart = (first / fanout) * fanout;
+
+			std::vector<ResultArrayType> parents;
+			for (uint64_t group = groupStart; group <= last; group += fanout)
+			{
+				const uint64_t groupEnd = std::min((group + fanout), levelSize);
+
+				std::vector<ResultArrayType> children;
+				for (uint64_t i = group; i < groupEnd; ++i)
+				{
+					if ((i >= first) && (i <= last))
+					{
+						children.push_back(nodes[i - first]);
+						continue;
+					}
+
+					if (sibling >= proof.siblings.size())
+						return false;
+					children.push_back(proof.siblings[sibling++]);
+				}
+
+				if (children.size() == 1)
+				{
+					// promoted
+					parents.push_back(children.front());
+					continue;
+				}
+
+				ResultArrayType parent {};
+				hashPrefixed({params.nodePrefix.data(), params.nodePrefix.size()}
+					, {reinterpret_cast<const Byte *>(children.data()), (children.size() * sizeof(ResultArrayType))}
+					, (children.size() * sizeof(ResultArrayType)), &parent);
+				parents.push_back(parent);
+			}
+
+			nodes = std::move(parents);
+			first /= fanout;
+			levelSize = (levelSize + fanout - 1) / fanout;
+		}
+
+		root = nodes.front();
+		return (sibling == proof.siblings.size());
+	}
+
+	template <typename H>
+	void MerkleTree<H>::addNodes(const std::size_t level, const DigestSpan nodes)
+	{
+		if (nodes.empty())
+			return;
+
+		if (m_pending.size() <= level)
+		{
+			m_pending.resize(level + 1);
+			m_levelSizes.resize(level + 1, 0);
+			if (m_params.keepLevels)
+				m_levels.resize(level + 1);
+		}
+
+		m_levelSizes[level] += static_cast<uint64_t>(nodes.size());
+		if (m_params.keepLevels)
+			m_levels[level].insert(m_levels[level].end(), nodes.begin(), nodes.end());
+
+		auto &pending = m_pending[level];
+		pending.insert(pending.end(), nodes.begin(), nodes.end());
+
+		// build the parents of every complete group at once
+		const std::size_t fanout = static_cast<std::size_t>(m_params.fanout);
+		const std::size_t groups = pending.size() / fanout;
+		if (groups == 0)
+			return;
+
+		const std::size_t groupSize = fanout * sizeof(ResultArrayType);
+		std::vector<ResultArrayType> parents(groups);
+		hashPrefixed({m_params.nodePrefix.data(), m_params.nodePrefix.size()}
+			, {reinterpret_cast<const Byte *>(pending.data()), (groups * groupSize)}
+			, groupSize, parents.data());
+		pending.erase(pending.begin(), (pending.begin() + (groups * fanout)));
+
+		addNodes((level + 1), {parents.data(), parents.size()});
+	}
+
+	template <typename H>
+	class MerkleVerifier
+	{
+		// checks each leaf of a range against a trusted root as soon as the leaf is complete
+		// the leaf digests in the proof are checked against the root upfront, so a bad leaf is caught without waiting for the rest
+
+		public:
+			using Byte = uint8_t;
+			using Tree = MerkleTree<H>;
+			using ResultArrayType = typename Tree::ResultArrayType;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			MerkleVerifier(const typename Tree::Parameters &params, const ResultArrayType &trustedRoot, const typename Tree::RangeProof &proof);
+
+			bool isValid() const;  // the proof matches the root and all data so far matches the proof
+			bool finalize();  // returns true if the whole range arrived and matched
+
+			uint64_t dataOffset() const;  // where the data of the range starts in the whole input
+			uint64_t dataSize() const;
+			uint64_t verifiedSize() const;  // bytes that passed verification, counted from `dataOffset()`
+
+			MerkleVerifier& addData(const Span<const Byte> inData);
+			MerkleVerifier& addData(const void *ptr, const std::size_t length);
+			template <typename T, std::size_t N>
+			MerkleVerifier& addData(const T (&array)[N]);
+			template <typename T>
+			MerkleVerifier& addData(const Span<T> inSpan);
+
+		private:
+			std::size_t expectedLeafSize(const std::size_t index) const;
+			void checkLeaf(const Span<const Byte> leaf);
+
+			const typename Tree::Parameters m_params;
+			const typename Tree::RangeProof m_proof;
+
+			bool m_valid = false;
+			std::size_t m_leafIndex = 0;  // into `m_proof.leaves`
+			uint64_t m_verifiedSize = 0;
+			std::vector<Byte> m_buffer;  // holds a partial leaf
+	};
+
+
+	//
+	template <typename H>
+	MerkleVerifier<H>::MerkleVerifier(const typename Tree::Parameters &params, const ResultArrayType &trustedRoot, const typename Tree::RangeProof &proof)
+		: m_params(params)
+		, m_proof(proof)
+	{
+		Tree::checkParameters(m_params);
+
+		ResultArrayType root {};
+		m_valid = Tree::rangeRoot(m_params, m_proof, root) && (root == trustedRoot);
+
+		m_buffer.reserve(m_params.leafSize);
+	}
+
+	template <typename H>
+	bool MerkleVerifier<H>::isValid() const
+	{
+		return m_valid;
+	}
+
+	template <typename H>
+	bool MerkleVerifier<H>::finalize()
+	{
+		// only an empty input has an empty leaf
+		if (m_valid && (m_leafIndex < m_proof.leaves.size()) && (m_buffer.size() == expectedLeafSize(m_leafIndex)))
+			checkLeaf({m_buffer.data(), m_buffer.size()});
+
+		return (m_valid && (m_leafIndex == m_proof.leaves.size()));
+	}
+
+	template <typename H>
+	uint64_t MerkleVerifier<H>::dataOffset() const
+	{
+		return (m_proof.firstLeaf * m_params.leafSize);
+	}
+
+	template <typename H>
+	uint64_t MerkleVerifier<H>::dataSize() const
+	{
+		uint64_t ret = 0;
+		for (std::size_t i = 0; i < m_proof.leaves.size(); ++i)
+			ret += expectedLeafSize(i);
+		return ret;
+	}
+
+	template <typename H>
+	uint64_t MerkleVerifier<H>::verifiedSize() const
+	{
+		return m_verifiedSize;
+	}
+
+	template <typename H>
+	MerkleVerifier<H>& MerkleVerifier<H>::addData(const Span<const Byte> inData)
+	{
+		Span<const Byte> data = inData;
+
+		while (m_valid && !data.empty())
+		{
+			const std::size_t leafSize = (m_leafIndex < m_proof.leaves.size()) ? expectedLeafSize(m_leafIndex) : 0;
+			if (leafSize == 0)
+			{
+				// more data than the range holds
+				m_valid = false;
+				break;
+			}
+
+			if (m_buffer.empty() && (static_cast<std::size_t>(data.size()) >= leafSize))
+			{
+				// check whole leaves straight from the input
+				checkLeaf(data.first(leafSize));
+				data = data.subspan(leafSize);
+				continue;
+			}
+
+			const std::size_t len = std::min<std::size_t>((leafSize - m_buffer.size()), data.size());
+			m_buffer.insert(m_buffer.end(), data.begin(), (data.begin() + len));
+			data = data.subspan(len);
+
+			if (m_buffer.size() == leafSize)
+			{
+				checkLeaf({m_buffer.data(), m_buffer.size()});
+				m_buffer.clear();
+			}
+		}
+
+		return (*this);
+	}
+
+	template <typename H>
+	MerkleVerifier<H>& MerkleVerifier<H>::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <typename H>
+	template <typename T, std::size_t N>
+	MerkleVerifier<H>& MerkleVerifier<H>::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename H>
+	template <typename T>
+	MerkleVerifier<H>& MerkleVerifier<H>::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	template <typename H>
+	std::size_t MerkleVerifier<H>::expectedLeafSize(const std::size_t index) const
+	{
+		const uint64_t leafOffset = (m_proof.firstLeaf + index) * m_params.leafSize;
+		if (leafOffset >= m_proof.totalSize)
+			return 0;
+		return static_cast<std::size_t>(std::min<uint64_t>(m_params.leafSize, (m_proof.totalSize - leafOffset)));
+	}
+
+	template <typename H>
+	void MerkleVerifier<H>::checkLeaf(const Span<const Byte> leaf)
+	{
+		ResultArrayType digest {};
+		Tree::hashPrefixed({m_params.leafPrefix.data(), m_params.leafPrefix.size()}, leaf, m_params.leafSize, &digest);
+
+		if (digest != m_proof.leaves[m_leafIndex])
+		{
+			m_valid = false;
+			return;
+		}
+
+		++m_leafIndex;
+		m_verifiedSize += static_cast<uint64_t>(leaf.size());
+	}
+}
+}
+	template <typename H>
+	using MerkleTree = Hash::MerkleTree_NS::MerkleTree<H>;
+	template <typename H>
+	using MerkleVerifier = Hash::MerkleTree_NS::MerkleVerifier<H>;
+}
+
+#endif  // CHOCOBO1_MERKLE_TREE_H
@@ -0,0 +1,456 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_PARALLEL_HASH_H
+#define CHOCOBO1_PARALLEL_HASH_H
+
+#include "cshake.h"
+#include "state_serializer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// ParallelHash_128(const int digestLengthInBytes, const int blockSize, const std::string &customize = {});
+	// ParallelHash_256(const int digestLengthInBytes, const int blockSize, const std::string &customize = {});
+
+	// ParallelHashXOF_128(const int digestLengthInBytes, const int blockSize, const std::string &customize = {});
+	// ParallelHashXOF_256(const int digestLengthInBytes, const int blockSize, const std::string &customize = {});
+	//   a `blockSize` that isn't positive throws `std::invalid_argument`
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, restore into an instance constructed with the same parameters
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+namespace Hash
+{
+namespace ParallelHash_NS
+{
+	template <typename C, typename S, int D, bool XOF>  // `C`: outer cSHAKE, `S`: leaf SHAKE, `D`: leaf digest length in bytes
+	class ParallelHash
+	{
+		// https://doi.org/10.6028/NIST.SP.800-185
+
+		public:
+			using Byte = uint8_t;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			explicit ParallelHash(const int digestLength, const int blockSize, const std::string &customize = {});
+
+			void reset();
+			ParallelHash& finalize();  // after this, only `toString()`, `toVector()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+
+			ParallelHash& addData(const Span<const Byte> inData);
+			ParallelHash& addData(const void *ptr, const std::size_t length);
+			template <typename T, std::size_t N>
+			ParallelHash& addData(const T (&array)[N]);
+			template <typename T>
+			ParallelHash& addData(const Span<T> inSpan);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// restore into an instance constructed with the same parameters
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			using Keccak = typename S::Keccak;
+
+			void hashLeaves(const Span<const Byte> data);
+			void hashLeavesRange(const Byte *data, const std::size_t leaves, Byte *digests) const;
+			void addLeafDigests(const Span<const Byte> digests);
+			void addPartialLeaf(const Span<const Byte> data);
+			void finishPartialLeaf();
+
+			static constexpr int LANES = Keccak::SIMD_LANES;
+			// `LANES` leaves are staged for a SIMD pass only if they fit in here, larger leaves are absorbed as they arrive
+			// either way the memory used doesn't grow with the block size
+			static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+			// batches of leaves at least this large are split across threads
+			// threads are started per batch rather than pooled, smaller batches are hashed on the calling thread
+			static constexpr std::size_t THREAD_THRESHOLD = 1024 * 1024;
+			// leaves hashed per batch, bounds the memory used for leaf digests
+			static constexpr std::size_t BATCH_LEAVES = 4096;
+
+			const int m_digestLength;
+			const std::size_t m_blockSize;
+
+			C m_prefixed;  // after the cSHAKE prefix & left_encode(B), `reset()` starts over from here
+			C m_outer;
+			const bool m_buffered;  // `LANES` leaves fit in `BUFFER_SIZE`
+			std::vector<Byte> m_buffer;  // holds up to `LANES` leaves, used if `m_buffered`
+			S m_leaf;  // the partial leaf, used if not `m_buffered`
+			std::size_t m_leafFill = 0;  // bytes absorbed into `m_leaf`
+			uint64_t m_leafCount = 0;
+	};
+
+
+	// helpers
+	constexpr Buffer<uint8_t, (sizeof(uint64_t) + 1)> rightEncode(const uint64_t value)
+	{
+		uint8_t n = 1;
+		while ((n < sizeof(value)) && ((value >> (8 * n)) != 0))
+			++n;
+
+		Buffer<uint8_t, (sizeof(uint64_t) + 1)> ret;
+		for (int i = (n - 1); i >= 0; --i)
+			ret.fill(Chocobo1::Hash::CShake_NS::ror<uint8_t>(value, (8 * i)));
+		ret.fill(n);
+
+		return ret;
+	}
+
+	template <typename T, std::size_t... I>
+	std::array<T, sizeof...(I)> makeStates(const int digestLength, std::index_sequence<I...>)
+	{
+		// one `T(digestLength)` per index, `T` has no default constructor
+		return {{(static_cast<void>(I), T(digestLength))...}};
+	}
+
+
+	//
+	template <typename C, typename S, int D, bool XOF>
+	ParallelHash<C, S, D, XOF>::ParallelHash(const int digestLength, const int blockSize, const std::string &customize)
+		: m_digestLength(digestLength)
+		, m_blockSize(static_cast<std::size_t>(blockSize))
+		, m_prefixed(digestLength, "ParallelHash", customize)
+		, m_outer(m_prefixed)
+		, m_buffered((m_blockSize * LANES) <= BUFFER_SIZE)
+		, m_leaf(D)
+	{
+		static_assert((D > 0), "Template parameter value invalid: D");
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+		if (blockSize <= 0)
+			throw std::invalid_argument("ParallelHash: blockSize must be positive");
+
+		const auto encoded = Chocobo1::Hash::CShake_NS::leftEncode(m_blockSize);
+		m_prefixed.addData({encoded.data(), encoded.size()});
+
+		if (m_buffered)
+			m_buffer.reserve(m_blockSize * LANES);
+		reset();
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	void ParallelHash<C, S, D, XOF>::reset()
+	{
+		m_outer = m_prefixed;
+		m_buffer.clear();
+		m_leaf.reset();
+		m_leafFill = 0;
+		m_leafCount = 0;
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	ParallelHash<C, S, D, XOF>& ParallelHash<C, S, D, XOF>::finalize()
+	{
+		// the last leaf may be shorter than `m_blockSize`
+		const std::size_t fullLeaves = m_buffer.size() / m_blockSize;
+		hashLeaves({m_buffer.data(), (fullLeaves * m_blockSize)});
+
+		const std::size_t remainder = m_buffer.size() % m_blockSize;
+		if (remainder > 0)
+		{
+			const auto digest = S(D).addData((m_buffer.data() + (fullLeaves * m_blockSize)), remainder).finalize().toVector();
+			addLeafDigests({digest.data(), digest.size()});
+		}
+		m_buffer.clear();
+
+		if (m_leafFill > 0)
+			finishPartialLeaf();
+
+		const auto encodedCount = rightEncode(m_leafCount);
+		m_outer.addData({encodedCount.data(), encodedCount.size()});
+		const auto encodedLength = rightEncode(XOF ? 0 : (static_cast<uint64_t>(m_digestLength) * 8));
+		m_outer.addData({encodedLength.data(), encodedLength.size()});
+
+		m_outer.finalize();
+		return (*this);
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	std::string ParallelHash<C, S, D, XOF>::toString() const
+	{
+		return m_outer.toString();
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	std::vector<typename ParallelHash<C, S, D, XOF>::Byte> ParallelHash<C, S, D, XOF>::toVector() const
+	{
+		return m_outer.toVector();
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	ParallelHash<C, S, D, XOF>& ParallelHash<C, S, D, XOF>::addData(const Span<const Byte> inData)
+	{
+		if (!m_buffered)
+		{
+			// complete the partial leaf, hash the whole leaves straight from the input & absorb the rest
+			Span<const Byte> data = inData;
+			if (m_leafFill > 0)
+			{
+				const std::size_t len = std::min<std::size_t>((m_blockSize - m_leafFill), data.size());
+				addPartialLeaf(data.first(len));
+				data = data.subspan(len);
+
+				if (m_leafFill < m_blockSize)
+					return (*this);
+				finishPartialLeaf();
+			}
+
+			const std::size_t len = (data.size() / m_blockSize) * m_blockSize;
+			hashLeaves(data.first(len));
+			addPartialLeaf(data.subspan(len));
+			return (*this);
+		}
+
+		const std::size_t batchSize = m_blockSize * LANES;
+		Span<const Byte> data = inData;
+
+		if (!m_buffer.empty())
+		{
+			const std::size_t len = std::min<std::size_t>((batchSize - m_buffer.size()), data.size());
+			m_buffer.insert(m_buffer.end(), data.begin(), (data.begin() + len));
+			data = data.subspan(len);
+
+			if (m_buffer.size() < batchSize)
+				return (*this);
+
+			hashLeaves({m_buffer.data(), m_buffer.size()});
+			m_buffer.clear();
+		}
+
+		// hash whole batches straight from the input
+		const std::size_t len = (data.size() / batchSize) * batchSize;
+		hashLeaves(data.first(len));
+
+		m_buffer.assign((data.begin() + len), data.end());
+		return (*this);
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	ParallelHash<C, S, D, XOF>& ParallelHash<C, S, D, XOF>::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	template <typename T, std::size_t N>
+	ParallelHash<C, S, D, XOF>& ParallelHash<C, S, D, XOF>::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	template <typename T>
+	ParallelHash<C, S, D, XOF>& ParallelHash<C, S, D, XOF>::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	std::vector<typename ParallelHash<C, S, D, XOF>::Byte> ParallelHash<C, S, D, XOF>::serialize() const
+	{
+		StateWriter writer("ParallelHash" + std::string(XOF ? "XOF_" : "_") + std::to_string(D));
+		writer.put(static_cast<uint64_t>(m_blockSize));
+		writer.putNested(m_outer.serialize());
+		writer.put(m_leafCount);
+		writer.putNested(m_buffer);
+		writer.put(static_cast<uint64_t>(m_leafFill));
+		writer.putNested(m_leaf.serialize());
+		return writer.data();
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	bool ParallelHash<C, S, D, XOF>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "ParallelHash" + std::string(XOF ? "XOF_" : "_") + std::to_string(D));
+		const uint64_t blockSize = reader.get<uint64_t>();
+		const std::vector<Byte> outer = reader.getNested();
+		const uint64_t leafCount = reader.get<uint64_t>();
+		std::vector<Byte> buffer = reader.getNested();
+		const uint64_t leafFill = reader.get<uint64_t>();
+		const std::vector<Byte> leaf = reader.getNested();
+		// pending bytes are either staged or absorbed, depending on the block size
+		const bool pendingValid = m_buffered
+			? ((buffer.size() < (m_blockSize * LANES)) && (leafFill == 0))
+			: (buffer.empty() && (leafFill < m_blockSize));
+		if (!reader.finished() || (blockSize != m_blockSize) || !pendingValid)
+			return false;
+
+		S leafState(D);
+		if (!leafState.restore({leaf.data(), leaf.size()}) || !m_outer.restore({outer.data(), outer.size()}))
+			return false;
+
+		m_leafCount = leafCount;
+		m_buffer = std::move(buffer);
+		if (m_buffered)
+			m_buffer.reserve(m_blockSize * LANES);
+		m_leaf = leafState;
+		m_leafFill = static_cast<std::size_t>(leafFill);
+		return true;
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	void ParallelHash<C, S, D, XOF>::hashLeaves(const Span<const Byte> data)
+	{
+		// `data` consists of whole leaves
+		assert((data.size() % m_blockSize) == 0);
+
+		const unsigned int cores = std::thread::hardware_concurrency();
+		const std::size_t batchLeaves = BATCH_LEAVES;
+		std::vector<Byte> digests;
+
+		for (std::size_t offset = 0; offset < static_cast<std::size_t>(data.size()); offset += (batchLeaves * m_blockSize))
+		{
+			const std::size_t leaves = std::min<std::size_t>(batchLeaves, ((data.size() - offset) / m_blockSize));
+			const Byte *batch = data.data() + offset;
+			digests.resize(leaves * D);
+
+			if (((leaves * m_blockSize) >= THREAD_THRESHOLD) && (cores != 1))
+			{
+				const std::size_t threadCount = (cores == 0) ? 2 : cores;
+				// keep the SIMD groups intact
+				const std::size_t perThread = (((leaves + threadCount - 1) / threadCount) + LANES - 1) / LANES * LANES;
+
+				std::vector<std::thread> workers;
+				for (std::size_t first = perThread; first < leaves; first += perThread)
+				{
+					const std::size_t count = std::min(perThread, (leaves - first));
+					workers.emplace_back([this, batch, first, count, &digests]()
+					{
+						hashLeavesRange((batch + (first * m_blockSize)), count, (digests.data() + (first * D)));
+					});
+				}
+				hashLeavesRange(batch, std::min(perThread, leaves), digests.data());
+
+				for (auto &worker : workers)
+					worker.join();
+			}
+			else
+			{
+				hashLeavesRange(batch, leaves, digests.data());
+			}
+
+			addLeafDigests({digests.data(), digests.size()});
+		}
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	void ParallelHash<C, S, D, XOF>::hashLeavesRange(const Byte *data, const std::size_t leaves, Byte *digests) const
+	{
+		const std::size_t wholeBlocks = m_blockSize / Keccak::BLOCK_SIZE;
+		const std::size_t tailLength = m_blockSize % Keccak::BLOCK_SIZE;
+
+		auto states = makeStates<S>(D, std::make_index_sequence<LANES> {});
+		std::size_t i = 0;
+		for (; (i + LANES) <= leaves; i += LANES)
+		{
+			Keccak *statePtrs[LANES] = {};
+			const Byte *leafData[LANES] = {};
+			for (int lane = 0; lane < LANES; ++lane)
+			{
+				states[lane].reset();
+				statePtrs[lane] = &states[lane];
+				leafData[lane] = data + ((i + lane) * m_blockSize);
+			}
+			Keccak::addBlocks(statePtrs, leafData, wholeBlocks);
+
+			for (int lane = 0; lane < LANES; ++lane)
+			{
+				const auto digest = states[lane].addData((leafData[lane] + (wholeBlocks * Keccak::BLOCK_SIZE)), tailLength).finalize().toVector();
+				std::copy(digest.begin(), digest.end(), (digests + ((i + lane) * D)));
+			}
+		}
+
+		for (; i < leaves; ++i)
+		{
+			S &state = states[0];
+			state.reset();
+			const auto digest = state.addData((data + (i * m_blockSize)), m_blockSize).finalize().toVector();
+			std::copy(digest.begin(), digest.end(), (digests + (i * D)));
+		}
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	void ParallelHash<C, S, D, XOF>::addLeafDigests(const Span<const Byte> digests)
+	{
+		m_outer.addData(digests);
+		m_leafCount += static_cast<uint64_t>(digests.size() / D);
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	void ParallelHash<C, S, D, XOF>::addPartialLeaf(const Span<const Byte> data)
+	{
+		m_leaf.addData(data);
+		m_leafFill += static_cast<std::size_t>(data.size());
+	}
+
+	template <typename C, typename S, int D, bool XOF>
+	void ParallelHash<C, S, D, XOF>::finishPartialLeaf()
+	{
+		const auto digest = m_leaf.finalize().toVector();
+		addLeafDigests({digest.data(), digest.size()});
+		m_leaf.reset();
+		m_leafFill = 0;
+	}
+}
+}
+	struct ParallelHash_128 : Hash::ParallelHash_NS::ParallelHash<CSHAKE_128, SHAKE_128, (256 / 8), false> { explicit ParallelHash_128(const int l, const int b, const std::string &c = {}) : Hash::ParallelHash_NS::ParallelHash<CSHAKE_128, SHAKE_128, (256 / 8), false>(l, b, c) {} };
+	struct ParallelHash_256 : Hash::ParallelHash_NS::ParallelHash<CSHAKE_256, SHAKE_256, (512 / 8), false> { explicit ParallelHash_256(const int l, const int b, const std::string &c = {}) : Hash::ParallelHash_NS::ParallelHash<CSHAKE_256, SHAKE_256, (512 / 8), false>(l, b, c) {} };
+	struct ParallelHashXOF_128 : Hash::ParallelHash_NS::ParallelHash<CSHAKE_128, SHAKE_128, (256 / 8), true> { explicit ParallelHashXOF_128(const int l, const int b, const std::string &c = {}) : Hash::ParallelHash_NS::ParallelHash<CSHAKE_128, SHAKE_128, (256 / 8), true>(l, b, c) {} };
+	struct ParallelHashXOF_256 : Hash::ParallelHash_NS::ParallelHash<CSHAKE_256, SHAKE_256, (512 / 8), true> { explicit ParallelHashXOF_256(const int l, const int b, const std::string &c = {}) : Hash::ParallelHash_NS::ParallelHash<CSHAKE_256, SHAKE_256, (512 / 8), true>(l, b, c) {} };
+}
+
+#endif  // CHOCOBO1_PARALLEL_HASH_H
@@ -0,0 +1,265 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_PBKDF2_H
+#define CHOCOBO1_PBKDF2_H
+
+#include "hmac.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// PBKDF2<H>::derive(const Span<const Byte> password, const Span<const Byte> salt, const uint32_t iterations, const Span<Byte> output);
+	// PBKDF2<H>::deriveMany(const Span<const Span<const Byte>> passwords, const Span<const Byte> salt, const uint32_t iterations, const Span<const Span<Byte>> outputs);
+	//   `H` is a hash class accepted by `HMAC<H>`, e.g. `PBKDF2<SHA2_256>::derive(password, salt, 100000, key)`
+	//   zero `iterations` or `passwords` & `outputs` of different sizes throw `std::invalid_argument`
+	//   the output blocks of all passwords are iterated side by side, `SHA2_256` & `SHA2_512` iterate on raw midstates in SIMD lanes
+	//   the raw kernels are the `Hash::HMAC_NS::Midstate<H>` specializations from hmac.h
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+namespace PBKDF2_NS
+{
+	using Byte = uint8_t;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+	template <typename T, std::size_t Extent = std::dynamic_extent>
+	using Span = std::span<T, Extent>;
+#else
+	template <typename T, std::size_t Extent = gsl::dynamic_extent>
+	using Span = gsl::span<T, Extent>;
+#endif
+
+	template <typename H>
+	using Midstate = HMAC_NS::Midstate<H>;
+
+
+	template <typename H>
+	class PBKDF2
+	{
+		// https://tools.ietf.org/html/rfc8018#section-5.2
+
+		public:
+			using Byte = uint8_t;
+			using ResultArrayType = typename H::ResultArrayType;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			static void derive(const Span<const Byte> password, const Span<const Byte> salt, const uint32_t iterations, const Span<Byte> output);
+
+			// `outputs[i]` = key derived from `passwords[i]`, the output lengths may differ
+			static void deriveMany(const Span<const Span<const Byte>> passwords, const Span<const Byte> salt, const uint32_t iterations, const Span<const Span<Byte>> outputs);
+
+		private:
+			struct Chain
+			{
+				std::size_t item = 0;  // index of the password
+				ResultArrayType u {};
+				ResultArrayType t {};
+			};
+
+			static void iterate(const Span<const Span<const Byte>> passwords, std::vector<Chain> &chains, const uint32_t rounds, std::false_type);
+			static void iterate(const Span<const Span<const Byte>> passwords, std::vector<Chain> &chains, const uint32_t rounds, std::true_type);
+	};
+
+
+	//
+	template <typename H>
+	void PBKDF2<H>::derive(const Span<const Byte> password, const Span<const Byte> salt, const uint32_t iterations, const Span<Byte> output)
+	{
+		deriveMany({&password, 1}, salt, iterations, {&output, 1});
+	}
+
+	template <typename H>
+	void PBKDF2<H>::deriveMany(const Span<const Span<const Byte>> passwords, const Span<const Byte> salt, const uint32_t iterations, const Span<const Span<Byte>> outputs)
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+
+		if (passwords.size() != outputs.size())
+			throw std::invalid_argument("PBKDF2: passwords & outputs must have the same size");
+		if (iterations < 1)
+			throw std::invalid_argument("PBKDF2: iterations must be at least 1");
+
+		const std::size_t digestSize = std::tuple_size<ResultArrayType>::value;
+		for (const Span<Byte> output : outputs)
+		{
+			// the block index is 32 bits wide
+			if (((static_cast<std::size_t>(output.size()) + digestSize - 1) / digestSize) > 0xFFFFFFFF)
+				throw std::invalid_argument("PBKDF2: output must be at most 2^32 - 1 digests long");
+		}
+
+		// one chain per output block, U_1 goes through `HMAC<H>` as the salt has arbitrary length
+		std::vector<Chain> chains;
+		for (std::size_t item = 0, iend = static_cast<std::size_t>(passwords.size()); item < iend; ++item)
+		{
+			HMAC<H> prf(passwords[item]);
+
+			const std::size_t blocks = (static_cast<std::size_t>(outputs[item].size()) + digestSize - 1) / digestSize;
+			for (std::size_t block = 1; block <= blocks; ++block)
+			{
+				const Byte index[4] = {static_cast<Byte>(block >> 24), static_cast<Byte>(block >> 16), static_cast<Byte>(block >> 8), static_cast<Byte>(block)};
+
+				Chain chain;
+				chain.item = item;
+				chain.u = prf.addData(salt).addData(index).finalize().toArray();
+				chain.t = chain.u;
+				chains.emplace_back(chain);
+				prf.reset();
+			}
+		}
+
+		if (iterations > 1)
+			iterate(passwords, chains, (iterations - 1), std::integral_constant<bool, Midstate<H>::RAW> {});
+
+		std::size_t chainIdx = 0;
+		for (const Span<Byte> output : outputs)
+		{
+			for (std::size_t offset = 0, oend = static_cast<std::size_t>(output.size()); offset < oend; offset += digestSize)
+			{
+				const ResultArrayType &t = chains[chainIdx++].t;
+				const std::size_t len = std::min(digestSize, (oend - offset));
+				std::copy(t.begin(), (t.begin() + len), (output.begin() + offset));
+			}
+		}
+	}
+
+	template <typename H>
+	void PBKDF2<H>::iterate(const Span<const Span<const Byte>> passwords, std::vector<Chain> &chains, const uint32_t rounds, std::false_type)
+	{
+		// chains of the same password are adjacent
+		std::size_t begin = 0;
+		while (begin < chains.size())
+		{
+			HMAC<H> prf(passwords[chains[begin].item]);
+
+			std::size_t end = begin;
+			for (; (end < chains.size()) && (chains[end].item == chains[begin].item); ++end)
+			{
+				Chain &chain = chains[end];
+				for (uint32_t r = 0; r < rounds; ++r)
+				{
+					prf.reset();
+					chain.u = prf.addData(Span<const Byte>(chain.u.data(), chain.u.size())).finalize().toArray();
+					for (std::size_t i = 0; i < chain.t.size(); ++i)
+						chain.t[i] ^= chain.u[i];
+				}
+			}
+
+			begin = end;
+		}
+	}
+
+	template <typename H>
+	void PBKDF2<H>::iterate(const Span<const Span<const Byte>> passwords, std::vector<Chain> &chains, const uint32_t rounds, std::true_type)
+	{
+		using Kernel = Midstate<H>;
+		using State = typename Kernel::State;
+		using PadBlock = std::array<Byte, H::BLOCK_SIZE>;
+
+		const std::size_t count = chains.size();
+		std::vector<State> inner(count);
+		std::vector<State> outer(count);
+		std::vector<State> u(count);
+		std::vector<State> t(count);
+
+		std::size_t begin = 0;
+		while (begin < count)
+		{
+			// same key processing as `HMAC<H>`
+			const Span<const Byte> password = passwords[chains[begin].item];
+			PadBlock key {};
+			if (password.size() > key.size())
+			{
+				const ResultArrayType digest = H().addData(password).finalize().toArray();
+				std::copy(digest.begin(), digest.end(), key.begin());
+			}
+			else
+			{
+				std::copy(password.begin(), password.end(), key.begin());
+			}
+
+			PadBlock innerPad {};
+			PadBlock outerPad {};
+			for (std::size_t i = 0; i < key.size(); ++i)
+			{
+				innerPad[i] = static_cast<Byte>(key[i] ^ 0x36);
+				outerPad[i] = static_cast<Byte>(key[i] ^ 0x5c);
+			}
+			const State innerState = Kernel::padState(innerPad.data());
+			const State outerState = Kernel::padState(outerPad.data());
+
+			std::size_t end = begin;
+			for (; (end < count) && (chains[end].item == chains[begin].item); ++end)
+			{
+				inner[end] = innerState;
+				outer[end] = outerState;
+				u[end] = Kernel::load(chains[end].u);
+				t[end] = Kernel::load(chains[end].t);
+			}
+
+			begin = end;
+		}
+
+		Kernel::iterate(inner.data(), outer.data(), u.data(), t.data(), count, rounds);
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			chains[i].u = Kernel::template store<ResultArrayType>(u[i]);
+			chains[i].t = Kernel::template store<ResultArrayType>(t[i]);
+		}
+	}
+}
+}
+	template <typename H>
+	using PBKDF2 = Hash::PBKDF2_NS::PBKDF2<H>;
+}
+
+#endif  // CHOCOBO1_PBKDF2_H
@@ -9,18 +9,26 @@
  *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
  */
 
+#include "../adler32.h"
 #include "../blake1_224.h"
 #include "../blake1_256.h"
 #include "../blake1_384.h"
 #include "../blake1_512.h"
 #include "../blake2.h"
+#include "../blake2bp.h"
 #include "../blake2s.h"
+#include "../blake2sp.h"
+#include "../blake2x.h"
+#include "../blake3.h"
 #include "../cshake.h"
+#include "../crc.h"
 #include "../crc_32.h"
 #include "../has_160.h"
+#include "../kangaroo_twelve.h"
 #include "../md2.h"
 #include "../md4.h"
 #include "../md5.h"
+#include "../parallel_hash.h"
 #include "../ripemd_128.h"
 #include "../ripemd_160.h"
 #include "../ripemd_256.h"
@@ -37,27 +45,41 @@
 #include "../tiger.h"
 #include "../tuple_hash.h"
 #include "../whirlpool.h"
+#include "../xxh3.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <sys/stat.h>
+
 
 #define ARRAY_LENGTH(a) (static_cast<int>(std::extent<decltype(a)>::value))
 
 
 enum class Hash : int
 {
+	Adler32,
 	Blake1_224, Blake1_256, Blake1_384, Blake1_512,
-	Blake2, Blake2s,
-	Crc_32,
+	Blake2, Blake2bp, Blake2s, Blake2sp,
+	Blake2xb, Blake2xs,
+	Blake3,
+	Crc_32, Crc_32c,
+	Crc_64_nvme, Crc_64_xz,
 	Cshake_128, Cshake_256,
 	Has160,
+	K12,
 	Md2, Md4, Md5,
+	Parallel_hash_128, Parallel_hash_256,
 	Ripemd_128, Ripemd_160, Ripemd_256, Ripemd_320,
 	Sha1,
 	Sha2_224, Sha2_256, Sha2_384, Sha2_512,
@@ -68,14 +90,31 @@ enum class Hash : int
 	Tiger1_128, Tiger1_160, Tiger1_192,
 	Tiger2_128, Tiger2_160, Tiger2_192,
 	Tuple_hash_128, Tuple_hash_256,
+	Turboshake_128, Turboshake_256,
 	Whirlpool,
+	Xxh3, Xxh3_128,
 	Invalid,
 };
 
 
 static void printUsage(const std::string &name);
 static Hash getHash(const std::string &hash);
-static bool runHash(const Hash hash, const int argc, const char *argv[]);
+static bool parseSize(const std::string &str, uint64_t &size);
+static bool runHash(const Hash hash, const int argc, const char *argv[], const bool checkpoint, const uint64_t checkpointEvery);
+template <typename T>
+static void addDataNPrint(T &hash, std::istream &inStream, const std::string &filename, uint64_t &offset, uint64_t checkpointEvery);
+template <typename T>
+static auto peekString(const T &hash, int) -> decltype(hash.peekDigest(), std::string());
+template <typename T>
+static auto peekString(const T &hash, long) -> decltype(T(hash), std::string());
+template <typename T>
+static std::string peekString(const T &hash, ...);
+static uint64_t fileId(const std::string &filename);
+static Chocobo1::SHA2_256::ResultArrayType tailDigest(std::istream &inStream, const uint64_t offset);
+template <typename T>
+static auto resumeNPrint(T &hash, const std::string &filename, const std::string &checkpointName, const uint64_t checkpointEvery, int) -> decltype(hash.serialize(), bool());
+template <typename T>
+static bool resumeNPrint(T &hash, const std::string &filename, const std::string &checkpointName, const uint64_t checkpointEvery, long);
 
 
 int main(const int argc, const char *argv[])
@@ -93,7 +132,30 @@ int main(const int argc, const char *argv[])
 
 	const Hash hash = getHash(argv[1]);
 
-	const bool ret = runHash(hash, argc, argv);
+	// `--checkpoint` & `--checkpoint-every` may follow the hash name, the hash arguments are parsed without them
+	std::vector<const char *> args(argv, (argv + argc));
+	bool checkpoint = false;
+	uint64_t checkpointEvery = 0;
+	while (args.size() > 2)
+	{
+		const std::string option = args[2];
+		if (option == "--checkpoint")
+		{
+			checkpoint = true;
+			args.erase(args.begin() + 2);
+		}
+		else if (option == "--checkpoint-every")
+		{
+			goToFail((args.size() <= 3) || !parseSize(args[3], checkpointEvery));
+			args.erase((args.begin() + 2), (args.begin() + 4));
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	const bool ret = runHash(hash, static_cast<int>(args.size()), args.data(), checkpoint, checkpointEvery);
 	goToFail(!ret);
 
 	return 0;
@@ -101,18 +163,27 @@ int main(const int argc, const char *argv[])
 
 void printUsage(const std::string &name)
 {
-	printf("Usage: %s <HASH> <FILE | - (stdin)>\n", name.c_str());
+	printf("Usage: %s <HASH> [--checkpoint] [--checkpoint-every <SIZE>] <FILE | - (stdin)>\n", name.c_str());
 	printf("  https://github.com/Chocobo1/Hash \n");
 	printf(
 		"\n"
 		"Available HASH:\n"
+		"  -adler32\n"
 		"  -blake1-224"		"\t -blake1-256"	"\t -blake1-384"	"\t -blake1-512\n"
-		"  -blake2"			"\t -blake2s\n"
-		"  -crc-32\n"
+		"  -blake2"			"\t -blake2bp"		"\t -blake2s"		"\t -blake2sp\n"
+		"      -blake2, -blake2s: [--length <Digest length (bits)>] [--key <Key (hex)>]\n"
+		"  -blake2xb <Digest length (bytes)>\n"
+		"  -blake2xs <Digest length (bytes)>\n"
+		"  -blake3\n"
+		"  -crc-32"			"\t -crc-32c"			"\t -crc-64-nvme"	"\t -crc-64-xz\n"
+		"      [--threads <Thread count, 0 for all cores>], not with --checkpoint or --checkpoint-every\n"
 		"  -cshake-128 <Digest length (bytes)> <Customization string>\n"
 		"  -cshake-256 <Digest length (bytes)> <Customization string>\n"
 		"  -has160\n"
+		"  -k12 <Digest length (bytes)> <Customization string>\n"
 		"  -md2"			"\t\t -md4"			"\t\t -md5\n"
+		"  -parallel-hash-128 <Digest length (bytes)> <Block size (bytes)> <Customization string>\n"
+		"  -parallel-hash-256 <Digest length (bytes)> <Block size (bytes)> <Customization string>\n"
 		"  -ripemd-128"		"\t -ripemd-160"	"\t -ripemd-256"	"\t -ripemd-320\n"
 		"  -sha1\n"
 		"  -sha2-224"		"\t -sha2-256"		"\t -sha2-384"		"\t -sha2-512"		"\t -sha2-512-224"	"\t -sha2-512-256\n"
@@ -124,19 +195,66 @@ void printUsage(const std::string &name)
 		"  -tiger2-128"		"\t -tiger2-160"	"\t -tiger2-192\n"
 		"  -tuple-hash-128 <Digest length (bytes)> <Customization string>\n"
 		"  -tuple-hash-256 <Digest length (bytes)> <Customization string>\n"
+		"  -turboshake-128 <Digest length (bytes)>\n"
+		"  -turboshake-256 <Digest length (bytes)>\n"
 		"  -whirlpool\n"
+		"  -xxh3\n"
+		"  -xxh3-128\n"
+		"\n"
+		"--checkpoint:\n"
+		"  Keep the hash state in <FILE>.<HASH>.checkpoint, the next run only hashes the data appended since.\n"
+		"  Meant for append-only files, a file that shrunk, was replaced or changed in the last 64 KiB before the saved point\n"
+		"  is hashed from the start. Changes further back aren't detected.\n"
+		"\n"
+		"--checkpoint-every:\n"
+		"  Also print the digest of the first N bytes every <SIZE> bytes (suffixes: K, M, G), then carry on hashing.\n"
 	);
 }
 
+bool parseSize(const std::string &str, uint64_t &size)
+{
+	if (str.find_first_not_of("0123456789") == 0)  // `std::stoull()` also takes signs & spaces
+		return false;
+
+	std::size_t end = 0;
+	unsigned long long value = 0;
+	try
+	{
+		value = std::stoull(str, &end);
+	}
+	catch (const std::exception &)
+	{
+		return false;
+	}
+
+	const std::string suffix = str.substr(end);
+	const int shift = (suffix == "") ? 0
+		: ((suffix == "K") || (suffix == "k")) ? 10
+		: ((suffix == "M") || (suffix == "m")) ? 20
+		: ((suffix == "G") || (suffix == "g")) ? 30
+		: -1;
+	if ((shift < 0) || (value == 0) || (value > (UINT64_MAX >> shift)))
+		return false;
+
+	size = static_cast<uint64_t>(value) << shift;
+	return true;
+}
+
 Hash getHash(const std::string &hash)
 {
 	static const std::string names[] = {
+		"-adler32",
 		"-blake1-224", "-blake1-256", "-blake1-384", "-blake1-512",
-		"-blake2", "-blake2s",
-		"-crc-32",
+		"-blake2", "-blake2bp", "-blake2s", "-blake2sp",
+		"-blake2xb", "-blake2xs",
+		"-blake3",
+		"-crc-32", "-crc-32c",
+		"-crc-64-nvme", "-crc-64-xz",
 		"-cshake-128", "-cshake-256",
 		"-has160",
+		"-k12",
 		"-md2", "-md4", "-md5",
+		"-parallel-hash-128", "-parallel-hash-256",
 		"-ripemd-128", "-ripemd-160", "-ripemd-256", "-ripemd-320",
 		"-sha1",
 		"-sha2-224", "-sha2-256", "-sha2-384", "-sha2-512",
@@ -147,7 +265,9 @@ Hash getHash(const std::string &hash)
 		"-tiger1-128", "-tiger1-160", "-tiger1-192",
 		"-tiger2-128", "-tiger2-160", "-tiger2-192",
 		"-tuple-hash-128", "-tuple-hash-256",
-		"-whirlpool"
+		"-turboshake-128", "-turboshake-256",
+		"-whirlpool",
+		"-xxh3", "-xxh3-128"
 	};
 
 	for (int i = 0; i < ARRAY_LENGTH(names); ++i)
@@ -158,23 +278,21 @@ Hash getHash(const std::string &hash)
 	return Hash::Invalid;
 }
 
-bool runHash(const Hash hash, const int argc, const char *argv[])
+bool runHash(const Hash hash, const int argc, const char *argv[], const bool checkpoint, const uint64_t checkpointEvery)
 {
-	const auto readNPrint = [](auto hash, const std::string &filename) -> void
+	const auto readNPrint = [&argv, checkpoint, checkpointEvery](auto hash, const std::string &filename) -> void
 	{
+		if (checkpoint && resumeNPrint(hash, filename, (filename + "." + (argv[1] + 1) + ".checkpoint"), checkpointEvery, 0))
+			return;
+
 		std::unique_ptr<std::istream, void (*)(std::istream *)> inStream {nullptr, [](auto) {}};
 		if (filename == "-")
 			inStream = {&std::cin, [](auto) {}};
 		else
 			inStream = {new std::ifstream(filename, (std::ios_base::in | std::ios_base::binary)), [](std::istream *p) {delete p;}};
 
-		const int bufSize = 1024 * 1024;
-		auto buf = std::make_unique<char[]>(bufSize);
-		while (inStream->good())
-		{
-			inStream->read(buf.get(), bufSize);
-			hash.addData(buf.get(), inStream->gcount());
-		}
+		uint64_t offset = 0;
+		addDataNPrint(hash, *inStream, filename, offset, checkpointEvery);
 
 		printf("%s  %s\n", hash.finalize().toString().c_str(), filename.c_str());
 	};
@@ -201,9 +319,195 @@ bool runHash(const Hash hash, const int argc, const char *argv[])
 		printf("%s  %s\n", hash.nextData(buf.data(), buf.size()).finalize().toString().c_str(), filename.c_str());
 	};
 
+	const auto readNPrintCrc = [](auto hash, const std::size_t threads, const std::string &filename) -> bool
+	{
+		// each thread reads its own part of the file, the partial CRCs are combined at the end
+		// more threads than cores only add overhead
+		const std::size_t cores = std::max(1U, std::thread::hardware_concurrency());
+		const std::size_t threadCount = ((threads == 0) || (threads > cores)) ? cores : threads;
+
+		std::ifstream file;
+		if (filename != "-")
+			file.open(filename, (std::ios_base::in | std::ios_base::binary | std::ios_base::ate));
+
+		const std::streamoff fileSize = file.is_open() ? static_cast<std::streamoff>(file.tellg()) : -1;
+		if (fileSize < 0)
+		{
+			// not seekable, split each buffer instead
+			std::istream &inStream = (filename == "-") ? std::cin : static_cast<std::istream &>(file);
+
+			const std::size_t bufSize = threadCount * 1024 * 1024;
+			auto buf = std::make_unique<char[]>(bufSize);
+			while (inStream.good())
+			{
+				inStream.read(buf.get(), static_cast<std::streamsize>(bufSize));
+				hash.addDataParallel(buf.get(), static_cast<std::size_t>(inStream.gcount()), threadCount);
+			}
+
+			printf("%s  %s\n", hash.finalize().toString().c_str(), filename.c_str());
+			return true;
+		}
+		file.close();
+
+		const uint64_t size = static_cast<uint64_t>(fileSize);
+		const uint64_t partSize = (size + threadCount - 1) / threadCount;
+
+		std::vector<decltype(hash)> partials(threadCount);
+		// one flag per worker, `std::vector<bool>` packs them into shared words
+		std::vector<char> failed(threadCount, 0);
+		std::vector<std::thread> workers;
+		for (std::size_t i = 0; i < threadCount; ++i)
+		{
+			workers.emplace_back([&partials, &failed, &filename, i, partSize, size]()
+			{
+				const uint64_t begin = std::min(size, (i * partSize));
+				uint64_t remaining = std::min(size, (begin + partSize)) - begin;
+
+				std::ifstream part(filename, (std::ios_base::in | std::ios_base::binary));
+				if (!part.is_open() || !part.seekg(static_cast<std::streamoff>(begin)))
+				{
+					failed[i] = 1;
+					return;
+				}
+
+				const std::size_t bufSize = 1024 * 1024;
+				auto buf = std::make_unique<char[]>(bufSize);
+				while ((remaining > 0) && part.good())
+				{
+					part.read(buf.get(), static_cast<std::streamsize>(std::min<uint64_t>(bufSize, remaining)));
+					partials[i].addData(buf.get(), static_cast<std::size_t>(part.gcount()));
+					remaining -= static_cast<uint64_t>(part.gcount());
+				}
+				// the file got shorter or a read failed, the partial CRC doesn't cover its part
+				if (remaining > 0)
+					failed[i] = 1;
+			});
+		}
+		for (auto &worker : workers)
+			worker.join();
+
+		if (std::find(failed.begin(), failed.end(), 1) != failed.end())
+			return false;
+
+		hash = partials[0];
+		for (std::size_t i = 1; i < threadCount; ++i)
+		{
+			const uint64_t begin = std::min(size, (i * partSize));
+			hash.combine(partials[i], (std::min(size, (begin + partSize)) - begin));
+		}
+
+		printf("%s  %s\n", hash.finalize().toString().c_str(), filename.c_str());
+		return true;
+	};
+
+	const auto runCrc = [&](auto hash) -> bool
+	{
+		if (argc == 3)
+		{
+			readNPrint(hash, argv[2]);
+			return true;
+		}
+
+		if ((argc != 5) || (std::string(argv[2]) != "--threads"))
+			return false;
+		if (checkpoint || (checkpointEvery != 0))
+		{
+			fprintf(stderr, "--threads can't be combined with --checkpoint or --checkpoint-every\n");
+			return false;
+		}
+
+		int threads = 0;
+		try
+		{
+			threads = std::stoi(argv[3]);
+		}
+		catch (const std::invalid_argument &)
+		{
+			return false;
+		}
+		catch (const std::out_of_range &)
+		{
+			return false;
+		}
+		if (threads < 0)
+			return false;
+
+		if (!readNPrintCrc(hash, static_cast<std::size_t>(threads), argv[4]))
+		{
+			fprintf(stderr, "Failed to read file: %s\n", argv[4]);
+			exit(1);
+		}
+		return true;
+	};
+
+	const auto runBlake2 = [&](auto hash) -> bool
+	{
+		// b2sum style options, followed by the file name
+		using Blake2Type = decltype(hash);
+
+		if ((argc % 2) == 0)
+			return false;
+
+		typename Blake2Type::Parameters params;
+		std::vector<uint8_t> key;
+		for (int i = 2; i < (argc - 1); i += 2)
+		{
+			const std::string option = argv[i];
+			const std::string value = argv[i + 1];
+
+			if (option == "--length")
+			{
+				int bits = 0;
+				try
+				{
+					bits = std::stoi(value);
+				}
+				catch (const std::invalid_argument &)
+				{
+					return false;
+				}
+				catch (const std::out_of_range &)
+				{
+					return false;
+				}
+				if ((bits <= 0) || ((bits % 8) != 0) || ((bits / 8) > params.digestLength))
+					return false;
+
+				params.digestLength = static_cast<uint8_t>(bits / 8);
+			}
+			else if (option == "--key")
+			{
+				const int maxKeySize = Blake2Type::MAX_KEY_SIZE;
+				if (((value.size() % 2) != 0) || ((value.size() / 2) > static_cast<std::size_t>(maxKeySize))
+					|| (value.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos))
+					return false;
+
+				key.clear();
+				for (std::size_t j = 0; j < value.size(); j += 2)
+					key.push_back(static_cast<uint8_t>(std::stoi(value.substr(j, 2), nullptr, 16)));
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		readNPrint(Blake2Type(key, params), argv[argc - 1]);
+		return true;
+	};
+
 	// when benchmarking, comment out unrelated hash as it bloats the binary
 	switch (hash)
 	{
+		case Hash::Adler32:
+		{
+			if (argc != 3)
+				return false;
+
+			readNPrint(Chocobo1::Adler32(), argv[2]);
+			return true;
+		}
+
 		case Hash::Blake1_224:
 		{
 			if (argc != 3)
@@ -241,32 +545,112 @@ bool runHash(const Hash hash, const int argc, const char *argv[])
 		}
 
 		case Hash::Blake2:
+		{
+			return runBlake2(Chocobo1::Blake2());
+		}
+
+		case Hash::Blake2bp:
 		{
 			if (argc != 3)
 				return false;
 
-			readNPrint(Chocobo1::Blake2(), argv[2]);
+			readNPrint(Chocobo1::Blake2bp(), argv[2]);
 			return true;
 		}
 
 		case Hash::Blake2s:
+		{
+			return runBlake2(Chocobo1::Blake2s());
+		}
+
+		case Hash::Blake2sp:
 		{
 			if (argc != 3)
 				return false;
 
-			readNPrint(Chocobo1::Blake2s(), argv[2]);
+			readNPrint(Chocobo1::Blake2sp(), argv[2]);
 			return true;
 		}
 
-		case Hash::Crc_32:
+		case Hash::Blake2xb:
+		{
+			if (argc != 4)
+				return false;
+
+			int digestLength = 0;
+			try
+			{
+				digestLength = std::stoi(argv[2]);
+			}
+			catch (const std::invalid_argument &e)
+			{
+				return false;
+			}
+			catch (const std::out_of_range &e)
+			{
+				return false;
+			}
+			if ((digestLength < 1) || (digestLength > Chocobo1::Blake2Xb::MAX_DIGEST_LENGTH))
+				return false;
+
+			readNPrint(Chocobo1::Blake2Xb(digestLength), argv[3]);
+			return true;
+		}
+
+		case Hash::Blake2xs:
+		{
+			if (argc != 4)
+				return false;
+
+			int digestLength = 0;
+			try
+			{
+				digestLength = std::stoi(argv[2]);
+			}
+			catch (const std::invalid_argument &e)
+			{
+				return false;
+			}
+			catch (const std::out_of_range &e)
+			{
+				return false;
+			}
+			if ((digestLength < 1) || (digestLength > Chocobo1::Blake2Xs::MAX_DIGEST_LENGTH))
+				return false;
+
+			readNPrint(Chocobo1::Blake2Xs(digestLength), argv[3]);
+			return true;
+		}
+
+		case Hash::Blake3:
 		{
 			if (argc != 3)
 				return false;
 
-			readNPrint(Chocobo1::CRC_32(), argv[2]);
+			readNPrint(Chocobo1::Blake3(), argv[2]);
 			return true;
 		}
 
+		case Hash::Crc_32:
+		{
+			return runCrc(Chocobo1::CRC_32());
+		}
+
+		case Hash::Crc_32c:
+		{
+			return runCrc(Chocobo1::CRC_32C());
+		}
+
+		case Hash::Crc_64_nvme:
+		{
+			return runCrc(Chocobo1::CRC_64_NVME());
+		}
+
+		case Hash::Crc_64_xz:
+		{
+			return runCrc(Chocobo1::CRC_64_XZ());
+		}
+
 		case Hash::Cshake_128:
 		{
 			if (argc != 5)
@@ -314,6 +698,25 @@ bool runHash(const Hash hash, const int argc, const char *argv[])
 			return true;
 		}
 
+		case Hash::K12:
+		{
+			if (argc != 5)
+				return false;
+
+			int digestLength = 0;
+			try
+			{
+				digestLength = std::stoi(argv[2]);
+			}
+			catch (const std::invalid_argument &e)
+			{
+				return false;
+			}
+
+			readNPrint(Chocobo1::KangarooTwelve(digestLength, argv[3]), argv[4]);
+			return true;
+		}
+
 		case Hash::Md2:
 		{
 			if (argc != 3)
@@ -341,6 +744,60 @@ bool runHash(const Hash hash, const int argc, const char *argv[])
 			return true;
 		}
 
+		case Hash::Parallel_hash_128:
+		{
+			if (argc != 6)
+				return false;
+
+			int digestLength = 0;
+			int blockSize = 0;
+			try
+			{
+				digestLength = std::stoi(argv[2]);
+				blockSize = std::stoi(argv[3]);
+			}
+			catch (const std::invalid_argument &e)
+			{
+				return false;
+			}
+			catch (const std::out_of_range &e)
+			{
+				return false;
+			}
+			if (blockSize <= 0)
+				return false;
+
+			readNPrint(Chocobo1::ParallelHash_128(digestLength, blockSize, argv[4]), argv[5]);
+			return true;
+		}
+
+		case Hash::Parallel_hash_256:
+		{
+			if (argc != 6)
+				return false;
+
+			int digestLength = 0;
+			int blockSize = 0;
+			try
+			{
+				digestLength = std::stoi(argv[2]);
+				blockSize = std::stoi(argv[3]);
+			}
+			catch (const std::invalid_argument &e)
+			{
+				return false;
+			}
+			catch (const std::out_of_range &e)
+			{
+				return false;
+			}
+			if (blockSize <= 0)
+				return false;
+
+			readNPrint(Chocobo1::ParallelHash_256(digestLength, blockSize, argv[4]), argv[5]);
+			return true;
+		}
+
 		case Hash::Ripemd_128:
 		{
 			if (argc != 3)
@@ -615,6 +1072,44 @@ bool runHash(const Hash hash, const int argc, const char *argv[])
 			return true;
 		}
 
+		case Hash::Turboshake_128:
+		{
+			if (argc != 4)
+				return false;
+
+			int digestLength = 0;
+			try
+			{
+				digestLength = std::stoi(argv[2]);
+			}
+			catch (const std::invalid_argument &e)
+			{
+				return false;
+			}
+
+			readNPrint(Chocobo1::TurboSHAKE_128(digestLength), argv[3]);
+			return true;
+		}
+
+		case Hash::Turboshake_256:
+		{
+			if (argc != 4)
+				return false;
+
+			int digestLength = 0;
+			try
+			{
+				digestLength = std::stoi(argv[2]);
+			}
+			catch (const std::invalid_argument &e)
+			{
+				return false;
+			}
+
+			readNPrint(Chocobo1::TurboSHAKE_256(digestLength), argv[3]);
+			return true;
+		}
+
 		case Hash::Whirlpool:
 		{
 			if (argc != 3)
@@ -624,6 +1119,24 @@ bool runHash(const Hash hash, const int argc, const char *argv[])
 			return true;
 		}
 
+		case Hash::Xxh3:
+		{
+			if (argc != 3)
+				return false;
+
+			readNPrint(Chocobo1::XXH3_64(), argv[2]);
+			return true;
+		}
+
+		case Hash::Xxh3_128:
+		{
+			if (argc != 3)
+				return false;
+
+			readNPrint(Chocobo1::XXH3_128(), argv[2]);
+			return true;
+		}
+
 		default:
 		case Hash::Invalid:
 			return false;
@@ -631,3 +1144,183 @@ bool runHash(const Hash hash, const int argc, const char *argv[])
 
 	return false;
 }
+
+template <typename T>
+void addDataNPrint(T &hash, std::istream &inStream, const std::string &filename, uint64_t &offset, uint64_t checkpointEvery)
+{
+	// `offset` counts from the start of the file, the running digests land on multiples of `checkpointEvery`
+	const int bufSize = 1024 * 1024;
+	auto buf = std::make_unique<char[]>(bufSize);
+	while (inStream.good())
+	{
+		inStream.read(buf.get(), bufSize);
+		const char *data = buf.get();
+		uint64_t remaining = static_cast<uint64_t>(inStream.gcount());
+		while (remaining > 0)
+		{
+			const uint64_t len = (checkpointEvery == 0) ? remaining
+				: std::min(remaining, (checkpointEvery - (offset % checkpointEvery)));
+			hash.addData(data, static_cast<std::size_t>(len));
+			data += len;
+			remaining -= len;
+			offset += len;
+
+			if ((checkpointEvery == 0) || ((offset % checkpointEvery) != 0))
+				continue;
+
+			const std::string digest = peekString(hash, 0);
+			if (digest.empty())
+			{
+				fprintf(stderr, "Running digests aren't supported by this hash\n");
+				checkpointEvery = 0;
+				continue;
+			}
+			printf("%s  %s (%llu bytes)\n", digest.c_str(), filename.c_str(), static_cast<unsigned long long>(offset));
+		}
+	}
+}
+
+template <typename T>
+auto peekString(const T &hash, int) -> decltype(hash.peekDigest(), std::string())
+{
+	std::string ret;
+	for (const uint8_t c : hash.peekDigest())
+	{
+		const char digits[] = "0123456789abcdef";
+		ret += digits[c >> 4];
+		ret += digits[c & 0xf];
+	}
+	return ret;
+}
+
+template <typename T>
+auto peekString(const T &hash, long) -> decltype(T(hash), std::string())
+{
+	// no cheap peek, finalize a full copy instead
+	T copy = hash;
+	return copy.finalize().toString();
+}
+
+template <typename T>
+std::string peekString(const T &, ...)
+{
+	return {};
+}
+
+uint64_t fileId(const std::string &filename)
+{
+	// the inode number, tells whether the file was replaced (e.g. rotated logs), 0 where there is none
+	struct stat info {};
+	if (stat(filename.c_str(), &info) != 0)
+		return 0;
+	return static_cast<uint64_t>(info.st_ino);
+}
+
+Chocobo1::SHA2_256::ResultArrayType tailDigest(std::istream &inStream, const uint64_t offset)
+{
+	// digest of the last 64 KiB before `offset`, tells whether the end of the hashed part was rewritten
+	// an append-only file is assumed, earlier changes would need hashing it all again
+	const uint64_t tailSize = std::min<uint64_t>(offset, (64 * 1024));
+	std::vector<char> tail(static_cast<std::size_t>(tailSize));
+
+	inStream.clear();
+	inStream.seekg(static_cast<std::streamoff>(offset - tailSize));
+	inStream.read(tail.data(), static_cast<std::streamsize>(tail.size()));
+	if (static_cast<uint64_t>(inStream.gcount()) != tailSize)
+		return {};
+	return Chocobo1::SHA2_256().addData(tail.data(), tail.size()).finalize().toArray();
+}
+
+template <typename T>
+auto resumeNPrint(T &hash, const std::string &filename, const std::string &checkpointName, const uint64_t checkpointEvery, int) -> decltype(hash.serialize(), bool())
+{
+	// checkpoint layout: the file offset hashed so far & `fileId()` (8 bytes each, little-endian),
+	// `tailDigest()` at that offset (32 bytes), then `hash.serialize()`
+	if (filename == "-")
+	{
+		fprintf(stderr, "Checkpoints need a regular file, hashing stdin from the start\n");
+		return false;
+	}
+	if (hash.serialize().empty())
+	{
+		// e.g. keyed hashes, their state isn't written out
+		fprintf(stderr, "Checkpoints aren't supported with these hash arguments, hashing from the start\n");
+		return false;
+	}
+
+	std::ifstream file(filename, (std::ios_base::in | std::ios_base::binary | std::ios_base::ate));
+	if (!file.is_open())
+		return false;
+	const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+
+	uint64_t offset = 0;
+	{
+		std::ifstream in(checkpointName, (std::ios_base::in | std::ios_base::binary));
+		const std::vector<uint8_t> saved {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+		const std::size_t headerSize = 16 + Chocobo1::SHA2_256::ResultArrayType().size();
+		if (saved.size() > headerSize)
+		{
+			uint64_t savedOffset = 0;
+			uint64_t savedId = 0;
+			for (int i = 0; i < 8; ++i)
+			{
+				savedOffset |= (static_cast<uint64_t>(saved[i]) << (8 * i));
+				savedId |= (static_cast<uint64_t>(saved[8 + i]) << (8 * i));
+			}
+
+			// a file that shrunk, was replaced or changed just before `savedOffset` is hashed from the start
+			// `restore()` leaves the state untouched on failure, start over in that case too
+			if ((savedOffset <= fileSize) && (savedId == fileId(filename))
+				&& std::equal((saved.begin() + 16), (saved.begin() + headerSize), tailDigest(file, savedOffset).begin())
+				&& hash.restore({(saved.data() + headerSize), (saved.size() - headerSize)}))
+			{
+				offset = savedOffset;
+			}
+		}
+	}
+
+	file.clear();
+	file.seekg(static_cast<std::streamoff>(offset));
+	addDataNPrint(hash, file, filename, offset, checkpointEvery);
+
+	// written aside & renamed, an interrupted run keeps the previous checkpoint
+	const uint64_t id = fileId(filename);
+	std::vector<uint8_t> saved(16);
+	for (int i = 0; i < 8; ++i)
+	{
+		saved[i] = static_cast<uint8_t>(offset >> (8 * i));
+		saved[8 + i] = static_cast<uint8_t>(id >> (8 * i));
+	}
+	const auto tail = tailDigest(file, offset);
+	saved.insert(saved.end(), tail.begin(), tail.end());
+	const std::vector<uint8_t> snapshot = hash.serialize();
+	saved.insert(saved.end(), snapshot.begin(), snapshot.end());
+
+	const std::string tempName = checkpointName + ".tmp";
+	std::ofstream out(tempName, (std::ios_base::out | std::ios_base::binary | std::ios_base::trunc));
+	out.write(reinterpret_cast<const char *>(saved.data()), static_cast<std::streamsize>(saved.size()));
+	out.close();
+	if (!out)
+	{
+		// keep the previous checkpoint rather than a truncated one
+		std::remove(tempName.c_str());
+		fprintf(stderr, "Failed to write checkpoint: %s\n", checkpointName.c_str());
+	}
+	else if (std::rename(tempName.c_str(), checkpointName.c_str()) != 0)
+	{
+		// some platforms refuse to overwrite
+		std::remove(checkpointName.c_str());
+		if (std::rename(tempName.c_str(), checkpointName.c_str()) != 0)
+			fprintf(stderr, "Failed to write checkpoint: %s\n", checkpointName.c_str());
+	}
+
+	printf("%s  %s\n", hash.finalize().toString().c_str(), filename.c_str());
+	return true;
+}
+
+template <typename T>
+bool resumeNPrint(T &, const std::string &, const std::string &, const uint64_t, long)
+{
+	fprintf(stderr, "Checkpoints aren't supported by this hash, hashing from the start\n");
+	return false;
+}
@@ -12,12 +12,16 @@
 #ifndef CHOCOBO1_RIPEMD_128_H
 #define CHOCOBO1_RIPEMD_128_H
 
+#include "state_serializer.h"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <climits>
 #include <cmath>
 #include <cstdint>
 #include <initializer_list>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -45,6 +49,11 @@ namespace Chocobo1
 {
 	// Use these!!
 	// RIPEMD_128();
+	//   `peekDigest()` returns the digest of the data so far without finalizing, more data can follow
+	//   `exportState()` & `importState(State)` copy the raw running state, e.g. hash a shared prefix once & fork it per suffix
+	//   `importState()` throws `std::invalid_argument` unless `State::length` is whole blocks & `State::bufferSize` is less than a block
+	//   `compressBlocks(blocks)` feeds whole 64-byte blocks directly: `blocks.size()` must be a multiple of 64 (block-aligned) & no bytes may be pending from `addData()`, otherwise it throws `std::invalid_argument`
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, `restore()` returns false on a malformed snapshot
 }
 
 
@@ -58,7 +67,7 @@ namespace Hash
 #if __cplusplus >= 201703L
 #define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
 #else
-#define CONSTEXPR_CPP17_CHOCOBO1_HASH
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
 #endif
 #endif
 
@@ -175,6 +184,8 @@ namespace RIPEMD_128_NS
 			using Byte = uint8_t;
 			using ResultArrayType = std::array<Byte, 16>;
 
+			static constexpr int BLOCK_SIZE = 64;
+
 #if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
 			template <typename T, std::size_t Extent = std::dynamic_extent>
 			using Span = std::span<T, Extent>;
@@ -183,6 +194,15 @@ namespace RIPEMD_128_NS
 			using Span = gsl::span<T, Extent>;
 #endif
 
+			struct State
+			{
+				// everything `importState()` needs to resume hashing
+				std::array<uint32_t, 4> h {};  // chaining value
+				uint64_t length = 0;  // bytes compressed into `h`
+				std::array<Byte, BLOCK_SIZE> buffer {};  // pending bytes, less than a block
+				std::size_t bufferSize = 0;
+			};
+
 
 			constexpr RIPEMD_128();
 
@@ -192,6 +212,7 @@ namespace RIPEMD_128_NS
 			std::string toString() const;
 			std::vector<Byte> toVector() const;
 			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
 
 			CONSTEXPR_CPP17_CHOCOBO1_HASH RIPEMD_128& addData(const Span<const Byte> inData);
 			CONSTEXPR_CPP17_CHOCOBO1_HASH RIPEMD_128& addData(const void *ptr, const std::size_t length);
@@ -202,11 +223,18 @@ namespace RIPEMD_128_NS
 			template <typename T>
 			RIPEMD_128& addData(const Span<T> inSpan);
 
+			// raw state access, e.g. hash a shared prefix once & fork it for many suffixes
+			CONSTEXPR_CPP17_CHOCOBO1_HASH State exportState() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH void importState(const State &state);
+			CONSTEXPR_CPP17_CHOCOBO1_HASH RIPEMD_128& compressBlocks(const Span<const Byte> blocks);  // whole blocks only, requires no pending bytes
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
 			CONSTEXPR_CPP17_CHOCOBO1_HASH void addDataImpl(const Span<const Byte> data);
 
-			static constexpr int BLOCK_SIZE = 64;
-
 			Buffer<Byte, (BLOCK_SIZE * 2)> m_buffer;  // x2 for paddings
 			uint64_t m_sizeCounter = 0;
 
@@ -285,7 +313,7 @@ namespace RIPEMD_128_NS
 		m_buffer.fill(1 << 7);
 
 		// append paddings
-		const size_t len = BLOCK_SIZE - ((m_buffer.size() + 8) % BLOCK_SIZE);
+		const size_t len = (BLOCK_SIZE - ((m_buffer.size() + 8) % BLOCK_SIZE)) % BLOCK_SIZE;
 		m_buffer.fill(0, (len + 8));
 
 		// append size in bits
@@ -304,7 +332,7 @@ namespace RIPEMD_128_NS
 		return (*this);
 	}
 
-	std::string RIPEMD_128::toString() const
+	inline std::string RIPEMD_128::toString() const
 	{
 		const auto a = toArray();
 		std::string ret;
@@ -323,7 +351,7 @@ namespace RIPEMD_128_NS
 		return ret;
 	}
 
-	std::vector<RIPEMD_128::Byte> RIPEMD_128::toVector() const
+	inline std::vector<RIPEMD_128::Byte> RIPEMD_128::toVector() const
 	{
 		const auto a = toArray();
 		return {a.begin(), a.end()};
@@ -345,6 +373,12 @@ namespace RIPEMD_128_NS
 		return ret;
 	}
 
+	CONSTEXPR_CPP17_CHOCOBO1_HASH RIPEMD_128::ResultArrayType RIPEMD_128::peekDigest() const
+	{
+		RIPEMD_128 copy = *this;
+		return copy.finalize().toArray();
+	}
+
 	CONSTEXPR_CPP17_CHOCOBO1_HASH RIPEMD_128& RIPEMD_128::addData(const Span<const Byte> inData)
 	{
 		Span<const Byte> data = inData;
@@ -403,6 +437,42 @@ namespace RIPEMD_128_NS
 		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
 	}
 
+	CONSTEXPR_CPP17_CHOCOBO1_HASH RIPEMD_128::State RIPEMD_128::exportState() const
+	{
+		State ret;
+		for (int i = 0; i < 4; ++i)
+			ret.h[i] = m_h[i];
+		ret.length = m_sizeCounter;
+		for (std::size_t i = 0; i < m_buffer.size(); ++i)
+			ret.buffer[i] = m_buffer[i];
+		ret.bufferSize = m_buffer.size();
+		return ret;
+	}
+
+	CONSTEXPR_CPP17_CHOCOBO1_HASH void RIPEMD_128::importState(const State &state)
+	{
+		if (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE))
+			throw std::invalid_argument("RIPEMD_128: importState() needs less than a block of pending bytes");
+		if ((state.length % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("RIPEMD_128: importState() needs a length of whole blocks");
+
+		for (int i = 0; i < 4; ++i)
+			m_h[i] = state.h[i];
+		m_sizeCounter = state.length;
+		m_buffer = {state.buffer.begin(), (state.buffer.begin() + state.bufferSize)};
+	}
+
+	CONSTEXPR_CPP17_CHOCOBO1_HASH RIPEMD_128& RIPEMD_128::compressBlocks(const Span<const Byte> blocks)
+	{
+		if (!m_buffer.empty())
+			throw std::invalid_argument("RIPEMD_128: compressBlocks() called with bytes pending from addData()");
+		if ((blocks.size() % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("RIPEMD_128: compressBlocks() takes whole blocks only");
+
+		addDataImpl(blocks);
+		return (*this);
+	}
+
 	CONSTEXPR_CPP17_CHOCOBO1_HASH void RIPEMD_128::addDataImpl(const Span<const Byte> data)
 	{
 		assert((data.size() % BLOCK_SIZE) == 0);
@@ -581,6 +651,37 @@ namespace RIPEMD_128_NS
 			m_h[0] = t;
 		}
 	}
+
+	inline std::vector<RIPEMD_128::Byte> RIPEMD_128::serialize() const
+	{
+		const State state = exportState();
+
+		StateWriter writer("RIPEMD_128");
+		for (const auto word : state.h)
+			writer.put(word);
+		writer.put(state.length);
+		writer.put(static_cast<uint32_t>(state.bufferSize));
+		writer.put(state.buffer.data(), state.bufferSize);
+		return writer.data();
+	}
+
+	inline bool RIPEMD_128::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "RIPEMD_128");
+		State state;
+		for (auto &word : state.h)
+			word = reader.get<uint32_t>();
+		state.length = reader.get<uint64_t>();
+		state.bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || ((state.length % BLOCK_SIZE) != 0) || (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE)))
+			return false;
+		reader.get(state.buffer.data(), state.bufferSize);
+		if (!reader.finished())
+			return false;
+
+		importState(state);
+		return true;
+	}
 }
 }
 	using RIPEMD_128 = Hash::RIPEMD_128_NS::RIPEMD_128;
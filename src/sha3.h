@@ -12,6 +12,9 @@
 #ifndef CHOCOBO1_SHA3_H
 #define CHOCOBO1_SHA3_H
 
+#include "state_serializer.h"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <climits>
@@ -40,6 +43,10 @@
 #include "gsl/span"
 #endif
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 
 namespace Chocobo1
 {
@@ -51,6 +58,10 @@ namespace Chocobo1
 
 	// SHAKE_128(const int digestLengthInBytes);
 	// SHAKE_256(const int digestLengthInBytes);
+
+	// TurboSHAKE_128(const int digestLengthInBytes);
+	// TurboSHAKE_256(const int digestLengthInBytes);
+	//   the XOFs also stream output of any length: `finalize()`, then `squeeze(Span<Byte>)` as many times as needed
 }
 
 
@@ -60,6 +71,14 @@ namespace Chocobo1
 
 namespace Hash
 {
+#ifndef CONSTEXPR_CPP17_CHOCOBO1_HASH
+#if __cplusplus >= 201703L
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
+#else
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
+#endif
+#endif
+
 #if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
 	using IndexType = std::size_t;
 #else
@@ -165,13 +184,32 @@ namespace Hash
 
 namespace SHA3_NS
 {
-	template<int R, int P>  // `R`: see m_params. `P`: suffix + padding
+	constexpr uint64_t roundConstantTable[24] =
+	{
+		0x0000000000000001, 0x0000000000008082, 0x800000000000808A, 0x8000000080008000, 0x000000000000808B, 0x0000000080000001,
+		0x8000000080008081, 0x8000000000008009, 0x000000000000008A, 0x0000000000000088, 0x0000000080008009, 0x000000008000000A,
+		0x000000008000808B, 0x800000000000008B, 0x8000000000008089, 0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+		0x000000000000800A, 0x800000008000000A, 0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008
+	};
+
+	// rho offsets of lane `(5 * y) + x`
+	constexpr int rhoTable[25] =
+	{
+		 0,  1, 62, 28, 27,
+		36, 44,  6, 55, 20,
+		 3, 10, 43, 25, 39,
+		41, 45, 15, 21,  8,
+		18,  2, 61, 56, 14
+	};
+
+	template <int R, int P, int Rounds = 24, int D = 0>  // `R`: see m_params. `P`: suffix + padding. `Rounds`: number of rounds of Keccak-p[1600]. `D`: fixed digest length in bytes, 0 for XOFs
 	class Keccak
 	{
 		// https://dx.doi.org/10.6028/NIST.FIPS.202
 
 		public:
 			using Byte = uint8_t;
+			using ResultArrayType = std::array<Byte, D>;
 
 #if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
 			template <typename T, std::size_t Extent = std::dynamic_extent>
@@ -185,10 +223,16 @@ namespace SHA3_NS
 			constexpr explicit Keccak(const int digestLength);
 
 			constexpr void reset();
-			Keccak& finalize();  // after this, only `toString()`, `toVector()`, `reset()` are available
+			CONSTEXPR_CPP17_CHOCOBO1_HASH Keccak& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `reset()` are available
 
 			std::string toString() const;
 			std::vector<Byte> toVector() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;  // fixed digest length only, e.g. SHA3_*
+			std::vector<Byte> peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
+
+			// XOF output in pieces, call it after `finalize()` as many times as needed
+			// the pieces concatenated are the same bytes as `toVector()` of the total length, but don't mix the two
+			CONSTEXPR_CPP17_CHOCOBO1_HASH Keccak& squeeze(const Span<Byte> output);
 
 			constexpr Keccak& addData(const Span<const Byte> inData);
 			constexpr Keccak& addData(const void *ptr, const std::size_t length);
@@ -199,9 +243,28 @@ namespace SHA3_NS
 			template <typename T>
 			Keccak& addData(const Span<T> inSpan);
 
+			// absorb `blocks` whole blocks into each of `states` simultaneously
+			// `data[i]` points to the first block of `states[i]`, consecutive blocks are `stride` bytes apart
+			// the states must not have pending data from `addData()`
+			template <std::size_t N>
+			static void addBlocks(Keccak *const (&states)[N], const Byte *const (&data)[N], const std::size_t blocks, const std::size_t stride = R);
+
+			static constexpr int BLOCK_SIZE = R;
+			static constexpr int SIMD_LANES = 4;  // number of states `addBlocks()` process in one pass
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
 			constexpr void addDataImpl(const Span<const Byte> data);
-			std::vector<typename Keccak::Byte> stateToVector() const;
+			constexpr void addPadding();
+			constexpr void permute();
+#if defined(__AVX2__)
+			static void addBlocksAvx2(Keccak *const *states, const Byte *const *data, const std::size_t blocks, const std::size_t stride);
+#endif
+			CONSTEXPR_CPP17_CHOCOBO1_HASH void readOutput(const Span<Byte> output) const;  // squeeze `output.size()` bytes without touching the state
+			constexpr void stateToBytes(const std::size_t offset, const Span<Byte> output) const;
 
 			struct
 			{
@@ -214,11 +277,11 @@ namespace SHA3_NS
 //				int d = 512 / 8;  // digest size
 //				int r = 576 / 8;  // (b - c)  // IOW, BLOCK_SIZE
 				int w = 64;       // (b / 25)
-			} const m_params;
-			const int m_digestLength;
+			} m_params;
+			int m_digestLength;
 
 			Buffer<Byte, R> m_buffer;
-			std::vector<Byte> m_final;
+			std::size_t m_squeezed = 0;  // bytes of the current state already handed out by `squeeze()`
 
 			uint64_t m_state[5][5] = {};  // [y][x]
 	};
@@ -273,61 +336,42 @@ namespace SHA3_NS
 	}
 
 	//
-	template <int R, int P>
-	constexpr Keccak<R, P>::Keccak(const int digestLength)
+	template <int R, int P, int Rounds, int D>
+	constexpr Keccak<R, P, Rounds, D>::Keccak(const int digestLength)
 		: m_params()
 		, m_digestLength(digestLength)
 	{
 		static_assert((R >= 0), "Template parameter value invalid: R");
 		static_assert((P >= 0), "Template parameter value invalid: P");
+		static_assert(((Rounds > 0) && (Rounds <= 24)), "Template parameter value invalid: Rounds");
+		static_assert((D >= 0), "Template parameter value invalid: D");
 		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
 
-		m_final.reserve(m_digestLength);
+		assert((D == 0) || (digestLength == D));
 		reset();
 	}
 
-	template <int R, int P>
-	constexpr void Keccak<R, P>::reset()
+	template <int R, int P, int Rounds, int D>
+	constexpr void Keccak<R, P, Rounds, D>::reset()
 	{
 		m_buffer.clear();
-		m_final.clear();
+		m_squeezed = 0;
 
 		for (int y = 0; y < 5; ++y)
 			for (int x = 0; x < 5; ++x)
 				m_state[y][x] = 0;
 	}
 
-	template <int R, int P>
-	Keccak<R, P>& Keccak<R, P>::finalize()
+	template <int R, int P, int Rounds, int D>
+	CONSTEXPR_CPP17_CHOCOBO1_HASH Keccak<R, P, Rounds, D>& Keccak<R, P, Rounds, D>::finalize()
 	{
-		// add padding
-		// the padding is reversed due to "B.1 Conversion Functions - Algorithm 11: b2h(S)"
-		m_buffer.fill(P);
-
-		const size_t len = R - (m_buffer.size() % R);
-		m_buffer.fill(0, len);
-		m_buffer[m_buffer.size() - 1] |= (1 << 7);
-
-		addDataImpl({m_buffer.data(), m_buffer.size()});
-		m_buffer.clear();
-
-		// squish out
-		while (true)
-		{
-			const std::vector<Byte> state = stateToVector();
-			m_final.insert(m_final.end(), state.begin(), (state.begin() + R));
-			if (m_final.size() >= static_cast<size_t>(m_digestLength))
-				break;
-
-			addDataImpl(std::array<Byte, R> {});
-		}
-
-		m_final.resize(m_digestLength);
+		// the output is squeezed on demand by `toArray()` & friends
+		addPadding();
 		return (*this);
 	}
 
-	template <int R, int P>
-	std::string Keccak<R, P>::toString() const
+	template <int R, int P, int Rounds, int D>
+	std::string Keccak<R, P, Rounds, D>::toString() const
 	{
 		const auto v = toVector();
 		std::string ret;
@@ -346,14 +390,56 @@ namespace SHA3_NS
 		return ret;
 	}
 
-	template <int R, int P>
-	std::vector<typename Keccak<R, P>::Byte> Keccak<R, P>::toVector() const
+	template <int R, int P, int Rounds, int D>
+	std::vector<typename Keccak<R, P, Rounds, D>::Byte> Keccak<R, P, Rounds, D>::toVector() const
 	{
-		return m_final;
+		std::vector<Byte> ret(static_cast<std::size_t>(m_digestLength));
+		readOutput({ret.data(), ret.size()});
+		return ret;
 	}
 
-	template <int R, int P>
-	constexpr Keccak<R, P>& Keccak<R, P>::addData(const Span<const Byte> inData)
+	template <int R, int P, int Rounds, int D>
+	CONSTEXPR_CPP17_CHOCOBO1_HASH typename Keccak<R, P, Rounds, D>::ResultArrayType Keccak<R, P, Rounds, D>::toArray() const
+	{
+		static_assert((D > 0), "XOFs don't have a fixed digest length, use `toVector()` instead");
+
+		ResultArrayType ret {};
+		readOutput({ret.data(), ret.size()});
+		return ret;
+	}
+
+	template <int R, int P, int Rounds, int D>
+	CONSTEXPR_CPP17_CHOCOBO1_HASH Keccak<R, P, Rounds, D>& Keccak<R, P, Rounds, D>::squeeze(const Span<Byte> output)
+	{
+		// carry on from where the previous call stopped, the state is permuted once all its bytes are out
+		const std::size_t outputSize = static_cast<std::size_t>(output.size());
+		for (std::size_t offset = 0; offset < outputSize; )
+		{
+			if (m_squeezed == static_cast<std::size_t>(R))
+			{
+				permute();
+				m_squeezed = 0;
+			}
+
+			const std::size_t len = std::min<std::size_t>((R - m_squeezed), (outputSize - offset));
+			stateToBytes(m_squeezed, output.subspan(offset, len));
+			m_squeezed += len;
+			offset += len;
+		}
+		return (*this);
+	}
+
+	template <int R, int P, int Rounds, int D>
+	std::vector<typename Keccak<R, P, Rounds, D>::Byte> Keccak<R, P, Rounds, D>::peekDigest() const
+	{
+		// the copy is only the lanes & the pending bytes
+		Keccak sponge = *this;
+		sponge.addPadding();
+		return sponge.toVector();
+	}
+
+	template <int R, int P, int Rounds, int D>
+	constexpr Keccak<R, P, Rounds, D>& Keccak<R, P, Rounds, D>::addData(const Span<const Byte> inData)
 	{
 		Span<const Byte> data = inData;
 
@@ -387,36 +473,36 @@ namespace SHA3_NS
 		return (*this);
 	}
 
-	template <int R, int P>
-	constexpr Keccak<R, P>& Keccak<R, P>::addData(const void *ptr, const std::size_t length)
+	template <int R, int P, int Rounds, int D>
+	constexpr Keccak<R, P, Rounds, D>& Keccak<R, P, Rounds, D>::addData(const void *ptr, const std::size_t length)
 	{
 		// Span::size_type = std::size_t
 		return addData({static_cast<const Byte*>(ptr), length});
 	}
 
-	template <int R, int P>
+	template <int R, int P, int Rounds, int D>
 	template <std::size_t N>
-	constexpr Keccak<R, P>& Keccak<R, P>::addData(const Byte (&array)[N])
+	constexpr Keccak<R, P, Rounds, D>& Keccak<R, P, Rounds, D>::addData(const Byte (&array)[N])
 	{
 		return addData({array, N});
 	}
 
-	template <int R, int P>
+	template <int R, int P, int Rounds, int D>
 	template <typename T, std::size_t N>
-	Keccak<R, P>& Keccak<R, P>::addData(const T (&array)[N])
+	Keccak<R, P, Rounds, D>& Keccak<R, P, Rounds, D>::addData(const T (&array)[N])
 	{
 		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
 	}
 
-	template <int R, int P>
+	template <int R, int P, int Rounds, int D>
 	template <typename T>
-	Keccak<R, P>& Keccak<R, P>::addData(const Span<T> inSpan)
+	Keccak<R, P, Rounds, D>& Keccak<R, P, Rounds, D>::addData(const Span<T> inSpan)
 	{
 		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
 	}
 
-	template <int R, int P>
-	constexpr void Keccak<R, P>::addDataImpl(const Span<const Byte> data)
+	template <int R, int P, int Rounds, int D>
+	constexpr void Keccak<R, P, Rounds, D>::addDataImpl(const Span<const Byte> data)
 	{
 		assert((data.size() % R) == 0);
 
@@ -424,139 +510,304 @@ namespace SHA3_NS
 		{
 			const Loader<uint64_t> m(static_cast<const Byte *>(data.data() + (iter * R)));
 			for (int i = 0; i < (R / 8); ++i)
+				m_state[i / 5][i % 5] ^= m[i];
+
+			permute();
+		}
+	}
+
+	template <int R, int P, int Rounds, int D>
+	constexpr void Keccak<R, P, Rounds, D>::permute()
+	{
+		const auto roundFunction = [this](const int indexRound)
+		{
+			const auto theta = [this]()
 			{
- 				uint64_t *statePtr = reinterpret_cast<uint64_t *>(m_state);
- 				statePtr[i] ^= m[i];
-			}
+				const uint64_t c[5] =
+				{
+					(m_state[0][0] ^ m_state[1][0] ^ m_state[2][0] ^ m_state[3][0] ^ m_state[4][0]),
+					(m_state[0][1] ^ m_state[1][1] ^ m_state[2][1] ^ m_state[3][1] ^ m_state[4][1]),
+					(m_state[0][2] ^ m_state[1][2] ^ m_state[2][2] ^ m_state[3][2] ^ m_state[4][2]),
+					(m_state[0][3] ^ m_state[1][3] ^ m_state[2][3] ^ m_state[3][3] ^ m_state[4][3]),
+					(m_state[0][4] ^ m_state[1][4] ^ m_state[2][4] ^ m_state[3][4] ^ m_state[4][4])
+				};
+				const uint64_t d[5] =
+				{
+					c[4] ^ rotl(c[1], 1),
+					c[0] ^ rotl(c[2], 1),
+					c[1] ^ rotl(c[3], 1),
+					c[2] ^ rotl(c[4], 1),
+					c[3] ^ rotl(c[0], 1)
+				};
 
-			const auto roundFunction = [this](const int indexRound)
+				for (int y = 0; y < 5; ++y)
+				{
+					m_state[y][0] ^= d[0];
+					m_state[y][1] ^= d[1];
+					m_state[y][2] ^= d[2];
+					m_state[y][3] ^= d[3];
+					m_state[y][4] ^= d[4];
+				}
+			};
+			const auto rhoPiChi = [this]()
 			{
-				const auto theta = [this]()
+				// rho, pi combined
+				const uint64_t tmp[5][5] =
 				{
-					const uint64_t c[5] =
 					{
-						(m_state[0][0] ^ m_state[1][0] ^ m_state[2][0] ^ m_state[3][0] ^ m_state[4][0]),
-						(m_state[0][1] ^ m_state[1][1] ^ m_state[2][1] ^ m_state[3][1] ^ m_state[4][1]),
-						(m_state[0][2] ^ m_state[1][2] ^ m_state[2][2] ^ m_state[3][2] ^ m_state[4][2]),
-						(m_state[0][3] ^ m_state[1][3] ^ m_state[2][3] ^ m_state[3][3] ^ m_state[4][3]),
-						(m_state[0][4] ^ m_state[1][4] ^ m_state[2][4] ^ m_state[3][4] ^ m_state[4][4])
-					};
-					const uint64_t d[5] =
+						rotl(m_state[0][0], (  0 % m_params.w)),
+						rotl(m_state[1][1], (300 % m_params.w)),
+						rotl(m_state[2][2], (171 % m_params.w)),
+						rotl(m_state[3][3], ( 21 % m_params.w)),
+						rotl(m_state[4][4], ( 78 % m_params.w))
+					},
 					{
-						c[4] ^ rotl(c[1], 1),
-						c[0] ^ rotl(c[2], 1),
-						c[1] ^ rotl(c[3], 1),
-						c[2] ^ rotl(c[4], 1),
-						c[3] ^ rotl(c[0], 1)
-					};
-
-					for (int y = 0; y < 5; ++y)
+						rotl(m_state[0][3], ( 28 % m_params.w)),
+						rotl(m_state[1][4], (276 % m_params.w)),
+						rotl(m_state[2][0], (  3 % m_params.w)),
+						rotl(m_state[3][1], ( 45 % m_params.w)),
+						rotl(m_state[4][2], (253 % m_params.w))
+					},
 					{
-						m_state[y][0] ^= d[0];
-						m_state[y][1] ^= d[1];
-						m_state[y][2] ^= d[2];
-						m_state[y][3] ^= d[3];
-						m_state[y][4] ^= d[4];
-					}
-				};
-				const auto rhoPiChi = [this]()
-				{
-					// rho, pi combined
-					const uint64_t tmp[5][5] =
+						rotl(m_state[0][1], (  1 % m_params.w)),
+						rotl(m_state[1][2], (  6 % m_params.w)),
+						rotl(m_state[2][3], (153 % m_params.w)),
+						rotl(m_state[3][4], (136 % m_params.w)),
+						rotl(m_state[4][0], (210 % m_params.w))
+					},
 					{
-						{
-							rotl(m_state[0][0], (  0 % m_params.w)),
-							rotl(m_state[1][1], (300 % m_params.w)),
-							rotl(m_state[2][2], (171 % m_params.w)),
-							rotl(m_state[3][3], ( 21 % m_params.w)),
-							rotl(m_state[4][4], ( 78 % m_params.w))
-						},
-						{
-							rotl(m_state[0][3], ( 28 % m_params.w)),
-							rotl(m_state[1][4], (276 % m_params.w)),
-							rotl(m_state[2][0], (  3 % m_params.w)),
-							rotl(m_state[3][1], ( 45 % m_params.w)),
-							rotl(m_state[4][2], (253 % m_params.w))
-						},
-						{
-							rotl(m_state[0][1], (  1 % m_params.w)),
-							rotl(m_state[1][2], (  6 % m_params.w)),
-							rotl(m_state[2][3], (153 % m_params.w)),
-							rotl(m_state[3][4], (136 % m_params.w)),
-							rotl(m_state[4][0], (210 % m_params.w))
-						},
-						{
-							rotl(m_state[0][4], ( 91 % m_params.w)),
-							rotl(m_state[1][0], ( 36 % m_params.w)),
-							rotl(m_state[2][1], ( 10 % m_params.w)),
-							rotl(m_state[3][2], ( 15 % m_params.w)),
-							rotl(m_state[4][3], (120 % m_params.w))
-						},
-						{
-							rotl(m_state[0][2], (190 % m_params.w)),
-							rotl(m_state[1][3], ( 55 % m_params.w)),
-							rotl(m_state[2][4], (231 % m_params.w)),
-							rotl(m_state[3][0], (105 % m_params.w)),
-							rotl(m_state[4][1], ( 66 % m_params.w))
-						}
-					};
-					// chi
-					for (int y = 0; y < 5; ++y)
+						rotl(m_state[0][4], ( 91 % m_params.w)),
+						rotl(m_state[1][0], ( 36 % m_params.w)),
+						rotl(m_state[2][1], ( 10 % m_params.w)),
+						rotl(m_state[3][2], ( 15 % m_params.w)),
+						rotl(m_state[4][3], (120 % m_params.w))
+					},
 					{
-						m_state[y][0] = tmp[y][0] ^ ((~tmp[y][1]) & tmp[y][2]);
-						m_state[y][1] = tmp[y][1] ^ ((~tmp[y][2]) & tmp[y][3]);
-						m_state[y][2] = tmp[y][2] ^ ((~tmp[y][3]) & tmp[y][4]);
-						m_state[y][3] = tmp[y][3] ^ ((~tmp[y][4]) & tmp[y][0]);
-						m_state[y][4] = tmp[y][4] ^ ((~tmp[y][0]) & tmp[y][1]);
+						rotl(m_state[0][2], (190 % m_params.w)),
+						rotl(m_state[1][3], ( 55 % m_params.w)),
+						rotl(m_state[2][4], (231 % m_params.w)),
+						rotl(m_state[3][0], (105 % m_params.w)),
+						rotl(m_state[4][1], ( 66 % m_params.w))
 					}
 				};
-				const auto iota = [this](const int indexRound)
+				// chi
+				for (int y = 0; y < 5; ++y)
 				{
-					static const uint64_t roundConstantTable[24] =
-					{
-						0x0000000000000001, 0x0000000000008082, 0x800000000000808A, 0x8000000080008000, 0x000000000000808B, 0x0000000080000001,
-						0x8000000080008081, 0x8000000000008009, 0x000000000000008A, 0x0000000000000088, 0x0000000080008009, 0x000000008000000A,
-						0x000000008000808B, 0x800000000000008B, 0x8000000000008089, 0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
-						0x000000000000800A, 0x800000008000000A, 0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008
-					};
+					m_state[y][0] = tmp[y][0] ^ ((~tmp[y][1]) & tmp[y][2]);
+					m_state[y][1] = tmp[y][1] ^ ((~tmp[y][2]) & tmp[y][3]);
+					m_state[y][2] = tmp[y][2] ^ ((~tmp[y][3]) & tmp[y][4]);
+					m_state[y][3] = tmp[y][3] ^ ((~tmp[y][4]) & tmp[y][0]);
+					m_state[y][4] = tmp[y][4] ^ ((~tmp[y][0]) & tmp[y][1]);
+				}
+			};
+			const auto iota = [this](const int indexRound)
+			{
+				m_state[0][0] ^= roundConstantTable[indexRound];
+			};
 
-					m_state[0][0] ^= roundConstantTable[indexRound];
-				};
+			theta();
+			rhoPiChi();
+			iota(indexRound);
+		};
 
-				theta();
-				rhoPiChi();
-				iota(indexRound);
-			};
+		// Keccak-p[1600, n] uses the last n rounds of Keccak-f[1600]
+		for (int i = (24 - Rounds); i < 24; ++i)
+			roundFunction(i);
+	}
+
+	template <int R, int P, int Rounds, int D>
+	constexpr void Keccak<R, P, Rounds, D>::addPadding()
+	{
+		// the padding is reversed due to "B.1 Conversion Functions - Algorithm 11: b2h(S)"
+		m_buffer.fill(P);
+
+		const size_t len = (R - (m_buffer.size() % R)) % R;
+		m_buffer.fill(0, len);
+		m_buffer[m_buffer.size() - 1] |= (1 << 7);
 
-			for (int i = 0; i < 24; ++i)
-				roundFunction(i);
+		addDataImpl({m_buffer.data(), m_buffer.size()});
+		m_buffer.clear();
+	}
+
+	template <int R, int P, int Rounds, int D>
+	template <std::size_t N>
+	void Keccak<R, P, Rounds, D>::addBlocks(Keccak *const (&states)[N], const Byte *const (&data)[N], const std::size_t blocks, const std::size_t stride)
+	{
+#if defined(__AVX2__)
+		if (N == SIMD_LANES)
+		{
+			addBlocksAvx2(states, data, blocks, stride);
+			return;
+		}
+#endif
+
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			assert(states[i]->m_buffer.empty());
+			for (std::size_t iter = 0; iter < blocks; ++iter)
+				states[i]->addDataImpl({(data[i] + (iter * stride)), R});
 		}
 	}
 
-	template <int R, int P>
-	std::vector<typename Keccak<R, P>::Byte> Keccak<R, P>::stateToVector() const
+#if defined(__AVX2__)
+	template <int R, int P, int Rounds, int D>
+	void Keccak<R, P, Rounds, D>::addBlocksAvx2(Keccak *const *states, const Byte *const *data, const std::size_t blocks, const std::size_t stride)
 	{
-		const Span<const uint64_t> state(reinterpret_cast<const uint64_t *>(m_state), 25);
-		const int dataSize = sizeof(typename decltype(state)::value_type);
+		// 4 states in the 4 64-bit lanes of AVX2 registers, lane `(5 * y) + x` is `m_state[y][x]`
+		const auto gather = [](const uint64_t a, const uint64_t b, const uint64_t c, const uint64_t d) -> __m256i
+		{
+			return _mm256_set_epi64x(static_cast<long long>(d), static_cast<long long>(c), static_cast<long long>(b), static_cast<long long>(a));
+		};
+		const auto rotl256 = [](const __m256i x, const int s) -> __m256i
+		{
+			if (s == 0)
+				return x;
+			return _mm256_or_si256(_mm256_slli_epi64(x, s), _mm256_srli_epi64(x, (64 - s)));
+		};
 
-		std::vector<Byte> ret;
-		ret.reserve(dataSize * state.size());
-		for (const auto i : state)
+		__m256i a[25];
+		for (int i = 0; i < 25; ++i)
 		{
-			for (int j = 0; j < dataSize; ++j)
-				ret.emplace_back(ror<Byte>(i, (j * 8)));
+			assert(states[i % 4]->m_buffer.empty());
+			a[i] = gather(states[0]->m_state[i / 5][i % 5], states[1]->m_state[i / 5][i % 5]
+				, states[2]->m_state[i / 5][i % 5], states[3]->m_state[i / 5][i % 5]);
 		}
 
-		return ret;
+		for (std::size_t iter = 0; iter < blocks; ++iter)
+		{
+			const Loader<uint64_t> m0(data[0] + (iter * stride));
+			const Loader<uint64_t> m1(data[1] + (iter * stride));
+			const Loader<uint64_t> m2(data[2] + (iter * stride));
+			const Loader<uint64_t> m3(data[3] + (iter * stride));
+			for (int i = 0; i < (R / 8); ++i)
+				a[i] = _mm256_xor_si256(a[i], gather(m0[i], m1[i], m2[i], m3[i]));
+
+			for (int round = (24 - Rounds); round < 24; ++round)
+			{
+				// theta
+				__m256i c[5];
+				for (int x = 0; x < 5; ++x)
+					c[x] = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[x], a[x + 5]), _mm256_xor_si256(a[x + 10], a[x + 15])), a[x + 20]);
+				for (int x = 0; x < 5; ++x)
+				{
+					const __m256i d = _mm256_xor_si256(c[(x + 4) % 5], rotl256(c[(x + 1) % 5], 1));
+					for (int y = 0; y < 25; y += 5)
+						a[y + x] = _mm256_xor_si256(a[y + x], d);
+				}
+
+				// rho, pi combined
+				__m256i b[25];
+				for (int y = 0; y < 5; ++y)
+				{
+					for (int x = 0; x < 5; ++x)
+						b[(((2 * x) + (3 * y)) % 5) * 5 + y] = rotl256(a[(5 * y) + x], rhoTable[(5 * y) + x]);
+				}
+
+				// chi
+				for (int y = 0; y < 25; y += 5)
+				{
+					for (int x = 0; x < 5; ++x)
+						a[y + x] = _mm256_xor_si256(b[y + x], _mm256_andnot_si256(b[y + ((x + 1) % 5)], b[y + ((x + 2) % 5)]));
+				}
+
+				// iota
+				a[0] = _mm256_xor_si256(a[0], _mm256_set1_epi64x(static_cast<long long>(roundConstantTable[round])));
+			}
+		}
+
+		for (int i = 0; i < 25; ++i)
+		{
+			alignas(32) uint64_t lanes[4] = {};
+			_mm256_store_si256(reinterpret_cast<__m256i *>(lanes), a[i]);
+			for (int j = 0; j < 4; ++j)
+				states[j]->m_state[i / 5][i % 5] = lanes[j];
+		}
+	}
+#endif
+
+	template <int R, int P, int Rounds, int D>
+	CONSTEXPR_CPP17_CHOCOBO1_HASH void Keccak<R, P, Rounds, D>::readOutput(const Span<Byte> output) const
+	{
+		// the first block is the current state, only longer outputs need a permuted copy
+		const std::size_t outputSize = static_cast<std::size_t>(output.size());
+		const std::size_t firstSize = std::min<std::size_t>(R, outputSize);
+		stateToBytes(0, output.first(firstSize));
+		if (firstSize == outputSize)
+			return;
+
+		Keccak sponge = *this;
+		for (std::size_t offset = firstSize; offset < outputSize; offset += R)
+		{
+			sponge.permute();
+			sponge.stateToBytes(0, output.subspan(offset, std::min<std::size_t>(R, (outputSize - offset))));
+		}
+	}
+
+	template <int R, int P, int Rounds, int D>
+	constexpr void Keccak<R, P, Rounds, D>::stateToBytes(const std::size_t offset, const Span<Byte> output) const
+	{
+		assert((offset + static_cast<std::size_t>(output.size())) <= static_cast<std::size_t>(R));
+
+		for (std::size_t i = 0; i < static_cast<std::size_t>(output.size()); ++i)
+		{
+			const std::size_t j = offset + i;
+			output[i] = ror<Byte>(m_state[(j / 8) / 5][(j / 8) % 5], (8 * (j % 8)));
+		}
+	}
+
+	template <int R, int P, int Rounds, int D>
+	std::vector<typename Keccak<R, P, Rounds, D>::Byte> Keccak<R, P, Rounds, D>::serialize() const
+	{
+		StateWriter writer("Keccak_" + std::to_string(R) + "_" + std::to_string(P) + "_" + std::to_string(Rounds));
+		writer.put(static_cast<uint32_t>(m_digestLength));
+		for (int y = 0; y < 5; ++y)
+		{
+			for (int x = 0; x < 5; ++x)
+				writer.put(m_state[y][x]);
+		}
+		writer.put(static_cast<uint32_t>(m_buffer.size()));
+		writer.put(m_buffer.data(), m_buffer.size());
+		return writer.data();
+	}
+
+	template <int R, int P, int Rounds, int D>
+	bool Keccak<R, P, Rounds, D>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "Keccak_" + std::to_string(R) + "_" + std::to_string(P) + "_" + std::to_string(Rounds));
+		const uint32_t digestLength = reader.get<uint32_t>();
+		uint64_t state[5][5] = {};
+		for (int y = 0; y < 5; ++y)
+		{
+			for (int x = 0; x < 5; ++x)
+				state[y][x] = reader.get<uint64_t>();
+		}
+		const uint32_t bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || (digestLength != static_cast<uint32_t>(m_digestLength)) || (bufferSize >= R))
+			return false;
+		Byte buffer[R] = {};
+		reader.get(buffer, bufferSize);
+		if (!reader.finished())
+			return false;
+
+		for (int y = 0; y < 5; ++y)
+		{
+			for (int x = 0; x < 5; ++x)
+				m_state[y][x] = state[y][x];
+		}
+		m_buffer = {buffer, (buffer + bufferSize)};
+		m_squeezed = 0;
+		return true;
 	}
 }
 }
-	struct SHA3_224 : Hash::SHA3_NS::Keccak<(1152 / 8), 0x06> { SHA3_224() : Hash::SHA3_NS::Keccak<(1152 / 8), 0x06>(224 / 8) {} };
-	struct SHA3_256 : Hash::SHA3_NS::Keccak<(1088 / 8), 0x06> { SHA3_256() : Hash::SHA3_NS::Keccak<(1088 / 8), 0x06>(256 / 8) {} };
-	struct SHA3_384 : Hash::SHA3_NS::Keccak<( 832 / 8), 0x06> { SHA3_384() : Hash::SHA3_NS::Keccak<( 832 / 8), 0x06>(384 / 8) {} };
-	struct SHA3_512 : Hash::SHA3_NS::Keccak<( 576 / 8), 0x06> { SHA3_512() : Hash::SHA3_NS::Keccak<( 576 / 8), 0x06>(512 / 8) {} };
-	struct SHAKE_128 : Hash::SHA3_NS::Keccak<(1344 / 8), 0x1F> { explicit SHAKE_128(const int d) : Hash::SHA3_NS::Keccak<(1344 / 8), 0x1F>(d) {} };
-	struct SHAKE_256 : Hash::SHA3_NS::Keccak<(1088 / 8), 0x1F> { explicit SHAKE_256(const int d) : Hash::SHA3_NS::Keccak<(1088 / 8), 0x1F>(d) {} };
+	struct SHA3_224 : Hash::SHA3_NS::Keccak<(1152 / 8), 0x06, 24, (224 / 8)> { constexpr SHA3_224() : Hash::SHA3_NS::Keccak<(1152 / 8), 0x06, 24, (224 / 8)>(224 / 8) {} };
+	struct SHA3_256 : Hash::SHA3_NS::Keccak<(1088 / 8), 0x06, 24, (256 / 8)> { constexpr SHA3_256() : Hash::SHA3_NS::Keccak<(1088 / 8), 0x06, 24, (256 / 8)>(256 / 8) {} };
+	struct SHA3_384 : Hash::SHA3_NS::Keccak<( 832 / 8), 0x06, 24, (384 / 8)> { constexpr SHA3_384() : Hash::SHA3_NS::Keccak<( 832 / 8), 0x06, 24, (384 / 8)>(384 / 8) {} };
+	struct SHA3_512 : Hash::SHA3_NS::Keccak<( 576 / 8), 0x06, 24, (512 / 8)> { constexpr SHA3_512() : Hash::SHA3_NS::Keccak<( 576 / 8), 0x06, 24, (512 / 8)>(512 / 8) {} };
+	struct SHAKE_128 : Hash::SHA3_NS::Keccak<(1344 / 8), 0x1F> { explicit constexpr SHAKE_128(const int d) : Hash::SHA3_NS::Keccak<(1344 / 8), 0x1F>(d) {} };
+	struct SHAKE_256 : Hash::SHA3_NS::Keccak<(1088 / 8), 0x1F> { explicit constexpr SHAKE_256(const int d) : Hash::SHA3_NS::Keccak<(1088 / 8), 0x1F>(d) {} };
+	struct TurboSHAKE_128 : Hash::SHA3_NS::Keccak<(1344 / 8), 0x1F, 12> { explicit constexpr TurboSHAKE_128(const int d) : Hash::SHA3_NS::Keccak<(1344 / 8), 0x1F, 12>(d) {} };
+	struct TurboSHAKE_256 : Hash::SHA3_NS::Keccak<(1088 / 8), 0x1F, 12> { explicit constexpr TurboSHAKE_256(const int d) : Hash::SHA3_NS::Keccak<(1088 / 8), 0x1F, 12>(d) {} };
 }
 
 #endif  // CHOCOBO1_SHA3_H
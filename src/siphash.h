@@ -0,0 +1,899 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2017-2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_SIPHASH_H
+#define CHOCOBO1_SIPHASH_H
+
+#include "state_serializer.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// SipHash_2_4(const SipHash_2_4::KeyArrayType &key);
+	// SipHash_1_3(const SipHash_1_3::KeyArrayType &key);
+	// HalfSipHash_2_4(const HalfSipHash_2_4::KeyArrayType &key);
+	// HalfSipHash_1_3(const HalfSipHash_1_3::KeyArrayType &key);
+	//   `SipHash_2_4::hash(key, data)` is the one-shot version for short inputs, `hashMany(key, inputs, outputs)` hashes many inputs at once
+	//   `inputs` & `outputs` of `hashMany()` must have the same size, otherwise it throws `std::invalid_argument`
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, restore into an instance constructed with the same key
+	//   the SipRounds can be run backwards to the key, keep the snapshots as secret as the key
+
+	// SipHasher<T, H = SipHash_1_3>(key);
+	//   `std::hash` compatible, for integral, enum, pointer & string types, the default constructor uses a random key
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+#ifndef CONSTEXPR_CPP17_CHOCOBO1_HASH
+#if __cplusplus >= 201703L
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
+#else
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
+#endif
+#endif
+
+namespace SipHash_NS
+{
+	template <typename Word>
+	struct Constants;
+
+	template <>
+	struct Constants<uint64_t>
+	{
+		// SipHash
+		static constexpr uint64_t INIT0 = 0x736f6d6570736575;
+		static constexpr uint64_t INIT1 = 0x646f72616e646f6d;
+		static constexpr uint64_t INIT2 = 0x6c7967656e657261;
+		static constexpr uint64_t INIT3 = 0x7465646279746573;
+		static constexpr unsigned int ROTATE0 = 13, ROTATE1 = 32, ROTATE2 = 16, ROTATE3 = 21, ROTATE4 = 17, ROTATE5 = 32;
+	};
+
+	template <>
+	struct Constants<uint32_t>
+	{
+		// HalfSipHash
+		static constexpr uint32_t INIT0 = 0;
+		static constexpr uint32_t INIT1 = 0;
+		static constexpr uint32_t INIT2 = 0x6c796765;
+		static constexpr uint32_t INIT3 = 0x74656462;
+		static constexpr unsigned int ROTATE0 = 5, ROTATE1 = 16, ROTATE2 = 8, ROTATE3 = 7, ROTATE4 = 13, ROTATE5 = 16;
+	};
+
+#if defined(__AVX2__)
+	// SIMD lanes for `hashMany()`, one message per lane
+	template <typename Word>
+	struct Avx2Ops;
+
+	template <>
+	struct Avx2Ops<uint64_t>
+	{
+		using Vector = __m256i;
+		static constexpr int LANES = 4;
+
+		static Vector load(const uint64_t *p)
+		{
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		}
+		static void store(uint64_t *p, const Vector x)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+		}
+		static Vector set1(const uint64_t x)
+		{
+			return _mm256_set1_epi64x(static_cast<long long>(x));
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm256_add_epi64(a, b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return _mm256_xor_si256(a, b);
+		}
+		template <unsigned int S>
+		static Vector rotl(const Vector x)
+		{
+			// whole-byte rotations are a single shuffle
+			if (S == 32)
+				return _mm256_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1));
+			if (S == 16)
+				return _mm256_shuffle_epi8(x, _mm256_setr_epi8(
+					6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11, 12, 13,
+					6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11, 12, 13));
+			return _mm256_or_si256(_mm256_slli_epi64(x, S), _mm256_srli_epi64(x, (64 - S)));
+		}
+	};
+
+	template <>
+	struct Avx2Ops<uint32_t>
+	{
+		using Vector = __m256i;
+		static constexpr int LANES = 8;
+
+		static Vector load(const uint32_t *p)
+		{
+			return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		}
+		static void store(uint32_t *p, const Vector x)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+		}
+		static Vector set1(const uint32_t x)
+		{
+			return _mm256_set1_epi32(static_cast<int>(x));
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm256_add_epi32(a, b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return _mm256_xor_si256(a, b);
+		}
+		template <unsigned int S>
+		static Vector rotl(const Vector x)
+		{
+			// whole-byte rotations are a single shuffle
+			if (S == 16)
+				return _mm256_shuffle_epi8(x, _mm256_setr_epi8(
+					2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+					2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+			if (S == 8)
+				return _mm256_shuffle_epi8(x, _mm256_setr_epi8(
+					3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+					3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14));
+			return _mm256_or_si256(_mm256_slli_epi32(x, S), _mm256_srli_epi32(x, (32 - S)));
+		}
+	};
+#endif
+
+#if defined(__AVX512F__)
+	template <typename Word>
+	struct Avx512Ops;
+
+	template <>
+	struct Avx512Ops<uint64_t>
+	{
+		using Vector = __m512i;
+		static constexpr int LANES = 8;
+		// the zero-masked shifts with every lane selected, the unmasked ones trip `-Wmaybe-uninitialized` on GCC 12
+		static constexpr __mmask8 ALL = 0xFF;
+
+		static Vector load(const uint64_t *p)
+		{
+			return _mm512_loadu_si512(p);
+		}
+		static void store(uint64_t *p, const Vector x)
+		{
+			_mm512_storeu_si512(p, x);
+		}
+		static Vector set1(const uint64_t x)
+		{
+			return _mm512_set1_epi64(static_cast<long long>(x));
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm512_add_epi64(a, b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return _mm512_xor_si512(a, b);
+		}
+		template <unsigned int S>
+		static Vector rotl(const Vector x)
+		{
+			return _mm512_or_si512(_mm512_maskz_slli_epi64(ALL, x, S), _mm512_maskz_srli_epi64(ALL, x, (64 - S)));
+		}
+	};
+
+	template <>
+	struct Avx512Ops<uint32_t>
+	{
+		using Vector = __m512i;
+		static constexpr int LANES = 16;
+		// the zero-masked shifts with every lane selected, the unmasked ones trip `-Wmaybe-uninitialized` on GCC 12
+		static constexpr __mmask16 ALL = 0xFFFF;
+
+		static Vector load(const uint32_t *p)
+		{
+			return _mm512_loadu_si512(p);
+		}
+		static void store(uint32_t *p, const Vector x)
+		{
+			_mm512_storeu_si512(p, x);
+		}
+		static Vector set1(const uint32_t x)
+		{
+			return _mm512_set1_epi32(static_cast<int>(x));
+		}
+		static Vector add(const Vector a, const Vector b)
+		{
+			return _mm512_add_epi32(a, b);
+		}
+		static Vector xor_(const Vector a, const Vector b)
+		{
+			return _mm512_xor_si512(a, b);
+		}
+		template <unsigned int S>
+		static Vector rotl(const Vector x)
+		{
+			return _mm512_or_si512(_mm512_maskz_slli_epi32(ALL, x, S), _mm512_maskz_srli_epi32(ALL, x, (32 - S)));
+		}
+	};
+#endif
+
+	template <typename Word, int CRounds, int DRounds>
+	class SipHash
+	{
+		// https://www.aumasson.jp/siphash/siphash.pdf
+		// https://github.com/veorq/SipHash
+
+		public:
+			using Byte = uint8_t;
+			using ResultArrayType = std::array<Byte, sizeof(Word)>;
+			using KeyArrayType = std::array<Byte, (2 * sizeof(Word))>;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			explicit constexpr SipHash(const KeyArrayType &key);
+
+			constexpr void reset();
+			constexpr SipHash& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `toUint64()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;
+			constexpr uint64_t toUint64() const;
+
+			constexpr SipHash& addData(const Span<const Byte> inData);
+			constexpr SipHash& addData(const void *ptr, const std::size_t length);
+			template <std::size_t N>
+			constexpr SipHash& addData(const Byte (&array)[N]);
+			template <typename T, std::size_t N>
+			SipHash& addData(const T (&array)[N]);
+			template <typename T>
+			SipHash& addData(const Span<T> inSpan);
+
+			// one-shot, without the streaming state, same result as `toUint64()`
+			static constexpr Word hash(const KeyArrayType &key, const Span<const Byte> data);
+			template <std::size_t N>
+			static constexpr Word hash(const KeyArrayType &key, const Byte (&array)[N]);
+
+			// same as calling `hash()` on each input, inputs are processed in lockstep in SIMD lanes or interleaved
+			// scalar states to overlap their latencies
+			static void hashMany(const KeyArrayType &key, const Span<const Span<const Byte>> inputs, const Span<Word> outputs);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// restore into an instance constructed with the same key, the snapshot is as secret as the key
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			struct State
+			{
+				Word v[4];
+			};
+
+			static constexpr int WORD_SIZE = sizeof(Word);
+			static constexpr int LANES = 4;
+
+			static constexpr Word loadWord(const Byte *ptr);
+			static constexpr Word loadPartialWord(const Byte *ptr, const int length);
+			static constexpr Word rotl(const Word x, const unsigned int s);
+			static constexpr State initState(const KeyArrayType &key);
+			static constexpr void round(State &s);
+			static constexpr void compress(State &s, const Word m);
+			static constexpr Word finish(State &s, const Word lastBlock);
+			static constexpr Word output(const State &s);
+#if defined(__AVX2__) || defined(__AVX512F__)
+			template <typename Ops>
+			static void roundSimd(typename Ops::Vector (&v)[4]);
+			template <typename Ops>
+			static void hashManySimd(const State &init, const Span<const Byte> *inputs, Word *outputs);
+#endif
+			static constexpr Word lastBlock(const Byte *tail, const std::size_t length);
+
+			KeyArrayType m_key = {};
+			State m_state = {};
+			Byte m_buffer[sizeof(Word)] = {};
+			std::size_t m_bufferSize = 0;
+			uint64_t m_totalLength = 0;
+			Word m_result = 0;
+	};
+
+
+	//
+	template <typename Word, int CRounds, int DRounds>
+	constexpr SipHash<Word, CRounds, DRounds>::SipHash(const KeyArrayType &key)
+		: m_key(key)
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+		static_assert((std::is_same<Word, uint64_t>::value || std::is_same<Word, uint32_t>::value), "");
+		reset();
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr void SipHash<Word, CRounds, DRounds>::reset()
+	{
+		m_state = initState(m_key);
+		m_bufferSize = 0;
+		m_totalLength = 0;
+		m_result = 0;
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr SipHash<Word, CRounds, DRounds>& SipHash<Word, CRounds, DRounds>::finalize()
+	{
+		// operate on a copy, `m_state` stays as it was
+		State s = m_state;
+		m_result = finish(s, lastBlock(m_buffer, static_cast<std::size_t>(m_totalLength)));
+		return (*this);
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	std::string SipHash<Word, CRounds, DRounds>::toString() const
+	{
+		const auto a = toArray();
+		std::string ret;
+		ret.resize(2 * a.size());
+
+		auto retPtr = &ret.front();
+		for (const auto c : a)
+		{
+			const Byte upper = static_cast<Byte>(c >> 4);
+			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
+
+			const Byte lower = c & 0xf;
+			*(retPtr++) = static_cast<char>((lower < 10) ? (lower + '0') : (lower - 10 + 'a'));
+		}
+
+		return ret;
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	std::vector<typename SipHash<Word, CRounds, DRounds>::Byte> SipHash<Word, CRounds, DRounds>::toVector() const
+	{
+		const auto a = toArray();
+		return {a.begin(), a.end()};
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	CONSTEXPR_CPP17_CHOCOBO1_HASH typename SipHash<Word, CRounds, DRounds>::ResultArrayType SipHash<Word, CRounds, DRounds>::toArray() const
+	{
+		// little-endian, same as the reference implementation
+		ResultArrayType ret {};
+		auto retPtr = ret.data();
+		for (int j = 0; j < WORD_SIZE; ++j)
+			*(retPtr++) = static_cast<Byte>(m_result >> (j * 8));
+
+		return ret;
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr uint64_t SipHash<Word, CRounds, DRounds>::toUint64() const
+	{
+		return m_result;
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr SipHash<Word, CRounds, DRounds>& SipHash<Word, CRounds, DRounds>::addData(const Span<const Byte> inData)
+	{
+		const Byte *ptr = inData.data();
+		std::size_t length = static_cast<std::size_t>(inData.size());
+		m_totalLength += length;
+
+		if (m_bufferSize > 0)
+		{
+			while ((m_bufferSize < sizeof(Word)) && (length > 0))
+			{
+				m_buffer[m_bufferSize++] = *(ptr++);
+				--length;
+			}
+			if (m_bufferSize < sizeof(Word))
+				return (*this);
+
+			compress(m_state, loadWord(m_buffer));
+			m_bufferSize = 0;
+		}
+
+		for (; length >= sizeof(Word); length -= sizeof(Word))
+		{
+			compress(m_state, loadWord(ptr));
+			ptr += sizeof(Word);
+		}
+
+		for (std::size_t i = 0; i < length; ++i)
+			m_buffer[i] = ptr[i];
+		m_bufferSize = length;
+
+		return (*this);
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr SipHash<Word, CRounds, DRounds>& SipHash<Word, CRounds, DRounds>::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	template <std::size_t N>
+	constexpr SipHash<Word, CRounds, DRounds>& SipHash<Word, CRounds, DRounds>::addData(const Byte (&array)[N])
+	{
+		return addData({array, N});
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	template <typename T, std::size_t N>
+	SipHash<Word, CRounds, DRounds>& SipHash<Word, CRounds, DRounds>::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	template <typename T>
+	SipHash<Word, CRounds, DRounds>& SipHash<Word, CRounds, DRounds>::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr Word SipHash<Word, CRounds, DRounds>::hash(const KeyArrayType &key, const Span<const Byte> data)
+	{
+		const Byte *ptr = data.data();
+		const std::size_t length = static_cast<std::size_t>(data.size());
+		const std::size_t end = length - (length % sizeof(Word));
+
+		State s = initState(key);
+		for (std::size_t i = 0; i < end; i += sizeof(Word))
+			compress(s, loadWord(ptr + i));
+		return finish(s, lastBlock((ptr + end), length));
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	template <std::size_t N>
+	constexpr Word SipHash<Word, CRounds, DRounds>::hash(const KeyArrayType &key, const Byte (&array)[N])
+	{
+		return hash(key, {array, N});
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	void SipHash<Word, CRounds, DRounds>::hashMany(const KeyArrayType &key, const Span<const Span<const Byte>> inputs, const Span<Word> outputs)
+	{
+		if (inputs.size() != outputs.size())
+			throw std::invalid_argument("SipHash::hashMany: inputs & outputs must have the same size");
+
+		const std::size_t count = static_cast<std::size_t>(inputs.size());
+		const State init = initState(key);
+
+		std::size_t i = 0;
+#if defined(__AVX512F__)
+		using SimdOps = Avx512Ops<Word>;
+#elif defined(__AVX2__)
+		using SimdOps = Avx2Ops<Word>;
+#endif
+#if defined(__AVX2__) || defined(__AVX512F__)
+		const std::size_t simdLanes = SimdOps::LANES;
+		for (; (i + simdLanes) <= count; i += simdLanes)
+			hashManySimd<SimdOps>(init, (inputs.data() + i), (outputs.data() + i));
+#endif
+
+		for (; (i + LANES) <= count; i += LANES)
+		{
+			// separate variables instead of an array, so the compiler keeps all states in registers
+			State s0 = init;
+			State s1 = init;
+			State s2 = init;
+			State s3 = init;
+			const auto forEachLane = [&s0, &s1, &s2, &s3](const auto &func)
+			{
+				func(s0, 0);
+				func(s1, 1);
+				func(s2, 2);
+				func(s3, 3);
+			};
+
+			const Byte *ptr[LANES] = {};
+			std::size_t length[LANES] = {};
+			std::size_t blocks[LANES] = {};
+			for (int lane = 0; lane < LANES; ++lane)
+			{
+				ptr[lane] = inputs[i + lane].data();
+				length[lane] = static_cast<std::size_t>(inputs[i + lane].size());
+				blocks[lane] = length[lane] / sizeof(Word);
+			}
+
+			// the blocks common to all lanes, then the leftovers one lane at a time
+			const std::size_t common = std::min(std::min(blocks[0], blocks[1]), std::min(blocks[2], blocks[3]));
+			for (std::size_t b = 0; b < common; ++b)
+			{
+				Word m[LANES] = {};
+				forEachLane([&m, &ptr, b](State &s, const int lane)
+				{
+					m[lane] = loadWord(ptr[lane] + (b * sizeof(Word)));
+					s.v[3] ^= m[lane];
+				});
+				for (int r = 0; r < CRounds; ++r)
+					forEachLane([](State &s, const int) { round(s); });
+				forEachLane([&m](State &s, const int lane) { s.v[0] ^= m[lane]; });
+			}
+			forEachLane([&ptr, &blocks, common](State &s, const int lane)
+			{
+				for (std::size_t b = common; b < blocks[lane]; ++b)
+					compress(s, loadWord(ptr[lane] + (b * sizeof(Word))));
+			});
+
+			// finalization dominates for short inputs, it is done in lockstep
+			Word last[LANES] = {};
+			forEachLane([&last, &ptr, &length, &blocks](State &s, const int lane)
+			{
+				last[lane] = lastBlock((ptr[lane] + (blocks[lane] * sizeof(Word))), length[lane]);
+				s.v[3] ^= last[lane];
+			});
+			for (int r = 0; r < CRounds; ++r)
+				forEachLane([](State &s, const int) { round(s); });
+			forEachLane([&last](State &s, const int lane)
+			{
+				s.v[0] ^= last[lane];
+				s.v[2] ^= 0xff;
+			});
+			for (int r = 0; r < DRounds; ++r)
+				forEachLane([](State &s, const int) { round(s); });
+			forEachLane([&outputs, i](State &s, const int lane)
+			{
+				outputs[i + static_cast<std::size_t>(lane)] = output(s);
+			});
+		}
+
+		for (; i < count; ++i)
+			outputs[i] = hash(key, inputs[i]);
+	}
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+	template <typename Word, int CRounds, int DRounds>
+	template <typename Ops>
+	void SipHash<Word, CRounds, DRounds>::roundSimd(typename Ops::Vector (&v)[4])
+	{
+		v[0] = Ops::add(v[0], v[1]);
+		v[1] = Ops::template rotl<Constants<Word>::ROTATE0>(v[1]);
+		v[1] = Ops::xor_(v[1], v[0]);
+		v[0] = Ops::template rotl<Constants<Word>::ROTATE1>(v[0]);
+		v[2] = Ops::add(v[2], v[3]);
+		v[3] = Ops::template rotl<Constants<Word>::ROTATE2>(v[3]);
+		v[3] = Ops::xor_(v[3], v[2]);
+		v[0] = Ops::add(v[0], v[3]);
+		v[3] = Ops::template rotl<Constants<Word>::ROTATE3>(v[3]);
+		v[3] = Ops::xor_(v[3], v[0]);
+		v[2] = Ops::add(v[2], v[1]);
+		v[1] = Ops::template rotl<Constants<Word>::ROTATE4>(v[1]);
+		v[1] = Ops::xor_(v[1], v[2]);
+		v[2] = Ops::template rotl<Constants<Word>::ROTATE5>(v[2]);
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	template <typename Ops>
+	void SipHash<Word, CRounds, DRounds>::hashManySimd(const State &init, const Span<const Byte> *inputs, Word *outputs)
+	{
+		// hashes `Ops::LANES` inputs
+		const int lanes = Ops::LANES;
+
+		const Byte *ptr[lanes] = {};
+		std::size_t length[lanes] = {};
+		std::size_t blocks[lanes] = {};
+		std::size_t common = SIZE_MAX;
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			ptr[lane] = inputs[lane].data();
+			length[lane] = static_cast<std::size_t>(inputs[lane].size());
+			blocks[lane] = length[lane] / sizeof(Word);
+			common = std::min(common, blocks[lane]);
+		}
+
+		typename Ops::Vector v[4] = {Ops::set1(init.v[0]), Ops::set1(init.v[1]), Ops::set1(init.v[2]), Ops::set1(init.v[3])};
+		Word m[lanes] = {};
+		for (std::size_t b = 0; b < common; ++b)
+		{
+			for (int lane = 0; lane < lanes; ++lane)
+				m[lane] = loadWord(ptr[lane] + (b * sizeof(Word)));
+			const typename Ops::Vector mv = Ops::load(m);
+
+			v[3] = Ops::xor_(v[3], mv);
+			for (int r = 0; r < CRounds; ++r)
+				roundSimd<Ops>(v);
+			v[0] = Ops::xor_(v[0], mv);
+		}
+
+		// lanes with more blocks continue on their own
+		bool uneven = false;
+		for (int lane = 0; lane < lanes; ++lane)
+			uneven |= (blocks[lane] != common);
+		if (uneven)
+		{
+			Word words[4][lanes] = {};
+			for (int j = 0; j < 4; ++j)
+				Ops::store(words[j], v[j]);
+			for (int lane = 0; lane < lanes; ++lane)
+			{
+				State s = {{words[0][lane], words[1][lane], words[2][lane], words[3][lane]}};
+				for (std::size_t b = common; b < blocks[lane]; ++b)
+					compress(s, loadWord(ptr[lane] + (b * sizeof(Word))));
+				for (int j = 0; j < 4; ++j)
+					words[j][lane] = s.v[j];
+			}
+			for (int j = 0; j < 4; ++j)
+				v[j] = Ops::load(words[j]);
+		}
+
+		for (int lane = 0; lane < lanes; ++lane)
+			m[lane] = lastBlock((ptr[lane] + (blocks[lane] * sizeof(Word))), length[lane]);
+		const typename Ops::Vector mv = Ops::load(m);
+
+		v[3] = Ops::xor_(v[3], mv);
+		for (int r = 0; r < CRounds; ++r)
+			roundSimd<Ops>(v);
+		v[0] = Ops::xor_(v[0], mv);
+		v[2] = Ops::xor_(v[2], Ops::set1(0xff));
+		for (int r = 0; r < DRounds; ++r)
+			roundSimd<Ops>(v);
+
+		// HalfSipHash returns `v1 ^ v3`
+		const typename Ops::Vector result = std::is_same<Word, uint64_t>::value
+			? Ops::xor_(Ops::xor_(v[0], v[1]), Ops::xor_(v[2], v[3]))
+			: Ops::xor_(v[1], v[3]);
+		Ops::store(outputs, result);
+	}
+#endif
+
+	template <typename Word, int CRounds, int DRounds>
+	std::vector<typename SipHash<Word, CRounds, DRounds>::Byte> SipHash<Word, CRounds, DRounds>::serialize() const
+	{
+		StateWriter writer("SipHash_" + std::to_string(WORD_SIZE * 8) + "_" + std::to_string(CRounds) + "_" + std::to_string(DRounds));
+		for (const auto word : m_state.v)
+			writer.put(word);
+		writer.put(m_totalLength);
+		writer.put(static_cast<uint32_t>(m_bufferSize));
+		writer.put(m_buffer, m_bufferSize);
+		return writer.data();
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	bool SipHash<Word, CRounds, DRounds>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "SipHash_" + std::to_string(WORD_SIZE * 8) + "_" + std::to_string(CRounds) + "_" + std::to_string(DRounds));
+		State state = {};
+		for (auto &word : state.v)
+			word = reader.get<Word>();
+		const uint64_t totalLength = reader.get<uint64_t>();
+		const uint32_t bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || (bufferSize >= sizeof(Word)) || (bufferSize != (totalLength % sizeof(Word))))
+			return false;
+		Byte buffer[sizeof(Word)] = {};
+		reader.get(buffer, bufferSize);
+		if (!reader.finished())
+			return false;
+
+		m_state = state;
+		m_totalLength = totalLength;
+		std::copy(buffer, (buffer + sizeof(Word)), m_buffer);
+		m_bufferSize = bufferSize;
+		m_result = 0;
+		return true;
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr Word SipHash<Word, CRounds, DRounds>::loadWord(const Byte *ptr)
+	{
+		// handle specific endianness here
+		const auto load32 = [](const Byte *p) -> uint64_t
+		{
+			return ( (static_cast<uint64_t>(*(p + 0)) <<  0)
+				| (static_cast<uint64_t>(*(p + 1)) <<  8)
+				| (static_cast<uint64_t>(*(p + 2)) << 16)
+				| (static_cast<uint64_t>(*(p + 3)) << 24));
+		};
+		if (sizeof(Word) == 4)
+			return static_cast<Word>(load32(ptr));
+		return static_cast<Word>(load32(ptr) | (load32(ptr + 4) << 32));
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr Word SipHash<Word, CRounds, DRounds>::loadPartialWord(const Byte *ptr, const int length)
+	{
+		Word ret = 0;
+		for (int i = (length - 1); i >= 0; --i)
+			ret = static_cast<Word>((ret << 8) | ptr[i]);
+		return ret;
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr Word SipHash<Word, CRounds, DRounds>::rotl(const Word x, const unsigned int s)
+	{
+		return ((x << s) | (x >> ((sizeof(Word) * 8) - s)));
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr typename SipHash<Word, CRounds, DRounds>::State SipHash<Word, CRounds, DRounds>::initState(const KeyArrayType &key)
+	{
+		const Word k0 = loadWord(key.data());
+		const Word k1 = loadWord(key.data() + sizeof(Word));
+		return {{
+			static_cast<Word>(k0 ^ Constants<Word>::INIT0), static_cast<Word>(k1 ^ Constants<Word>::INIT1)
+			, static_cast<Word>(k0 ^ Constants<Word>::INIT2), static_cast<Word>(k1 ^ Constants<Word>::INIT3)
+		}};
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr void SipHash<Word, CRounds, DRounds>::round(State &s)
+	{
+		s.v[0] += s.v[1];
+		s.v[1] = rotl(s.v[1], Constants<Word>::ROTATE0);
+		s.v[1] ^= s.v[0];
+		s.v[0] = rotl(s.v[0], Constants<Word>::ROTATE1);
+		s.v[2] += s.v[3];
+		s.v[3] = rotl(s.v[3], Constants<Word>::ROTATE2);
+		s.v[3] ^= s.v[2];
+		s.v[0] += s.v[3];
+		s.v[3] = rotl(s.v[3], Constants<Word>::ROTATE3);
+		s.v[3] ^= s.v[0];
+		s.v[2] += s.v[1];
+		s.v[1] = rotl(s.v[1], Constants<Word>::ROTATE4);
+		s.v[1] ^= s.v[2];
+		s.v[2] = rotl(s.v[2], Constants<Word>::ROTATE5);
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr void SipHash<Word, CRounds, DRounds>::compress(State &s, const Word m)
+	{
+		s.v[3] ^= m;
+		for (int r = 0; r < CRounds; ++r)
+			round(s);
+		s.v[0] ^= m;
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr Word SipHash<Word, CRounds, DRounds>::finish(State &s, const Word last)
+	{
+		compress(s, last);
+		s.v[2] ^= 0xff;
+		for (int r = 0; r < DRounds; ++r)
+			round(s);
+		return output(s);
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr Word SipHash<Word, CRounds, DRounds>::output(const State &s)
+	{
+		// HalfSipHash returns `v1 ^ v3`
+		return std::is_same<Word, uint64_t>::value
+			? (s.v[0] ^ s.v[1] ^ s.v[2] ^ s.v[3])
+			: (s.v[1] ^ s.v[3]);
+	}
+
+	template <typename Word, int CRounds, int DRounds>
+	constexpr Word SipHash<Word, CRounds, DRounds>::lastBlock(const Byte *tail, const std::size_t length)
+	{
+		// the remaining bytes, with the lowest byte of the total length on top
+		const int tailSize = static_cast<int>(length % sizeof(Word));
+		return (loadPartialWord(tail, tailSize) | (static_cast<Word>(length & 0xff) << ((sizeof(Word) - 1) * 8)));
+	}
+
+
+	template <typename T, typename H>
+	class SipHasher
+	{
+		public:
+			using KeyArrayType = typename H::KeyArrayType;
+
+			SipHasher();
+			explicit SipHasher(const KeyArrayType &key);
+
+			template <typename U = T, typename std::enable_if<(std::is_integral<U>::value || std::is_enum<U>::value || std::is_pointer<U>::value), int>::type = 0>
+			std::size_t operator()(const T &value) const;
+
+			template <typename U = T, typename std::enable_if<!(std::is_integral<U>::value || std::is_enum<U>::value || std::is_pointer<U>::value), int>::type = 0>
+			std::size_t operator()(const T &value) const;
+
+		private:
+			KeyArrayType m_key = {};
+	};
+
+
+	//
+	template <typename T, typename H>
+	SipHasher<T, H>::SipHasher()
+	{
+		// per-instance random key, the hash values are unpredictable to an attacker
+		std::random_device device;
+		for (auto &b : m_key)
+			b = static_cast<typename H::Byte>(device());
+	}
+
+	template <typename T, typename H>
+	SipHasher<T, H>::SipHasher(const KeyArrayType &key)
+		: m_key(key)
+	{
+	}
+
+	template <typename T, typename H>
+	template <typename U, typename std::enable_if<(std::is_integral<U>::value || std::is_enum<U>::value || std::is_pointer<U>::value), int>::type>
+	std::size_t SipHasher<T, H>::operator()(const T &value) const
+	{
+		// fixed size input, the loops are unrolled by the compiler
+		typename H::Byte bytes[sizeof(T)] = {};
+		std::memcpy(bytes, &value, sizeof(T));
+		return static_cast<std::size_t>(H::hash(m_key, bytes));
+	}
+
+	template <typename T, typename H>
+	template <typename U, typename std::enable_if<!(std::is_integral<U>::value || std::is_enum<U>::value || std::is_pointer<U>::value), int>::type>
+	std::size_t SipHasher<T, H>::operator()(const T &value) const
+	{
+		// string types: `std::string`, `std::string_view`, ...
+		return static_cast<std::size_t>(H::hash(m_key, {reinterpret_cast<const typename H::Byte *>(value.data()), (value.size() * sizeof(value[0]))}));
+	}
+}
+}
+	using SipHash_2_4 = Hash::SipHash_NS::SipHash<uint64_t, 2, 4>;
+	using SipHash_1_3 = Hash::SipHash_NS::SipHash<uint64_t, 1, 3>;
+	using HalfSipHash_2_4 = Hash::SipHash_NS::SipHash<uint32_t, 2, 4>;
+	using HalfSipHash_1_3 = Hash::SipHash_NS::SipHash<uint32_t, 1, 3>;
+
+	template <typename T, typename H = SipHash_1_3>
+	using SipHasher = Hash::SipHash_NS::SipHasher<T, H>;
+}
+
+#endif  // CHOCOBO1_SIPHASH_H
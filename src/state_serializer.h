@@ -0,0 +1,158 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_STATE_SERIALIZER_H
+#define CHOCOBO1_STATE_SERIALIZER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+// the `serialize()` & `restore()` snapshots of all hash classes go through these
+
+namespace Hash
+{
+	class StateWriter
+	{
+		// snapshot layout: format version, hash name, NUL, then the fields
+		// integers are stored in little-endian regardless of the host
+		public:
+			explicit StateWriter(const std::string &name)
+			{
+				const uint8_t version = VERSION;
+				m_data.push_back(version);
+				for (const char c : name)
+					m_data.push_back(static_cast<uint8_t>(c));
+				m_data.push_back(0);
+			}
+
+			template <typename T>
+			StateWriter& put(const T value)
+			{
+				static_assert(std::is_unsigned<T>::value, "");
+				for (std::size_t i = 0; i < sizeof(T); ++i)
+					m_data.push_back(static_cast<uint8_t>(value >> (8 * i)));
+				return (*this);
+			}
+
+			StateWriter& put(const uint8_t *data, const std::size_t length)
+			{
+				m_data.insert(m_data.end(), data, (data + length));
+				return (*this);
+			}
+
+			StateWriter& putNested(const std::vector<uint8_t> &snapshot)
+			{
+				// length-prefixed bytes, e.g. the snapshot of a member hash
+				put(static_cast<uint32_t>(snapshot.size()));
+				return put(snapshot.data(), snapshot.size());
+			}
+
+			std::vector<uint8_t> data() const
+			{
+				return m_data;
+			}
+
+			static constexpr uint8_t VERSION = 2;  // 2: 128-bit byte counts are stored in full
+
+		private:
+			std::vector<uint8_t> m_data;
+	};
+
+	class StateReader
+	{
+		// reads what `StateWriter` wrote, any mismatch or overrun turns `ok()` false for good
+		public:
+			StateReader(const uint8_t *data, const std::size_t length, const std::string &name)
+				: m_ptr(data)
+				, m_end(data + length)
+			{
+				const uint8_t version = StateWriter::VERSION;
+				if (get<uint8_t>() != version)
+					m_ok = false;
+
+				uint8_t str[256] = {};
+				get(str, std::min<std::size_t>((name.size() + 1), sizeof(str)));
+				if ((name.size() >= sizeof(str)) || !std::equal(name.begin(), name.end(), str) || (str[name.size()] != 0))
+					m_ok = false;
+			}
+
+			template <typename T>
+			T get()
+			{
+				static_assert(std::is_unsigned<T>::value, "");
+				if (!m_ok || (static_cast<std::size_t>(m_end - m_ptr) < sizeof(T)))
+				{
+					m_ok = false;
+					return 0;
+				}
+
+				T ret = 0;
+				for (std::size_t i = 0; i < sizeof(T); ++i)
+					ret = static_cast<T>(ret | (static_cast<T>(m_ptr[i]) << (8 * i)));
+				m_ptr += sizeof(T);
+				return ret;
+			}
+
+			void get(uint8_t *out, const std::size_t length)
+			{
+				if (!m_ok || (static_cast<std::size_t>(m_end - m_ptr) < length))
+				{
+					m_ok = false;
+					return;
+				}
+
+				std::copy(m_ptr, (m_ptr + length), out);
+				m_ptr += length;
+			}
+
+			std::vector<uint8_t> getNested()
+			{
+				// what `StateWriter::putNested()` wrote
+				const uint32_t length = get<uint32_t>();
+				if (!m_ok || (static_cast<std::size_t>(m_end - m_ptr) < length))
+				{
+					m_ok = false;
+					return {};
+				}
+
+				std::vector<uint8_t> ret(m_ptr, (m_ptr + length));
+				m_ptr += length;
+				return ret;
+			}
+
+			bool ok() const
+			{
+				return m_ok;
+			}
+
+			bool finished() const
+			{
+				// everything was read, nothing more
+				return (m_ok && (m_ptr == m_end));
+			}
+
+		private:
+			const uint8_t *m_ptr = nullptr;
+			const uint8_t *m_end = nullptr;
+			bool m_ok = true;
+	};
+}
+}
+
+#endif  // CHOCOBO1_STATE_SERIALIZER_H
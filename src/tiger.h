@@ -12,12 +12,16 @@
 #ifndef CHOCOBO1_TIGER_H
 #define CHOCOBO1_TIGER_H
 
+#include "state_serializer.h"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <climits>
 #include <cmath>
 #include <cstdint>
 #include <initializer_list>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -51,6 +55,11 @@ namespace Chocobo1
 	// Tiger2_128();
 	// Tiger2_160();
 	// Tiger2_192();
+	//   `peekDigest()` returns the digest of the data so far without finalizing, more data can follow
+	//   `exportState()` & `importState(State)` copy the raw running state, e.g. hash a shared prefix once & fork it per suffix
+	//   `importState()` throws `std::invalid_argument` unless `State::length` is whole blocks & `State::bufferSize` is less than a block
+	//   `compressBlocks(blocks)` feeds whole 64-byte blocks directly: `blocks.size()` must be a multiple of 64 (block-aligned) & no bytes may be pending from `addData()`, otherwise it throws `std::invalid_argument`
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, `restore()` returns false on a malformed snapshot
 }
 
 
@@ -64,7 +73,7 @@ namespace Hash
 #if __cplusplus >= 201703L
 #define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
 #else
-#define CONSTEXPR_CPP17_CHOCOBO1_HASH
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
 #endif
 #endif
 
@@ -182,6 +191,8 @@ namespace Tiger_NS
 			using Byte = uint8_t;
 			using ResultArrayType = std::array<Byte, (D / 8)>;
 
+			static constexpr int BLOCK_SIZE = 64;
+
 #if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
 			template <typename T, std::size_t Extent = std::dynamic_extent>
 			using Span = std::span<T, Extent>;
@@ -190,6 +201,15 @@ namespace Tiger_NS
 			using Span = gsl::span<T, Extent>;
 #endif
 
+			struct State
+			{
+				// everything `importState()` needs to resume hashing
+				std::array<uint64_t, 3> h {};  // chaining value
+				uint64_t length = 0;  // bytes compressed into `h`
+				std::array<Byte, BLOCK_SIZE> buffer {};  // pending bytes, less than a block
+				std::size_t bufferSize = 0;
+			};
+
 
 			constexpr Tiger();
 
@@ -199,6 +219,7 @@ namespace Tiger_NS
 			std::string toString() const;
 			std::vector<Byte> toVector() const;
 			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType toArray() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH ResultArrayType peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
 
 			constexpr Tiger& addData(const Span<const Byte> inData);
 			constexpr Tiger& addData(const void *ptr, const std::size_t length);
@@ -209,11 +230,18 @@ namespace Tiger_NS
 			template <typename T>
 			Tiger& addData(const Span<T> inSpan);
 
+			// raw state access, e.g. hash a shared prefix once & fork it for many suffixes
+			CONSTEXPR_CPP17_CHOCOBO1_HASH State exportState() const;
+			CONSTEXPR_CPP17_CHOCOBO1_HASH void importState(const State &state);
+			constexpr Tiger& compressBlocks(const Span<const Byte> blocks);  // whole blocks only, requires no pending bytes
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
 			constexpr void addDataImpl(const Span<const Byte> data);
 
-			static constexpr int BLOCK_SIZE = 64;
-
 			Buffer<Byte, (BLOCK_SIZE * 2)> m_buffer;  // x2 for paddings
 			uint64_t m_sizeCounter = 0;
 
@@ -440,7 +468,7 @@ namespace Tiger_NS
 		m_buffer.fill((V == 1) ? 1 : (1 << 7));
 
 		// append paddings
-		const size_t len = BLOCK_SIZE - ((m_buffer.size() + 8) % BLOCK_SIZE);
+		const size_t len = (BLOCK_SIZE - ((m_buffer.size() + 8) % BLOCK_SIZE)) % BLOCK_SIZE;
 		m_buffer.fill(0, (len + 8));
 
 		// append size in bits
@@ -502,6 +530,13 @@ namespace Tiger_NS
 		return ret;
 	}
 
+	template <int V, int D>
+	CONSTEXPR_CPP17_CHOCOBO1_HASH typename Tiger<V, D>::ResultArrayType Tiger<V, D>::peekDigest() const
+	{
+		Tiger copy = *this;
+		return copy.finalize().toArray();
+	}
+
 	template <int V, int D>
 	constexpr Tiger<V, D>& Tiger<V, D>::addData(const Span<const Byte> inData)
 	{
@@ -565,6 +600,45 @@ namespace Tiger_NS
 		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
 	}
 
+	template <int V, int D>
+	CONSTEXPR_CPP17_CHOCOBO1_HASH typename Tiger<V, D>::State Tiger<V, D>::exportState() const
+	{
+		State ret;
+		for (int i = 0; i < 3; ++i)
+			ret.h[i] = m_h[i];
+		ret.length = m_sizeCounter;
+		for (std::size_t i = 0; i < m_buffer.size(); ++i)
+			ret.buffer[i] = m_buffer[i];
+		ret.bufferSize = m_buffer.size();
+		return ret;
+	}
+
+	template <int V, int D>
+	CONSTEXPR_CPP17_CHOCOBO1_HASH void Tiger<V, D>::importState(const State &state)
+	{
+		if (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE))
+			throw std::invalid_argument("Tiger: importState() needs less than a block of pending bytes");
+		if ((state.length % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("Tiger: importState() needs a length of whole blocks");
+
+		for (int i = 0; i < 3; ++i)
+			m_h[i] = state.h[i];
+		m_sizeCounter = state.length;
+		m_buffer = {state.buffer.begin(), (state.buffer.begin() + state.bufferSize)};
+	}
+
+	template <int V, int D>
+	constexpr Tiger<V, D>& Tiger<V, D>::compressBlocks(const Span<const Byte> blocks)
+	{
+		if (!m_buffer.empty())
+			throw std::invalid_argument("Tiger: compressBlocks() called with bytes pending from addData()");
+		if ((blocks.size() % BLOCK_SIZE) != 0)
+			throw std::invalid_argument("Tiger: compressBlocks() takes whole blocks only");
+
+		addDataImpl(blocks);
+		return (*this);
+	}
+
 	template <int V, int D>
 	constexpr void Tiger<V, D>::addDataImpl(const Span<const Byte> data)
 	{
@@ -642,6 +716,39 @@ namespace Tiger_NS
 			m_h[2] = c + cc;
 		}
 	}
+
+	template <int V, int D>
+	std::vector<typename Tiger<V, D>::Byte> Tiger<V, D>::serialize() const
+	{
+		const State state = exportState();
+
+		StateWriter writer("Tiger" + std::to_string(V) + "_" + std::to_string(D));
+		for (const auto word : state.h)
+			writer.put(word);
+		writer.put(state.length);
+		writer.put(static_cast<uint32_t>(state.bufferSize));
+		writer.put(state.buffer.data(), state.bufferSize);
+		return writer.data();
+	}
+
+	template <int V, int D>
+	bool Tiger<V, D>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "Tiger" + std::to_string(V) + "_" + std::to_string(D));
+		State state;
+		for (auto &word : state.h)
+			word = reader.get<uint64_t>();
+		state.length = reader.get<uint64_t>();
+		state.bufferSize = reader.get<uint32_t>();
+		if (!reader.ok() || ((state.length % BLOCK_SIZE) != 0) || (state.bufferSize >= static_cast<std::size_t>(BLOCK_SIZE)))
+			return false;
+		reader.get(state.buffer.data(), state.bufferSize);
+		if (!reader.finished())
+			return false;
+
+		importState(state);
+		return true;
+	}
 }
 }
 	using Tiger1_128 = Hash::Tiger_NS::Tiger<1, 128>;
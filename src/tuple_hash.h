@@ -13,9 +13,9 @@
 #define CHOCOBO1_TUPLE_HASH_H
 
 #include "cshake.h"
+#include "state_serializer.h"
 
 #include <climits>
-#include <cmath>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -44,6 +44,7 @@ namespace Chocobo1
 	// Use these!!
 	// TupleHash_128(const int digestLengthInBytes, const std::string &customize = {});
 	// TupleHash_256(const int digestLengthInBytes, const std::string &customize = {});
+	//   `serialize()` & `restore(snapshot)` save & resume the running state as versioned, endian-stable bytes, restore into an instance constructed with the same parameters
 }
 
 
@@ -88,6 +89,11 @@ namespace TupleHash_NS
 			template <typename T>
 			TupleHash& nextData(const Span<T> inSpan);
 
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			// restore into an instance constructed with the same parameters
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
 		private:
 			constexpr void addDataImpl(const Span<const Byte> data);
 
@@ -97,17 +103,19 @@ namespace TupleHash_NS
 
 
 	// helpers
-	const auto rightEncode = [](const uint64_t value) -> Buffer<uint8_t, sizeof(value)>
+	constexpr Buffer<uint8_t, (sizeof(uint64_t) + 1)> rightEncode(const uint64_t value)
 	{
-		const uint8_t n = (value == 0) ? 1 : static_cast<uint8_t>(std::lround((std::log2(value) / 8) + 0.5));
+		uint8_t n = 1;
+		while ((n < sizeof(value)) && ((value >> (8 * n)) != 0))
+			++n;
 
-		Buffer<uint8_t, sizeof(value)> ret;
+		Buffer<uint8_t, (sizeof(uint64_t) + 1)> ret;
 		for (int i = (n - 1); i >= 0; --i)
 			ret.fill(Chocobo1::Hash::CShake_NS::ror<uint8_t>(value, (8 * i)));
 		ret.fill(n);
 
 		return ret;
-	};
+	}
 
 
 	//
@@ -184,6 +192,25 @@ namespace TupleHash_NS
 		return nextData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
 	}
 
+	template <typename Alg>
+	std::vector<typename TupleHash<Alg>::Byte> TupleHash<Alg>::serialize() const
+	{
+		StateWriter writer("TupleHash");
+		writer.putNested(m_cshake.serialize());
+		return writer.data();
+	}
+
+	template <typename Alg>
+	bool TupleHash<Alg>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "TupleHash");
+		const std::vector<Byte> running = reader.getNested();
+		if (!reader.finished())
+			return false;
+
+		return m_cshake.restore({running.data(), running.size()});
+	}
+
 	template <typename Alg>
 	constexpr void TupleHash<Alg>::addDataImpl(const Span<const Byte> data)
 	{
@@ -0,0 +1,878 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2017-2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_XXH3_H
+#define CHOCOBO1_XXH3_H
+
+#include "state_serializer.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if (__cplusplus > 201703L)
+#include <version>
+#endif
+
+#ifndef USE_STD_SPAN_CHOCOBO1_HASH
+#if (__cpp_lib_span >= 202002L)
+#define USE_STD_SPAN_CHOCOBO1_HASH 1
+#else
+#define USE_STD_SPAN_CHOCOBO1_HASH 0
+#endif
+#endif
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+#include <span>
+#else
+#include "gsl/span"
+#endif
+
+#if defined(__SSE2__) || defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+
+namespace Chocobo1
+{
+	// Use these!!
+	// XXH3_64();
+	// XXH3_128();
+	// XXH3_64(const uint64_t seed);
+	// XXH3_128(const uint64_t seed);
+	//   non-cryptographic, for hash tables, deduplication & checksums, `toUint64()` gives the digest as an integer
+}
+
+
+namespace Chocobo1
+{
+// users should ignore things in this namespace
+
+namespace Hash
+{
+#ifndef CONSTEXPR_CPP17_CHOCOBO1_HASH
+#if __cplusplus >= 201703L
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH constexpr
+#else
+#define CONSTEXPR_CPP17_CHOCOBO1_HASH inline
+#endif
+#endif
+
+
+namespace XXH3_NS
+{
+	// helpers
+	inline uint32_t readLE32(const uint8_t *ptr)
+	{
+		return ( (static_cast<uint32_t>(*(ptr + 0)) <<  0)
+			| (static_cast<uint32_t>(*(ptr + 1)) <<  8)
+			| (static_cast<uint32_t>(*(ptr + 2)) << 16)
+			| (static_cast<uint32_t>(*(ptr + 3)) << 24));
+	}
+
+	inline uint64_t readLE64(const uint8_t *ptr)
+	{
+		return (static_cast<uint64_t>(readLE32(ptr)) | (static_cast<uint64_t>(readLE32(ptr + 4)) << 32));
+	}
+
+	inline void writeLE64(uint8_t *ptr, const uint64_t x)
+	{
+		for (int i = 0; i < 8; ++i)
+			ptr[i] = static_cast<uint8_t>(x >> (i * 8));
+	}
+
+	inline uint32_t swap32(const uint32_t x)
+	{
+		return ((x << 24) | ((x << 8) & 0x00FF0000) | ((x >> 8) & 0x0000FF00) | (x >> 24));
+	}
+
+	inline uint64_t swap64(const uint64_t x)
+	{
+		return ((static_cast<uint64_t>(swap32(static_cast<uint32_t>(x))) << 32) | swap32(static_cast<uint32_t>(x >> 32)));
+	}
+
+	template <typename T>
+	T rotl(const T x, const unsigned int s)
+	{
+		static_assert(std::is_unsigned<T>::value, "");
+		return ((x << s) | (x >> ((sizeof(T) * 8) - s)));
+	}
+
+	struct Uint128
+	{
+		uint64_t low;
+		uint64_t high;
+	};
+
+	inline Uint128 mult64to128(const uint64_t a, const uint64_t b)
+	{
+#if defined(__SIZEOF_INT128__)
+		__extension__ typedef unsigned __int128 NativeUint128;
+		const NativeUint128 product = static_cast<NativeUint128>(a) * b;
+		return {static_cast<uint64_t>(product), static_cast<uint64_t>(product >> 64)};
+#else
+		const uint64_t loLo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+		const uint64_t hiLo = (a >> 32) * (b & 0xFFFFFFFF);
+		const uint64_t loHi = (a & 0xFFFFFFFF) * (b >> 32);
+		const uint64_t hiHi = (a >> 32) * (b >> 32);
+		const uint64_t cross = (loLo >> 32) + (hiLo & 0xFFFFFFFF) + loHi;
+		return {((cross << 32) | (loLo & 0xFFFFFFFF)), (hiHi + (hiLo >> 32) + (cross >> 32))};
+#endif
+	}
+
+	inline uint64_t mult128fold64(const uint64_t a, const uint64_t b)
+	{
+		const Uint128 product = mult64to128(a, b);
+		return (product.low ^ product.high);
+	}
+
+	// stripe kernels: 8 accumulators of 64 bits each, a stripe is 64 bytes of input
+	struct ScalarOps
+	{
+		static void accumulate(uint64_t *acc, const uint8_t *input, const uint8_t *secret, const std::size_t stripes)
+		{
+			for (std::size_t s = 0; s < stripes; ++s)
+			{
+				const uint8_t *in = input + (s * 64);
+				const uint8_t *key = secret + (s * 8);
+				for (int i = 0; i < 8; ++i)
+				{
+					const uint64_t data = readLE64(in + (i * 8));
+					const uint64_t dataKey = data ^ readLE64(key + (i * 8));
+					acc[i ^ 1] += data;
+					acc[i] += (dataKey & 0xFFFFFFFF) * (dataKey >> 32);
+				}
+			}
+		}
+
+		static void scramble(uint64_t *acc, const uint8_t *secret)
+		{
+			for (int i = 0; i < 8; ++i)
+			{
+				uint64_t a = acc[i];
+				a ^= (a >> 47);
+				a ^= readLE64(secret + (i * 8));
+				a *= 0x9E3779B1;
+				acc[i] = a;
+			}
+		}
+	};
+
+#if defined(__SSE2__)
+	struct Sse2Ops
+	{
+		static void accumulate(uint64_t *acc, const uint8_t *input, const uint8_t *secret, const std::size_t stripes)
+		{
+			__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(acc));
+			__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(acc) + 1);
+			__m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(acc) + 2);
+			__m128i a3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(acc) + 3);
+
+			const auto lane = [](const __m128i sum, const __m128i data, const __m128i key) -> __m128i
+			{
+				const __m128i dataKey = _mm_xor_si128(data, key);
+				const __m128i product = _mm_mul_epu32(dataKey, _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+				return _mm_add_epi64(sum, _mm_add_epi64(product, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+			};
+			for (std::size_t s = 0; s < stripes; ++s)
+			{
+				const __m128i *in = reinterpret_cast<const __m128i *>(input + (s * 64));
+				const __m128i *key = reinterpret_cast<const __m128i *>(secret + (s * 8));
+				a0 = lane(a0, _mm_loadu_si128(in), _mm_loadu_si128(key));
+				a1 = lane(a1, _mm_loadu_si128(in + 1), _mm_loadu_si128(key + 1));
+				a2 = lane(a2, _mm_loadu_si128(in + 2), _mm_loadu_si128(key + 2));
+				a3 = lane(a3, _mm_loadu_si128(in + 3), _mm_loadu_si128(key + 3));
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(acc), a0);
+			_mm_storeu_si128((reinterpret_cast<__m128i *>(acc) + 1), a1);
+			_mm_storeu_si128((reinterpret_cast<__m128i *>(acc) + 2), a2);
+			_mm_storeu_si128((reinterpret_cast<__m128i *>(acc) + 3), a3);
+		}
+
+		static void scramble(uint64_t *acc, const uint8_t *secret)
+		{
+			const __m128i prime = _mm_set1_epi32(static_cast<int>(0x9E3779B1));
+			for (int i = 0; i < 4; ++i)
+			{
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(acc) + i);
+				const __m128i key = _mm_loadu_si128(reinterpret_cast<const __m128i *>(secret) + i);
+				const __m128i dataKey = _mm_xor_si128(_mm_xor_si128(a, _mm_srli_epi64(a, 47)), key);
+				const __m128i productLow = _mm_mul_epu32(dataKey, prime);
+				const __m128i productHigh = _mm_mul_epu32(_mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+				_mm_storeu_si128((reinterpret_cast<__m128i *>(acc) + i), _mm_add_epi64(productLow, _mm_slli_epi64(productHigh, 32)));
+			}
+		}
+	};
+#endif
+
+#if defined(__AVX2__)
+	struct Avx2Ops
+	{
+		static void accumulate(uint64_t *acc, const uint8_t *input, const uint8_t *secret, const std::size_t stripes)
+		{
+			__m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc));
+			__m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc) + 1);
+
+			const auto lane = [](const __m256i sum, const __m256i data, const __m256i key) -> __m256i
+			{
+				const __m256i dataKey = _mm256_xor_si256(data, key);
+				const __m256i product = _mm256_mul_epu32(dataKey, _mm256_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+				return _mm256_add_epi64(sum, _mm256_add_epi64(product, _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+			};
+			for (std::size_t s = 0; s < stripes; ++s)
+			{
+				const __m256i *in = reinterpret_cast<const __m256i *>(input + (s * 64));
+				const __m256i *key = reinterpret_cast<const __m256i *>(secret + (s * 8));
+				a0 = lane(a0, _mm256_loadu_si256(in), _mm256_loadu_si256(key));
+				a1 = lane(a1, _mm256_loadu_si256(in + 1), _mm256_loadu_si256(key + 1));
+			}
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(acc), a0);
+			_mm256_storeu_si256((reinterpret_cast<__m256i *>(acc) + 1), a1);
+		}
+
+		static void scramble(uint64_t *acc, const uint8_t *secret)
+		{
+			const __m256i prime = _mm256_set1_epi32(static_cast<int>(0x9E3779B1));
+			for (int i = 0; i < 2; ++i)
+			{
+				const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc) + i);
+				const __m256i key = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(secret) + i);
+				const __m256i dataKey = _mm256_xor_si256(_mm256_xor_si256(a, _mm256_srli_epi64(a, 47)), key);
+				const __m256i productLow = _mm256_mul_epu32(dataKey, prime);
+				const __m256i productHigh = _mm256_mul_epu32(_mm256_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+				_mm256_storeu_si256((reinterpret_cast<__m256i *>(acc) + i), _mm256_add_epi64(productLow, _mm256_slli_epi64(productHigh, 32)));
+			}
+		}
+	};
+#endif
+
+#if defined(__AVX512F__)
+	struct Avx512Ops
+	{
+		static void accumulate(uint64_t *acc, const uint8_t *input, const uint8_t *secret, const std::size_t stripes)
+		{
+			__m512i a = _mm512_loadu_si512(acc);
+			for (std::size_t s = 0; s < stripes; ++s)
+			{
+				const __m512i data = _mm512_loadu_si512(input + (s * 64));
+				const __m512i dataKey = _mm512_xor_si512(data, _mm512_loadu_si512(secret + (s * 8)));
+				const __m512i product = _mm512_mul_epu32(dataKey, _mm512_shuffle_epi32(dataKey, static_cast<_MM_PERM_ENUM>(_MM_SHUFFLE(0, 3, 0, 1))));
+				a = _mm512_add_epi64(a, _mm512_add_epi64(product, _mm512_shuffle_epi32(data, static_cast<_MM_PERM_ENUM>(_MM_SHUFFLE(1, 0, 3, 2)))));
+			}
+			_mm512_storeu_si512(acc, a);
+		}
+
+		static void scramble(uint64_t *acc, const uint8_t *secret)
+		{
+			const __m512i prime = _mm512_set1_epi32(static_cast<int>(0x9E3779B1));
+			const __m512i a = _mm512_loadu_si512(acc);
+			// a ^ (a >> 47) ^ key
+			const __m512i dataKey = _mm512_ternarylogic_epi32(a, _mm512_srli_epi64(a, 47), _mm512_loadu_si512(secret), 0x96);
+			const __m512i productLow = _mm512_mul_epu32(dataKey, prime);
+			const __m512i productHigh = _mm512_mul_epu32(_mm512_shuffle_epi32(dataKey, static_cast<_MM_PERM_ENUM>(_MM_SHUFFLE(0, 3, 0, 1))), prime);
+			_mm512_storeu_si512(acc, _mm512_add_epi64(productLow, _mm512_slli_epi64(productHigh, 32)));
+		}
+	};
+#endif
+
+#if defined(__AVX512F__)
+	using StripeOps = Avx512Ops;
+#elif defined(__AVX2__)
+	using StripeOps = Avx2Ops;
+#elif defined(__SSE2__)
+	using StripeOps = Sse2Ops;
+#else
+	using StripeOps = ScalarOps;
+#endif
+
+	template <int Bits>
+	class XXH3
+	{
+		// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+		// inputs up to 240 bytes take the dedicated short paths, longer inputs are processed in 64-byte stripes
+
+		static_assert(((Bits == 64) || (Bits == 128)), "XXH3 is defined for 64 or 128 bits");
+
+		public:
+			using Byte = uint8_t;
+			using ResultArrayType = std::array<Byte, (Bits / 8)>;
+
+#if (USE_STD_SPAN_CHOCOBO1_HASH == 1)
+			template <typename T, std::size_t Extent = std::dynamic_extent>
+			using Span = std::span<T, Extent>;
+#else
+			template <typename T, std::size_t Extent = gsl::dynamic_extent>
+			using Span = gsl::span<T, Extent>;
+#endif
+
+
+			explicit XXH3(const uint64_t seed = 0);
+
+			void reset();
+			XXH3& finalize();  // after this, only `toArray()`, `toString()`, `toVector()`, `toUint64()`, `reset()` are available
+
+			std::string toString() const;
+			std::vector<Byte> toVector() const;
+			ResultArrayType toArray() const;
+			ResultArrayType peekDigest() const;  // digest of the data added so far, the running state is untouched & more data can follow
+			uint64_t toUint64() const;  // the digest as an integer, the lower half for the 128-bit variant
+
+			XXH3& addData(const Span<const Byte> inData);
+			XXH3& addData(const void *ptr, const std::size_t length);
+			template <std::size_t N>
+			XXH3& addData(const Byte (&array)[N]);
+			template <typename T, std::size_t N>
+			XXH3& addData(const T (&array)[N]);
+			template <typename T>
+			XXH3& addData(const Span<T> inSpan);
+
+			// versioned & endian-stable snapshot of the running state, `restore()` it later & keep adding data
+			std::vector<Byte> serialize() const;
+			bool restore(const Span<const Byte> snapshot);  // returns false & keeps the current state if `snapshot` is malformed or from another hash
+
+		private:
+			static constexpr std::size_t STRIPE_SIZE = 64;
+			static constexpr std::size_t SECRET_SIZE = 192;
+			static constexpr std::size_t STRIPES_PER_BLOCK = (SECRET_SIZE - STRIPE_SIZE) / 8;
+			static constexpr std::size_t BUFFER_SIZE = 4 * STRIPE_SIZE;
+			static constexpr std::size_t MIDSIZE_MAX = 240;
+
+			static constexpr uint64_t PRIME32_1 = 0x9E3779B1;
+			static constexpr uint64_t PRIME32_2 = 0x85EBCA77;
+			static constexpr uint64_t PRIME32_3 = 0xC2B2AE3D;
+			static constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87;
+			static constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4F;
+			static constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9;
+			static constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63;
+			static constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5;
+			static constexpr uint64_t PRIME_MX1 = 0x165667919E3779F9;
+			static constexpr uint64_t PRIME_MX2 = 0x9FB21C651E98DF25;
+
+			static constexpr Byte DEFAULT_SECRET[SECRET_SIZE] =
+			{
+				0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+				0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+				0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+				0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+				0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+				0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+				0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+				0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+				0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+				0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+				0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+				0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+			};
+
+			static uint64_t avalanche(uint64_t h);
+			static uint64_t avalancheXXH64(uint64_t h);
+			static uint64_t mix16(const Byte *input, const Byte *secret, const uint64_t seed);
+			static void mix32(Uint128 &acc, const Byte *input1, const Byte *input2, const Byte *secret, const uint64_t seed);
+			static uint64_t mergeAccumulators(const uint64_t *acc, const Byte *secret, const uint64_t start);
+
+			// one-shot digests for inputs up to `MIDSIZE_MAX` bytes
+			static Uint128 hashShort64(const Byte *input, const std::size_t length, const uint64_t seed);
+			static Uint128 hashShort128(const Byte *input, const std::size_t length, const uint64_t seed);
+
+			void consumeStripes(uint64_t *acc, std::size_t &stripesInBlock, const Byte *input, std::size_t stripes) const;
+
+			uint64_t m_seed = 0;
+			Byte m_secret[SECRET_SIZE] = {};
+
+			uint64_t m_acc[8] = {};
+			std::size_t m_stripesInBlock = 0;
+			uint64_t m_totalLength = 0;
+
+			// the tail of the input, the last stripe processed sits at the end of the buffer
+			Byte m_buffer[BUFFER_SIZE] = {};
+			std::size_t m_bufferSize = 0;
+
+			Uint128 m_result = {};
+	};
+
+
+	//
+	template <int Bits>
+	XXH3<Bits>::XXH3(const uint64_t seed)
+		: m_seed(seed)
+	{
+		static_assert((CHAR_BIT == 8), "Sorry, we don't support exotic CPUs");
+
+		// the long input path uses a secret derived from the seed, the short paths use the seed directly
+		for (std::size_t i = 0; i < SECRET_SIZE; i += 16)
+		{
+			writeLE64((m_secret + i), (readLE64(DEFAULT_SECRET + i) + seed));
+			writeLE64((m_secret + i + 8), (readLE64(DEFAULT_SECRET + i + 8) - seed));
+		}
+		reset();
+	}
+
+	template <int Bits>
+	void XXH3<Bits>::reset()
+	{
+		m_acc[0] = PRIME32_3;
+		m_acc[1] = PRIME64_1;
+		m_acc[2] = PRIME64_2;
+		m_acc[3] = PRIME64_3;
+		m_acc[4] = PRIME64_4;
+		m_acc[5] = PRIME32_2;
+		m_acc[6] = PRIME64_5;
+		m_acc[7] = PRIME32_1;
+		m_stripesInBlock = 0;
+		m_totalLength = 0;
+		m_bufferSize = 0;
+		m_result = {};
+	}
+
+	template <int Bits>
+	XXH3<Bits>& XXH3<Bits>::finalize()
+	{
+		if (m_totalLength <= MIDSIZE_MAX)
+		{
+			m_result = (Bits == 64)
+				? hashShort64(m_buffer, m_bufferSize, m_seed)
+				: hashShort128(m_buffer, m_bufferSize, m_seed);
+			return (*this);
+		}
+
+		uint64_t acc[8];
+		std::copy(m_acc, (m_acc + 8), acc);
+		std::size_t stripesInBlock = m_stripesInBlock;
+
+		// the last stripe always ends at the end of the input, it may overlap with data already processed
+		Byte lastStripe[STRIPE_SIZE];
+		if (m_bufferSize >= STRIPE_SIZE)
+		{
+			consumeStripes(acc, stripesInBlock, m_buffer, ((m_bufferSize - 1) / STRIPE_SIZE));
+			std::copy((m_buffer + m_bufferSize - STRIPE_SIZE), (m_buffer + m_bufferSize), lastStripe);
+		}
+		else
+		{
+			const std::size_t catchUp = STRIPE_SIZE - m_bufferSize;
+			std::copy((m_buffer + BUFFER_SIZE - catchUp), (m_buffer + BUFFER_SIZE), lastStripe);
+			std::copy(m_buffer, (m_buffer + m_bufferSize), (lastStripe + catchUp));
+		}
+		StripeOps::accumulate(acc, lastStripe, (m_secret + SECRET_SIZE - STRIPE_SIZE - 7), 1);
+
+		m_result.low = mergeAccumulators(acc, (m_secret + 11), (m_totalLength * PRIME64_1));
+		if (Bits == 128)
+			m_result.high = mergeAccumulators(acc, (m_secret + SECRET_SIZE - STRIPE_SIZE - 11), ~(m_totalLength * PRIME64_2));
+		return (*this);
+	}
+
+	template <int Bits>
+	std::string XXH3<Bits>::toString() const
+	{
+		const auto a = toArray();
+		std::string ret;
+		ret.resize(2 * a.size());
+
+		auto retPtr = &ret.front();
+		for (const auto c : a)
+		{
+			const Byte upper = static_cast<Byte>(c >> 4);
+			*(retPtr++) = static_cast<char>((upper < 10) ? (upper + '0') : (upper - 10 + 'a'));
+
+			const Byte lower = c & 0xf;
+			*(retPtr++) = static_cast<char>((lower < 10) ? (lower + '0') : (lower - 10 + 'a'));
+		}
+
+		return ret;
+	}
+
+	template <int Bits>
+	std::vector<typename XXH3<Bits>::Byte> XXH3<Bits>::toVector() const
+	{
+		const auto a = toArray();
+		return {a.begin(), a.end()};
+	}
+
+	template <int Bits>
+	typename XXH3<Bits>::ResultArrayType XXH3<Bits>::toArray() const
+	{
+		// canonical representation: big-endian, the upper half first
+		ResultArrayType ret {};
+		auto retPtr = ret.data();
+		if (Bits == 128)
+		{
+			for (int j = 7; j >= 0; --j)
+				*(retPtr++) = static_cast<Byte>(m_result.high >> (j * 8));
+		}
+		for (int j = 7; j >= 0; --j)
+			*(retPtr++) = static_cast<Byte>(m_result.low >> (j * 8));
+
+		return ret;
+	}
+
+	template <int Bits>
+	typename XXH3<Bits>::ResultArrayType XXH3<Bits>::peekDigest() const
+	{
+		XXH3 copy = *this;
+		return copy.finalize().toArray();
+	}
+
+	template <int Bits>
+	uint64_t XXH3<Bits>::toUint64() const
+	{
+		return m_result.low;
+	}
+
+	template <int Bits>
+	XXH3<Bits>& XXH3<Bits>::addData(const Span<const Byte> inData)
+	{
+		const Byte *ptr = inData.data();
+		std::size_t length = static_cast<std::size_t>(inData.size());
+		m_totalLength += length;
+
+		// data is processed only when more data follows it, the last stripe needs special treatment
+		if ((m_bufferSize + length) <= BUFFER_SIZE)
+		{
+			std::copy(ptr, (ptr + length), (m_buffer + m_bufferSize));
+			m_bufferSize += length;
+			return (*this);
+		}
+
+		if (m_bufferSize > 0)
+		{
+			const std::size_t fill = BUFFER_SIZE - m_bufferSize;
+			std::copy(ptr, (ptr + fill), (m_buffer + m_bufferSize));
+			ptr += fill;
+			length -= fill;
+
+			consumeStripes(m_acc, m_stripesInBlock, m_buffer, (BUFFER_SIZE / STRIPE_SIZE));
+			m_bufferSize = 0;
+		}
+
+		if (length > BUFFER_SIZE)
+		{
+			const std::size_t stripes = (length - 1) / STRIPE_SIZE;
+			consumeStripes(m_acc, m_stripesInBlock, ptr, stripes);
+			ptr += (stripes * STRIPE_SIZE);
+			length -= (stripes * STRIPE_SIZE);
+
+			std::copy((ptr - STRIPE_SIZE), ptr, (m_buffer + BUFFER_SIZE - STRIPE_SIZE));
+		}
+
+		std::copy(ptr, (ptr + length), m_buffer);
+		m_bufferSize = length;
+		return (*this);
+	}
+
+	template <int Bits>
+	XXH3<Bits>& XXH3<Bits>::addData(const void *ptr, const std::size_t length)
+	{
+		// Span::size_type = std::size_t
+		return addData({static_cast<const Byte*>(ptr), length});
+	}
+
+	template <int Bits>
+	template <std::size_t N>
+	XXH3<Bits>& XXH3<Bits>::addData(const Byte (&array)[N])
+	{
+		return addData({array, N});
+	}
+
+	template <int Bits>
+	template <typename T, std::size_t N>
+	XXH3<Bits>& XXH3<Bits>::addData(const T (&array)[N])
+	{
+		return addData({reinterpret_cast<const Byte*>(array), (sizeof(T) * N)});
+	}
+
+	template <int Bits>
+	template <typename T>
+	XXH3<Bits>& XXH3<Bits>::addData(const Span<T> inSpan)
+	{
+		return addData({reinterpret_cast<const Byte*>(inSpan.data()), inSpan.size_bytes()});
+	}
+
+	template <int Bits>
+	uint64_t XXH3<Bits>::avalanche(uint64_t h)
+	{
+		h ^= (h >> 37);
+		h *= PRIME_MX1;
+		h ^= (h >> 32);
+		return h;
+	}
+
+	template <int Bits>
+	uint64_t XXH3<Bits>::avalancheXXH64(uint64_t h)
+	{
+		h ^= (h >> 33);
+		h *= PRIME64_2;
+		h ^= (h >> 29);
+		h *= PRIME64_3;
+		h ^= (h >> 32);
+		return h;
+	}
+
+	template <int Bits>
+	uint64_t XXH3<Bits>::mix16(const Byte *input, const Byte *secret, const uint64_t seed)
+	{
+		return mult128fold64((readLE64(input) ^ (readLE64(secret) + seed)), (readLE64(input + 8) ^ (readLE64(secret + 8) - seed)));
+	}
+
+	template <int Bits>
+	void XXH3<Bits>::mix32(Uint128 &acc, const Byte *input1, const Byte *input2, const Byte *secret, const uint64_t seed)
+	{
+		acc.low += mix16(input1, secret, seed);
+		acc.low ^= (readLE64(input2) + readLE64(input2 + 8));
+		acc.high += mix16(input2, (secret + 16), seed);
+		acc.high ^= (readLE64(input1) + readLE64(input1 + 8));
+	}
+
+	template <int Bits>
+	uint64_t XXH3<Bits>::mergeAccumulators(const uint64_t *acc, const Byte *secret, const uint64_t start)
+	{
+		uint64_t result = start;
+		for (int i = 0; i < 4; ++i)
+			result += mult128fold64((acc[2 * i] ^ readLE64(secret + (16 * i))), (acc[(2 * i) + 1] ^ readLE64(secret + (16 * i) + 8)));
+		return avalanche(result);
+	}
+
+	template <int Bits>
+	Uint128 XXH3<Bits>::hashShort64(const Byte *input, const std::size_t length, const uint64_t seed)
+	{
+		const Byte *secret = DEFAULT_SECRET;
+		const uint64_t len = length;
+
+		if (length == 0)
+			return {avalancheXXH64(seed ^ readLE64(secret + 56) ^ readLE64(secret + 64)), 0};
+
+		if (length <= 3)
+		{
+			const uint32_t combined = (static_cast<uint32_t>(input[0]) << 16) | (static_cast<uint32_t>(input[length >> 1]) << 24)
+				| static_cast<uint32_t>(input[length - 1]) | (static_cast<uint32_t>(length) << 8);
+			const uint64_t bitflip = (readLE32(secret) ^ readLE32(secret + 4)) + seed;
+			return {avalancheXXH64(combined ^ bitflip), 0};
+		}
+
+		if (length <= 8)
+		{
+			const uint64_t s = seed ^ (static_cast<uint64_t>(swap32(static_cast<uint32_t>(seed))) << 32);
+			const uint64_t bitflip = (readLE64(secret + 8) ^ readLE64(secret + 16)) - s;
+			const uint64_t input64 = readLE32(input + length - 4) + (static_cast<uint64_t>(readLE32(input)) << 32);
+			uint64_t h = input64 ^ bitflip;
+			h ^= rotl<uint64_t>(h, 49) ^ rotl<uint64_t>(h, 24);
+			h *= PRIME_MX2;
+			h ^= (h >> 35) + len;
+			h *= PRIME_MX2;
+			h ^= (h >> 28);
+			return {h, 0};
+		}
+
+		if (length <= 16)
+		{
+			const uint64_t bitflip1 = (readLE64(secret + 24) ^ readLE64(secret + 32)) + seed;
+			const uint64_t bitflip2 = (readLE64(secret + 40) ^ readLE64(secret + 48)) - seed;
+			const uint64_t inputLow = readLE64(input) ^ bitflip1;
+			const uint64_t inputHigh = readLE64(input + length - 8) ^ bitflip2;
+			return {avalanche(len + swap64(inputLow) + inputHigh + mult128fold64(inputLow, inputHigh)), 0};
+		}
+
+		uint64_t acc = len * PRIME64_1;
+		if (length <= 128)
+		{
+			if (length > 32)
+			{
+				if (length > 64)
+				{
+					if (length > 96)
+					{
+						acc += mix16((input + 48), (secret + 96), seed);
+						acc += mix16((input + length - 64), (secret + 112), seed);
+					}
+					acc += mix16((input + 32), (secret + 64), seed);
+					acc += mix16((input + length - 48), (secret + 80), seed);
+				}
+				acc += mix16((input + 16), (secret + 32), seed);
+				acc += mix16((input + length - 32), (secret + 48), seed);
+			}
+			acc += mix16(input, secret, seed);
+			acc += mix16((input + length - 16), (secret + 16), seed);
+			return {avalanche(acc), 0};
+		}
+
+		// 129 to 240 bytes
+		for (std::size_t i = 0; i < 8; ++i)
+			acc += mix16((input + (16 * i)), (secret + (16 * i)), seed);
+		acc = avalanche(acc);
+
+		uint64_t accEnd = mix16((input + length - 16), (secret + 136 - 17), seed);
+		for (std::size_t i = 8; i < (length / 16); ++i)
+			accEnd += mix16((input + (16 * i)), (secret + (16 * (i - 8)) + 3), seed);
+		return {avalanche(acc + accEnd), 0};
+	}
+
+	template <int Bits>
+	Uint128 XXH3<Bits>::hashShort128(const Byte *input, const std::size_t length, const uint64_t seed)
+	{
+		const Byte *secret = DEFAULT_SECRET;
+		const uint64_t len = length;
+
+		if (length == 0)
+			return {avalancheXXH64(seed ^ readLE64(secret + 64) ^ readLE64(secret + 72))
+				, avalancheXXH64(seed ^ readLE64(secret + 80) ^ readLE64(secret + 88))};
+
+		if (length <= 3)
+		{
+			const uint32_t combinedLow = (static_cast<uint32_t>(input[0]) << 16) | (static_cast<uint32_t>(input[length >> 1]) << 24)
+				| static_cast<uint32_t>(input[length - 1]) | (static_cast<uint32_t>(length) << 8);
+			const uint32_t combinedHigh = rotl<uint32_t>(swap32(combinedLow), 13);
+			const uint64_t bitflipLow = (readLE32(secret) ^ readLE32(secret + 4)) + seed;
+			const uint64_t bitflipHigh = (readLE32(secret + 8) ^ readLE32(secret + 12)) - seed;
+			return {avalancheXXH64(combinedLow ^ bitflipLow), avalancheXXH64(combinedHigh ^ bitflipHigh)};
+		}
+
+		if (length <= 8)
+		{
+			const uint64_t s = seed ^ (static_cast<uint64_t>(swap32(static_cast<uint32_t>(seed))) << 32);
+			const uint64_t input64 = readLE32(input) + (static_cast<uint64_t>(readLE32(input + length - 4)) << 32);
+			const uint64_t bitflip = (readLE64(secret + 16) ^ readLE64(secret + 24)) + s;
+			Uint128 m = mult64to128((input64 ^ bitflip), (PRIME64_1 + (len << 2)));
+			m.high += (m.low << 1);
+			m.low ^= (m.high >> 3);
+			m.low ^= (m.low >> 35);
+			m.low *= PRIME_MX2;
+			m.low ^= (m.low >> 28);
+			return {m.low, avalanche(m.high)};
+		}
+
+		if (length <= 16)
+		{
+			const uint64_t bitflipLow = (readLE64(secret + 32) ^ readLE64(secret + 40)) - seed;
+			const uint64_t bitflipHigh = (readLE64(secret + 48) ^ readLE64(secret + 56)) + seed;
+			const uint64_t inputLow = readLE64(input);
+			const uint64_t inputHigh = readLE64(input + length - 8) ^ bitflipHigh;
+			Uint128 m = mult64to128((inputLow ^ readLE64(input + length - 8) ^ bitflipLow), PRIME64_1);
+			m.low += ((len - 1) << 54);
+			m.high += inputHigh + ((inputHigh & 0xFFFFFFFF) * (PRIME32_2 - 1));
+			m.low ^= swap64(m.high);
+			Uint128 h = mult64to128(m.low, PRIME64_2);
+			h.high += (m.high * PRIME64_2);
+			return {avalanche(h.low), avalanche(h.high)};
+		}
+
+		Uint128 acc = {(len * PRIME64_1), 0};
+		if (length <= 128)
+		{
+			if (length > 32)
+			{
+				if (length > 64)
+				{
+					if (length > 96)
+						mix32(acc, (input + 48), (input + length - 64), (secret + 96), seed);
+					mix32(acc, (input + 32), (input + length - 48), (secret + 64), seed);
+				}
+				mix32(acc, (input + 16), (input + length - 32), (secret + 32), seed);
+			}
+			mix32(acc, input, (input + length - 16), secret, seed);
+		}
+		else
+		{
+			// 129 to 240 bytes
+			for (std::size_t i = 0; i < 4; ++i)
+				mix32(acc, (input + (32 * i)), (input + (32 * i) + 16), (secret + (32 * i)), seed);
+			acc.low = avalanche(acc.low);
+			acc.high = avalanche(acc.high);
+
+			for (std::size_t i = 4; i < (length / 32); ++i)
+				mix32(acc, (input + (32 * i)), (input + (32 * i) + 16), (secret + 3 + (32 * (i - 4))), seed);
+			mix32(acc, (input + length - 16), (input + length - 32), (secret + 136 - 17 - 16), (0 - seed));
+		}
+
+		return {avalanche(acc.low + acc.high)
+			, (0 - avalanche((acc.low * PRIME64_1) + (acc.high * PRIME64_4) + ((len - seed) * PRIME64_2)))};
+	}
+
+	template <int Bits>
+	void XXH3<Bits>::consumeStripes(uint64_t *acc, std::size_t &stripesInBlock, const Byte *input, std::size_t stripes) const
+	{
+		// the accumulators are scrambled after each block of `STRIPES_PER_BLOCK` stripes
+		while (stripes > 0)
+		{
+			const std::size_t count = std::min(stripes, (STRIPES_PER_BLOCK - stripesInBlock));
+			StripeOps::accumulate(acc, input, (m_secret + (stripesInBlock * 8)), count);
+			stripesInBlock += count;
+			input += (count * STRIPE_SIZE);
+			stripes -= count;
+
+			if (stripesInBlock == STRIPES_PER_BLOCK)
+			{
+				StripeOps::scramble(acc, (m_secret + SECRET_SIZE - STRIPE_SIZE));
+				stripesInBlock = 0;
+			}
+		}
+	}
+
+	template <int Bits>
+	constexpr std::size_t XXH3<Bits>::STRIPE_SIZE;
+	template <int Bits>
+	constexpr std::size_t XXH3<Bits>::SECRET_SIZE;
+	template <int Bits>
+	constexpr std::size_t XXH3<Bits>::STRIPES_PER_BLOCK;
+	template <int Bits>
+	constexpr std::size_t XXH3<Bits>::BUFFER_SIZE;
+	template <int Bits>
+	constexpr std::size_t XXH3<Bits>::MIDSIZE_MAX;
+	template <int Bits>
+	constexpr typename XXH3<Bits>::Byte XXH3<Bits>::DEFAULT_SECRET[XXH3<Bits>::SECRET_SIZE];
+
+	template <int Bits>
+	std::vector<typename XXH3<Bits>::Byte> XXH3<Bits>::serialize() const
+	{
+		StateWriter writer("XXH3_" + std::to_string(Bits));
+		writer.put(m_seed);
+		for (const auto acc : m_acc)
+			writer.put(acc);
+		writer.put(static_cast<uint64_t>(m_stripesInBlock));
+		writer.put(m_totalLength);
+		writer.put(static_cast<uint32_t>(m_bufferSize));
+		writer.put(m_buffer, BUFFER_SIZE);  // the last stripe processed sits at the end
+		return writer.data();
+	}
+
+	template <int Bits>
+	bool XXH3<Bits>::restore(const Span<const Byte> snapshot)
+	{
+		StateReader reader(snapshot.data(), static_cast<std::size_t>(snapshot.size()), "XXH3_" + std::to_string(Bits));
+		const uint64_t seed = reader.get<uint64_t>();
+		uint64_t acc[8] = {};
+		for (auto &i : acc)
+			i = reader.get<uint64_t>();
+		const uint64_t stripesInBlock = reader.get<uint64_t>();
+		const uint64_t totalLength = reader.get<uint64_t>();
+		const uint32_t bufferSize = reader.get<uint32_t>();
+		Byte buffer[BUFFER_SIZE] = {};
+		reader.get(buffer, BUFFER_SIZE);
+		if (!reader.finished() || (seed != m_seed) || (stripesInBlock >= STRIPES_PER_BLOCK) || (bufferSize > BUFFER_SIZE))
+			return false;
+
+		std::copy(acc, (acc + 8), m_acc);
+		m_stripesInBlock = static_cast<std::size_t>(stripesInBlock);
+		m_totalLength = totalLength;
+		std::copy(buffer, (buffer + BUFFER_SIZE), m_buffer);
+		m_bufferSize = bufferSize;
+		return true;
+	}
+}
+}
+	using XXH3_64 = Hash::XXH3_NS::XXH3<64>;
+	using XXH3_128 = Hash::XXH3_NS::XXH3<128>;
+}
+
+#endif  // CHOCOBO1_XXH3_H
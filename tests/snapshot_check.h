@@ -0,0 +1,103 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#ifndef CHOCOBO1_TESTS_SNAPSHOT_CHECK_H
+#define CHOCOBO1_TESTS_SNAPSHOT_CHECK_H
+
+#include "catch2/single_include/catch2/catch.hpp"
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+
+// checks shared by the `serialize()` / `restore()` & `peekDigest()` tests
+// `makeHash` returns a fresh instance with the parameters under test, e.g. `[]() { return Hash(32, "abc"); }`
+namespace SnapshotCheck
+{
+	inline std::vector<uint8_t> pattern(const std::size_t length)
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	}
+
+	// the empty prefix, then just before, at & just after each boundary
+	inline std::vector<std::size_t> splitsAround(const std::initializer_list<std::size_t> boundaries)
+	{
+		std::vector<std::size_t> ret = {0};
+		for (const std::size_t boundary : boundaries)
+		{
+			ret.push_back(boundary - 1);
+			ret.push_back(boundary);
+			ret.push_back(boundary + 1);
+		}
+		return ret;
+	}
+
+	template <typename Snapshot>
+	void checkRejected(const Snapshot &)
+	{
+	}
+
+	template <typename Snapshot, typename MakeOther, typename... Rest>
+	void checkRejected(const Snapshot &snapshot, const MakeOther &makeOther, const Rest &...rest)
+	{
+		auto other = makeOther();
+		REQUIRE_FALSE(other.restore(snapshot));
+		checkRejected(snapshot, rest...);
+	}
+
+	// at every split, the snapshot of the prefix restores into a fresh instance & finishes with the digest of the whole `data`
+	// a truncated snapshot is rejected, so is the snapshot by each instance of `makeMismatched`
+	template <typename MakeHash, typename... MakeMismatched>
+	void roundTrip(const MakeHash &makeHash, const std::vector<uint8_t> &data, const std::vector<std::size_t> &splits, const MakeMismatched &...makeMismatched)
+	{
+		const std::string expected = makeHash().addData(data.data(), data.size()).finalize().toString();
+		for (const std::size_t split : splits)
+		{
+			REQUIRE(split <= data.size());
+
+			auto prefix = makeHash();
+			prefix.addData(data.data(), split);
+			const auto snapshot = prefix.serialize();
+
+			auto restored = makeHash();
+			REQUIRE(restored.restore(snapshot));
+			REQUIRE(expected == restored.addData((data.data() + split), (data.size() - split)).finalize().toString());
+
+			auto truncated = makeHash();
+			REQUIRE_FALSE(truncated.restore({snapshot.data(), (snapshot.size() - 1)}));
+			checkRejected(snapshot, makeMismatched...);
+		}
+	}
+
+	// at every split, peeking gives the digest of the prefix & the state keeps going
+	template <typename MakeHash>
+	void peek(const MakeHash &makeHash, const std::vector<uint8_t> &data, const std::vector<std::size_t> &splits)
+	{
+		const std::string expected = makeHash().addData(data.data(), data.size()).finalize().toString();
+		for (const std::size_t split : splits)
+		{
+			REQUIRE(split <= data.size());
+
+			auto prefix = makeHash();
+			prefix.addData(data.data(), split);
+			const auto peeked = prefix.peekDigest();
+			REQUIRE(makeHash().addData(data.data(), split).finalize().toVector() == std::vector<uint8_t>(peeked.begin(), peeked.end()));
+			REQUIRE(expected == prefix.addData((data.data() + split), (data.size() - split)).finalize().toString());
+		}
+	}
+}
+
+#endif  // CHOCOBO1_TESTS_SNAPSHOT_CHECK_H
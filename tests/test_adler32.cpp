@@ -0,0 +1,116 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2017-2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/adler32.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <cstring>
+#include <vector>
+
+
+TEST_CASE("adler32")
+{
+	using Hash = Chocobo1::Adler32;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	// my own tests
+	REQUIRE("00000001" == Hash().finalize().toString());
+
+	const char s11[] = "Wikipedia";
+	REQUIRE("11e60398" == Hash().addData(s11, strlen(s11)).finalize().toString());
+
+	const char s12[] = "The quick brown fox jumps over the lazy dog";
+	REQUIRE("5bdc0fda" == Hash().addData(s12, strlen(s12)).finalize().toString());
+
+	// across the SIMD block sizes & the deferred modulo
+	const std::pair<std::size_t, std::string> s2[] =
+	{
+		{0, "00000001"},
+		{1, "00010001"},
+		{15, "023f006a"},
+		{16, "02b80079"},
+		{31, "137f01d2"},
+		{32, "157001f1"},
+		{33, "17810211"},
+		{100, "8b7c1357"},
+		{5552, "8f318a94"},
+		{5553, "19f28ab2"},
+		{11121, "86941d3e"},
+		{100000, "84cba994"}
+	};
+	for (const auto &s : s2)
+	{
+		const auto data = pattern(s.first + 1);
+		REQUIRE(s.second == Hash().addData(data.data(), s.first).finalize().toString());
+
+		// misaligned
+		std::vector<uint8_t> shifted(s.first + 1);
+		std::memcpy((shifted.data() + 1), data.data(), s.first);
+		REQUIRE(s.second == Hash().addData((shifted.data() + 1), s.first).finalize().toString());
+
+		for (const std::size_t chunk : {1, 7, 64, 1000})
+		{
+			Hash hash;
+			for (std::size_t i = 0; i < s.first; i += chunk)
+				hash.addData((data.data() + i), std::min(chunk, (s.first - i)));
+			REQUIRE(s.second == hash.finalize().toString());
+		}
+
+		for (const std::size_t split : {std::size_t(0), (s.first / 3), s.first})
+		{
+			Hash first;
+			first.addData(data.data(), split);
+			Hash second;
+			second.addData((data.data() + split), (s.first - split));
+			REQUIRE(s.second == first.combine(second, (s.first - split)).finalize().toString());
+		}
+	}
+
+	// worst case for the sums
+	const std::vector<uint8_t> s3(200000, 0xFF);
+	REQUIRE("14d06057" == Hash().addData(s3.data(), s3.size()).finalize().toString());
+
+	// parallel
+	const auto s4 = pattern((3 * 1024 * 1024) + 5);
+	const auto s4Sequential = Hash().addData(s4.data(), s4.size()).finalize().toString();
+	for (const std::size_t threads : {0, 1, 3, 7, 1000000})
+		REQUIRE(s4Sequential == Hash().addDataParallel(s4.data(), s4.size(), threads).finalize().toString());
+
+	Hash s5;
+	s5.addData(s4.data(), s4.size()).finalize();
+	s5.reset();
+	REQUIRE("00000001" == s5.finalize().toString());
+
+	const int s6[2] = {0};
+	const char s6_2[8] = {0};
+	REQUIRE(Hash().addData(Hash::Span<const int>(s6)).finalize().toString()
+			== Hash().addData(s6_2).finalize().toString());
+
+	const unsigned char s7[] = {0x00, 0x0A};
+	const auto s7_1 = Hash().addData(s7, 2).finalize().toArray();
+	const auto s7_2 = Hash().addData(s7).finalize().toArray();
+	REQUIRE(s7_1 == s7_2);
+
+	// snapshots & peeks around the 32-byte SIMD blocks & the 5552-byte stretches between the modulo reductions
+	const auto s8 = pattern(12000);
+	const auto s8Splits = SnapshotCheck::splitsAround({32, 5552, 11104});
+	SnapshotCheck::roundTrip([]() { return Hash(); }, s8, s8Splits);
+	SnapshotCheck::peek([]() { return Hash(); }, s8, s8Splits);
+}
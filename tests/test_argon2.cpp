@@ -0,0 +1,158 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/argon2.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+	using Byte = uint8_t;
+
+	std::vector<Byte> pattern(const std::size_t length)
+	{
+		std::vector<Byte> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<Byte>(i % 251);
+		return ret;
+	}
+
+	std::vector<Byte> bytes(const std::string &str)
+	{
+		return {str.begin(), str.end()};
+	}
+
+	std::string toHex(const std::vector<Byte> &data)
+	{
+		std::string ret;
+		for (const Byte c : data)
+		{
+			const char digits[] = "0123456789abcdef";
+			ret += digits[c >> 4];
+			ret += digits[c & 0xf];
+		}
+		return ret;
+	}
+
+	template <typename Hash>
+	std::string hash(const typename Hash::Parameters &params, const std::vector<Byte> &password, const std::vector<Byte> &salt, const std::size_t length)
+	{
+		std::vector<Byte> output(length);
+		Hash::hash(params, password, salt, output);
+		return toHex(output);
+	}
+
+	template <typename Hash>
+	typename Hash::Parameters costs(const uint32_t memory, const uint32_t passes, const uint32_t lanes)
+	{
+		typename Hash::Parameters params;
+		params.memory = memory;
+		params.passes = passes;
+		params.lanes = lanes;
+		return params;
+	}
+
+	template <typename Hash>
+	void checkVectors(const std::string (&expected)[4])
+	{
+		// https://tools.ietf.org/html/rfc9106#section-5
+		const std::vector<Byte> secret(8, 0x03);
+		const std::vector<Byte> associatedData(12, 0x04);
+		typename Hash::Parameters params = costs<Hash>(32, 3, 4);
+		params.secret = secret;
+		params.associatedData = associatedData;
+		REQUIRE(expected[0] == hash<Hash>(params, std::vector<Byte>(32, 0x01), std::vector<Byte>(16, 0x02), 32));
+
+		// argon2-cffi
+		REQUIRE(expected[1] == hash<Hash>(costs<Hash>(256, 2, 1), bytes("password"), bytes("somesalt"), 32));
+		REQUIRE(expected[2] == hash<Hash>(costs<Hash>(1024, 3, 4), pattern(50), pattern(16), 100));
+		REQUIRE(expected[3] == hash<Hash>(costs<Hash>(29, 1, 3), pattern(10), pattern(8), 4));
+
+		// the number of threads doesn't change the result
+		for (const uint32_t threads : {1, 2, 3, 4})
+		{
+			typename Hash::Parameters threaded = costs<Hash>(1024, 3, 4);
+			threaded.threads = threads;
+			REQUIRE(expected[2] == hash<Hash>(threaded, pattern(50), pattern(16), 100));
+		}
+	}
+}
+
+TEST_CASE("argon2d")
+{
+	using Hash = Chocobo1::Argon2d;
+
+	const std::string s1[] =
+	{
+		"512b391b6f1162975371d30919734294f868e3be3984f3c1a13a4db9fabe4acb",
+		"25c4ee8ba448054b49efc804e478b9d823be1f9bd2e99f51d6ec4007a3a1501f",
+		"4ff32fb15664acea869d9eec1c34aa8dd5c731779c8d8322cd4ad696f5a47f6dd74820a61e641b81415c2d688b771b9f00e71b1053dfe480cc11e72249aa0ad6396ec8c9d395eaa55a44995639e59376ffb3d2e7274590740d6db3f8c66b0e22f7eabb53",
+		"fe3af733"
+	};
+	checkVectors<Hash>(s1);
+}
+
+TEST_CASE("argon2i")
+{
+	using Hash = Chocobo1::Argon2i;
+
+	const std::string s1[] =
+	{
+		"c814d9d1dc7f37aa13f0d77f2494bda1c8de6b016dd388d29952a4c4672b6ce8",
+		"89e9029f4637b295beb027056a7336c414fadd43f6b208645281cb214a56452f",
+		"f4180d92c2bb26b5638800d6a9144402cbe7269c91640d585acd971618c28386830a568fc419c793abcc714d9a6638c845f2b97305ad1f70bcd88a3bf50204af9f5ebc54edda07835665a029b4f98c5d934d6bd256228d5f5da387f3052139d38bd03277",
+		"dc69276d"
+	};
+	checkVectors<Hash>(s1);
+
+	// https://github.com/P-H-C/phc-winner-argon2/blob/master/src/test.c
+	REQUIRE("c1628832147d9720c5bd1cfd61367078729f6dfb6f8fea9ff98158e0d7816ed0" == hash<Hash>(costs<Hash>(65536, 2, 1), bytes("password"), bytes("somesalt"), 32));
+}
+
+TEST_CASE("argon2id")
+{
+	using Hash = Chocobo1::Argon2id;
+
+	const std::string s1[] =
+	{
+		"0d640df58d78766c08c037a34a8b53c9d01ef0452d75b65eb52520e96b01e659",
+		"9dfeb910e80bad0311fee20f9c0e2b12c17987b4cac90c2ef54d5b3021c68bfe",
+		"18dfe94424c980947798e95dbec3879d5fc07ab34ee1108a0b237cc8ca4c90c96840fe5a49714581a8a58a5d0d0a95ce4fa068bea8296d5e7c5abb2602d44a7a0899b23a31c25706cf7c2ca1795cfac821a331c75d24ff8b6bf91868f003b7f0b15b678a",
+		"2e6cfa06"
+	};
+	checkVectors<Hash>(s1);
+}
+
+TEST_CASE("argon2 parameters")
+{
+	using Hash = Chocobo1::Argon2id;
+
+	const std::vector<Byte> password = bytes("password");
+	const std::vector<Byte> salt = bytes("somesalt");
+	std::vector<Byte> output(32);
+
+	REQUIRE_NOTHROW(Hash::hash(costs<Hash>(8, 1, 1), password, salt, output));
+	REQUIRE_THROWS_AS(Hash::hash(costs<Hash>(64, 1, 0), password, salt, output), std::invalid_argument);
+	REQUIRE_THROWS_AS(Hash::hash(costs<Hash>(1 << 30, 1, 0x1000000), password, salt, output), std::invalid_argument);
+	REQUIRE_THROWS_AS(Hash::hash(costs<Hash>(64, 0, 1), password, salt, output), std::invalid_argument);
+	REQUIRE_THROWS_AS(Hash::hash(costs<Hash>(4, 1, 1), password, salt, output), std::invalid_argument);
+	REQUIRE_THROWS_AS(Hash::hash(costs<Hash>(31, 1, 4), password, salt, output), std::invalid_argument);
+	REQUIRE_THROWS_AS(Hash::hash(costs<Hash>(64, 1, 1), password, {}, output), std::invalid_argument);
+	REQUIRE_THROWS_AS(Hash::hash(costs<Hash>(64, 1, 1), password, bytes("salt"), output), std::invalid_argument);
+
+	std::vector<Byte> shortOutput(3);
+	REQUIRE_THROWS_AS(Hash::hash(costs<Hash>(64, 1, 1), password, salt, shortOutput), std::invalid_argument);
+}
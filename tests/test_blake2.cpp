@@ -12,8 +12,11 @@
 #include "../src/blake2.h"
 
 #include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 
 TEST_CASE("blake2")
@@ -67,3 +70,95 @@ TEST_CASE("blake2")
 	const auto s17_2 = Hash().addData(s17).finalize().toArray();
 	REQUIRE(s17_1 == s17_2);
 }
+
+TEST_CASE("blake2-keyed")
+{
+	using Hash = Chocobo1::Blake2;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	std::vector<uint8_t> key(64);
+	for (std::size_t i = 0; i < key.size(); ++i)
+		key[i] = static_cast<uint8_t>(i);
+
+	// generated with python hashlib
+	const std::pair<std::size_t, std::string> s1[] =
+	{
+		{0, "10ebb67700b1868efb4417987acf4690ae9d972fb7a590c2f02871799aaa4786b5e996e8f0f4eb981fc214b005f42d2ff4233499391653df7aefcbc13fc51568"},
+		{1, "961f6dd1e4dd30f63901690c512e78e4b45e4742ed197c3c5e45c549fd25f2e4187b0bc9fe30492b16b0d0bc4ef9b0f34c7003fac09a5ef1532e69430234cebd"},
+		{127, "76d2d819c92bce55fa8e092ab1bf9b9eab237a25267986cacf2b8ee14d214d730dc9a5aa2d7b596e86a1fd8fa0804c77402d2fcd45083688b218b1cdfa0dcbcb"},
+		{128, "72065ee4dd91c2d8509fa1fc28a37c7fc9fa7d5b3f8ad3d0d7a25626b57b1b44788d4caf806290425f9890a3a2a35a905ab4b37acfd0da6e4517b2525c9651e4"},
+		{129, "64475dfe7600d7171bea0b394e27c9b00d8e74dd1e416a79473682ad3dfdbb706631558055cfc8a40e07bd015a4540dcdea15883cbbf31412df1de1cd4152b91"},
+		{1000, "715377e0611515b904d259ce52fc8e5d2c50468b1680b2984786b6949cc571f453d28cfb6969cb523ec84e06bf2a4465f3f37511db7792228d038942935750c1"}
+	};
+	const Hash keyed(key);
+	for (const auto &s : s1)
+	{
+		const auto data = pattern(s.first);
+		REQUIRE(s.second == Hash(key).addData(data.data(), data.size()).finalize().toString());
+
+		// copy of the precomputed keyed state
+		Hash copy = keyed;
+		REQUIRE(s.second == copy.addData(data.data(), data.size()).finalize().toString());
+
+		Hash chunked(key);
+		for (std::size_t i = 0; i < data.size(); i += 7)
+			chunked.addData((data.data() + i), std::min<std::size_t>(7, (data.size() - i)));
+		REQUIRE(s.second == chunked.finalize().toString());
+	}
+
+	Hash s2(key);
+	const auto s2Data = pattern(1000);
+	s2.addData(s2Data.data(), s2Data.size()).finalize();
+	s2.reset();
+	REQUIRE(s1[0].second == s2.finalize().toString());
+
+	// salt, personalization & digest length
+	const char s3Key[] = "key";
+	const char s3Salt[] = "0123456789abcdef";
+	const char s3Personal[] = "personalization!";
+	Hash::Parameters s3Params;
+	s3Params.digestLength = 20;
+	std::memcpy(s3Params.salt.data(), s3Salt, s3Params.salt.size());
+	std::memcpy(s3Params.personalization.data(), s3Personal, s3Params.personalization.size());
+	const Hash s3(Hash::Span<const uint8_t>(reinterpret_cast<const uint8_t *>(s3Key), strlen(s3Key)), s3Params);
+	REQUIRE("82a2e4436160cbb84f17e89d0aaadf91b69c9d08" == Hash(s3).addData("abc", 3).finalize().toString());
+	REQUIRE(20 == Hash(s3).addData("abc", 3).finalize().toVector().size());
+
+	const auto s3Array = Hash(s3).addData("abc", 3).finalize().toArray();
+	REQUIRE(s3Array.size() == 64);
+	REQUIRE(std::all_of((s3Array.begin() + 20), s3Array.end(), [](const uint8_t c) { return c == 0; }));
+
+	Hash::Parameters s4Params;
+	s4Params.digestLength = 32;
+	REQUIRE("bddd813c634239723171ef3fee98579b94964e3bb1cb3e427262c8c068d52319" == Hash(s4Params).addData("abc", 3).finalize().toString());
+
+	const uint8_t s5Key[] = {'k'};
+	REQUIRE("490b6c8300eb23464bd2f9ca37c036be5091da14ddbeafab424c4c0a1f9eaac5" == Hash(s5Key, s4Params).finalize().toString());
+
+	// snapshots & peeks around the 128-byte blocks, the last full block is held back until more data arrives
+	const auto s6 = pattern(1000);
+	const auto s6Splits = SnapshotCheck::splitsAround({128, 256});
+	SnapshotCheck::roundTrip([&]() { return Hash(s4Params); }, s6, s6Splits
+		, []() { return Hash(); }  // different parameters
+		, [&]() { return Hash(s5Key, s4Params); });  // keyed
+	SnapshotCheck::peek([&]() { return Hash(s4Params); }, s6, s6Splits);  // `digestLength` bytes long
+	SnapshotCheck::peek([&]() { return Hash(key); }, s6, s6Splits);
+
+	// keyed states aren't handed out
+	for (const std::size_t split : s6Splits)
+		REQUIRE(Hash(key).addData(s6.data(), split).serialize().empty());
+
+	// the 128-bit byte counter is restored in full, its high word sits before the buffer size & the 100 buffered bytes
+	Hash highCounter(s4Params);
+	auto highSnapshot = highCounter.addData(s6.data(), 100).serialize();
+	highSnapshot[highSnapshot.size() - 100 - 4 - 8] = 1;
+	REQUIRE(highCounter.restore(highSnapshot));
+	REQUIRE(highSnapshot == highCounter.serialize());
+}
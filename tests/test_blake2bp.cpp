@@ -0,0 +1,105 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/blake2bp.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <cstring>
+
+
+TEST_CASE("blake2bp")
+{
+	using Hash = Chocobo1::Blake2bp;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	// official test suite
+	REQUIRE("b5ef811a8038f70b628fa8b294daae7492b1ebe343a80eaabbf1f6ae664dd67b9d90b0120791eab81dc96985f28849f6a305186a85501b405114bfa678df9380"
+			== Hash().finalize().toString());
+
+
+	// my own tests
+	const char s1[] = "abc";
+	REQUIRE("b91a6b66ae87526c400b0a8b53774dc65284ad8f6575f8148ff93dff943a6ecd8362130f22d6dae633aa0f91df4ac89aaff31d0f1b923c898e82025dedbdad6e"
+			== Hash().addData(s1, strlen(s1)).finalize().toString());
+
+	const char s2[] = "a";
+	Hash test2;
+	for (long int i = 0 ; i < 1000000; ++i)
+		test2.addData(s2, strlen(s2));
+	REQUIRE("4fd1b8c1e05baa115dbf00df2eb2d217e935f5332b55a20d018109f6b5e08009711b40ae8ff73cf94017796a5a9675dbd2b8341a13f010eb33563dd2ffbbea5e"
+			== test2.finalize().toString());
+
+	const char s11[] = "The quick brown fox jumps over the lazy dog";
+	REQUIRE("f10e0523631699102c63412c0701fa19f6550fbac0e9c035803c6033b50465222bb92ee0af0dad53edca32f0e08a72c077a6cafc6f4d24a7fb649079d47ce089"
+			== Hash().addData(s11, strlen(s11)).finalize().toString());
+
+	// around block & stripe boundaries
+	const std::pair<std::size_t, std::string> s12[] =
+	{
+		{127, "ea64b003a135766121cfbccbdc08dca2402926be78cea3d0a7253d9ec9e63b8acdd994559917e0e03b5e155f944d7198d99245a794ce19c9b4df4da4a3399334"},
+		{128, "05ad0f271faf7e361320518452813ff9fb9976ac378050b6eefb05f7867b577b8f14475794cff61b2bc062d346a7c65c6e0067c60a374af7940f10aa449d5fb9"},
+		{512, "61c4dabacdfb1352185aae9dbc04b348af681478b0c4aa7291c7bab11783e8afe05830d87b6e003bbd95a08d9db6b053f12e75602fd5f1c1f49d39cd6c12b40b"},
+		{513, "c62cf13185f8eb971737218c9ae187f6447dfd286d206c7d42f442c719527c59d4655ca5829bf3912d284b916f5bdaa36672363bdca29b0ed2047ba98404a2ad"},
+		{640, "0baeb34afb0295343c42d880fd427b6736a684a6f1e13154db7c01739da1d21d102f84a67a4c18e851eda12f58b5773242d41c67f00557dac7df98e374b8086c"},
+		{1024, "1d37eac00a55afe13b8affbf6c3fd60e3608ef9479bb48e88a26a7fc5667a8c57845ecdc1e9e4b45a03bae187a150af93fb09be6cd96ccd954cbbe30c9be7d25"},
+		{1025, "628ba9706b121c0e05d24c9d72538d22e8e6f6d5ab99ba04b95744e8e4e878b4353d10a354a44788f8b867550b64af60a71ca33290e67d24d8b811a7a8b3f644"},
+		{1537, "d3b435097d332eb11d10c08df257f77ab4482ce88481ad5030490d4008c294241222f478905336ae4c830f1bb9c6204cd184e4a21c725dd74a55d4110dec8028"},
+		{5000, "8b33d6034750171716d5951a7e8df9cd7188ed2b859de92a53c0c61f48007b85ee78679522636897950b0143c49c522e58f0531ab3c88329e276428ac98938bd"}
+	};
+	for (const auto &s : s12)
+	{
+		const auto data = pattern(s.first);
+		REQUIRE(s.second == Hash().addData(data.data(), data.size()).finalize().toString());
+
+		for (const std::size_t chunk : {1, 100, 512, 700})
+		{
+			Hash hash;
+			for (std::size_t i = 0; i < data.size(); i += chunk)
+				hash.addData((data.data() + i), std::min(chunk, (data.size() - i)));
+			REQUIRE(s.second == hash.finalize().toString());
+		}
+	}
+
+	// large enough to be split across threads
+	const auto s13 = pattern((3 * 1024 * 1024) + 77);
+	REQUIRE("0ce4aa110ad67efc723da521ca03d292b52a54ad69e10b64031bcdf7b3d119c367c6503804abe9ec87d486ec31b325b8785f4c71b9b9bf9efad3fa5061906986"
+			== Hash().addData(s13.data(), s13.size()).finalize().toString());
+
+	Hash s14;
+	s14.addData(s11, strlen(s11)).finalize();
+	s14.reset();
+	REQUIRE("b5ef811a8038f70b628fa8b294daae7492b1ebe343a80eaabbf1f6ae664dd67b9d90b0120791eab81dc96985f28849f6a305186a85501b405114bfa678df9380"
+			== s14.finalize().toString());
+
+	const int s15[2] = {0};
+	const char s15_2[8] = {0};
+	REQUIRE(Hash().addData(Hash::Span<const int>(s15)).finalize().toString()
+			== Hash().addData(s15_2).finalize().toString());
+
+	const unsigned char s16[] = {0x00, 0x0A};
+	const auto s16_1 = Hash().addData(s16, 2).finalize().toArray();
+	const auto s16_2 = Hash().addData(s16).finalize().toArray();
+	REQUIRE(s16_1 == s16_2);
+
+	// snapshots around the 128-byte leaf blocks & the 512-byte stripes, up to 2 stripes are buffered
+	const auto s17 = pattern(2000);
+	SnapshotCheck::roundTrip([]() { return Hash(); }, s17, SnapshotCheck::splitsAround({128, 512, 1024}));
+	REQUIRE_FALSE(Hash().restore(Chocobo1::Blake2().serialize()));
+}
@@ -12,8 +12,11 @@
 #include "../src/blake2s.h"
 
 #include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 
 TEST_CASE("blake2s")
@@ -67,3 +70,88 @@ TEST_CASE("blake2s")
 	const auto s17_2 = Hash().addData(s17).finalize().toArray();
 	REQUIRE(s17_1 == s17_2);
 }
+
+TEST_CASE("blake2s-keyed")
+{
+	using Hash = Chocobo1::Blake2s;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	std::vector<uint8_t> key(32);
+	for (std::size_t i = 0; i < key.size(); ++i)
+		key[i] = static_cast<uint8_t>(i);
+
+	// generated with python hashlib
+	const std::pair<std::size_t, std::string> s1[] =
+	{
+		{0, "48a8997da407876b3d79c0d92325ad3b89cbb754d86ab71aee047ad345fd2c49"},
+		{1, "40d15fee7c328830166ac3f918650f807e7e01e177258cdc0a39b11f598066f1"},
+		{63, "c65382513f07460da39833cb666c5ed82e61b9e998f4b0c4287cee56c3cc9bcd"},
+		{64, "8975b0577fd35566d750b362b0897a26c399136df07bababbde6203ff2954ed4"},
+		{65, "21fe0ceb0052be7fb0f004187cacd7de67fa6eb0938d927677f2398c132317a8"},
+		{1000, "d5c42863172fb2424de520ff25866bf2ac9201ce81b6a8b703f67ea4c6735767"}
+	};
+	const Hash keyed(key);
+	for (const auto &s : s1)
+	{
+		const auto data = pattern(s.first);
+		REQUIRE(s.second == Hash(key).addData(data.data(), data.size()).finalize().toString());
+
+		// copy of the precomputed keyed state
+		Hash copy = keyed;
+		REQUIRE(s.second == copy.addData(data.data(), data.size()).finalize().toString());
+
+		Hash chunked(key);
+		for (std::size_t i = 0; i < data.size(); i += 7)
+			chunked.addData((data.data() + i), std::min<std::size_t>(7, (data.size() - i)));
+		REQUIRE(s.second == chunked.finalize().toString());
+	}
+
+	Hash s2(key);
+	const auto s2Data = pattern(1000);
+	s2.addData(s2Data.data(), s2Data.size()).finalize();
+	s2.reset();
+	REQUIRE(s1[0].second == s2.finalize().toString());
+
+	// salt, personalization & digest length
+	const char s3Key[] = "key";
+	const char s3Salt[] = "01234567";
+	const char s3Personal[] = "person!!";
+	Hash::Parameters s3Params;
+	s3Params.digestLength = 20;
+	std::memcpy(s3Params.salt.data(), s3Salt, s3Params.salt.size());
+	std::memcpy(s3Params.personalization.data(), s3Personal, s3Params.personalization.size());
+	const Hash s3(Hash::Span<const uint8_t>(reinterpret_cast<const uint8_t *>(s3Key), strlen(s3Key)), s3Params);
+	REQUIRE("0162123aec0bd2a87d4f974321d393c39996b548" == Hash(s3).addData("abc", 3).finalize().toString());
+	REQUIRE(20 == Hash(s3).addData("abc", 3).finalize().toVector().size());
+
+	const auto s3Array = Hash(s3).addData("abc", 3).finalize().toArray();
+	REQUIRE(s3Array.size() == 32);
+	REQUIRE(std::all_of((s3Array.begin() + 20), s3Array.end(), [](const uint8_t c) { return c == 0; }));
+
+	Hash::Parameters s4Params;
+	s4Params.digestLength = 16;
+	REQUIRE("aa4938119b1dc7b87cbad0ffd200d0ae" == Hash(s4Params).addData("abc", 3).finalize().toString());
+
+	const uint8_t s5Key[] = {'k'};
+	REQUIRE("5175c87d8aa9480d45ba9a546f2a436f" == Hash(s5Key, s4Params).finalize().toString());
+
+	// snapshots & peeks around the 64-byte blocks, the last full block is held back until more data arrives
+	const auto s6 = pattern(1000);
+	const auto s6Splits = SnapshotCheck::splitsAround({64, 128});
+	SnapshotCheck::roundTrip([&]() { return Hash(s4Params); }, s6, s6Splits
+		, []() { return Hash(); }  // different parameters
+		, [&]() { return Hash(s5Key, s4Params); });  // keyed
+	SnapshotCheck::peek([&]() { return Hash(s4Params); }, s6, s6Splits);  // `digestLength` bytes long
+	SnapshotCheck::peek([&]() { return Hash(key); }, s6, s6Splits);
+
+	// keyed states aren't handed out
+	for (const std::size_t split : s6Splits)
+		REQUIRE(Hash(key).addData(s6.data(), split).serialize().empty());
+}
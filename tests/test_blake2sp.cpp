@@ -0,0 +1,105 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/blake2sp.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <cstring>
+
+
+TEST_CASE("blake2sp")
+{
+	using Hash = Chocobo1::Blake2sp;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	// official test suite
+	REQUIRE("dd0e891776933f43c7d032b08a917e25741f8aa9a12c12e1cac8801500f2ca4f"
+			== Hash().finalize().toString());
+
+
+	// my own tests
+	const char s1[] = "abc";
+	REQUIRE("70f75b58f1fecab821db43c88ad84edde5a52600616cd22517b7bb14d440a7d5"
+			== Hash().addData(s1, strlen(s1)).finalize().toString());
+
+	const char s2[] = "a";
+	Hash test2;
+	for (long int i = 0 ; i < 1000000; ++i)
+		test2.addData(s2, strlen(s2));
+	REQUIRE("106cd96590d84eede13f09f3940b8e1a7c728988f9b771f811a2f21fd768cc92"
+			== test2.finalize().toString());
+
+	const char s11[] = "The quick brown fox jumps over the lazy dog";
+	REQUIRE("cf192976714bb648e72b29fa90e6bf0fbc5bf2efe7d5c26ed8ff34e855368691"
+			== Hash().addData(s11, strlen(s11)).finalize().toString());
+
+	// around block & stripe boundaries
+	const std::pair<std::size_t, std::string> s12[] =
+	{
+		{63, "1024c940be7341449b5010522b509f65bbdc1287b455c2bb7f72b2c92fd0d189"},
+		{64, "52603b6cbfad4966cb044cb267568385cf35f21e6c45cf30aed19832cb51e9f5"},
+		{512, "8d9e357863298dd8364b7caf4234317f8a49f180d788b7abffb521925f1e1ff1"},
+		{513, "8a4bc3330497e681f15daf24fc496044a1c32bf0a837a210399e1ae4af7e92be"},
+		{640, "6cfddeada48f1c33e72a7010017398c1835a78f45ca9901ac69204bc538f2ab8"},
+		{1024, "48467549502e2d3f422870bfb1d09bce71a065735763bf654582cf46a5112793"},
+		{1025, "04e03e65b8f19a5f46288802b2a515bab73363262caa300ae75c0eb29c016e5a"},
+		{1537, "d4352a7dd38affbfec4d3f5e04b7955038f15af30d21e099899080dc5ea66c32"},
+		{5000, "654900a5431ad42ce22176aab694c795fd0fa188b2677f70849e6ba19dd2202d"}
+	};
+	for (const auto &s : s12)
+	{
+		const auto data = pattern(s.first);
+		REQUIRE(s.second == Hash().addData(data.data(), data.size()).finalize().toString());
+
+		for (const std::size_t chunk : {1, 100, 512, 700})
+		{
+			Hash hash;
+			for (std::size_t i = 0; i < data.size(); i += chunk)
+				hash.addData((data.data() + i), std::min(chunk, (data.size() - i)));
+			REQUIRE(s.second == hash.finalize().toString());
+		}
+	}
+
+	// large enough to be split across threads
+	const auto s13 = pattern((3 * 1024 * 1024) + 77);
+	REQUIRE("47702c3c6cb342c3f5c61210d1cf0c27f53b489f6028407c74d7dddffbc57636"
+			== Hash().addData(s13.data(), s13.size()).finalize().toString());
+
+	Hash s14;
+	s14.addData(s11, strlen(s11)).finalize();
+	s14.reset();
+	REQUIRE("dd0e891776933f43c7d032b08a917e25741f8aa9a12c12e1cac8801500f2ca4f"
+			== s14.finalize().toString());
+
+	const int s15[2] = {0};
+	const char s15_2[8] = {0};
+	REQUIRE(Hash().addData(Hash::Span<const int>(s15)).finalize().toString()
+			== Hash().addData(s15_2).finalize().toString());
+
+	const unsigned char s16[] = {0x00, 0x0A};
+	const auto s16_1 = Hash().addData(s16, 2).finalize().toArray();
+	const auto s16_2 = Hash().addData(s16).finalize().toArray();
+	REQUIRE(s16_1 == s16_2);
+
+	// snapshots around the 64-byte leaf blocks & the 512-byte stripes, up to 2 stripes are buffered
+	const auto s17 = pattern(2000);
+	SnapshotCheck::roundTrip([]() { return Hash(); }, s17, SnapshotCheck::splitsAround({64, 512, 1024}));
+	REQUIRE_FALSE(Hash().restore(Chocobo1::Blake2s().serialize()));
+}
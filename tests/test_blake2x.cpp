@@ -0,0 +1,138 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/blake2x.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <cstring>
+#include <stdexcept>
+
+
+TEST_CASE("blake2xb")
+{
+	using Hash = Chocobo1::Blake2Xb;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	REQUIRE("34" == Hash(1).finalize().toString());
+	REQUIRE_THROWS_AS(Hash(0), std::invalid_argument);
+
+	const char s1[] = "abc";
+	REQUIRE("2fb422fd52e01ea99b5ba67723173cee4b74f2b6cb5fe527a45b7216b98957a946f10f20196d094a391f8aa5e3720962b19d5affde2ed8cc8c489d6e84b75ab2"
+			== Hash(64).addData(s1, strlen(s1)).finalize().toString());
+
+	const char s2[] = "The quick brown fox jumps over the lazy dog";
+	REQUIRE("02824bc7179180e26017f06da27552e98de0f060a890b3b1d1cbbbb6bd5ec353611f8ceb52604e61b47b2923e928fd5dcfe68515c9fd6362814a93f2e271aeee8fbbc8969d2f7f6dbd20a5f5dea80a95157e9c7021bf966c55e6b8be67a1dc24121fb9a7"
+			== Hash(100).addData(s2, strlen(s2)).finalize().toString());
+
+	const auto s3 = pattern(1000);
+	REQUIRE("93a2589ac97bd6c4f6fa83e2306eb223130fefc5f6b2671d66d62d7d35dce9963ab53f3d51e3dd859fecbc7df48f65a4c0fe466bf1c79e9dfb989804b671f657f97455e9ec8c69aa5e0b45a0984f8512b07a59d53a403c1d3a24f9cd30b2f83f932d6738aee90af5ed812e31cf802daca00745d3ce90b0f320601c52512d609a005f0546b43f10a290b5374e41dc4af4fe5407976c65e7f04aeceae8f3f27f1679d2904692e725f5e2385bfa2cb0f460dcee7b3325b1ec76d4e13e5176c1ac71f51eed785b737caa92fdc58587a9b871efdb1be99e61a90b6804fb6363d21e3f0f063aac23c73cc4753433993ad784ed6e397175be4cc08c58cd827dd288ffa22cd8061f778153f70ab5483279692ec6ae864c59866d6687b6470819ea3896f317abad24501ebd27789c5bc50714b069b35a6bcb8a3d6ab3a0a274376d4ef7ff71cd664bc4c0b872421a51263f"
+			== Hash(333).addData(s3.data(), s3.size()).finalize().toString());
+
+	// large enough to be split across threads
+	const int s4Length = (3 * 1024 * 1024) + 5;
+	const auto s4 = Hash(s4Length).addData(s1, strlen(s1)).finalize().toVector();
+	REQUIRE(s4.size() == s4Length);
+	const auto toHex = [](const std::vector<uint8_t> &v, const std::size_t offset, const std::size_t length) -> std::string
+	{
+		std::string ret;
+		for (std::size_t i = offset; i < (offset + length); ++i)
+		{
+			const char digits[] = "0123456789abcdef";
+			ret += digits[v[i] >> 4];
+			ret += digits[v[i] & 0xf];
+		}
+		return ret;
+	};
+	REQUIRE("3f5009db09c8e86be857da6c3373b8928622e504ecd75fb08cdfa17d621a8fc03028db16e51618cffecfffdc877a18e1e19cb26fd36a7bc49625dc4219fe9dc5"
+			== toHex(s4, 0, 64));
+	REQUIRE("86b745f5f80efdb697adabbacd4838b0e8f81fbb647f89b1cdbc9b5950945220f30501a70723d5a7a4c2a0ccce795acbb18759bf792148d8839ff36f231e6ed5"
+			== toHex(s4, (12345 * 64), 64));
+	REQUIRE("de5c32a0e5" == toHex(s4, (s4Length - 5), 5));
+
+	Hash s5(100);
+	s5.addData(s1, strlen(s1)).finalize();
+	s5.reset();
+	REQUIRE("02824bc7179180e26017f06da27552e98de0f060a890b3b1d1cbbbb6bd5ec353611f8ceb52604e61b47b2923e928fd5dcfe68515c9fd6362814a93f2e271aeee8fbbc8969d2f7f6dbd20a5f5dea80a95157e9c7021bf966c55e6b8be67a1dc24121fb9a7"
+			== s5.addData(s2, strlen(s2)).finalize().toString());
+
+	const int s15[2] = {0};
+	const char s15_2[8] = {0};
+	REQUIRE(Hash(100).addData(Hash::Span<const int>(s15)).finalize().toString()
+			== Hash(100).addData(s15_2).finalize().toString());
+
+	const unsigned char s16[] = {0x00, 0x0A};
+	const auto s16_1 = Hash(100).addData(s16, 2).finalize().toVector();
+	const auto s16_2 = Hash(100).addData(s16).finalize().toVector();
+	REQUIRE(s16_1 == s16_2);
+}
+
+
+TEST_CASE("blake2xs")
+{
+	using Hash = Chocobo1::Blake2Xs;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	REQUIRE("07" == Hash(1).finalize().toString());
+
+	const char s1[] = "abc";
+	REQUIRE("efc558202baf61be20d27f9c65d735f9274fae9715f9bbd1d7ca0ab2f5c3ddb774d415f79d2263d193911018f1137b276e78c4f8811926a2ab80b16efa1f0973"
+			== Hash(64).addData(s1, strlen(s1)).finalize().toString());
+
+	const char s2[] = "The quick brown fox jumps over the lazy dog";
+	REQUIRE("b161ab91ff26f9f0884fca6959d6d095d75b93b11c14f8279d36661bbad5a274c2528d01e0deaa2f3d5e1bad811a08900f84cee86f92b0403c6266a4bb077d8561e42be74c36c75df68f42e1295fb56368621cf1d5424a3805145d7ec68de77ee7fe65ce"
+			== Hash(100).addData(s2, strlen(s2)).finalize().toString());
+
+	const auto s3 = pattern(1000);
+	REQUIRE("289c6a60b31127693694b7f5fb948c1a2be8bb620adb1b2ae561031221e064c02d6c8ec46ee7d433eab4089cdaddf6b5e633cda1971bb5b5bdf09c2adafcb5d87af2daf59e57c5885cf952f4dfec1903512286eeb9b0cf7703338a7c6451993af1637b7ef0acec77ddbe57faa9bb0c8855e941b80c579a5bd10569565fce4c950ff0cbec1af25657c20036e1a3ae4d877ba652ce9b96e21e1b93b95351578caccc88152bfda4c71e19920d2266f74c57d07e75bd1e76e2e5a8cc82328341002a094cb16cc2c71a65f3ab1cd8f904b0c23fc7717661d6dfd1858bab38ef4a97d471f03c56f62db48146e0515de0b957b09f8f519cc45b8f55354ef83a49d536184038900be2aba3e23a6199d2e894a53f5d605c8afa7128df9484120679fb612f8eb47602c1f79f333d4a0d7d47fb0899365233809b1aed78273f79b19fdbbed3ada14f04b53cfd70a8c5fe1c9d"
+			== Hash(333).addData(s3.data(), s3.size()).finalize().toString());
+
+	// maximum known length
+	const auto s4 = Hash(65534).addData(s1, strlen(s1)).finalize().toString();
+	REQUIRE("614e29c45fc357ac94794356a55c46a794e479779d83e92c1a5105c18d5bcdb6f08812f7a7119e94"
+			== s4.substr(s4.size() - 80));
+
+	// out of range lengths are rejected
+	REQUIRE_THROWS_AS(Hash(0), std::invalid_argument);
+	REQUIRE_THROWS_AS(Hash(-5), std::invalid_argument);
+	REQUIRE_THROWS_AS(Hash(Hash::MAX_DIGEST_LENGTH + 1), std::invalid_argument);
+	REQUIRE_THROWS_AS(Hash(1000000), std::invalid_argument);
+
+	const int s15[2] = {0};
+	const char s15_2[8] = {0};
+	REQUIRE(Hash(100).addData(Hash::Span<const int>(s15)).finalize().toString()
+			== Hash(100).addData(s15_2).finalize().toString());
+
+	const unsigned char s16[] = {0x00, 0x0A};
+	const auto s16_1 = Hash(100).addData(s16, 2).finalize().toVector();
+	const auto s16_2 = Hash(100).addData(s16).finalize().toVector();
+	REQUIRE(s16_1 == s16_2);
+
+	// snapshots around the 64-byte blocks of the root Blake2s
+	SnapshotCheck::roundTrip([]() { return Hash(333); }, s3, SnapshotCheck::splitsAround({64, 128})
+		, []() { return Hash(334); }  // different length
+		, []() { return Chocobo1::Blake2Xb(333); });
+}
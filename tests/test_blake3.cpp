@@ -0,0 +1,179 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/blake3.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <cstring>
+#include <tuple>
+
+
+TEST_CASE("blake3")
+{
+	using Hash = Chocobo1::Blake3;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	const auto toHex = [](const std::vector<uint8_t> &data) -> std::string
+	{
+		const char digits[] = "0123456789abcdef";
+		std::string ret;
+		for (const auto c : data)
+		{
+			ret += digits[c >> 4];
+			ret += digits[c & 0xf];
+		}
+		return ret;
+	};
+
+	const char keyString[] = "whats the Elvish word for friend";
+	Hash::KeyArrayType key {};
+	std::memcpy(key.data(), keyString, key.size());
+	const std::string context = "BLAKE3 2019-12-27 16:29:52 test vectors context";
+
+	// official test suite
+	// input length, hash, keyed hash, derived key
+	const std::tuple<std::size_t, std::string, std::string, std::string> s1[] =
+	{
+		{0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"
+			, "92b2b75604ed3c761f9d6f62392c8a9227ad0ea3f09573e783f1498a4ed60d26"
+			, "2cc39783c223154fea8dfb7c1b1660f2ac2dcbd1c1de8277b0b0dd39b7e50d7d"},
+		{1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"
+			, "6d7878dfff2f485635d39013278ae14f1454b8c0a3a2d34bc1ab38228a80c95b"
+			, "b3e2e340a117a499c6cf2398a19ee0d29cca2bb7404c73063382693bf66cb06c"},
+		{1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11"
+			, "c951ecdf03288d0fcc96ee3413563d8a6d3589547f2c2fb36d9786470f1b9d6e"
+			, "74a16c1c3d44368a86e1ca6df64be6a2f64cce8f09220787450722d85725dea5"},
+		{1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"
+			, "75c46f6f3d9eb4f55ecaaee480db732e6c2105546f1e675003687c31719c7ba4"
+			, "7356cd7720d5b66b6d0697eb3177d9f8d73a4a5c5e968896eb6a689684302706"},
+		{1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"
+			, "357dc55de0c7e382c900fd6e320acc04146be01db6a8ce7210b7189bd664ea69"
+			, "effaa245f065fbf82ac186839a249707c3bddf6d3fdda22d1b95a3c970379bcb"},
+		{2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a"
+			, "879cf1fa2ea0e79126cb1063617a05b6ad9d0b696d0d757cf053439f60a99dd1"
+			, "7b2945cb4fef70885cc5d78a87bf6f6207dd901ff239201351ffac04e1088a23"},
+		{2049, "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030"
+			, "9f29700902f7c86e514ddc4df1e3049f258b2472b6dd5267f61bf13983b78dd5"
+			, "2ea477c5515cc3dd606512ee72bb3e0e758cfae7232826f35fb98ca1bcbdf273"},
+		{3072, "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2"
+			, "044a0e7b172a312dc02a4c9a818c036ffa2776368d7f528268d2e6b5df191770"
+			, "050df97f8c2ead654d9bb3ab8c9178edcd902a32f8495949feadcc1e0480c46b"},
+		{3073, "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3"
+			, "68dede9bef00ba89e43f31a6825f4cf433389fedae75c04ee9f0cf16a427c95a"
+			, "72613c9ec9ff7e40f8f5c173784c532ad852e827dba2bf85b2ab4b76f7079081"},
+		{4096, "015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e969"
+			, "befc660aea2f1718884cd8deb9902811d332f4fc4a38cf7c7300d597a081bfc0"
+			, "1e0d7f3db8c414c97c6307cbda6cd27ac3b030949da8e23be1a1a924ad2f25b9"},
+		{4097, "9b4052b38f1c5fc8b1f9ff7ac7b27cd242487b3d890d15c96a1c25b8aa0fb995"
+			, "00df940cd36bb9fa7cbbc3556744e0dbc8191401afe70520ba292ee3ca80abbc"
+			, "aca51029626b55fda7117b42a7c211f8c6e9ba4fe5b7a8ca922f34299500ead8"},
+		{5121, "628bd2cb2004694adaab7bbd778a25df25c47b9d4155a55f8fbd79f2fe154cff"
+			, "6ccf1c34753e7a044db80798ecd0782a8f76f33563accaddbfbb2e0ea4b2d024"
+			, "b07f01e518e702f7ccb44a267e9e112d403a7b3f4883a47ffbed4b48339b3c34"},
+		{8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"
+			, "954a2a75420c8d6547e3ba5b98d963e6fa6491addc8c023189cc519821b4a1f5"
+			, "af1e0346e389b17c23200270a64aa4e1ead98c61695d917de7d5b00491c9b0f1"},
+		{16384, "f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde4"
+			, "9e9fc4eb7cf081ea7c47d1807790ed211bfec56aa25bb7037784c13c4b707b0d"
+			, "160e18b5878cd0df1c3af85eb25a0db5344d43a6fbd7a8ef4ed98d0714c3f7e1"},
+		{31744, "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47"
+			, "efa53b389ab67c593dba624d898d0f7353ab99e4ac9d42302ee64cbf9939a419"
+			, "39772aef80e0ebe60596361e45b061e8f417429d529171b6764468c22928e28e"},
+		{102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"
+			, "1c35d1a5811083fd7119f5d5d1ba027b4d01c0c6c49fb6ff2cf75393ea5db4a7"
+			, "4652cff7a3f385a6103b5c260fc1593e13c778dbe608efb092fe7ee69df6e9c6"}
+	};
+	for (const auto &s : s1)
+	{
+		const auto data = pattern(std::get<0>(s));
+		REQUIRE(std::get<1>(s) == Hash().addData(data.data(), data.size()).finalize().toString());
+		REQUIRE(std::get<2>(s) == Hash(key).addData(data.data(), data.size()).finalize().toString());
+		REQUIRE(std::get<3>(s) == Hash(context).addData(data.data(), data.size()).finalize().toString());
+
+		for (const std::size_t chunk : {1, 100, 1024, 4096})
+		{
+			Hash hash;
+			for (std::size_t i = 0; i < data.size(); i += chunk)
+				hash.addData((data.data() + i), std::min(chunk, (data.size() - i)));
+			REQUIRE(std::get<1>(s) == hash.finalize().toString());
+		}
+	}
+
+	// extendable output
+	REQUIRE("af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262e00f03e7b69af26b7faaf09fcd333050338ddfe085b8cc869ca98b206c08243a26f5487789e8f660afe6c99ef9e0c52b92e7393024a80459cf91f476f9ffdbda7001c22e159b402631f277ca96f2defdf1078282314e763699a31c5363165421cce14d"
+			== toHex(Hash().finalize().toVector(131)));
+
+	const auto s2 = pattern(5121);
+	REQUIRE("6ccf1c34753e7a044db80798ecd0782a8f76f33563accaddbfbb2e0ea4b2d0240d07e63f13667a8d1490e5e04f13eb617aea16a8c8a5aaed1ef6fbde1b0515e3c81050b361af6ead126032998290b563e3caddeaebfab592e155f2e161fb7cba939092133f23f9e65245e58ec23457b78a2e8a125588aad6e07d7f11a85b88d375b72d"
+			== toHex(Hash(key).addData(s2.data(), s2.size()).finalize().toVector(131)));
+
+
+	// my own tests
+	const char s3[] = "abc";
+	REQUIRE("6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85"
+			== Hash().addData(s3, strlen(s3)).finalize().toString());
+
+	const char s4[] = "a";
+	Hash test4;
+	for (long int i = 0 ; i < 1000000; ++i)
+		test4.addData(s4, strlen(s4));
+	REQUIRE("616f575a1b58d4c9797d4217b9730ae5e6eb319d76edef6549b46f4efe31ff8b"
+			== test4.finalize().toString());
+
+	const char s11[] = "The quick brown fox jumps over the lazy dog";
+	REQUIRE("2f1514181aadccd913abd94cfa592701a5686ab23f8df1dff1b74710febc6d4a"
+			== Hash().addData(s11, strlen(s11)).finalize().toString());
+
+	// large enough to be split across threads
+	const auto s13 = pattern((3 * 1024 * 1024) + 77);
+	REQUIRE("2d73fca65af826c9ead9180eaf7d83e1b0e3a7bdb55ba17465155ec442f7df41"
+			== Hash().addData(s13.data(), s13.size()).finalize().toString());
+
+	Hash s14;
+	s14.addData(s11, strlen(s11)).finalize();
+	s14.reset();
+	REQUIRE("af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"
+			== s14.finalize().toString());
+
+	const int s15[2] = {0};
+	const char s15_2[8] = {0};
+	REQUIRE(Hash().addData(Hash::Span<const int>(s15)).finalize().toString()
+			== Hash().addData(s15_2).finalize().toString());
+
+	const unsigned char s16[] = {0x00, 0x0A};
+	const auto s16_1 = Hash().addData(s16, 2).finalize().toArray();
+	const auto s16_2 = Hash().addData(s16).finalize().toArray();
+	REQUIRE(s16_1 == s16_2);
+
+	// snapshots & peeks around the 64-byte blocks, the 1024-byte chunks & the 16-chunk SIMD batches
+	const auto s17 = pattern(20000);
+	const auto s17Splits = SnapshotCheck::splitsAround({64, 1024, 2048, 16384});
+	SnapshotCheck::roundTrip([]() { return Hash(); }, s17, s17Splits
+		, [&]() { return Hash(context); }  // different mode
+		, [&]() { return Hash(key); });  // keyed
+	SnapshotCheck::peek([]() { return Hash(); }, s17, s17Splits);
+
+	// keyed & key derivation states aren't handed out
+	for (const std::size_t split : s17Splits)
+	{
+		REQUIRE(Hash(key).addData(s17.data(), split).serialize().empty());
+		REQUIRE(Hash(context).addData(s17.data(), split).serialize().empty());
+	}
+}
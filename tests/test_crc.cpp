@@ -0,0 +1,270 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2017-2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/crc.h"
+#include "../src/crc_32.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+	std::vector<uint8_t> pattern(const std::size_t length)
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	}
+
+	template <typename Hash>
+	void checkVectors(const std::pair<std::size_t, std::string> (&vectors)[12])
+	{
+		for (const auto &v : vectors)
+		{
+			const auto data = pattern(v.first + 1);
+			REQUIRE(v.second == Hash().addData(data.data(), v.first).finalize().toString());
+
+			// misaligned
+			std::vector<uint8_t> shifted(v.first + 1);
+			std::memcpy((shifted.data() + 1), data.data(), v.first);
+			REQUIRE(v.second == Hash().addData((shifted.data() + 1), v.first).finalize().toString());
+
+			for (const std::size_t chunk : {1, 7, 64, 1000})
+			{
+				Hash hash;
+				for (std::size_t i = 0; i < v.first; i += chunk)
+					hash.addData((data.data() + i), std::min(chunk, (v.first - i)));
+				REQUIRE(v.second == hash.finalize().toString());
+			}
+
+			for (const std::size_t split : {std::size_t(0), (v.first / 3), v.first})
+			{
+				Hash first;
+				first.addData(data.data(), split);
+				Hash second;
+				second.addData((data.data() + split), (v.first - split));
+				REQUIRE(v.second == first.combine(second, (v.first - split)).finalize().toString());
+			}
+		}
+	}
+
+	// one bit at a time, shares nothing with the table, `crc32` & PCLMUL paths
+	// reflected with all-ones init & xorout, as every preset with a SIMD path
+	template <int Width, uint64_t Poly>
+	std::string bitwiseReflected(const uint8_t *data, const std::size_t length)
+	{
+		const uint64_t ones = (Width == 64) ? ~uint64_t(0) : ((uint64_t(1) << (Width % 64)) - 1);
+
+		uint64_t reversedPoly = 0;
+		for (int i = 0; i < Width; ++i)
+		{
+			if (((Poly >> i) & 1) != 0)
+				reversedPoly |= (uint64_t(1) << (Width - 1 - i));
+		}
+
+		uint64_t crc = ones;
+		for (std::size_t i = 0; i < length; ++i)
+		{
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; ++bit)
+				crc = ((crc & 1) != 0) ? ((crc >> 1) ^ reversedPoly) : (crc >> 1);
+		}
+		crc ^= ones;
+
+		char ret[17] = {};
+		std::snprintf(ret, sizeof(ret), "%0*llx", (Width / 4), static_cast<unsigned long long>(crc));
+		return ret;
+	}
+
+	template <typename Hash, int Width, uint64_t Poly>
+	void checkBitwise()
+	{
+		// every tail length around the 64-byte folds, then around the 3 * 4096-byte lanes of CRC-32C
+		const auto data = pattern((3 * 4096) + 300);
+		std::vector<std::size_t> lengths;
+		for (std::size_t length = 0; length <= 300; ++length)
+			lengths.push_back(length);
+		for (const std::size_t length : {4095, 4096, 4097, 12287, 12288, 12289, 12350})
+			lengths.push_back(length);
+
+		for (const std::size_t length : lengths)
+		{
+			REQUIRE(bitwiseReflected<Width, Poly>(data.data(), length) == Hash().addData(data.data(), length).finalize().toString());
+		}
+	}
+}
+
+TEST_CASE("crc")
+{
+	// https://reveng.sourceforge.io/crc-catalogue/ check values
+	const char s1[] = "123456789";
+	const std::size_t s1Size = strlen(s1);
+
+	REQUIRE("f4" == Chocobo1::Crc<8, 0x07, false, 0x00, 0x00>().addData(s1, s1Size).finalize().toString());  // CRC-8/SMBUS
+	REQUIRE("bb3d" == Chocobo1::Crc<16, 0x8005, true, 0x0000, 0x0000>().addData(s1, s1Size).finalize().toString());  // CRC-16/ARC
+	REQUIRE("29b1" == Chocobo1::Crc<16, 0x1021, false, 0xFFFF, 0x0000>().addData(s1, s1Size).finalize().toString());  // CRC-16/IBM-3740
+	REQUIRE("c25a56" == Chocobo1::Crc<24, 0x00065B, true, 0x555555, 0x000000>().addData(s1, s1Size).finalize().toString());  // CRC-24/BLE
+	REQUIRE("21cf02" == Chocobo1::Crc<24, 0x864CFB, false, 0xB704CE, 0x000000>().addData(s1, s1Size).finalize().toString());  // CRC-24/OPENPGP
+	REQUIRE("cbf43926" == Chocobo1::CRC_32().addData(s1, s1Size).finalize().toString());
+	REQUIRE("fc891918" == Chocobo1::Crc<32, 0x04C11DB7, false, 0xFFFFFFFF, 0xFFFFFFFF>().addData(s1, s1Size).finalize().toString());  // CRC-32/BZIP2
+	REQUIRE("e3069283" == Chocobo1::CRC_32C().addData(s1, s1Size).finalize().toString());
+	REQUIRE("d4164fc646" == Chocobo1::Crc<40, 0x0004820009, false, 0x0000000000, 0xFFFFFFFFFF>().addData(s1, s1Size).finalize().toString());  // CRC-40/GSM
+	REQUIRE("6c40df5f0b497347" == Chocobo1::Crc<64, 0x42F0E1EBA9EA3693, false, 0x0000000000000000, 0x0000000000000000>().addData(s1, s1Size).finalize().toString());  // CRC-64/ECMA-182
+	REQUIRE("ae8b14860a799888" == Chocobo1::CRC_64_NVME().addData(s1, s1Size).finalize().toString());
+	REQUIRE("995dc9bbdf1939fa" == Chocobo1::CRC_64_XZ().addData(s1, s1Size).finalize().toString());
+
+	// slicing depth doesn't change the result
+	const auto s2 = pattern(1000);
+	const auto s2Expected = Chocobo1::CRC_64_XZ().addData(s2.data(), s2.size()).finalize().toString();
+	REQUIRE(s2Expected == Chocobo1::Crc<64, 0x42F0E1EBA9EA3693, true, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 1>().addData(s2.data(), s2.size()).finalize().toString());
+	REQUIRE(s2Expected == Chocobo1::Crc<64, 0x42F0E1EBA9EA3693, true, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 4>().addData(s2.data(), s2.size()).finalize().toString());
+	REQUIRE(s2Expected == Chocobo1::Crc<64, 0x42F0E1EBA9EA3693, true, 0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF, 16>().addData(s2.data(), s2.size()).finalize().toString());
+	using Crc16 = Chocobo1::Crc<16, 0x1021, false, 0xFFFF, 0x0000, 16>;
+	REQUIRE(Crc16().addData(s2.data(), s2.size()).finalize().toString()
+			== Chocobo1::Crc<16, 0x1021, false, 0xFFFF, 0x0000, 1>().addData(s2.data(), s2.size()).finalize().toString());
+
+	// combine for non-reflected
+	Crc16 s3First;
+	s3First.addData(s1, 4);
+	Crc16 s3Second;
+	s3Second.addData((s1 + 4), (s1Size - 4));
+	REQUIRE("29b1" == s3First.combine(s3Second, (s1Size - 4)).finalize().toString());
+
+	// the SIMD paths (`run_tests_simd`) & the table path agree with the definition
+	checkBitwise<Chocobo1::CRC_32, 32, 0x04C11DB7>();
+	checkBitwise<Chocobo1::CRC_32C, 32, 0x1EDC6F41>();
+	checkBitwise<Chocobo1::CRC_64_NVME, 64, 0xAD93D23594C93659>();
+	checkBitwise<Chocobo1::CRC_64_XZ, 64, 0x42F0E1EBA9EA3693>();
+}
+
+TEST_CASE("crc-32c")
+{
+	using Hash = Chocobo1::CRC_32C;
+
+	// my own tests
+	const std::pair<std::size_t, std::string> s1[] =
+	{
+		{0, "00000000"},
+		{1, "527d5351"},
+		{15, "68ef03f6"},
+		{16, "d9c908eb"},
+		{63, "7a873004"},
+		{64, "fb6d36eb"},
+		{65, "694420fa"},
+		{127, "6c31bd0c"},
+		{1000, "11f66220"},
+		{12288, "b30be1ed"},
+		{12295, "70096e45"},
+		{40000, "68608d15"}
+	};
+	checkVectors<Hash>(s1);
+
+	const auto s2 = pattern((3 * 1024 * 1024) + 5);
+	const auto s2Sequential = Hash().addData(s2.data(), s2.size()).finalize().toString();
+	for (const std::size_t threads : {0, 1, 3, 10000})
+		REQUIRE(s2Sequential == Hash().addDataParallel(s2.data(), s2.size(), threads).finalize().toString());
+
+	Hash s3;
+	s3.addData(s2.data(), s2.size()).finalize();
+	s3.reset();
+	REQUIRE("00000000" == s3.finalize().toString());
+
+	const int s4[2] = {0};
+	const char s4_2[8] = {0};
+	REQUIRE(Hash().addData(Hash::Span<const int>(s4)).finalize().toString()
+			== Hash().addData(s4_2).finalize().toString());
+
+	const unsigned char s5[] = {0x00, 0x0A};
+	const auto s5_1 = Hash().addData(s5, 2).finalize().toArray();
+	const auto s5_2 = Hash().addData(s5).finalize().toArray();
+	REQUIRE(s5_1 == s5_2);
+
+	// snapshots & peeks around the 64-byte folds & the 4096-byte lanes of the 3-lane merge
+	const auto s6 = pattern(13000);
+	const auto s6Splits = SnapshotCheck::splitsAround({64, 4096, 12288});
+	SnapshotCheck::roundTrip([]() { return Hash(); }, s6, s6Splits
+		, []() { return Chocobo1::CRC_32(); }  // different polynomial
+		, []() { return Chocobo1::CRC_64_XZ(); });  // different width
+	SnapshotCheck::peek([]() { return Hash(); }, s6, s6Splits);
+}
+
+TEST_CASE("crc-64/nvme")
+{
+	using Hash = Chocobo1::CRC_64_NVME;
+
+	// my own tests
+	const std::pair<std::size_t, std::string> s1[] =
+	{
+		{0, "0000000000000000"},
+		{1, "d5da5047efec8728"},
+		{15, "555fd71d5814a5e7"},
+		{16, "cf6454c75df95620"},
+		{63, "05e1746b5d43bc84"},
+		{64, "e13ddeba8972d85c"},
+		{65, "c2a59b652d8ed28b"},
+		{127, "81de5ecc9327565c"},
+		{1000, "3a2d3571b6998416"},
+		{12288, "652f7017226d3bdb"},
+		{12295, "feeeb3922a6bdb35"},
+		{40000, "e6edaf565dc54262"}
+	};
+	checkVectors<Hash>(s1);
+
+	const auto s2 = pattern((3 * 1024 * 1024) + 5);
+	const auto s2Sequential = Hash().addData(s2.data(), s2.size()).finalize().toString();
+	for (const std::size_t threads : {0, 1, 3, 10000})
+		REQUIRE(s2Sequential == Hash().addDataParallel(s2.data(), s2.size(), threads).finalize().toString());
+
+	const unsigned char s3[] = {0x00, 0x0A};
+	const auto s3_1 = Hash().addData(s3, 2).finalize().toArray();
+	const auto s3_2 = Hash().addData(s3).finalize().toArray();
+	REQUIRE(s3_1 == s3_2);
+}
+
+TEST_CASE("crc-64/xz")
+{
+	using Hash = Chocobo1::CRC_64_XZ;
+
+	// my own tests
+	const std::pair<std::size_t, std::string> s1[] =
+	{
+		{0, "0000000000000000"},
+		{1, "1fada17364673f59"},
+		{15, "edb6371293e5b0ca"},
+		{16, "7a64e421b6985356"},
+		{63, "1272c116cffa2aab"},
+		{64, "d098e69b0b93f24b"},
+		{65, "af76c475ab95eff9"},
+		{127, "fdf18b596bb90ea0"},
+		{1000, "3aa4c90fe06cddbb"},
+		{12288, "0ca523416a7972a0"},
+		{12295, "3b18353eb716fb7f"},
+		{40000, "425cf9a68588072d"}
+	};
+	checkVectors<Hash>(s1);
+
+	const auto s2 = pattern((3 * 1024 * 1024) + 5);
+	const auto s2Sequential = Hash().addData(s2.data(), s2.size()).finalize().toString();
+	for (const std::size_t threads : {0, 1, 3, 10000})
+		REQUIRE(s2Sequential == Hash().addDataParallel(s2.data(), s2.size(), threads).finalize().toString());
+
+	const unsigned char s3[] = {0x00, 0x0A};
+	const auto s3_1 = Hash().addData(s3, 2).finalize().toArray();
+	const auto s3_2 = Hash().addData(s3).finalize().toArray();
+	REQUIRE(s3_1 == s3_2);
+}
@@ -14,6 +14,7 @@
 #include "catch2/single_include/catch2/catch.hpp"
 
 #include <cstring>
+#include <vector>
 
 
 TEST_CASE("crc-32")
@@ -46,3 +47,50 @@ TEST_CASE("crc-32")
 	const auto s16_2 = Hash().addData(s16).finalize().toArray();
 	REQUIRE(s16_1 == s16_2);
 }
+
+TEST_CASE("crc-32 combine")
+{
+	using Hash = Chocobo1::CRC_32;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	// my own tests
+	const char s1[] = "The quick brown fox jumps over the lazy dog";
+	const std::size_t s1Size = strlen(s1);
+	for (std::size_t i = 0; i <= s1Size; ++i)
+	{
+		Hash second;
+		second.addData((s1 + i), (s1Size - i));
+		REQUIRE("414fa339" == Hash().addData(s1, i).combine(second, (s1Size - i)).finalize().toString());
+	}
+
+	const auto s2 = pattern(100000);
+	for (const std::size_t split : {0, 1, 15, 16, 17, 4096, 65537, 100000})
+	{
+		Hash first;
+		first.addData(s2.data(), split);
+		Hash second;
+		second.addData((s2.data() + split), (s2.size() - split));
+		REQUIRE(Hash().addData(s2.data(), s2.size()).finalize().toString()
+				== first.combine(second, (s2.size() - split)).finalize().toString());
+	}
+
+	// parallel
+	const auto s3 = pattern((5 * 1024 * 1024) + 3);
+	const auto s3Sequential = Hash().addData(s3.data(), s3.size()).finalize().toString();
+	for (const std::size_t threads : {0, 1, 2, 3, 7, 16})
+		REQUIRE(s3Sequential == Hash().addDataParallel(s3.data(), s3.size(), threads).finalize().toString());
+
+	Hash s4;
+	s4.addData(s3.data(), 10);
+	s4.addDataParallel((s3.data() + 10), (s3.size() - 10), 4);
+	REQUIRE(s3Sequential == s4.finalize().toString());
+
+	REQUIRE("414fa339" == Hash().addDataParallel(s1, s1Size, 4).finalize().toString());
+}
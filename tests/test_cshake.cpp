@@ -12,8 +12,11 @@
 #include "../src/cshake.h"
 
 #include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
 
 #include <cstring>
+#include <string>
+#include <vector>
 
 
 #define ARRAY_LENGTH(a) (static_cast<int>(std::extent<decltype(a)>::value))
@@ -74,6 +77,29 @@ TEST_CASE("cshake-256")
 	const auto s17_1 = Hash(512).addData(s17, 2).finalize().toVector();
 	const auto s17_2 = Hash(512).addData(s17).finalize().toVector();
 	REQUIRE(s17_1 == s17_2);
+
+	const Hash s18((512 / 8), "", "Email Signature");
+	Hash s18_1 = s18;
+	REQUIRE("07dc27b11e51fbac75bc7b3c1d983e8b4b85fb1defaf218912ac86430273091727f42b17ed1df63e8ec118f04b23633c1dfb1574c8fb55cb45da8e25afb092bb"
+			== s18_1.addData(s2, ARRAY_LENGTH(s2)).finalize().toString());
+	s18_1.reset();
+	REQUIRE("d008828e2b80ac9d2218ffee1d070c48b8e4c87bff32c9699d5b6896eee0edd164020e2be0560858d9c00c037e34a96937c561a74c412bb4c746469527281c8c"
+			== s18_1.addData(s1, ARRAY_LENGTH(s1)).finalize().toString());
+
+	const auto s19_1 = Chocobo1::Hash::CShake_NS::leftEncode(0);
+	REQUIRE(std::vector<uint8_t>({1, 0}) == std::vector<uint8_t>(s19_1.data(), (s19_1.data() + s19_1.size())));
+	const auto s19_2 = Chocobo1::Hash::CShake_NS::leftEncode(0x0100000000000000);
+	REQUIRE(std::vector<uint8_t>({8, 1, 0, 0, 0, 0, 0, 0, 0}) == std::vector<uint8_t>(s19_2.data(), (s19_2.data() + s19_2.size())));
+
+	// snapshots around the 136-byte blocks, customized or not
+	const std::vector<uint8_t> s20(s2, (s2 + ARRAY_LENGTH(s2)));
+	const auto s20Splits = SnapshotCheck::splitsAround({136});
+	SnapshotCheck::roundTrip([]() { return Hash((512 / 8), "", "Email Signature"); }, s20, s20Splits
+		, []() { return Hash((256 / 8), "", "Email Signature"); }  // different length
+		, []() { return Hash(512 / 8); }  // not customized
+		, []() { return Chocobo1::CSHAKE_128((512 / 8), "", "Email Signature"); });
+	SnapshotCheck::roundTrip([]() { return Hash(512 / 8); }, s20, s20Splits
+		, []() { return Hash((512 / 8), "", "Email Signature"); });  // customized
 }
 
 
@@ -132,4 +158,21 @@ TEST_CASE("cshake-128")
 	const auto s17_1 = Hash(512).addData(s17, 2).finalize().toVector();
 	const auto s17_2 = Hash(512).addData(s17).finalize().toVector();
 	REQUIRE(s17_1 == s17_2);
+
+	// streamed output is the one-shot output, whatever the pieces
+	for (const std::string customize : {"", "Email Signature"})
+	{
+		const auto expected = Hash(1000, "", customize).addData(s15.data(), s15.size()).finalize().toVector();
+
+		Hash streamed(0, "", customize);
+		streamed.addData(s15.data(), s15.size()).finalize();
+		std::vector<uint8_t> pieces(expected.size());
+		std::size_t offset = 0;
+		for (const std::size_t len : {1, 167, 168, 169, 0, 336, 159})
+		{
+			streamed.squeeze({(pieces.data() + offset), len});
+			offset += len;
+		}
+		REQUIRE(expected == pieces);
+	}
 }
@@ -0,0 +1,135 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/blake2.h"
+#include "../src/blake2s.h"
+#include "../src/hash_many.h"
+#include "../src/md5.h"
+#include "../src/sha2_256.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+	struct LaneCountingSHA2_256 : Chocobo1::SHA2_256
+	{
+		static int kernelCalls;
+	};
+	int LaneCountingSHA2_256::kernelCalls = 0;
+}
+
+namespace Chocobo1
+{
+namespace Hash
+{
+namespace HashMany_NS
+{
+	template <>
+	struct MultiLane<LaneCountingSHA2_256>
+	{
+		static constexpr int LANES = 2;
+		static constexpr int BLOCK_SIZE = 64;
+
+		static void hash(const Span<const Byte> *inputs, LaneCountingSHA2_256::ResultArrayType *const *outputs)
+		{
+			++LaneCountingSHA2_256::kernelCalls;
+
+			REQUIRE((inputs[0].size() / BLOCK_SIZE) == (inputs[1].size() / BLOCK_SIZE));
+			for (int i = 0; i < LANES; ++i)
+				*outputs[i] = Chocobo1::SHA2_256().addData(inputs[i]).finalize().toArray();
+		}
+	};
+}
+}
+}
+
+
+TEST_CASE("hashMany")
+{
+	using Byte = uint8_t;
+	using Span = Chocobo1::SHA2_256::Span<const Byte>;
+
+	std::vector<std::string> messages;
+	for (const int len : {0, 3, 64, 70, 5, 200, 130, 63, 1000})
+		messages.emplace_back(static_cast<std::size_t>(len), static_cast<char>('a' + (len % 26)));
+
+	std::vector<Span> inputs;
+	for (const auto &m : messages)
+		inputs.emplace_back(reinterpret_cast<const Byte *>(m.data()), m.size());
+
+	{
+		using Hash = Chocobo1::MD5;
+
+		std::vector<Hash::ResultArrayType> outputs(inputs.size());
+		Chocobo1::hashMany<Hash>(inputs, outputs);
+
+		for (std::size_t i = 0; i < messages.size(); ++i)
+			REQUIRE(outputs[i] == Hash().addData(messages[i].data(), messages[i].size()).finalize().toArray());
+	}
+
+	{
+		using Hash = LaneCountingSHA2_256;
+
+		std::vector<Hash::ResultArrayType> outputs(inputs.size());
+		Chocobo1::hashMany<Hash>(inputs, outputs);
+
+		// block counts: {0, 0, 1, 1, 0, 3, 2, 0, 15}
+		REQUIRE(Hash::kernelCalls == 3);
+		for (std::size_t i = 0; i < messages.size(); ++i)
+			REQUIRE(outputs[i] == Chocobo1::SHA2_256().addData(messages[i].data(), messages[i].size()).finalize().toArray());
+	}
+
+	{
+		std::vector<Chocobo1::MD5::ResultArrayType> outputs;
+		Chocobo1::hashMany<Chocobo1::MD5>({}, outputs);
+		REQUIRE(outputs.empty());
+	}
+
+	{
+		// every input needs an output
+		std::vector<Chocobo1::MD5::ResultArrayType> outputs(inputs.size() - 1);
+		REQUIRE_THROWS_AS(Chocobo1::hashMany<Chocobo1::MD5>(inputs, outputs), std::invalid_argument);
+		REQUIRE_THROWS_AS(Chocobo1::hashMany<Chocobo1::Blake2>(inputs, {}), std::invalid_argument);
+	}
+}
+
+TEMPLATE_TEST_CASE("hashMany-blake2", "", Chocobo1::Blake2, Chocobo1::Blake2s)
+{
+	using Hash = TestType;
+	using Byte = uint8_t;
+	using Span = typename Hash::template Span<const Byte>;
+
+	// enough messages for whole kernel calls: same sizes, sizes around block boundaries & mixed sizes within a block count
+	std::vector<std::string> messages;
+	for (const int len : {0, 1, 63, 64, 65, 127, 128, 129, 1000})
+	{
+		for (int i = 0; i < (2 * Chocobo1::Hash::HashMany_NS::MultiLane<Hash>::LANES); ++i)
+			messages.emplace_back(static_cast<std::size_t>(len), static_cast<char>('a' + i));
+	}
+	for (int i = 0; i < 20; ++i)
+		messages.emplace_back(static_cast<std::size_t>(128 + (i * 5)), static_cast<char>('A' + i));
+
+	std::vector<Span> inputs;
+	for (const auto &m : messages)
+		inputs.emplace_back(reinterpret_cast<const Byte *>(m.data()), m.size());
+
+	std::vector<typename Hash::ResultArrayType> outputs(inputs.size());
+	Chocobo1::hashMany<Hash>(inputs, outputs);
+
+	// same as the scalar path
+	for (std::size_t i = 0; i < messages.size(); ++i)
+		REQUIRE(outputs[i] == Hash().addData(messages[i].data(), messages[i].size()).finalize().toArray());
+}
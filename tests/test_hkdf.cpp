@@ -0,0 +1,134 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/hkdf.h"
+#include "../src/sha1.h"
+#include "../src/sha2_256.h"
+#include "../src/sha2_512.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+	using Byte = uint8_t;
+
+	std::vector<Byte> pattern(const std::size_t length)
+	{
+		std::vector<Byte> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<Byte>(i % 251);
+		return ret;
+	}
+
+	std::vector<Byte> range(const int first, const int last)
+	{
+		std::vector<Byte> ret;
+		for (int i = first; i < last; ++i)
+			ret.emplace_back(static_cast<Byte>(i));
+		return ret;
+	}
+
+	template <typename T>
+	std::string toHex(const T &data)
+	{
+		std::string ret;
+		for (const Byte c : data)
+		{
+			const char digits[] = "0123456789abcdef";
+			ret += digits[c >> 4];
+			ret += digits[c & 0xf];
+		}
+		return ret;
+	}
+
+	template <typename H>
+	void checkVector(const std::vector<Byte> &salt, const std::vector<Byte> &ikm, const std::vector<Byte> &info, const std::string &prk, const std::string &okm)
+	{
+		using KDF = Chocobo1::HKDF<H>;
+
+		const auto extracted = KDF::extract(salt, ikm);
+		REQUIRE(prk == toHex(extracted));
+
+		std::vector<Byte> output(okm.size() / 2);
+		KDF::expand(extracted, info, output);
+		REQUIRE(okm == toHex(output));
+
+		std::vector<Byte> output2(output.size());
+		KDF::derive(salt, ikm, info, output2);
+		REQUIRE(output == output2);
+	}
+}
+
+TEST_CASE("hkdf-sha2_256")
+{
+	using H = Chocobo1::SHA2_256;
+
+	// https://tools.ietf.org/html/rfc5869#appendix-A
+	checkVector<H>(range(0x00, 0x0d), std::vector<Byte>(22, 0x0b), range(0xf0, 0xfa)
+		, "077709362c2e32df0ddc3f0dc47bba6390b6c73bb50f9c3122ec844ad7c2b3e5"
+		, "3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf34007208d5b887185865");
+	checkVector<H>(range(0x60, 0xb0), range(0x00, 0x50), range(0xb0, 0x100)
+		, "06a6b88c5853361a06104c9ceb35b45cef760014904671014a193f40c15fc244"
+		, "b11e398dc80327a1c8e7f78c596a49344f012eda2d4efad8a050cc4c19afa97c59045a99cac7827271cb41c65e590e09da3275600c2f09b8367793a9aca3db71cc30c58179ec3e87c14c01d5c1f3434f1d87");
+	checkVector<H>({}, std::vector<Byte>(22, 0x0b), {}
+		, "19ef24a32c717b167f33a91d6f648bdf96596776afdb6377ac434c1c293ccb04"
+		, "8da4e775a563c18f715f802a063c5a31b8a11f5c5ee1879ec3454e5f3c738d2d9d201395faa4b61a96c8");
+}
+
+TEST_CASE("hkdf-sha1")
+{
+	using H = Chocobo1::SHA1;
+
+	// https://tools.ietf.org/html/rfc5869#appendix-A
+	checkVector<H>(range(0x00, 0x0d), std::vector<Byte>(11, 0x0b), range(0xf0, 0xfa)
+		, "9b6c18c432a7bf8f0e71c8eb88f4b30baa2ba243"
+		, "085a01ea1b10f36933068b56efa5ad81a4f14b822f5b091568a9cdd4f155fda2c22e422478d305f3f896");
+	checkVector<H>({}, std::vector<Byte>(22, 0x0c), {}
+		, "2adccada18779e7c2077ad2eb19d3f3e731385dd"
+		, "2c91117204d745f3500d636a62f64f0ab3bae548aa53d423b0d1f27ebba6f5e5673a081d70cce7acfc48");
+}
+
+TEST_CASE("hkdf-sha2_512")
+{
+	using KDF = Chocobo1::HKDF<Chocobo1::SHA2_512>;
+
+	// my own tests, the longest output allowed
+	std::vector<Byte> output(255 * 64);
+	KDF::derive(pattern(20), pattern(100), pattern(30), output);
+	REQUIRE("cda688e3fb920667d8b2676f03c6c01512f821e6a863210c080df0c72c04c6bf" == toHex(std::vector<Byte>((output.end() - 32), output.end())));
+
+	// a shorter output is a prefix of a longer one
+	std::vector<Byte> output2(100);
+	KDF::derive(pattern(20), pattern(100), pattern(30), output2);
+	REQUIRE(std::equal(output2.begin(), output2.end(), output.begin()));
+}
+
+TEST_CASE("hkdf-output-length")
+{
+	using KDF = Chocobo1::HKDF<Chocobo1::SHA2_256>;
+
+	const auto prk = pattern(32);
+	const auto info = pattern(10);
+
+	// the one-byte counter runs out after 255 blocks
+	std::vector<Byte> longest(255 * 32);
+	REQUIRE_NOTHROW(KDF::expand(prk, info, longest));
+
+	std::vector<Byte> tooLong((255 * 32) + 1);
+	REQUIRE_THROWS_AS(KDF::expand(prk, info, tooLong), std::invalid_argument);
+	REQUIRE_THROWS_AS(KDF::derive(pattern(13), pattern(22), info, tooLong), std::invalid_argument);
+}
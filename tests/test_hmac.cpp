@@ -0,0 +1,194 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/hmac.h"
+#include "../src/md5.h"
+#include "../src/ripemd_160.h"
+#include "../src/sha1.h"
+#include "../src/sha2_224.h"
+#include "../src/sha2_256.h"
+#include "../src/sha2_384.h"
+#include "../src/sha2_512.h"
+#include "../src/sha2_512_256.h"
+#include "../src/sm3.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+	using Byte = uint8_t;
+
+	std::vector<Byte> pattern(const std::size_t length)
+	{
+		std::vector<Byte> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<Byte>(i % 251);
+		return ret;
+	}
+
+	template <typename H>
+	void checkVectors(const std::string (&expected)[3])
+	{
+		using Hash = Chocobo1::HMAC<H>;
+		using Span = typename Hash::template Span<const Byte>;
+
+		// https://tools.ietf.org/html/rfc4231 test cases 1, 2 & 6
+		const std::vector<Byte> key1(20, 0x0b);
+		const char data1[] = "Hi There";
+		REQUIRE(expected[0] == Hash(key1).addData(data1, strlen(data1)).finalize().toString());
+
+		const char key2[] = "Jefe";
+		const char data2[] = "what do ya want for nothing?";
+		REQUIRE(expected[1] == Hash(Span(reinterpret_cast<const Byte *>(key2), strlen(key2))).addData(data2, strlen(data2)).finalize().toString());
+
+		const std::vector<Byte> key3(131, 0xaa);
+		const char data3[] = "Test Using Larger Than Block-Size Key - Hash Key First";
+		REQUIRE(expected[2] == Hash(key3).addData(data3, strlen(data3)).finalize().toString());
+
+		// copies & `reset()` start from the cached pad states
+		const Hash keyed(key1);
+		Hash copy = keyed;
+		REQUIRE(expected[0] == copy.addData(data1, strlen(data1)).finalize().toString());
+		copy.reset();
+		REQUIRE(expected[0] == copy.addData(data1, 3).addData((data1 + 3), (strlen(data1) - 3)).finalize().toString());
+	}
+
+	template <typename H>
+	void checkHashMany()
+	{
+		using Hash = Chocobo1::HMAC<H>;
+		using Span = typename Hash::template Span<const Byte>;
+
+		const std::vector<Byte> key = pattern(100);
+		const auto data = pattern(1000);
+
+		// lengths around the padding boundaries & several blocks long
+		std::vector<Span> inputs;
+		for (std::size_t i = 0; i < 150; ++i)
+		{
+			const std::size_t length = (i * 37) % 300;
+			inputs.emplace_back((data.data() + i), length);
+		}
+
+		std::vector<typename Hash::ResultArrayType> expected;
+		for (const auto &input : inputs)
+			expected.emplace_back(Hash(key).addData(input).finalize().toArray());
+
+		std::vector<typename Hash::ResultArrayType> outputs(inputs.size());
+		Hash(key).hashMany(inputs, outputs);
+		REQUIRE(outputs == expected);
+
+		Hash(key).hashMany({}, {});
+
+		// every input needs an output
+		REQUIRE_THROWS_AS(Hash(key).hashMany(inputs, {outputs.data(), (outputs.size() - 1)}), std::invalid_argument);
+	}
+
+	struct LaneCountingSHA2_256 : Chocobo1::SHA2_256
+	{
+		static std::size_t maxLanes;
+	};
+	std::size_t LaneCountingSHA2_256::maxLanes = 0;
+}
+
+namespace Chocobo1
+{
+namespace Hash
+{
+namespace HMAC_NS
+{
+	template <>
+	struct Midstate<LaneCountingSHA2_256> : Sha2Midstate<uint32_t>
+	{
+		static void compressLanes(State *states, const Byte *const *blocks, const std::size_t count)
+		{
+			LaneCountingSHA2_256::maxLanes = std::max(LaneCountingSHA2_256::maxLanes, count);
+			Sha2Midstate<uint32_t>::compressLanes(states, blocks, count);
+		}
+	};
+}
+}
+}
+
+
+TEST_CASE("hmac")
+{
+	// generated with python hmac
+	checkVectors<Chocobo1::MD5>({"5ccec34ea9656392457fa1ac27f08fbc",
+		"750c783e6ab0b503eaa86e310a5db738",
+		"bfecaf4efff90a3a668f3922fec3762d"});
+	checkVectors<Chocobo1::SHA1>({"b617318655057264e28bc0b6fb378c8ef146be00",
+		"effcdf6ae5eb2fa2d27416d5f184df9c259a7c79",
+		"90d0dace1c1bdc957339307803160335bde6df2b"});
+	checkVectors<Chocobo1::SHA2_224>({"896fb1128abbdf196832107cd49df33f47b4b1169912ba4f53684b22",
+		"a30e01098bc6dbbf45690f3a7e9e6d0f8bbea2a39e6148008fd05e44",
+		"95e9a0db962095adaebe9b2d6f0dbce2d499f112f2d2b7273fa6870e"});
+	checkVectors<Chocobo1::SHA2_256>({"b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7",
+		"5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843",
+		"60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"});
+	checkVectors<Chocobo1::SHA2_384>({"afd03944d84895626b0825f4ab46907f15f9dadbe4101ec682aa034c7cebc59cfaea9ea9076ede7f4af152e8b2fa9cb6",
+		"af45d2e376484031617f78d2b58a6b1b9c7ef464f5a01b47e42ec3736322445e8e2240ca5e69e2c78b3239ecfab21649",
+		"4ece084485813e9088d2c63a041bc5b44f9ef1012a2b588f3cd11f05033ac4c60c2ef6ab4030fe8296248df163f44952"});
+	checkVectors<Chocobo1::SHA2_512>({"87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cdedaa833b7d6b8a702038b274eaea3f4e4be9d914eeb61f1702e696c203a126854",
+		"164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea2505549758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737",
+		"80b24263c7c1a3ebb71493c1dd7be8b49b46d1f41b4aeec1121b013783f8f3526b56d037e05f2598bd0fd2215d6a1e5295e64f73f63f0aec8b915a985d786598"});
+	checkVectors<Chocobo1::SHA2_512_256>({"9f9126c3d9c3c330d760425ca8a217e31feae31bfe70196ff81642b868402eab",
+		"6df7b24630d5ccb2ee335407081a87188c221489768fa2020513b2d593359456",
+		"87123c45f7c537a404f8f47cdbedda1fc9bec60eeb971982ce7ef10e774e6539"});
+	checkVectors<Chocobo1::RIPEMD_160>({"24cb4bd67d20fc1a5d2ed7732dcc39377f0a5668",
+		"dda6c0213a485a9e24f4742064a7f033b43c4069",
+		"71bb52d26408e5a221393d5811b03cc7f94bcd3a"});
+	checkVectors<Chocobo1::SM3>({"51b00d1fb49832bfb01c3ce27848e59f871d9ba938dc563b338ca964755cce70",
+		"2e87f1d16862e6d964b50a5200bf2b10b764faa9680a296a2405f24bec39f882",
+		"b4fd844e13342002f0b2e0690ea7741f1497d993a70494cea601e657bedf67a0"});
+
+	using Hash = Chocobo1::HMAC<Chocobo1::SHA2_256>;
+
+	const std::vector<Byte> key = pattern(32);
+	const auto s1 = pattern(1000);
+	Hash s2(key);
+	s2.addData(s1.data(), s1.size()).finalize();
+	s2.reset();
+	REQUIRE(Hash(key).finalize().toString() == s2.finalize().toString());
+
+	const int s3[2] = {0};
+	const char s3_2[8] = {0};
+	REQUIRE(Hash(key).addData(Hash::Span<const int>(s3)).finalize().toString()
+			== Hash(key).addData(s3_2).finalize().toString());
+
+	const unsigned char s4[] = {0x00, 0x0A};
+	const auto s4_1 = Hash(key).addData(s4, 2).finalize().toArray();
+	const auto s4_2 = Hash(key).addData(s4).finalize().toArray();
+	REQUIRE(s4_1 == s4_2);
+
+	// snapshots around the 64-byte blocks of the inner hash
+	SnapshotCheck::roundTrip([&]() { return Hash(key); }, s1, SnapshotCheck::splitsAround({64, 128})
+		, [&]() { return Chocobo1::HMAC<Chocobo1::SHA2_512>(key); });
+}
+
+TEST_CASE("hmac-hashMany")
+{
+	checkHashMany<Chocobo1::SHA2_256>();
+	checkHashMany<Chocobo1::SHA2_512>();
+	checkHashMany<Chocobo1::SM3>();
+
+	// the messages go through the kernel together
+	checkHashMany<LaneCountingSHA2_256>();
+	REQUIRE(LaneCountingSHA2_256::maxLanes > 1);
+}
@@ -0,0 +1,120 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/kangaroo_twelve.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+
+#include <cstring>
+
+
+TEST_CASE("kangaroo-twelve")
+{
+	using Hash = Chocobo1::KangarooTwelve;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	// official test suite from RFC 9861
+	REQUIRE("1ac2d450fc3b4205d19da7bfca1b37513c0803577ac7167f06fe2ce1f0ef39e5"
+			== Hash(32).finalize().toString());
+	REQUIRE("1ac2d450fc3b4205d19da7bfca1b37513c0803577ac7167f06fe2ce1f0ef39e54269c056b8c82e48276038b6d292966cc07a3d4645272e31ff38508139eb0a71"
+			== Hash(64).finalize().toString());
+
+	const auto s1 = pattern(17 * 17);
+	REQUIRE("0c315ebcdedbf61426de7dcf8fb725d1e74675d7f5327a5067f367b108ecb67c"
+			== Hash(32).addData(s1.data(), s1.size()).finalize().toString());
+
+	const auto s2 = pattern(17 * 17 * 17);
+	REQUIRE("cb552e2ec77d9910701d578b457ddf772c12e322e4ee7fe417f92c758f0d59d0"
+			== Hash(32).addData(s2.data(), s2.size()).finalize().toString());
+
+	const auto s3 = pattern(17 * 17 * 17 * 17);
+	REQUIRE("8701045e22205345ff4dda05555cbb5c3af1a771c2b89baef37db43d9998b9fe"
+			== Hash(32).addData(s3.data(), s3.size()).finalize().toString());
+
+	const auto s4 = pattern(1);
+	REQUIRE("fab658db63e94a246188bf7af69a133045f46ee984c56e3c3328caaf1aa1a583"
+			== Hash(32, {s4.begin(), s4.end()}).finalize().toString());
+
+	const unsigned char s5[] = {0xFF};
+	const auto s5_c = pattern(41);
+	REQUIRE("d848c5068ced736f4462159b9867fd4c20b808acc3d5bc48e0b06ba0a3762ec4"
+			== Hash(32, {s5_c.begin(), s5_c.end()}).addData(s5).finalize().toString());
+
+
+	// my own tests
+	// around chunk boundaries
+	const std::pair<std::size_t, std::string> s11[] =
+	{
+		{8191, "1b577636f723643e990cc7d6a659837436fd6a103626600eb8301cd1dbe553d6"},
+		{8192, "48f256f6772f9edfb6a8b661ec92dc93b95ebd05a08a17b39ae3490870c926c3"}
+	};
+	for (const auto &s : s11)
+	{
+		const auto data = pattern(s.first);
+		REQUIRE(s.second == Hash(32).addData(data.data(), data.size()).finalize().toString());
+	}
+
+	const auto s12 = pattern((8192 * 5) + 1);
+	REQUIRE("323c061d266119bdb6419daff5e543b232686788d1d760200468b49bf510e67f"
+			== Hash(32, "abc").addData(s12.data(), s12.size()).finalize().toString());
+	for (const std::size_t chunk : {1, 100, 8192, 10000})
+	{
+		Hash hash(32, "abc");
+		for (std::size_t i = 0; i < s12.size(); i += chunk)
+			hash.addData((s12.data() + i), std::min(chunk, (s12.size() - i)));
+		REQUIRE("323c061d266119bdb6419daff5e543b232686788d1d760200468b49bf510e67f"
+				== hash.finalize().toString());
+	}
+
+	// large enough to be split across threads
+	const auto s13 = pattern((1536 * 1024) + 77);
+	REQUIRE("ab26a9295fc208006437011aabef64cd708804fede8ef42105fe3de50da4bae4"
+			== Hash(32).addData(s13.data(), s13.size()).finalize().toString());
+
+	Hash s14(32);
+	s14.addData(s13.data(), s13.size()).finalize();
+	s14.reset();
+	REQUIRE("1ac2d450fc3b4205d19da7bfca1b37513c0803577ac7167f06fe2ce1f0ef39e5"
+			== s14.finalize().toString());
+
+	const int s15[2] = {0};
+	const char s15_2[8] = {0};
+	REQUIRE(Hash(32).addData(Hash::Span<const int>(s15)).finalize().toString()
+			== Hash(32).addData(s15_2).finalize().toString());
+
+	const unsigned char s16[] = {0x00, 0x0A};
+	const auto s16_1 = Hash(32).addData(s16, 2).finalize().toVector();
+	const auto s16_2 = Hash(32).addData(s16).finalize().toVector();
+	REQUIRE(s16_1 == s16_2);
+
+	// snapshots survive a round-trip through bytes, before & after the tree mode kicks in
+	for (const std::size_t split : {0, 100, 8192, 8193, 20000, (8192 * 5)})
+	{
+		Hash prefix(32, "abc");
+		prefix.addData(s12.data(), split);
+		const auto snapshot = prefix.serialize();
+
+		Hash restored(32, "abc");
+		REQUIRE(restored.restore(snapshot));
+		REQUIRE("323c061d266119bdb6419daff5e543b232686788d1d760200468b49bf510e67f"
+				== restored.addData((s12.data() + split), (s12.size() - split)).finalize().toString());
+		REQUIRE_FALSE(Hash(32, "abc").restore({snapshot.data(), (snapshot.size() - 1)}));
+		REQUIRE_FALSE(Hash(32, "abd").restore(snapshot));  // different customization
+		REQUIRE_FALSE(Hash(64, "abc").restore(snapshot));  // different length
+	}
+}
@@ -0,0 +1,112 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/kmac.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <vector>
+
+
+namespace
+{
+	std::vector<uint8_t> sequence(const uint8_t first, const std::size_t length)
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(first + i);
+		return ret;
+	}
+}
+
+TEST_CASE("kmac-128")
+{
+	using Hash = Chocobo1::KMAC_128;
+	using XOF = Chocobo1::KMACXOF_128;
+
+	// official test suite from NIST
+	const auto key = sequence(0x40, 32);
+	const auto s1 = sequence(0x00, 4);
+	const auto s2 = sequence(0x00, 200);
+	REQUIRE("e5780b0d3ea6f7d3a429c5706aa43a00fadbd7d49628839e3187243f456ee14e"
+			== Hash(32, key).addData(s1.data(), s1.size()).finalize().toString());
+	REQUIRE("3b1fba963cd8b0b59e8c1a6d71888b7143651af8ba0a7070c0979e2811324aa5"
+			== Hash(32, key, "My Tagged Application").addData(s1.data(), s1.size()).finalize().toString());
+	REQUIRE("1f5b4e6cca02209e0dcb5ca635b89a15e271ecc760071dfd805faa38f9729230"
+			== Hash(32, key, "My Tagged Application").addData(s2.data(), s2.size()).finalize().toString());
+
+	REQUIRE("cd83740bbd92ccc8cf032b1481a0f4460e7ca9dd12b08a0c4031178bacd6ec35"
+			== XOF(32, key).addData(s1.data(), s1.size()).finalize().toString());
+	REQUIRE("31a44527b4ed9f5c6101d11de6d26f0620aa5c341def41299657fe9df1a3b16c"
+			== XOF(32, key, "My Tagged Application").addData(s1.data(), s1.size()).finalize().toString());
+	REQUIRE("47026c7cd793084aa0283c253ef658490c0db61438b8326fe9bddf281b83ae0f"
+			== XOF(32, key, "My Tagged Application").addData(s2.data(), s2.size()).finalize().toString());
+
+	// my own tests
+	const Hash s3(32, key, "My Tagged Application");
+	Hash s3_1 = s3;
+	REQUIRE("1f5b4e6cca02209e0dcb5ca635b89a15e271ecc760071dfd805faa38f9729230"
+			== s3_1.addData(s2.data(), s2.size()).finalize().toString());
+	s3_1.reset();
+	REQUIRE("3b1fba963cd8b0b59e8c1a6d71888b7143651af8ba0a7070c0979e2811324aa5"
+			== s3_1.addData(s1.data(), s1.size()).finalize().toString());
+	s3_1 = Hash(32, key);
+	REQUIRE("e5780b0d3ea6f7d3a429c5706aa43a00fadbd7d49628839e3187243f456ee14e"
+			== s3_1.addData(s1.data(), s1.size()).finalize().toString());
+	s3_1 = s3;
+	REQUIRE("1f5b4e6cca02209e0dcb5ca635b89a15e271ecc760071dfd805faa38f9729230"
+			== s3_1.addData(s2.data(), s2.size()).finalize().toString());
+
+	const int s4[2] = {0};
+	const char s4_2[8] = {0};
+	REQUIRE(Hash(32, key).addData(Hash::Span<const int>(s4)).finalize().toString()
+			== Hash(32, key).addData(s4_2).finalize().toString());
+
+	const unsigned char s5[] = {0x00, 0x0A};
+	const auto s5_1 = Hash(32, key).addData(s5, 2).finalize().toVector();
+	const auto s5_2 = Hash(32, key).addData(s5).finalize().toVector();
+	REQUIRE(s5_1 == s5_2);
+
+	// snapshots around the 168-byte blocks
+	SnapshotCheck::roundTrip([&]() { return Hash(32, key, "My Tagged Application"); }, s2, SnapshotCheck::splitsAround({168})
+		, [&]() { return Hash(64, key, "My Tagged Application"); }  // different length
+		, [&]() { return XOF(32, key, "My Tagged Application"); });
+}
+
+TEST_CASE("kmac-256")
+{
+	using Hash = Chocobo1::KMAC_256;
+	using XOF = Chocobo1::KMACXOF_256;
+
+	// official test suite from NIST
+	const auto key = sequence(0x40, 32);
+	const auto s1 = sequence(0x00, 4);
+	const auto s2 = sequence(0x00, 200);
+	REQUIRE("20c570c31346f703c9ac36c61c03cb64c3970d0cfc787e9b79599d273a68d2f7f69d4cc3de9d104a351689f27cf6f5951f0103f33f4f24871024d9c27773a8dd"
+			== Hash(64, key, "My Tagged Application").addData(s1.data(), s1.size()).finalize().toString());
+	REQUIRE("75358cf39e41494e949707927cee0af20a3ff553904c86b08f21cc414bcfd691589d27cf5e15369cbbff8b9a4c2eb17800855d0235ff635da82533ec6b759b69"
+			== Hash(64, key).addData(s2.data(), s2.size()).finalize().toString());
+	REQUIRE("b58618f71f92e1d56c1b8c55ddd7cd188b97b4ca4d99831eb2699a837da2e4d970fbacfde50033aea585f1a2708510c32d07880801bd182898fe476876fc8965"
+			== Hash(64, key, "My Tagged Application").addData(s2.data(), s2.size()).finalize().toString());
+
+	REQUIRE("1755133f1534752aad0748f2c706fb5c784512cab835cd15676b16c0c6647fa96faa7af634a0bf8ff6df39374fa00fad9a39e322a7c92065a64eb1fb0801eb2b"
+			== XOF(64, key, "My Tagged Application").addData(s1.data(), s1.size()).finalize().toString());
+	REQUIRE("ff7b171f1e8a2b24683eed37830ee797538ba8dc563f6da1e667391a75edc02ca633079f81ce12a25f45615ec89972031d18337331d24ceb8f8ca8e6a19fd98b"
+			== XOF(64, key).addData(s2.data(), s2.size()).finalize().toString());
+	REQUIRE("d5be731c954ed7732846bb59dbe3a8e30f83e77a4bff4459f2f1c2b4ecebb8ce67ba01c62e8ab8578d2d499bd1bb276768781190020a306a97de281dcc30305d"
+			== XOF(64, key, "My Tagged Application").addData(s2.data(), s2.size()).finalize().toString());
+
+	// my own tests
+	const auto longKey = sequence(0x00, 200);  // longer than the rate
+	const std::string s3 = "generated with pycryptodome";
+	REQUIRE("06bad3d9f8e1b70de05eff911b3d24c6aa297dfe2c4cadafab09de63060ffdabca88396e1fbb6989155d8cf5837f0b00fc19b266f603bf9a9fb9743357d0b4fd" == Hash(64, longKey).addData(s3.data(), s3.size()).finalize().toString());
+}
@@ -14,6 +14,7 @@
 #include "catch2/single_include/catch2/catch.hpp"
 
 #include <cstring>
+#include <string>
 
 
 TEST_CASE("md5")
@@ -27,6 +28,10 @@ TEST_CASE("md5")
 	const char s2[] = "a";
 	REQUIRE("0cc175b9c0f1b6a831c399e269772661" == Hash().addData(s2, strlen(s2)).finalize().toString());
 
+	// the padding & the size fill the last block exactly
+	const std::string s2_2(55, 'a');
+	REQUIRE("ef1772b6dff9a122358552954ad0df65" == Hash().addData(s2_2.data(), s2_2.size()).finalize().toString());
+
 	const char s3[] = "abc";
 	REQUIRE("900150983cd24fb0d6963f7d28e17f72" == Hash().addData(s3, strlen(s3)).finalize().toString());
 
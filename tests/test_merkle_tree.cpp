@@ -0,0 +1,299 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/blake2.h"
+#include "../src/merkle_tree.h"
+#include "../src/sha2_256.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+
+TEST_CASE("merkle tree")
+{
+	using Hash = Chocobo1::MerkleTree<Chocobo1::SHA2_256>;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	// my own tests
+	// default: 1024 bytes leaves, 0x00 leaf prefix, 0x01 node prefix, binary
+	const std::pair<std::size_t, std::string> s1[] =
+	{
+		{0, "6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d"},
+		{1, "96a296d224f285c67bee93c30f8a309157f0daa35dc5b87e410b78630a09cfc7"},
+		{1024, "5ebe8c44eeb4a630185f0514cf91fdb89521bfdbdc35b0e1ebf1f49afd46f460"},
+		{1025, "1273b840222d605b78e4ee66ece27006d769aee87152b9e89545bd5b5931b199"},
+		{4101, "20d23d53944c4943b941faa96af55b659f9006c3711c9dc07e9a7e6bd885f703"},
+		{5120, "8f45aaa398f94dd077cdf70a17a7d0d1557d7752614688c51075e8a1a2771a14"},
+		{7000, "eca50d34735fa5aad3c56cbb60533e5a11d946101695d1336ad04bedb39dc476"}
+	};
+	for (const auto &s : s1)
+	{
+		const auto data = pattern(s.first);
+		REQUIRE(s.second == Hash().addData(data.data(), data.size()).finalize().toString());
+
+		for (const std::size_t chunk : {1, 100, 1024, 3000})
+		{
+			Hash hash;
+			for (std::size_t i = 0; i < data.size(); i += chunk)
+				hash.addData((data.data() + i), std::min(chunk, (data.size() - i)));
+			REQUIRE(s.second == hash.finalize().toString());
+		}
+	}
+
+	// wider trees
+	const std::tuple<int, std::size_t, std::string> s2[] =
+	{
+		{3, 7000, "2359cf334884c3b59f2663441351a4fc134da185db00a40a059e9b79e1815fb1"},
+		{3, 20000, "1de7195234be015d593a44c202b91f9989166afb20d36e5540acae1f6542c282"},
+		{4, 7000, "6457216deebd756d71c8684b0f878b0be48e5427a6996e866c79dde91df65cb0"},
+		{4, 20000, "dbe1e39a7cc9f3b1d0387ba58fb3f948dcf1e546a31cf274d012f6e3e3f5906c"}
+	};
+	for (const auto &s : s2)
+	{
+		Hash::Parameters params;
+		params.fanout = std::get<0>(s);
+		const auto data = pattern(std::get<1>(s));
+		REQUIRE(std::get<2>(s) == Hash(params).addData(data.data(), data.size()).finalize().toString());
+	}
+
+	// without domain separation
+	Hash::Parameters s3Params;
+	s3Params.leafSize = 100;
+	s3Params.leafPrefix = {};
+	s3Params.nodePrefix = {};
+	const auto s3 = pattern(5000);
+	REQUIRE("1a35668f0476712bd37870b2b26bb1d242ded4c311dbb3b4ad3234394b2ea15a"
+			== Hash(s3Params).addData(s3.data(), s3.size()).finalize().toString());
+
+	// other hash
+	Chocobo1::MerkleTree<Chocobo1::Blake2>::Parameters s4Params;
+	s4Params.leafSize = 64;
+	s4Params.leafPrefix = {'L'};
+	s4Params.nodePrefix = {'N'};
+	s4Params.fanout = 4;
+	const auto s4 = pattern(10000);
+	REQUIRE("fff2abeebf8c2ddebd593710fa771308a22349b1d4e8304a46f9460f7a65d55640d14795d01dd6e1622f4237e205ba3cda8bbfb49414fd72783e6e76a1db7ab3"
+			== Chocobo1::MerkleTree<Chocobo1::Blake2>(s4Params).addData(s4.data(), s4.size()).finalize().toString());
+
+	// large enough to be split across threads
+	const auto s5 = pattern((3 * 1024 * 1024) + 77);
+	REQUIRE("1d1adc353de081e06cb342172e5f3616e5a8c888a99fdb619e4949b878921d26"
+			== Hash().addData(s5.data(), s5.size()).finalize().toString());
+
+	// levels
+	Hash::Parameters s6Params;
+	s6Params.fanout = 3;
+	s6Params.keepLevels = true;
+	const auto s6 = pattern(7000);
+	Hash s6Tree(s6Params);
+	s6Tree.addData(s6.data(), s6.size()).finalize();
+	const auto s6Levels = s6Tree.levels();
+	REQUIRE(s6Levels.size() == 3);
+	REQUIRE(s6Levels[0].size() == 7);
+	REQUIRE(s6Levels[1].size() == 3);
+	REQUIRE(s6Levels[2].size() == 1);
+	REQUIRE(s6Levels[1][2] == s6Levels[0][6]);  // promoted
+	REQUIRE(s6Levels[2][0] == s6Tree.toArray());
+	const auto s6Serialized = s6Tree.serializeLevels();
+	REQUIRE(s6Serialized.size() == (11 * 32));
+	REQUIRE("202f854d353bb4f62b23dd4f374f956d91156d9291f1ca24ae8549309f486a1f"
+			== Chocobo1::SHA2_256().addData(s6Serialized.data(), s6Serialized.size()).finalize().toString());
+
+	Hash s7;
+	s7.addData(s5.data(), s5.size()).finalize();
+	s7.reset();
+	REQUIRE("6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d"
+			== s7.finalize().toString());
+
+	const int s8[2] = {0};
+	const char s8_2[8] = {0};
+	REQUIRE(Hash().addData(Hash::Span<const int>(s8)).finalize().toString()
+			== Hash().addData(s8_2).finalize().toString());
+
+	const unsigned char s9[] = {0x00, 0x0A};
+	const auto s9_1 = Hash().addData(s9, 2).finalize().toArray();
+	const auto s9_2 = Hash().addData(s9).finalize().toArray();
+	REQUIRE(s9_1 == s9_2);
+
+	// parameters the tree can't be built with
+	Hash::Parameters s10Params;
+	s10Params.leafSize = 0;
+	REQUIRE_THROWS_AS(Hash(s10Params), std::invalid_argument);
+	for (const int fanout : {-1, 0, 1})
+	{
+		Hash::Parameters p;
+		p.fanout = fanout;
+		REQUIRE_THROWS_AS(Hash(p), std::invalid_argument);
+	}
+}
+
+TEST_CASE("merkle range proof")
+{
+	using Hash = Chocobo1::MerkleTree<Chocobo1::SHA2_256>;
+	using Verifier = Chocobo1::MerkleVerifier<Chocobo1::SHA2_256>;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	// my own tests
+	Hash::Parameters params;
+	params.keepLevels = true;
+	const auto s1 = pattern(7000);
+	Hash s1Tree(params);
+	s1Tree.addData(s1.data(), s1.size()).finalize();
+	const auto s1Root = s1Tree.toArray();
+
+	const auto s1Proof = s1Tree.rangeProof(2100, 10);
+	REQUIRE(s1Proof.totalSize == 7000);
+	REQUIRE(s1Proof.firstLeaf == 2);
+	REQUIRE(s1Proof.leaves.size() == 1);
+	REQUIRE(s1Proof.siblings.size() == 3);
+	const auto s1Last = s1Tree.rangeProof(6500, 500);
+	REQUIRE(s1Last.firstLeaf == 6);
+	REQUIRE(s1Last.siblings.size() == 2);  // the last leaf is promoted, it has no sibling at the bottom
+
+	// every range, fed in various chunk sizes
+	for (const int fanout : {2, 3, 4})
+	{
+		for (const std::size_t size : {0, 1, 1024, 1025, 7000, 20000})
+		{
+			Hash::Parameters p;
+			p.fanout = fanout;
+			p.keepLevels = true;
+			const auto data = pattern(size);
+			Hash tree(p);
+			tree.addData(data.data(), data.size()).finalize();
+
+			const std::pair<std::size_t, std::size_t> ranges[] =
+			{
+				{0, 0},
+				{0, size},
+				{(size / 3), (size / 3)},
+				{(size / 2), ((size > 0) ? 1 : 0)},
+				{((size > 0) ? (size - 1) : 0), ((size > 0) ? 1 : 0)}
+			};
+			for (const auto &range : ranges)
+			{
+				const auto proof = tree.rangeProof(range.first, range.second);
+				for (const std::size_t chunk : {1, 100, 1024, 3000})
+				{
+					Verifier verifier(p, tree.toArray(), proof);
+					REQUIRE(verifier.isValid());
+
+					const std::size_t offset = static_cast<std::size_t>(verifier.dataOffset());
+					const std::size_t length = static_cast<std::size_t>(verifier.dataSize());
+					REQUIRE(offset <= range.first);
+					REQUIRE((offset + length) >= (range.first + range.second));
+
+					for (std::size_t i = 0; i < length; i += chunk)
+						verifier.addData((data.data() + offset + i), std::min(chunk, (length - i)));
+					REQUIRE(verifier.verifiedSize() == length);
+					REQUIRE(verifier.finalize());
+				}
+			}
+		}
+	}
+
+	// tampered data is caught at the leaf it belongs to
+	const auto s2Proof = s1Tree.rangeProof(0, 7000);
+	auto s2 = s1;
+	s2[3000] ^= 1;
+	Verifier s2Verifier(params, s1Root, s2Proof);
+	s2Verifier.addData(s2.data(), 2048);
+	REQUIRE(s2Verifier.isValid());
+	REQUIRE(s2Verifier.verifiedSize() == 2048);
+	s2Verifier.addData((s2.data() + 2048), 2048);
+	REQUIRE(!s2Verifier.isValid());
+	REQUIRE(s2Verifier.verifiedSize() == 2048);
+	REQUIRE(!s2Verifier.finalize());
+
+	// tampered proof
+	auto s3Proof = s1Proof;
+	s3Proof.siblings[1][0] ^= 1;
+	REQUIRE(!Verifier(params, s1Root, s3Proof).isValid());
+
+	auto s3Proof2 = s1Proof;
+	s3Proof2.siblings.pop_back();
+	REQUIRE(!Verifier(params, s1Root, s3Proof2).isValid());
+
+	auto s3Proof3 = s1Proof;
+	s3Proof3.firstLeaf = 3;
+	REQUIRE(!Verifier(params, s1Root, s3Proof3).isValid());
+
+	// wrong root
+	auto s4Root = s1Root;
+	s4Root[31] ^= 1;
+	REQUIRE(!Verifier(params, s4Root, s1Proof).isValid());
+
+	// truncated & overlong data
+	Verifier s5Verifier(params, s1Root, s1Last);
+	s5Verifier.addData((s1.data() + 6144), 800);
+	REQUIRE(s5Verifier.isValid());
+	REQUIRE(!s5Verifier.finalize());
+
+	Verifier s5Verifier2(params, s1Root, s1Proof);
+	s5Verifier2.addData((s1.data() + 2048), 1025);
+	REQUIRE(!s5Verifier2.isValid());
+
+	// other hash
+	using Blake2Tree = Chocobo1::MerkleTree<Chocobo1::Blake2>;
+	Blake2Tree::Parameters s6Params;
+	s6Params.leafSize = 64;
+	s6Params.fanout = 4;
+	s6Params.keepLevels = true;
+	const auto s6 = pattern(10000);
+	Blake2Tree s6Tree(s6Params);
+	s6Tree.addData(s6.data(), s6.size()).finalize();
+	const auto s6Proof = s6Tree.rangeProof(5000, 700);
+	Chocobo1::MerkleVerifier<Chocobo1::Blake2> s6Verifier(s6Params, s6Tree.toArray(), s6Proof);
+	s6Verifier.addData((s6.data() + s6Verifier.dataOffset()), static_cast<std::size_t>(s6Verifier.dataSize()));
+	REQUIRE(s6Verifier.finalize());
+
+	const int s7[2] = {0};
+	const char s7_2[8] = {0};
+	Hash s7Tree(params);
+	s7Tree.addData(s7_2).finalize();
+	Verifier s7Verifier(params, s7Tree.toArray(), s7Tree.rangeProof(0, 8));
+	s7Verifier.addData(Verifier::Span<const int>(s7));
+	REQUIRE(s7Verifier.finalize());
+
+	// out-of-range requests & parameters
+	REQUIRE_THROWS_AS(s1Tree.rangeProof(7000, 1), std::out_of_range);
+	REQUIRE_THROWS_AS(s1Tree.rangeProof(6999, 2), std::out_of_range);
+	REQUIRE_THROWS_AS(s1Tree.rangeProof(1, UINT64_MAX), std::out_of_range);
+	REQUIRE(s1Tree.rangeProof(7000, 0).firstLeaf == 6);
+	Hash s8Tree;
+	s8Tree.addData(s1.data(), s1.size()).finalize();
+	REQUIRE_THROWS_AS(s8Tree.rangeProof(0, 1), std::invalid_argument);
+
+	Hash::Parameters s9Params = params;
+	s9Params.leafSize = 0;
+	REQUIRE_THROWS_AS(Verifier(s9Params, s1Root, s1Proof), std::invalid_argument);
+	s9Params = params;
+	s9Params.fanout = 1;
+	REQUIRE_THROWS_AS(Verifier(s9Params, s1Root, s1Proof), std::invalid_argument);
+}
@@ -0,0 +1,148 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/blake1_224.h"
+#include "../src/blake1_256.h"
+#include "../src/blake1_384.h"
+#include "../src/blake1_512.h"
+#include "../src/has_160.h"
+#include "../src/md2.h"
+#include "../src/md4.h"
+#include "../src/md5.h"
+#include "../src/ripemd_128.h"
+#include "../src/ripemd_160.h"
+#include "../src/ripemd_256.h"
+#include "../src/ripemd_320.h"
+#include "../src/sha1.h"
+#include "../src/sha2_224.h"
+#include "../src/sha2_256.h"
+#include "../src/sha2_384.h"
+#include "../src/sha2_512.h"
+#include "../src/sha2_512_224.h"
+#include "../src/sha2_512_256.h"
+#include "../src/sm3.h"
+#include "../src/tiger.h"
+#include "../src/whirlpool.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+
+namespace
+{
+	template <typename Hash>
+	auto misalignLength(typename Hash::State &state, int) -> decltype(state.length, bool())
+	{
+		state.length += 1;
+		return true;
+	}
+
+	template <typename Hash>
+	bool misalignLength(typename Hash::State &, long)
+	{
+		// MD2 has no length field
+		return false;
+	}
+}
+
+
+TEMPLATE_TEST_CASE("midstate", "",
+	Chocobo1::Blake1_224, Chocobo1::Blake1_256, Chocobo1::Blake1_384, Chocobo1::Blake1_512,
+	Chocobo1::HAS_160,
+	Chocobo1::MD2, Chocobo1::MD4, Chocobo1::MD5,
+	Chocobo1::RIPEMD_128, Chocobo1::RIPEMD_160, Chocobo1::RIPEMD_256, Chocobo1::RIPEMD_320,
+	Chocobo1::SHA1,
+	Chocobo1::SHA2_224, Chocobo1::SHA2_256, Chocobo1::SHA2_384, Chocobo1::SHA2_512,
+	Chocobo1::SHA2_512_224, Chocobo1::SHA2_512_256,
+	Chocobo1::SM3,
+	Chocobo1::Tiger1_192,
+	Chocobo1::Whirlpool)
+{
+	using Hash = TestType;
+
+	std::vector<char> data(300);
+	for (std::size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<char>(i % 251);
+	const auto expected = Hash().addData(data.data(), data.size()).finalize().toString();
+
+	// midstate export/import, the prefix leaves some bytes pending
+	Hash prefix;
+	prefix.addData(data.data(), 130);
+	Hash resumed;
+	resumed.importState(prefix.exportState());
+	REQUIRE(expected == resumed.addData((data.data() + 130), (data.size() - 130)).finalize().toString());
+
+	Hash compressed;
+	compressed.compressBlocks({reinterpret_cast<const typename Hash::Byte *>(data.data()), (2 * Hash::BLOCK_SIZE)});
+	REQUIRE(Hash().addData(data.data(), (2 * Hash::BLOCK_SIZE)).finalize().toString()
+			== compressed.finalize().toString());
+
+	// snapshots survive a round-trip through bytes
+	const auto snapshot = prefix.serialize();
+	Hash restored;
+	REQUIRE(restored.restore(snapshot));
+	REQUIRE(expected == restored.addData((data.data() + 130), (data.size() - 130)).finalize().toString());
+	REQUIRE_FALSE(Hash().restore({snapshot.data(), (snapshot.size() - 1)}));
+
+	// peeking gives the digest so far & the state keeps going
+	Hash peeked;
+	peeked.addData(data.data(), 130);
+	REQUIRE(Hash().addData(data.data(), 130).finalize().toArray() == peeked.peekDigest());
+	REQUIRE(expected == peeked.addData((data.data() + 130), (data.size() - 130)).finalize().toString());
+
+	// broken preconditions throw & leave the state alone
+	typename Hash::State fullBuffer = prefix.exportState();
+	fullBuffer.bufferSize = Hash::BLOCK_SIZE;
+	REQUIRE_THROWS_AS(Hash().importState(fullBuffer), std::invalid_argument);
+
+	typename Hash::State partialBlock = prefix.exportState();
+	if (misalignLength<Hash>(partialBlock, 0))
+		REQUIRE_THROWS_AS(Hash().importState(partialBlock), std::invalid_argument);
+
+	const auto *blocks = reinterpret_cast<const typename Hash::Byte *>(data.data());
+	REQUIRE_THROWS_AS(Hash().compressBlocks({blocks, (Hash::BLOCK_SIZE - 1)}), std::invalid_argument);
+	Hash pending;
+	pending.addData(data.data(), 1);
+	REQUIRE_THROWS_AS(pending.compressBlocks({blocks, Hash::BLOCK_SIZE}), std::invalid_argument);
+	REQUIRE(Hash().addData(data.data(), 1).finalize().toString() == pending.finalize().toString());
+}
+
+TEMPLATE_TEST_CASE("midstate-128-bit-length", "",
+	Chocobo1::Blake1_384, Chocobo1::Blake1_512,
+	Chocobo1::SHA2_384, Chocobo1::SHA2_512, Chocobo1::SHA2_512_224, Chocobo1::SHA2_512_256,
+	Chocobo1::Whirlpool)
+{
+	using Hash = TestType;
+
+	// byte counts of 2^64 & more are kept in full, also through snapshots
+	typename Hash::State state;
+	state.length = 2 * Hash::BLOCK_SIZE;
+	state.lengthHigh = 1;
+	state.bufferSize = 3;
+
+	Hash hash;
+	hash.importState(state);
+	REQUIRE(hash.exportState().length == state.length);
+	REQUIRE(hash.exportState().lengthHigh == state.lengthHigh);
+
+	Hash restored;
+	REQUIRE(restored.restore(hash.serialize()));
+	REQUIRE(restored.exportState().lengthHigh == state.lengthHigh);
+	REQUIRE(restored.finalize().toString() == hash.finalize().toString());
+
+	// the high word is part of the length padding
+	state.lengthHigh = 0;
+	Hash low;
+	low.importState(state);
+	REQUIRE(low.finalize().toString() != restored.toString());
+}
@@ -0,0 +1,168 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/parallel_hash.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <cstring>
+#include <stdexcept>
+
+
+#define ARRAY_LENGTH(a) (static_cast<int>(std::extent<decltype(a)>::value))
+
+
+namespace
+{
+	std::vector<uint8_t> pattern(const std::size_t length)
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	}
+}
+
+
+TEST_CASE("parallel_hash-128")
+{
+	using Hash = Chocobo1::ParallelHash_128;
+
+	// official test suite from NIST
+	const uint8_t s1[24] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27};
+	REQUIRE("ba8dc1d1d979331d3f813603c67f72609ab5e44b94a0b8f9af46514454a2b4f5"
+			== Hash(32, 8).addData(s1, ARRAY_LENGTH(s1)).finalize().toString());
+
+	REQUIRE("fc484dcb3f84dceedc353438151bee58157d6efed0445a81f165e495795b7206"
+			== Hash(32, 8, "Parallel Data").addData(s1, ARRAY_LENGTH(s1)).finalize().toString());
+
+
+	// my own tests
+	const auto s2 = pattern(5000);
+	REQUIRE("0432a0ff6c465871410fb450bacde6d157bd2071d127cf000a3f5743568ad054"
+			== Hash(32, 200).addData(s2.data(), s2.size()).finalize().toString());
+
+	for (const std::size_t chunk : {1, 7, 200, 801, 3000})
+	{
+		Hash hash(32, 200);
+		for (std::size_t i = 0; i < s2.size(); i += chunk)
+			hash.addData((s2.data() + i), std::min(chunk, (s2.size() - i)));
+		REQUIRE("0432a0ff6c465871410fb450bacde6d157bd2071d127cf000a3f5743568ad054"
+				== hash.finalize().toString());
+	}
+
+	// single partial leaf
+	const auto s3 = pattern(100);
+	REQUIRE("608cc771a0a6e4472cbb5f9afaf6c9524a3977656a0937f592f5d3f8ac01f142"
+			== Hash(32, 1000).addData(s3.data(), s3.size()).finalize().toString());
+
+	// large enough to be split across threads
+	const auto s4 = pattern((1536 * 1024) + 123);
+	REQUIRE("bef891d01dd5721b3515089562371f45faf761d3b8db72888e31a1a08f843c34"
+			== Hash(32, 8192).addData(s4.data(), s4.size()).finalize().toString());
+
+	// leaves too large to be staged are absorbed as they arrive
+	const auto s6 = pattern(350017);
+	for (const std::size_t chunk : {std::size_t(1000), std::size_t(99999), std::size_t(100001), s6.size()})
+	{
+		Hash hash(32, 100000);
+		for (std::size_t i = 0; i < s6.size(); i += chunk)
+			hash.addData((s6.data() + i), std::min(chunk, (s6.size() - i)));
+		REQUIRE("3f9cc05f19c6a3c043ff681e6eb11965f98c942bae5af71bd46ab4fc33069bef"
+				== hash.finalize().toString());
+	}
+	for (const std::size_t split : {1, 100000, 150000})
+	{
+		Hash prefix(32, 100000);
+		prefix.addData(s6.data(), split);
+		const auto snapshot = prefix.serialize();
+		REQUIRE(snapshot.size() < 1024);
+
+		Hash restored(32, 100000);
+		REQUIRE(restored.restore(snapshot));
+		REQUIRE("3f9cc05f19c6a3c043ff681e6eb11965f98c942bae5af71bd46ab4fc33069bef"
+				== restored.addData((s6.data() + split), (s6.size() - split)).finalize().toString());
+		REQUIRE_FALSE(Hash(32, 200).restore(snapshot));
+	}
+
+	Hash s5(32, 8);
+	s5.addData(s2.data(), s2.size()).finalize();
+	s5.reset();
+	REQUIRE("ba8dc1d1d979331d3f813603c67f72609ab5e44b94a0b8f9af46514454a2b4f5"
+			== s5.addData(s1, ARRAY_LENGTH(s1)).finalize().toString());
+
+	const int s15[2] = {0};
+	const char s15_2[8] = {0};
+	REQUIRE(Hash(32, 8).addData(Hash::Span<const int>(s15)).finalize().toString()
+			== Hash(32, 8).addData(s15_2).finalize().toString());
+
+	const unsigned char s16[] = {0x00, 0x0A};
+	const auto s16_1 = Hash(32, 8).addData(s16, 2).finalize().toVector();
+	const auto s16_2 = Hash(32, 8).addData(s16).finalize().toVector();
+	REQUIRE(s16_1 == s16_2);
+
+	// snapshots around the 200-byte leaves & the 4-leaf SIMD batches
+	SnapshotCheck::roundTrip([]() { return Hash(32, 200); }, s2, SnapshotCheck::splitsAround({200, 800, 1600})
+		, []() { return Hash(32, 100); }  // different block size
+		, []() { return Hash(64, 200); }  // different length
+		, []() { return Chocobo1::ParallelHashXOF_128(32, 200); });
+}
+
+
+TEST_CASE("parallel_hash-256")
+{
+	using Hash = Chocobo1::ParallelHash_256;
+
+	// official test suite from NIST
+	const uint8_t s1[24] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27};
+	REQUIRE("bc1ef124da34495e948ead207dd9842235da432d2bbc54b4c110e64c451105531b7f2a3e0ce055c02805e7c2de1fb746af97a1dd01f43b824e31b87612410429"
+			== Hash(64, 8).addData(s1, ARRAY_LENGTH(s1)).finalize().toString());
+
+	REQUIRE("cdf15289b54f6212b4bc270528b49526006dd9b54e2b6add1ef6900dda3963bb33a72491f236969ca8afaea29c682d47a393c065b38e29fae651a2091c833110"
+			== Hash(64, 8, "Parallel Data").addData(s1, ARRAY_LENGTH(s1)).finalize().toString());
+
+	// invalid block sizes
+	REQUIRE_THROWS_AS(Hash(64, 0), std::invalid_argument);
+	REQUIRE_THROWS_AS(Hash(64, -1), std::invalid_argument);
+}
+
+
+TEST_CASE("parallel_hash_xof-128")
+{
+	using Hash = Chocobo1::ParallelHashXOF_128;
+
+	// official test suite from NIST
+	const uint8_t s1[24] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27};
+	REQUIRE("fe47d661e49ffe5b7d999922c062356750caf552985b8e8ce6667f2727c3c8d3"
+			== Hash(32, 8).addData(s1, ARRAY_LENGTH(s1)).finalize().toString());
+}
+
+
+TEST_CASE("parallel_hash_xof-256")
+{
+	using Hash = Chocobo1::ParallelHashXOF_256;
+
+	// official test suite from NIST
+	const uint8_t s1[24] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27};
+	REQUIRE("c10a052722614684144d28474850b410757e3cba87651ba167a5cbddff7f466675fbf84bcae7378ac444be681d729499afca667fb879348bfdda427863c82f1c"
+			== Hash(64, 8).addData(s1, ARRAY_LENGTH(s1)).finalize().toString());
+
+
+	// my own tests
+	const auto s2 = pattern(10000);
+	REQUIRE("1b0698ddbb15de2a1287719cf6f18e9157d26ef05519675086baf13f6fe04974ea7ce8ca33fc0b3a"
+			== Hash(40, 1000, "abc").addData(s2.data(), s2.size()).finalize().toString());
+
+	const auto s3 = pattern(350017);
+	REQUIRE("ab7a5168b2a3a54d87d6bb1ae386d28150c8e865d6bebcffe1ce122c994e70824cfff6b54b645349733819ac09cc5694ce5902a5865a8a9931583ecff116a351"
+			== Hash(64, 70000, "x").addData(s3.data(), s3.size()).finalize().toString());
+}
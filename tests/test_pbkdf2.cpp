@@ -0,0 +1,154 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/pbkdf2.h"
+#include "../src/sha1.h"
+#include "../src/sha2_256.h"
+#include "../src/sha2_512.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+	using Byte = uint8_t;
+
+	std::vector<Byte> pattern(const std::size_t length)
+	{
+		std::vector<Byte> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<Byte>(i % 251);
+		return ret;
+	}
+
+	std::vector<Byte> bytes(const std::string &str)
+	{
+		return {str.begin(), str.end()};
+	}
+
+	std::string toHex(const std::vector<Byte> &data)
+	{
+		std::string ret;
+		for (const Byte c : data)
+		{
+			const char digits[] = "0123456789abcdef";
+			ret += digits[c >> 4];
+			ret += digits[c & 0xf];
+		}
+		return ret;
+	}
+
+	template <typename H>
+	std::string derive(const std::vector<Byte> &password, const std::vector<Byte> &salt, const uint32_t iterations, const std::size_t length)
+	{
+		std::vector<Byte> output(length);
+		Chocobo1::PBKDF2<H>::derive(password, salt, iterations, output);
+		return toHex(output);
+	}
+
+	template <typename H>
+	void checkMany()
+	{
+		using KDF = Chocobo1::PBKDF2<H>;
+
+		// lanes mix passwords of different lengths & output lengths spanning several blocks
+		std::vector<std::vector<Byte>> passwords;
+		std::vector<std::vector<Byte>> outputs;
+		for (std::size_t i = 0; i < 19; ++i)
+		{
+			passwords.emplace_back(pattern((i * 23) % 300));
+			outputs.emplace_back(((i * 37) % 150) + 1);
+		}
+		const auto salt = pattern(20);
+
+		for (const std::size_t count : {std::size_t(1), std::size_t(2), std::size_t(5), std::size_t(8), std::size_t(9), passwords.size()})
+		{
+			std::vector<typename KDF::template Span<const Byte>> passwordSpans;
+			std::vector<typename KDF::template Span<Byte>> outputSpans;
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				std::fill(outputs[i].begin(), outputs[i].end(), 0);
+				passwordSpans.emplace_back(passwords[i].data(), passwords[i].size());
+				outputSpans.emplace_back(outputs[i].data(), outputs[i].size());
+			}
+			KDF::deriveMany(passwordSpans, salt, 100, outputSpans);
+
+			for (std::size_t i = 0; i < count; ++i)
+				REQUIRE(toHex(outputs[i]) == derive<H>(passwords[i], salt, 100, outputs[i].size()));
+		}
+	}
+}
+
+TEST_CASE("pbkdf2-sha1")
+{
+	using H = Chocobo1::SHA1;
+
+	// https://tools.ietf.org/html/rfc6070
+	REQUIRE("0c60c80f961f0e71f3a9b524af6012062fe037a6" == derive<H>(bytes("password"), bytes("salt"), 1, 20));
+	REQUIRE("ea6c014dc72d6f8ccd1ed92ace1d41f0d8de8957" == derive<H>(bytes("password"), bytes("salt"), 2, 20));
+	REQUIRE("4b007901b765489abead49d926f721d065a429c1" == derive<H>(bytes("password"), bytes("salt"), 4096, 20));
+	REQUIRE("3d2eec4fe41c849b80c8d83662c0e44a8b291a964cf2f07038"
+		== derive<H>(bytes("passwordPASSWORDpassword"), bytes("saltSALTsaltSALTsaltSALTsaltSALTsalt"), 4096, 25));
+	REQUIRE("56fa6aa75548099dcc37d7f03425e0c3" == derive<H>(bytes(std::string("pass\0word", 9)), bytes(std::string("sa\0lt", 5)), 4096, 16));
+
+	checkMany<H>();
+}
+
+TEST_CASE("pbkdf2-sha2_256")
+{
+	using H = Chocobo1::SHA2_256;
+
+	// https://tools.ietf.org/html/rfc7914#section-11
+	REQUIRE("55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783"
+		== derive<H>(bytes("passwd"), bytes("salt"), 1, 64));
+	REQUIRE("4ddcd8f60b98be21830cee5ef22701f9641a4418d04c0414aeff08876b34ab56a1d425a1225833549adb841b51c9b3176a272bdebba1d078478f62b397f33c8d"
+		== derive<H>(bytes("Password"), bytes("NaCl"), 80000, 64));
+
+	// my own tests
+	REQUIRE("18903be4cb8f7dcb0bb5a5bdf76d4534dbd569779f4d2cc104049a8b5bdb0958b0e55a53ae3ea97d" == derive<H>(pattern(100), pattern(16), 1000, 40));
+
+	checkMany<H>();
+}
+
+TEST_CASE("pbkdf2-sha2_512")
+{
+	using H = Chocobo1::SHA2_512;
+
+	// my own tests
+	REQUIRE("867f70cf1ade02cff3752599a3a53dc4af34c7a669815ae5d513554e1c8cf252c02d470a285a0501bad999bfe943c08f050235d7d68b1da55e63f73b60a57fce"
+		== derive<H>(bytes("password"), bytes("salt"), 1, 64));
+	REQUIRE("d197b1b33db0143e018b12f3d1d1479e6cdebdcc97c5c0f87f6902e072f457b5143f30602641b3d55cd335988cb36b84376060ecd532e039b742a239434af2d5d6883f0be4c24d363b638f4c2f8d917533cd4158937d0b490697a64adadb07f180c32308"
+		== derive<H>(bytes("password"), bytes("salt"), 4096, 100));
+	REQUIRE("fc7b9375b9364bea00a9964aaa73007adb49635f455bfdc175a6fe597d48f78652dc83944343c0e992e87ee229d6c330be53d4aba94f5cddd0e1517160923d38"
+		== derive<H>(pattern(200), pattern(30), 1000, 64));
+
+	checkMany<H>();
+}
+
+TEST_CASE("pbkdf2-parameters")
+{
+	using KDF = Chocobo1::PBKDF2<Chocobo1::SHA2_256>;
+
+	const auto password = bytes("password");
+	const auto salt = bytes("salt");
+	std::vector<Byte> output(32);
+	REQUIRE_THROWS_AS(KDF::derive(password, salt, 0, output), std::invalid_argument);
+
+	// every password needs an output
+	const KDF::Span<const Byte> passwords[2] = {password, password};
+	const KDF::Span<Byte> outputs[1] = {output};
+	REQUIRE_THROWS_AS(KDF::deriveMany(passwords, salt, 1, outputs), std::invalid_argument);
+	REQUIRE_THROWS_AS(KDF::deriveMany({passwords, 1}, salt, 1, {}), std::invalid_argument);
+}
@@ -14,6 +14,7 @@
 #include "catch2/single_include/catch2/catch.hpp"
 
 #include <cstring>
+#include <string>
 
 
 #define ARRAY_LENGTH(a) (static_cast<int>(std::extent<decltype(a)>::value))
@@ -30,6 +31,10 @@ TEST_CASE("sha1")
 	const char s2[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
 	REQUIRE("84983e441c3bd26ebaae4aa1f95129e5e54670f1" == Hash().addData(s2, strlen(s2)).finalize().toString());
 
+	// the padding & the size fill the last block exactly
+	const std::string s2_2(55, 'a');
+	REQUIRE("c1c8bbdc22796e28c0e15163d20899b65621d65a" == Hash().addData(s2_2.data(), s2_2.size()).finalize().toString());
+
 	const char s3[] = "a";
 	Hash test3;
 	for (long int i = 0 ; i < 1000000; ++i)
@@ -14,6 +14,7 @@
 #include "catch2/single_include/catch2/catch.hpp"
 
 #include <cstring>
+#include <string>
 
 
 #define ARRAY_LENGTH(a) (static_cast<int>(std::extent<decltype(a)>::value))
@@ -30,6 +31,10 @@ TEST_CASE("sha2-256")
 	const char s2[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
 	REQUIRE("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" == Hash().addData(s2, strlen(s2)).finalize().toString());
 
+	// the padding & the size fill the last block exactly
+	const std::string s2_2(55, 'a');
+	REQUIRE("9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318" == Hash().addData(s2_2.data(), s2_2.size()).finalize().toString());
+
 	const char s3[] = "a";
 	Hash test3;
 	for (long int i = 0 ; i < 1000000; ++i)
@@ -87,4 +92,14 @@ TEST_CASE("sha2-256")
 	const auto s16_1 = Hash().addData(s16, 2).finalize().toArray();
 	const auto s16_2 = Hash().addData(s16).finalize().toArray();
 	REQUIRE(s16_1 == s16_2);
+
+	// the snapshot layout doesn't depend on the host endianness
+	std::string s17;
+	for (const uint8_t c : Hash().addData("abc", 3).serialize())
+	{
+		const char digits[] = "0123456789abcdef";
+		s17 += digits[c >> 4];
+		s17 += digits[c & 0xf];
+	}
+	REQUIRE("02534841325f3235360067e6096a85ae67bb72f36e3c3af54fa57f520e518c68059babd9831f19cde05b000000000000000003000000616263" == s17);
 }
@@ -14,6 +14,7 @@
 #include "catch2/single_include/catch2/catch.hpp"
 
 #include <cstring>
+#include <string>
 
 
 #define ARRAY_LENGTH(a) (static_cast<int>(std::extent<decltype(a)>::value))
@@ -32,6 +33,10 @@ TEST_CASE("sha2-512")
 	REQUIRE("8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909"
 			== Hash().addData(s2, strlen(s2)).finalize().toString());
 
+	// the padding & the size fill the last block exactly
+	const std::string s2_2(111, 'a');
+	REQUIRE("fa9121c7b32b9e01733d034cfc78cbf67f926c7ed83e82200ef86818196921760b4beff48404df811b953828274461673c68d04e297b0eb7b2b4d60fc6b566a2" == Hash().addData(s2_2.data(), s2_2.size()).finalize().toString());
+
 	const char s3[] = "a";
 	Hash test3;
 	for (long int i = 0 ; i < 1000000; ++i)
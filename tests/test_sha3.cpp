@@ -12,8 +12,10 @@
 #include "../src/sha3.h"
 
 #include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
 
 #include <cstring>
+#include <vector>
 
 
 TEST_CASE("sha3-512")
@@ -69,6 +71,9 @@ TEST_CASE("sha3-512")
 	const auto s16_1 = Hash().addData(s16, 2).finalize().toVector();
 	const auto s16_2 = Hash().addData(s16).finalize().toVector();
 	REQUIRE(s16_1 == s16_2);
+
+	const auto s17 = Hash().addData(s11, strlen(s11)).finalize().toArray();
+	REQUIRE(std::vector<uint8_t>(s17.begin(), s17.end()) == Hash().addData(s11, strlen(s11)).finalize().toVector());
 }
 
 
@@ -125,6 +130,9 @@ TEST_CASE("sha3-384")
 	const auto s16_1 = Hash().addData(s16, 2).finalize().toVector();
 	const auto s16_2 = Hash().addData(s16).finalize().toVector();
 	REQUIRE(s16_1 == s16_2);
+
+	const auto s17 = Hash().addData(s11, strlen(s11)).finalize().toArray();
+	REQUIRE(std::vector<uint8_t>(s17.begin(), s17.end()) == Hash().addData(s11, strlen(s11)).finalize().toVector());
 }
 
 
@@ -181,6 +189,22 @@ TEST_CASE("sha3-256")
 	const auto s16_1 = Hash().addData(s16, 2).finalize().toVector();
 	const auto s16_2 = Hash().addData(s16).finalize().toVector();
 	REQUIRE(s16_1 == s16_2);
+
+	const auto s17 = Hash().addData(s11, strlen(s11)).finalize().toArray();
+	REQUIRE(std::vector<uint8_t>(s17.begin(), s17.end()) == Hash().addData(s11, strlen(s11)).finalize().toVector());
+
+	// the padding byte alone completes the block
+	const std::vector<char> s18(135, 'a');
+	REQUIRE("8094bb53c44cfb1e67b7c30447f9a1c33696d2463ecc1d9c92538913392843c9"
+			== Hash().addData(s18.data(), s18.size()).finalize().toString());
+
+	// snapshots & peeks around the 136-byte blocks
+	const auto s19 = SnapshotCheck::pattern(1000);
+	const auto s19Splits = SnapshotCheck::splitsAround({136, 272});
+	SnapshotCheck::roundTrip([]() { return Hash(); }, s19, s19Splits
+		, []() { return Chocobo1::SHA3_224(); }
+		, []() { return Chocobo1::SHAKE_256(32); });  // same rate, different padding
+	SnapshotCheck::peek([]() { return Hash(); }, s19, s19Splits);
 }
 
 
@@ -237,4 +261,7 @@ TEST_CASE("sha3-224")
 	const auto s16_1 = Hash().addData(s16, 2).finalize().toVector();
 	const auto s16_2 = Hash().addData(s16).finalize().toVector();
 	REQUIRE(s16_1 == s16_2);
+
+	const auto s17 = Hash().addData(s11, strlen(s11)).finalize().toArray();
+	REQUIRE(std::vector<uint8_t>(s17.begin(), s17.end()) == Hash().addData(s11, strlen(s11)).finalize().toVector());
 }
@@ -14,6 +14,7 @@
 #include "catch2/single_include/catch2/catch.hpp"
 
 #include <cstring>
+#include <vector>
 
 
 TEST_CASE("shake-256")
@@ -69,6 +70,19 @@ TEST_CASE("shake-256")
 	const auto s16_1 = Hash(512).addData(s16, 2).finalize().toVector();
 	const auto s16_2 = Hash(512).addData(s16).finalize().toVector();
 	REQUIRE(s16_1 == s16_2);
+
+	// streamed output is the one-shot output, whatever the pieces
+	const auto s17 = Hash(1000).addData(s13, strlen(s13)).finalize().toVector();
+	Hash streamed(0);
+	streamed.addData(s13, strlen(s13)).finalize();
+	std::vector<uint8_t> pieces(s17.size());
+	std::size_t offset = 0;
+	for (const std::size_t len : {1, 135, 136, 137, 0, 272, 319})
+	{
+		streamed.squeeze({(pieces.data() + offset), len});
+		offset += len;
+	}
+	REQUIRE(s17 == pieces);
 }
 
 
@@ -125,4 +139,11 @@ TEST_CASE("shake-128")
 	const auto s16_1 = Hash(512).addData(s16, 2).finalize().toVector();
 	const auto s16_2 = Hash(512).addData(s16).finalize().toVector();
 	REQUIRE(s16_1 == s16_2);
+
+	// peeking squeezes several blocks & the state keeps going
+	Hash peeked(512);
+	peeked.addData(s13, 100);
+	REQUIRE(Hash(512).addData(s13, 100).finalize().toVector() == peeked.peekDigest());
+	REQUIRE(Hash(512).addData(s13, strlen(s13)).finalize().toString()
+			== peeked.addData((s13 + 100), (strlen(s13) - 100)).finalize().toString());
 }
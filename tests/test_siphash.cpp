@@ -0,0 +1,228 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2017-2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/siphash.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+
+namespace
+{
+	std::vector<uint8_t> pattern(const std::size_t length)
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	}
+
+	template <typename Hash>
+	typename Hash::KeyArrayType patternKey()
+	{
+		// 00 01 02 ..., same as the reference test vectors
+		typename Hash::KeyArrayType key = {};
+		for (std::size_t i = 0; i < key.size(); ++i)
+			key[i] = static_cast<uint8_t>(i);
+		return key;
+	}
+
+	template <typename Hash>
+	void checkVectors(const std::pair<std::size_t, std::string> (&vectors)[10])
+	{
+		using Word = decltype(Hash::hash(patternKey<Hash>(), {}));
+		const auto key = patternKey<Hash>();
+
+		std::vector<std::vector<uint8_t>> data;
+		std::vector<typename Hash::template Span<const uint8_t>> spans;
+		for (const auto &v : vectors)
+			data.emplace_back(pattern(v.first));
+		for (const auto &d : data)
+			spans.emplace_back(d.data(), d.size());
+
+		for (std::size_t i = 0; i < data.size(); ++i)
+		{
+			const auto &d = data[i];
+			const std::string &expected = vectors[i].second;
+			REQUIRE(expected == Hash(key).addData(d.data(), d.size()).finalize().toString());
+
+			for (const std::size_t chunk : {1, 3, 5})
+			{
+				Hash hash(key);
+				for (std::size_t j = 0; j < d.size(); j += chunk)
+					hash.addData((d.data() + j), std::min(chunk, (d.size() - j)));
+				REQUIRE(expected == hash.finalize().toString());
+			}
+
+			const uint64_t value = Hash(key).addData(d.data(), d.size()).finalize().toUint64();
+			REQUIRE(value == Hash::hash(key, spans[i]));
+		}
+
+		// lockstep lanes & the leftover inputs
+		for (std::size_t i = 0; i < (4 * data.size()); ++i)
+		{
+			const auto span = spans[(i * 7) % data.size()];
+			spans.emplace_back(span);
+		}
+		for (const std::size_t count : {std::size_t(3), std::size_t(4), std::size_t(16), std::size_t(17), spans.size()})
+		{
+			std::vector<Word> outputs(count);
+			Hash::hashMany(key, {spans.data(), count}, outputs);
+			for (std::size_t i = 0; i < count; ++i)
+				REQUIRE(outputs[i] == Hash::hash(key, spans[i]));
+		}
+
+		std::vector<Word> shortOutputs(spans.size() - 1);
+		REQUIRE_THROWS_AS(Hash::hashMany(key, spans, shortOutputs), std::invalid_argument);
+	}
+}
+
+TEST_CASE("siphash-2-4")
+{
+	using Hash = Chocobo1::SipHash_2_4;
+
+	// https://github.com/veorq/SipHash/blob/master/vectors.h
+	const std::pair<std::size_t, std::string> s1[] =
+	{
+		{0, "310e0edd47db6f72"},
+		{1, "fd67dc93c539f874"},
+		{3, "2d7efbd796666785"},
+		{7, "37d1018bf50002ab"},
+		{8, "6224939a79f5f593"},
+		{9, "b0e4a90bdf82009e"},
+		{15, "e545be4961ca29a1"},
+		{16, "db9bc2577fcc2a3f"},
+		{63, "724506eb4c328a95"},
+		{100, "7e2ac585ec3f6f09"}
+	};
+	checkVectors<Hash>(s1);
+
+	// my own tests
+	const auto s2 = pattern(1000);
+	REQUIRE("52949957e4b35828" == Hash(patternKey<Hash>()).addData(s2.data(), s2.size()).finalize().toString());
+
+	Hash s3(patternKey<Hash>());
+	s3.addData(s2.data(), s2.size()).finalize();
+	s3.reset();
+	REQUIRE("310e0edd47db6f72" == s3.finalize().toString());
+
+	const int s4[2] = {0};
+	const char s4_2[8] = {0};
+	REQUIRE(Hash(patternKey<Hash>()).addData(Hash::Span<const int>(s4)).finalize().toString()
+			== Hash(patternKey<Hash>()).addData(s4_2).finalize().toString());
+
+	const unsigned char s5[] = {0x00, 0x0A};
+	const auto s5_1 = Hash(patternKey<Hash>()).addData(s5, 2).finalize().toArray();
+	const auto s5_2 = Hash(patternKey<Hash>()).addData(s5).finalize().toArray();
+	REQUIRE(s5_1 == s5_2);
+
+	// snapshots around the 8-byte words
+	SnapshotCheck::roundTrip([]() { return Hash(patternKey<Hash>()); }, s2, SnapshotCheck::splitsAround({8, 16})
+		, []() { return Chocobo1::SipHash_1_3(patternKey<Chocobo1::SipHash_1_3>()); }  // different rounds
+		, []() { return Chocobo1::HalfSipHash_2_4(patternKey<Chocobo1::HalfSipHash_2_4>()); });  // 4-byte words
+}
+
+TEST_CASE("siphash-1-3")
+{
+	using Hash = Chocobo1::SipHash_1_3;
+
+	// my own tests
+	const std::pair<std::size_t, std::string> s1[] =
+	{
+		{0, "dcc40f055801acab"},
+		{1, "93ca577df39bf4c9"},
+		{3, "fbf7dde7b80af88b"},
+		{7, "4011b19b987d92d3"},
+		{8, "8e9a298d11959036"},
+		{9, "e43d066cb38ea425"},
+		{15, "5699512a6dd820d3"},
+		{16, "668b907d1add4fcc"},
+		{63, "a8b3bbb76290199d"},
+		{100, "3b3aac0cc241ee3b"}
+	};
+	checkVectors<Hash>(s1);
+
+	// CPython's `hash()` with `PYTHONHASHSEED=0`, an all-zero key
+	const char s2[] = "abc";
+	REQUIRE(0xc03bc3a0042630f2 == Hash::hash({}, {reinterpret_cast<const uint8_t *>(s2), strlen(s2)}));
+}
+
+TEST_CASE("halfsiphash-2-4")
+{
+	using Hash = Chocobo1::HalfSipHash_2_4;
+
+	// https://github.com/veorq/SipHash/blob/master/vectors.h
+	const std::pair<std::size_t, std::string> s1[] =
+	{
+		{0, "a9359f5b"},
+		{1, "27475ab8"},
+		{3, "8afee704"},
+		{4, "2a6e4689"},
+		{7, "8bcf63c5"},
+		{8, "d0b8848f"},
+		{9, "f806e779"},
+		{15, "74fe2b97"},
+		{63, "59ea4a74"},
+		{100, "af9be784"}
+	};
+	checkVectors<Hash>(s1);
+}
+
+TEST_CASE("halfsiphash-1-3")
+{
+	using Hash = Chocobo1::HalfSipHash_1_3;
+
+	// my own tests
+	const std::pair<std::size_t, std::string> s1[] =
+	{
+		{0, "96c81458"},
+		{1, "ca64e8e7"},
+		{3, "39995301"},
+		{4, "a69e057e"},
+		{7, "d6d9389d"},
+		{8, "b1997957"},
+		{9, "edca39c8"},
+		{15, "047b25d0"},
+		{63, "04831787"},
+		{100, "3003fbca"}
+	};
+	checkVectors<Hash>(s1);
+}
+
+TEST_CASE("siphasher")
+{
+	using Key = Chocobo1::SipHash_1_3::KeyArrayType;
+	const Key key = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+
+	const uint8_t s1Bytes[8] = {0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11};
+	uint64_t s1 = 0;
+	std::memcpy(&s1, s1Bytes, sizeof(s1));
+	REQUIRE(static_cast<std::size_t>(Chocobo1::SipHash_1_3::hash(key, s1Bytes)) == Chocobo1::SipHasher<uint64_t>(key)(s1));
+
+	const std::string s2 = "hello world";
+	REQUIRE(static_cast<std::size_t>(Chocobo1::SipHash_1_3::hash(key, {reinterpret_cast<const uint8_t *>(s2.data()), s2.size()}))
+			== Chocobo1::SipHasher<std::string>(key)(s2));
+	REQUIRE(Chocobo1::SipHasher<std::string, Chocobo1::SipHash_2_4>(Chocobo1::SipHash_2_4::KeyArrayType {})(s2)
+			!= Chocobo1::SipHasher<std::string, Chocobo1::SipHash_1_3>(key)(s2));
+
+	std::unordered_set<std::string, Chocobo1::SipHasher<std::string>> s3;
+	for (int i = 0; i < 1000; ++i)
+		s3.insert(std::to_string(i));
+	REQUIRE(s3.size() == 1000);
+	REQUIRE(s3.count("999") == 1);
+	REQUIRE(s3.count("1000") == 0);
+}
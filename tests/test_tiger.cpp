@@ -77,6 +77,9 @@ TEST_CASE("tiger1-192")
 	const auto s16_1 = Hash().addData(s16, 2).finalize().toArray();
 	const auto s16_2 = Hash().addData(s16).finalize().toArray();
 	REQUIRE(s16_1 == s16_2);
+
+	// snapshots don't cross between the tiger variants
+	REQUIRE_FALSE(Chocobo1::Tiger2_192().restore(Hash().addData(s3, strlen(s3)).serialize()));
 }
 
 
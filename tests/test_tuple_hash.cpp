@@ -72,6 +72,26 @@ TEST_CASE("tuple_hash-256")
 	const auto s7_1 = Hash(32).nextData(s7, 2).finalize().toVector();
 	const auto s7_2 = Hash(32).nextData(s7).finalize().toVector();
 	REQUIRE(s7_1 == s7_2);
+
+	const Hash s8(64, "My Tuple App");
+	Hash s8_1 = s8;
+	REQUIRE("45000be63f9b6bfd89f54717670f69a9bc763591a4f05c50d68891a744bcc6e7d6d5b5e82c018da999ed35b0bb49c9678e526abd8e85c13ed254021db9e790ce"
+			== s8_1.nextData(s3_1, ARRAY_LENGTH(s3_1)).nextData(s3_2, ARRAY_LENGTH(s3_2)).nextData(s3_3, ARRAY_LENGTH(s3_3)).finalize().toString());
+	s8_1.reset();
+	REQUIRE("147c2191d5ed7efd98dbd96d7ab5a11692576f5fe2a5065f3e33de6bba9f3aa1c4e9a068a289c61c95aab30aee1e410b0b607de3620e24a4e3bf9852a1d4367e"
+			== s8_1.nextData(s2_1, ARRAY_LENGTH(s2_1)).nextData(s2_2, ARRAY_LENGTH(s2_2)).finalize().toString());
+
+	// snapshots survive a round-trip through bytes, between the elements
+	Hash s9(64, "My Tuple App");
+	s9.nextData(s3_1, ARRAY_LENGTH(s3_1)).nextData(s3_2, ARRAY_LENGTH(s3_2));
+	const auto s9Snapshot = s9.serialize();
+	Hash s9_1(64, "My Tuple App");
+	REQUIRE(s9_1.restore(s9Snapshot));
+	REQUIRE("45000be63f9b6bfd89f54717670f69a9bc763591a4f05c50d68891a744bcc6e7d6d5b5e82c018da999ed35b0bb49c9678e526abd8e85c13ed254021db9e790ce"
+			== s9_1.nextData(s3_3, ARRAY_LENGTH(s3_3)).finalize().toString());
+	REQUIRE_FALSE(Hash(64, "My Tuple App").restore({s9Snapshot.data(), (s9Snapshot.size() - 1)}));
+	REQUIRE_FALSE(Hash(32, "My Tuple App").restore(s9Snapshot));  // different length
+	REQUIRE_FALSE(Chocobo1::TupleHash_128(64, "My Tuple App").restore(s9Snapshot));
 }
 
 
@@ -0,0 +1,85 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/sha3.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+
+#include <cstring>
+
+
+TEST_CASE("turboshake-128")
+{
+	using Hash = Chocobo1::TurboSHAKE_128;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	// official test suite from RFC 9861
+	REQUIRE("1e415f1c5983aff2169217277d17bb538cd945a397ddec541f1ce41af2c1b74c"
+			== Hash(32).finalize().toString());
+	REQUIRE("1e415f1c5983aff2169217277d17bb538cd945a397ddec541f1ce41af2c1b74c3e8ccae2a4dae56c84a04c2385c03c15e8193bdf58737363321691c05462c8df"
+			== Hash(64).finalize().toString());
+
+	const auto s1 = pattern(17);
+	REQUIRE("9c97d036a3bac819db70ede0ca554ec6e4c2a1a4ffbfd9ec269ca6a111161233"
+			== Hash(32).addData(s1.data(), s1.size()).finalize().toString());
+
+	const auto s2 = pattern(17 * 17);
+	REQUIRE("96c77c279e0126f7fc07c9b07f5cdae1e0be60bdbe10620040e75d7223a624d2"
+			== Hash(32).addData(s2.data(), s2.size()).finalize().toString());
+
+
+	// my own tests
+	Hash test3(32);
+	for (const auto c : s2)
+		test3.addData(&c, 1);
+	REQUIRE("96c77c279e0126f7fc07c9b07f5cdae1e0be60bdbe10620040e75d7223a624d2"
+			== test3.finalize().toString());
+
+	test3.reset();
+	REQUIRE("1e415f1c5983aff2169217277d17bb538cd945a397ddec541f1ce41af2c1b74c"
+			== test3.finalize().toString());
+}
+
+
+TEST_CASE("turboshake-256")
+{
+	using Hash = Chocobo1::TurboSHAKE_256;
+
+	const auto pattern = [](const std::size_t length) -> std::vector<uint8_t>
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	};
+
+	// official test suite from RFC 9861
+	REQUIRE("367a329dafea871c7802ec67f905ae13c57695dc2c6663c61035f59a18f8e7db11edc0e12e91ea60eb6b32df06dd7f002fbafabb6e13ec1cc20d995547600db0"
+			== Hash(64).finalize().toString());
+
+	const auto s1 = pattern(17 * 17);
+	REQUIRE("66b810db8e90780424c0847372fdc95710882fde31c6df75beb9d4cd9305cfcae35e7b83e8b7e6eb4b78605880116316fe2c078a09b94ad7b8213c0a738b65c0"
+			== Hash(64).addData(s1.data(), s1.size()).finalize().toString());
+
+
+	// my own tests
+	const int s2[2] = {0};
+	const char s2_2[8] = {0};
+	REQUIRE(Hash(64).addData(Hash::Span<const int>(s2)).finalize().toString()
+			== Hash(64).addData(s2_2).finalize().toString());
+}
@@ -0,0 +1,122 @@
+/*
+ *  Chocobo1/Hash
+ *
+ *   Copyright 2017-2020 by Mike Tzou (Chocobo1)
+ *     https://github.com/Chocobo1/Hash
+ *
+ *   Licensed under GNU General Public License 3 or later.
+ *
+ *  @license GPL3 <https://www.gnu.org/licenses/gpl-3.0-standalone.html>
+ */
+
+#include "../src/xxh3.h"
+
+#include "catch2/single_include/catch2/catch.hpp"
+#include "snapshot_check.h"
+
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+
+namespace
+{
+	std::vector<uint8_t> pattern(const std::size_t length)
+	{
+		std::vector<uint8_t> ret(length);
+		for (std::size_t i = 0; i < length; ++i)
+			ret[i] = static_cast<uint8_t>(i % 251);
+		return ret;
+	}
+
+	template <typename Hash>
+	void checkStreaming(const std::size_t length, const uint64_t seed, const std::string &expected)
+	{
+		const auto data = pattern(length + 1);
+		REQUIRE(expected == Hash(seed).addData(data.data(), length).finalize().toString());
+
+		// misaligned
+		std::vector<uint8_t> shifted(length + 1);
+		std::memcpy((shifted.data() + 1), data.data(), length);
+		REQUIRE(expected == Hash(seed).addData((shifted.data() + 1), length).finalize().toString());
+
+		// across the internal buffer & the block boundaries
+		for (const std::size_t chunk : {1, 7, 64, 255, 256, 257, 1000})
+		{
+			Hash hash(seed);
+			for (std::size_t i = 0; i < length; i += chunk)
+				hash.addData((data.data() + i), std::min(chunk, (length - i)));
+			REQUIRE(expected == hash.finalize().toString());
+		}
+	}
+}
+
+TEST_CASE("xxh3")
+{
+	// generated with the reference implementation
+	const std::tuple<std::size_t, std::string, std::string> s1[] =
+	{
+		std::make_tuple(0, "2d06800538d394c2", "99aa06d3014798d86001c324468d497f"),
+		std::make_tuple(1, "c44bdff4074eecdb", "a6cd5e9392000f6ac44bdff4074eecdb"),
+		std::make_tuple(3, "5f4299fc161c9cbb", "e3b55f57945a17cf5f4299fc161c9cbb"),
+		std::make_tuple(4, "60dab036a58211f2", "eb70bf5fc779e9e6a6111d53e80a3db5"),
+		std::make_tuple(8, "3a1c2d7c85af88f8", "e1e4432a62217fe4cfd50c61c8bb98c1"),
+		std::make_tuple(9, "e9612598145bb9dc", "16c769d83e4aebce907931979dca3746"),
+		std::make_tuple(16, "8355e3a6f61770db", "72950631827607e2842812cc870dcae2"),
+		std::make_tuple(17, "9ef341a99de37328", "685bc458b37d057fc06e233df7729217"),
+		std::make_tuple(128, "85c6174c7ff4c46b", "14792fc3af88dc6c05321a0b64d67b41"),
+		std::make_tuple(129, "ec7642b431ba3e5a", "dd5e74ac6b45f54ebc30b63382b09a3b"),
+		std::make_tuple(240, "375a384d957fe865", "65b5be86da5540e7c92b68e16f83bbb6"),
+		std::make_tuple(241, "02e8cd95421c6d02", "1da1cb61bcb8a2a102e8cd95421c6d02"),
+		std::make_tuple(1024, "e5d78bafa45b2aa5", "d0ac1f7b93bf57b9e5d78bafa45b2aa5"),
+		std::make_tuple(1025, "e95c42288f28186e", "2882ebca04ec915ce95c42288f28186e"),
+		std::make_tuple(100000, "42c23aeead96750d", "54182c58bbb1337c42c23aeead96750d")
+	};
+	for (const auto &s : s1)
+	{
+		checkStreaming<Chocobo1::XXH3_64>(std::get<0>(s), 0, std::get<1>(s));
+		checkStreaming<Chocobo1::XXH3_128>(std::get<0>(s), 0, std::get<2>(s));
+	}
+
+	// seeded
+	const uint64_t seed = 0x123456789ABCDEF0;
+	checkStreaming<Chocobo1::XXH3_64>(0, seed, "8aa56c2c3d8317f6");
+	checkStreaming<Chocobo1::XXH3_128>(0, seed, "e7da00845366b2f3b950a1d9e9a4a947");
+	checkStreaming<Chocobo1::XXH3_64>(5, seed, "33a8bd0a4e449ab6");
+	checkStreaming<Chocobo1::XXH3_128>(5, seed, "5fc1b61b7571100b25e5edaea4b5e2e4");
+	checkStreaming<Chocobo1::XXH3_64>(200, seed, "c49a0216f97e3bf3");
+	checkStreaming<Chocobo1::XXH3_128>(200, seed, "1293b5fcb0a6ba9aa32a8907cfb94d80");
+	checkStreaming<Chocobo1::XXH3_64>(5000, seed, "f6942172dec74ac0");
+	checkStreaming<Chocobo1::XXH3_128>(5000, seed, "e48fb838803f5ca4f6942172dec74ac0");
+
+	const char s2[] = "The quick brown fox jumps over the lazy dog";
+	REQUIRE("ce7d19a5418fb365" == Chocobo1::XXH3_64().addData(s2, strlen(s2)).finalize().toString());
+	REQUIRE("ddd650205ca3e7fa24a1cc2e3a8a7651" == Chocobo1::XXH3_128().addData(s2, strlen(s2)).finalize().toString());
+	REQUIRE(0xce7d19a5418fb365 == Chocobo1::XXH3_64().addData(s2, strlen(s2)).finalize().toUint64());
+	REQUIRE(0x24a1cc2e3a8a7651 == Chocobo1::XXH3_128().addData(s2, strlen(s2)).finalize().toUint64());
+
+	using Hash = Chocobo1::XXH3_64;
+
+	const auto s3Data = pattern(5000);
+	Hash s3(seed);
+	s3.addData(s3Data.data(), s3Data.size()).finalize();
+	s3.reset();
+	REQUIRE("8aa56c2c3d8317f6" == s3.finalize().toString());
+
+	const int s4[2] = {0};
+	const char s4_2[8] = {0};
+	REQUIRE(Hash().addData(Hash::Span<const int>(s4)).finalize().toString()
+			== Hash().addData(s4_2).finalize().toString());
+
+	const unsigned char s5[] = {0x00, 0x0A};
+	const auto s5_1 = Hash().addData(s5, 2).finalize().toArray();
+	const auto s5_2 = Hash().addData(s5).finalize().toArray();
+	REQUIRE(s5_1 == s5_2);
+
+	// snapshots & peeks around the 64-byte stripes, the 240-byte short input limit, the 256-byte buffer & the 1024-byte blocks
+	const auto s6Splits = SnapshotCheck::splitsAround({64, 240, 256, 1024, 2048});
+	SnapshotCheck::roundTrip([&]() { return Hash(seed); }, s3Data, s6Splits
+		, []() { return Hash(); }  // different seed
+		, [&]() { return Chocobo1::XXH3_128(seed); });
+	SnapshotCheck::peek([&]() { return Hash(seed); }, s3Data, s6Splits);
+}